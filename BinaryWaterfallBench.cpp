@@ -0,0 +1,531 @@
+// Benchmark harness for the hot paths: tile renderers, palette mapping, audio block generation,
+// PCM decoding, the compare-mode diff count, thumbnail filtering and spectrogram analysis.
+// Every case runs a warmup, then a fixed number of timed iterations; p50/p99 (plus min and mean)
+// are reported as a table on stderr and as JSON on stdout or --json PATH, so runs can be diffed
+// to catch regressions. Input is a deterministic pseudo-random buffer unless --file is given.
+//
+// Render cases draw into a hidden GLFW window and end each iteration with glFinish, so they time
+// the GPU work as well as the submission. The immediate-mode renderer costs one quad per pixel, so
+// it runs a twentieth of the iterations (at least 5). Without a GL context the render group is
+// skipped and the CPU groups still run.
+//
+// Example:
+//   BinaryWaterfallBench --iterations 500 --filter audio/ --json audio.json
+#include <GLFW/glfw3.h>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include "MappedFile.h"
+#include "Palette.h"
+#include "Playback.h"
+#include "Colorize.h"
+#include "FrameDiff.h"
+#include "FrameGeometry.h"
+#include "FrameRenderer.h"
+#include "SoftwareRenderer.h"
+#include "Spectrogram.h"
+
+#define BASE_FRAME_RATE 24   // Same baseline as the player: 1x speed shows 24 frames per second
+
+struct BenchOptions {
+    std::string inputPath;           // --file: benchmark on real data instead of random bytes
+    std::string jsonPath = "-";      // --json: results ("-" for stdout)
+    std::string filter;              // --filter: only cases whose "group/name" contains this
+    int iterations = 200;
+    int warmup = 20;
+    int windowWidth = 1280;
+    int windowHeight = 720;
+    unsigned sampleRate = 48000;
+    bool skipGL = false;
+};
+
+struct BenchResult {
+    std::string group;
+    std::string name;
+    std::string params;              // pre-formatted JSON object members
+    int iterations = 0;
+    double bytes = 0.0;              // input bytes per iteration, for throughput
+    double minimum = 0.0;            // microseconds
+    double mean = 0.0;
+    double p50 = 0.0;
+    double p99 = 0.0;
+};
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " [options]\n"
+        "  --iterations N           timed iterations per case (default 200)\n"
+        "  --warmup N               untimed iterations per case (default 20)\n"
+        "  --filter TEXT            only run cases whose group/name contains TEXT\n"
+        "  --file PATH              benchmark on this file instead of random data\n"
+        "  --window WxH             size of the hidden render target (default 1280x720)\n"
+        "  --sample-rate N          audio rate for block generation (default 48000)\n"
+        "  --no-gl                  skip the render group\n"
+        "  --json PATH              write results as JSON (default \"-\", stdout)\n";
+}
+
+static bool parseArguments(int argc, char** argv, BenchOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--iterations" && hasValue) options.iterations = std::atoi(argv[++i]);
+        else if (arg == "--warmup" && hasValue) options.warmup = std::atoi(argv[++i]);
+        else if (arg == "--filter" && hasValue) options.filter = argv[++i];
+        else if (arg == "--file" && hasValue) options.inputPath = argv[++i];
+        else if (arg == "--json" && hasValue) options.jsonPath = argv[++i];
+        else if (arg == "--sample-rate" && hasValue) options.sampleRate = static_cast<unsigned>(std::atoi(argv[++i]));
+        else if (arg == "--no-gl") options.skipGL = true;
+        else if (arg == "--window" && hasValue) {
+            char trailing = 0;
+            if (std::sscanf(argv[++i], "%dx%d%c", &options.windowWidth, &options.windowHeight, &trailing) != 2) {
+                std::cerr << "Error: Invalid window size: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else {
+            std::cerr << "Error: Unrecognized argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    if (options.iterations <= 0 || options.warmup < 0 || options.windowWidth <= 0 || options.windowHeight <= 0 ||
+        options.sampleRate == 0) {
+        std::cerr << "Error: Iterations, window size and sample rate must be positive." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// --- Timing ---
+static double percentile(const std::vector<double>& sorted, double fraction) {
+    // Nearest rank.
+    size_t rank = static_cast<size_t>(std::ceil(fraction * static_cast<double>(sorted.size())));
+    if (rank < 1)
+        rank = 1;
+    return sorted[rank - 1];
+}
+
+// Runs body(iteration) `warmup` times untimed and `iterations` times timed.
+template <typename Body>
+static BenchResult runBenchmark(int warmup, int iterations, Body body) {
+    long long iteration = 0;
+    for (int i = 0; i < warmup; i++)
+        body(iteration++);
+    std::vector<double> samples(static_cast<size_t>(iterations));
+    for (int i = 0; i < iterations; i++) {
+        std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+        body(iteration++);
+        samples[i] = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+    }
+    BenchResult result;
+    result.iterations = iterations;
+    double sum = 0.0;
+    for (double sample : samples)
+        sum += sample;
+    std::sort(samples.begin(), samples.end());
+    result.minimum = samples.front();
+    result.mean = sum / static_cast<double>(iterations);
+    result.p50 = percentile(samples, 0.50);
+    result.p99 = percentile(samples, 0.99);
+    return result;
+}
+
+struct BenchContext {
+    const BenchOptions* options;
+    ByteView data;
+    std::vector<BenchResult> results;
+};
+
+static bool selected(const BenchContext& context, const std::string& group, const std::string& name) {
+    return context.options->filter.empty() ||
+        (group + "/" + name).find(context.options->filter) != std::string::npos;
+}
+
+static void record(BenchContext& context, BenchResult result, const std::string& group, const std::string& name,
+    const std::string& params, double bytes) {
+    result.group = group;
+    result.name = name;
+    result.params = params;
+    result.bytes = bytes;
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-44s p50 %10.2f us  p99 %10.2f us  min %10.2f us", (group + "/" + name).c_str(),
+        result.p50, result.p99, result.minimum);
+    std::cerr << line << std::endl;
+    context.results.push_back(result);
+}
+
+// --- Palette mapping ---
+// One frame through the shared LUT (RGBA32, as the CPU renderers use it), the exporter's
+// colorize-then-scale path at scale 4, and the software renderer's cache miss (RGBA32 at scale 4).
+static void benchColorize(BenchContext& context) {
+    const BenchOptions& options = *context.options;
+    const PaletteLUT& palette = getPalette(PALETTE_RAINBOW);
+    for (int g = 0; g < geometryPresetCount(); g++) {
+        FrameGeometry geometry = geometryPreset(g);
+        const size_t frameBytes = frameByteCount(geometry);
+        const size_t frames = context.data.size() / frameBytes;
+        if (frames == 0)
+            continue;
+        char params[128];
+        std::snprintf(params, sizeof(params), "\"geometry\": \"%dx%d\"", geometry.width, geometry.height);
+        std::vector<unsigned char> rgba(frameBytes * 4);
+        std::string name = std::string("rgba32-") + geometry.name;
+        if (selected(context, "colorize", name)) {
+            BenchResult result = runBenchmark(options.warmup, options.iterations, [&](long long i) {
+                colorizeRGBA32(context.data.data() + (i % frames) * frameBytes, frameBytes, palette, rgba.data());
+            });
+            record(context, result, "colorize", name, params, static_cast<double>(frameBytes));
+        }
+        const int scale = 4;
+        std::vector<unsigned char> rgb(frameBytes * 3);
+        std::vector<unsigned char> scaled(frameBytes * 3 * scale * scale);
+        name = std::string("rgb24-scale4-") + geometry.name;
+        if (selected(context, "colorize", name)) {
+            BenchResult result = runBenchmark(options.warmup, options.iterations, [&](long long i) {
+                colorizeRGB24(context.data.data() + (i % frames) * frameBytes, frameBytes, palette, rgb.data());
+                scaleNearest(rgb.data(), geometry.width, geometry.height, 3, scale, scaled.data());
+            });
+            record(context, result, "colorize", name, params, static_cast<double>(frameBytes));
+        }
+        std::vector<unsigned char> tile(frameBytes * 4 * scale * scale);
+        name = std::string("rgba32-scale4-") + geometry.name;
+        if (selected(context, "colorize", name)) {
+            BenchResult result = runBenchmark(options.warmup, options.iterations, [&](long long i) {
+                colorizeRGBA32(context.data.data() + (i % frames) * frameBytes, frameBytes, palette, rgba.data());
+                scaleNearest(rgba.data(), geometry.width, geometry.height, 4, scale, tile.data());
+            });
+            record(context, result, "colorize", name, params, static_cast<double>(frameBytes));
+        }
+    }
+}
+
+// --- Audio block generation ---
+// renderPlaybackBlock as jackProcessCallback calls it, with the player's default loop (frames
+// 0..34 at the player geometry), over buffer sizes 32..4096, speeds 0.1x..1000x and each resampler.
+static void benchAudio(BenchContext& context) {
+    const BenchOptions& options = *context.options;
+    const FrameGeometry geometry;
+    const double frameBytes = static_cast<double>(frameByteCount(geometry));
+    const double baseAdvance = frameBytes * BASE_FRAME_RATE / static_cast<double>(options.sampleRate);
+    const double speeds[] = { 0.1, 1.0, 10.0, 100.0, 1000.0 };
+    std::vector<float> out(4096);
+    for (int mode = 0; mode < RESAMPLE_COUNT; mode++) {
+        for (size_t nframes = 32; nframes <= 4096; nframes *= 2) {
+            for (double speed : speeds) {
+                char name[96];
+                std::snprintf(name, sizeof(name), "%s-n%zu-x%g", resampleModeName(static_cast<ResampleMode>(mode)),
+                    nframes, speed);
+                for (char* c = name; *c; c++)
+                    *c = static_cast<char>(std::tolower(static_cast<unsigned char>(*c)));
+                if (!selected(context, "audio", name))
+                    continue;
+                PlaybackState playback;
+                playback.multiplier = speed;
+                playback.loopEnabled = true;
+                playback.loopStart = 0.0;
+                playback.loopEnd = std::min(34.0 * frameBytes, static_cast<double>(context.data.size()));
+                BenchResult result = runBenchmark(options.warmup, options.iterations, [&](long long) {
+                    renderPlaybackBlock(playback, context.data, baseAdvance, 1.0f, out.data(), nframes,
+                        static_cast<ResampleMode>(mode));
+                });
+                char params[160];
+                std::snprintf(params, sizeof(params),
+                    "\"resampler\": \"%s\", \"nframes\": %zu, \"speed\": %g, \"sample_rate\": %u",
+                    resampleModeName(static_cast<ResampleMode>(mode)), nframes, speed, options.sampleRate);
+                // Share of the period's real-time budget is what matters for the JACK thread.
+                record(context, result, "audio", name, params,
+                    static_cast<double>(nframes) * baseAdvance * speed);
+            }
+        }
+    }
+}
+
+// --- PCM decoding ---
+// renderPlaybackFrames per sample format and channel count at 1x native rate (one frame per
+// sample: the contiguous deinterleave path) and at 1.5x (the per-sample path), nearest and linear,
+// over a 1024-sample period at --sample-rate.
+static void benchAudioFormats(BenchContext& context) {
+    const BenchOptions& options = *context.options;
+    const size_t nframes = 1024;
+    const unsigned channelCounts[] = { 1, 2, 8 };
+    const double speeds[] = { 1.0, 1.5 };
+    const ResampleMode modes[] = { RESAMPLE_NEAREST, RESAMPLE_LINEAR };
+    std::vector<std::vector<float>> buffers(MAX_AUDIO_CHANNELS, std::vector<float>(nframes));
+    float* outs[MAX_AUDIO_CHANNELS];
+    for (unsigned c = 0; c < MAX_AUDIO_CHANNELS; c++)
+        outs[c] = buffers[c].data();
+    for (int format = 0; format < SAMPLE_FORMAT_COUNT; format++) {
+        for (unsigned channels : channelCounts) {
+            AudioLayout layout;
+            layout.format = static_cast<SampleFormat>(format);
+            layout.channels = channels;
+            if (isByteLayout(layout))
+                continue;
+            const double baseAdvance = static_cast<double>(audioFrameBytes(layout));
+            for (double speed : speeds) {
+                for (ResampleMode mode : modes) {
+                    char name[96];
+                    std::snprintf(name, sizeof(name), "%s-ch%u-x%g-%s", sampleFormatName(layout.format), channels, speed,
+                        mode == RESAMPLE_NEAREST ? "nearest" : "linear");
+                    if (!selected(context, "audio-format", name))
+                        continue;
+                    PlaybackState playback;
+                    playback.multiplier = speed;
+                    playback.loopEnabled = false;
+                    BenchResult result = runBenchmark(options.warmup, options.iterations, [&](long long) {
+                        renderPlaybackFrames(playback, context.data, layout, baseAdvance, 1.0f, outs, nframes, mode);
+                    });
+                    char params[160];
+                    std::snprintf(params, sizeof(params),
+                        "\"format\": \"%s\", \"channels\": %u, \"speed\": %g, \"resampler\": \"%s\", \"nframes\": %zu",
+                        sampleFormatName(layout.format), channels, speed, resampleModeName(mode), nframes);
+                    record(context, result, "audio-format", name, params,
+                        static_cast<double>(nframes) * baseAdvance * speed);
+                }
+            }
+        }
+    }
+}
+
+// --- Diff count ---
+// One pool task of buildFrameDiffIndex: countChangedBytes over DIFF_CHUNK_BYTES, frame by frame at
+// the player geometry, comparing the data against itself one frame further on (compare mode's
+// self-diff). Run with the vector path and with the 64-bit word fallback it replaces on targets
+// without SSE2 or NEON.
+static void benchDiff(BenchContext& context) {
+    const BenchOptions& options = *context.options;
+    const FrameGeometry geometry;
+    const size_t frameBytes = frameByteCount(geometry);
+    if (context.data.size() < DIFF_CHUNK_BYTES + frameBytes)
+        return;
+    const size_t chunks = (context.data.size() - frameBytes) / DIFF_CHUNK_BYTES;
+    const size_t frames = DIFF_CHUNK_BYTES / frameBytes;
+    volatile size_t sink = 0;   // keeps the counts live
+    for (int swar = 0; swar < 2; swar++) {
+        const char* name = swar ? "count-swar" : "count";
+        if (!selected(context, "diff", name))
+            continue;
+        BenchResult result = runBenchmark(options.warmup, options.iterations, [&](long long i) {
+            const unsigned char* chunk = context.data.data() + static_cast<size_t>(i % chunks) * DIFF_CHUNK_BYTES;
+            size_t changed = 0;
+            for (size_t f = 0; f < frames; f++) {
+                const unsigned char* a = chunk + f * frameBytes;
+                changed += swar ? countChangedBytesSwar(a, a + frameBytes, frameBytes)
+                    : countChangedBytes(a, a + frameBytes, frameBytes);
+            }
+            sink = changed;
+        });
+        char params[128];
+        std::snprintf(params, sizeof(params), "\"kernel\": \"%s\", \"frame_bytes\": %zu, \"bytes\": %zu",
+            swar ? "swar" : "simd", frameBytes, frames * frameBytes);
+        record(context, result, "diff", name, params, static_cast<double>(frames * frameBytes));
+    }
+}
+
+// --- Thumbnails ---
+// One box-filtered thumbnail (what the strip builds for the slots near the playhead) per
+// geometry preset.
+static void benchThumbnails(BenchContext& context) {
+    const BenchOptions& options = *context.options;
+    for (int g = 0; g < geometryPresetCount(); g++) {
+        FrameGeometry geometry = geometryPreset(g);
+        const size_t frameBytes = frameByteCount(geometry);
+        const size_t frames = context.data.size() / frameBytes;
+        std::string name = std::string("box-") + geometry.name;
+        if (frames == 0 || !selected(context, "thumbnail", name))
+            continue;
+        ThumbnailShape shape = chooseThumbnailShape(geometry.width, frameBytes);
+        std::vector<unsigned char> pixels(static_cast<size_t>(shape.width) * shape.height);
+        BenchResult result = runBenchmark(options.warmup, options.iterations, [&](long long i) {
+            boxFilterThumbnail(context.data.data() + (i % frames) * frameBytes, shape, pixels.data());
+        });
+        char params[128];
+        std::snprintf(params, sizeof(params), "\"geometry\": \"%dx%d\", \"thumbnail\": \"%dx%d\"", geometry.width,
+            geometry.height, shape.width, shape.height);
+        record(context, result, "thumbnail", name, params, static_cast<double>(frameBytes));
+    }
+}
+
+// --- Spectrogram ---
+// spectrumLevels on one block: what the analysis thread does per hop. The blocks are the first
+// 256 KB of the data read as 8-bit PCM, the player's default layout, converted up front.
+static void benchSpectrogram(BenchContext& context) {
+    const BenchOptions& options = *context.options;
+    const char* name = "levels";
+    const size_t size = SPECTROGRAM_FFT_SIZE;
+    const size_t blocks = std::min<size_t>(context.data.size() / size, 256);
+    if (blocks == 0 || !selected(context, "spectrogram", name))
+        return;
+    FftPlan plan;
+    initFftPlan(plan, SPECTROGRAM_FFT_SIZE);
+    std::vector<float> samples(blocks * size), re, im;
+    for (size_t s = 0; s < samples.size(); s++)
+        samples[s] = (static_cast<float>(context.data.data()[s]) - 128.0f) / 128.0f;
+    std::vector<unsigned char> levels(SPECTROGRAM_BINS);
+    BenchResult result = runBenchmark(options.warmup, options.iterations, [&](long long i) {
+        spectrumLevels(plan, samples.data() + static_cast<size_t>(i % blocks) * size, re, im, levels.data());
+    });
+    char params[64];
+    std::snprintf(params, sizeof(params), "\"fft_size\": %d", SPECTROGRAM_FFT_SIZE);
+    record(context, result, "spectrogram", name, params, static_cast<double>(size));
+}
+
+// --- Renderers ---
+// Each iteration scrolls by one frame (the common playback case), so the array renderer uploads the
+// one new frame, the software renderer colorizes one new tile, and the atlas renderer re-uploads
+// every visible frame.
+static void benchRender(BenchContext& context) {
+    const BenchOptions& options = *context.options;
+    if (!glfwInit()) {
+        std::cerr << "GLFW unavailable; skipping render benchmarks." << std::endl;
+        return;
+    }
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+    GLFWwindow* window = glfwCreateWindow(options.windowWidth, options.windowHeight, "Binary Waterfall Bench", NULL, NULL);
+    if (!window) {
+        std::cerr << "No GL context; skipping render benchmarks." << std::endl;
+        glfwTerminate();
+        return;
+    }
+    glfwMakeContextCurrent(window);
+    glfwSwapInterval(0);
+    TextureRenderer textureRenderer;
+    TileArrayRenderer tileArrayRenderer;
+    SoftwareRenderer softwareRenderer;
+    if (initTextureRenderer(textureRenderer))
+        initTileArrayRenderer(tileArrayRenderer);
+    int width, height;
+    glfwGetFramebufferSize(window, &width, &height);
+    setupPixelProjection(width, height);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    const PaletteLUT& palette = getPalette(PALETTE_RAINBOW);
+    const int scales[] = { 1, 2, 4, 8 };
+    const char* variants[] = { "immediate", "texture", "array", "software" };
+    for (int g = 0; g < geometryPresetCount(); g++) {
+        FrameGeometry geometry = geometryPreset(g);
+        const size_t frames = context.data.size() / frameByteCount(geometry);
+        if (frames == 0)
+            continue;
+        for (int scale : scales) {
+            TileLayout layout = computeTileLayout(width, height, geometry.width, geometry.height, scale);
+            for (int variant = 0; variant < 4; variant++) {
+                char name[96];
+                std::snprintf(name, sizeof(name), "%s-%s-s%d", variants[variant], geometry.name, scale);
+                if (!selected(context, "render", name))
+                    continue;
+                if ((variant == 1 && !textureRenderer.ready) || (variant == 2 && !tileArrayRenderer.ready)) {
+                    std::cerr << "render/" << name << ": renderer unavailable on this context" << std::endl;
+                    continue;
+                }
+                int iterations = options.iterations;
+                int warmup = options.warmup;
+                if (variant == 0) {
+                    iterations = std::max(5, iterations / 20);
+                    warmup = std::min(warmup, 2);
+                }
+                bool ok = true;
+                BenchResult result = runBenchmark(warmup, iterations, [&](long long i) {
+                    size_t startFrame = static_cast<size_t>(i) % frames;
+                    glClear(GL_COLOR_BUFFER_BIT);
+                    if (variant == 0)
+                        renderTilesImmediate(layout, context.data.data(), startFrame, frames, palette);
+                    else if (variant == 1)
+                        ok = renderTilesTexture(textureRenderer, layout, context.data.data(), startFrame, frames, palette) && ok;
+                    else if (variant == 2)
+                        ok = renderTilesArray(tileArrayRenderer, layout, context.data.data(), 0, startFrame, frames, palette) && ok;
+                    else
+                        ok = renderTilesSoftware(softwareRenderer, layout, context.data.data(), 0, startFrame, frames, palette) && ok;
+                    glFinish();
+                });
+                if (!ok) {
+                    std::cerr << "render/" << name << ": renderer rejected this layout" << std::endl;
+                    continue;
+                }
+                char params[192];
+                std::snprintf(params, sizeof(params),
+                    "\"geometry\": \"%dx%d\", \"scale\": %d, \"window\": \"%dx%d\", \"tiles\": %d",
+                    geometry.width, geometry.height, scale, width, height, layout.columns * layout.rows);
+                record(context, result, "render", name, params,
+                    static_cast<double>(layout.columns * layout.rows) * static_cast<double>(frameByteCount(geometry)));
+            }
+        }
+    }
+    destroyTileArrayRenderer(tileArrayRenderer);
+    destroyTextureRenderer(textureRenderer);
+    destroySoftwareRenderer(softwareRenderer);
+    glfwDestroyWindow(window);
+    glfwTerminate();
+}
+
+// --- JSON output ---
+static bool writeJson(const BenchContext& context) {
+    const BenchOptions& options = *context.options;
+    FILE* file = (options.jsonPath == "-") ? stdout : std::fopen(options.jsonPath.c_str(), "w");
+    if (!file) {
+        std::cerr << "Error: Could not create " << options.jsonPath << std::endl;
+        return false;
+    }
+    std::fprintf(file, "{\n  \"iterations\": %d,\n  \"warmup\": %d,\n  \"input_bytes\": %zu,\n  \"unit\": \"us\",\n"
+        "  \"benchmarks\": [\n", options.iterations, options.warmup, context.data.size());
+    for (size_t i = 0; i < context.results.size(); i++) {
+        const BenchResult& result = context.results[i];
+        double throughput = (result.p50 > 0.0) ? result.bytes / result.p50 : 0.0;   // bytes/us == MB/s
+        std::fprintf(file, "    { \"group\": \"%s\", \"name\": \"%s\", %s, \"iterations\": %d, "
+            "\"min\": %.3f, \"mean\": %.3f, \"p50\": %.3f, \"p99\": %.3f, \"mb_per_s\": %.1f }%s\n",
+            result.group.c_str(), result.name.c_str(), result.params.c_str(), result.iterations,
+            result.minimum, result.mean, result.p50, result.p99, throughput,
+            (i + 1 < context.results.size()) ? "," : "");
+    }
+    std::fprintf(file, "  ]\n}\n");
+    bool ok = (std::fflush(file) == 0);
+    if (file != stdout)
+        ok = (std::fclose(file) == 0) && ok;
+    return ok;
+}
+
+int main(int argc, char** argv) {
+    BenchOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+    BenchContext context;
+    context.options = &options;
+    MappedFile mediaFile;
+    std::vector<unsigned char> synthetic;
+    if (!options.inputPath.empty()) {
+        if (!openMappedFile(mediaFile, options.inputPath))
+            return EXIT_FAILURE;
+        context.data = mediaFile.view;
+    }
+    else {
+        // 64 MB from a fixed xorshift seed: more than any cache, the same on every run.
+        synthetic.resize(64u << 20);
+        uint64_t state = 0x9E3779B97F4A7C15ULL;
+        for (size_t i = 0; i < synthetic.size(); i += 8) {
+            state ^= state << 13;
+            state ^= state >> 7;
+            state ^= state << 17;
+            std::memcpy(&synthetic[i], &state, 8);
+        }
+        context.data.bytes = synthetic.data();
+        context.data.length = synthetic.size();
+    }
+    benchColorize(context);
+    benchAudio(context);
+    benchAudioFormats(context);
+    benchDiff(context);
+    benchThumbnails(context);
+    benchSpectrogram(context);
+    if (!options.skipGL)
+        benchRender(context);
+    bool ok = writeJson(context);
+    closeMappedFile(mediaFile);
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,417 @@
+// Headless batch exporter: renders a file as the player would show it, without a window or JACK.
+// Video goes to a PPM image sequence or a raw RGB24 stream (for piping into ffmpeg), audio to a
+// 32-bit float WAV. The playhead is driven by the same renderPlaybackBlock/handleLoop code as
+// jackProcessCallback, one video frame's worth of samples at a time, so picture and sound stay in
+// step with the interactive player. Frames are colorized on a thread pool with a bounded number
+// in flight.
+//
+// Example:
+//   BinaryWaterfallExport disk.img --speed 4 --raw - --wav disk.wav |
+//       ffmpeg -f rawvideo -pix_fmt rgb24 -s 256x512 -r 24 -i - -i disk.wav out.mp4
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cctype>
+#include <cstdint>
+#include <chrono>
+#include <future>
+#include <filesystem>
+#ifdef _WIN32
+#include <io.h>
+#include <fcntl.h>
+#endif
+#include "MappedFile.h"
+#include "Palette.h"
+#include "Playback.h"
+#include "Colorize.h"
+#include "FrameGeometry.h"
+#include "ThreadPool.h"
+
+#define BASE_FRAME_RATE 24   // Same baseline as the player: 1x speed shows 24 frames per second
+
+struct ExportOptions {
+    std::string inputPath;
+    std::string imageDir;            // --images: write frame_000000.ppm ... into this directory
+    std::string rawPath;             // --raw: RGB24 stream ("-" for stdout)
+    std::string wavPath;             // --wav: matching audio
+    int frameWidth = 64;
+    int frameHeight = 128;
+    int scale = 4;                   // integer pixel scale, as WINDOW_SCALE in the player
+    PaletteId palette = PALETTE_RAINBOW;
+    ResampleMode resampler = RESAMPLE_NEAREST;
+    double speed = 1.0;              // playback multiplier
+    double fps = 24.0;               // output video rate (independent of speed)
+    unsigned sampleRate = 48000;
+    float volume = 1.0f;
+    double startFrame = 0.0;
+    bool loopEnabled = false;
+    bool boomerangMode = false;
+    double loopStartFrame = 0.0;
+    double loopEndFrame = 0.0;
+    long long maxFrames = -1;        // -1: one pass over the file (or loop region)
+    unsigned threads = 0;            // 0: one per hardware thread
+};
+
+// --- Name matching for --palette / --resampler (case and spaces ignored) ---
+static std::string normalizeName(const char* name) {
+    std::string result;
+    for (const char* c = name; *c; c++) {
+        if (std::isalnum(static_cast<unsigned char>(*c)))
+            result += static_cast<char>(std::tolower(static_cast<unsigned char>(*c)));
+    }
+    return result;
+}
+
+static bool parsePalette(const char* name, PaletteId& id) {
+    for (int i = 0; i < PALETTE_COUNT; i++) {
+        if (normalizeName(paletteName(static_cast<PaletteId>(i))) == normalizeName(name)) {
+            id = static_cast<PaletteId>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parseResampler(const char* name, ResampleMode& mode) {
+    for (int i = 0; i < RESAMPLE_COUNT; i++) {
+        if (normalizeName(resampleModeName(static_cast<ResampleMode>(i))) == normalizeName(name)) {
+            mode = static_cast<ResampleMode>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+static void printUsage(const char* program) {
+    std::cerr << "Usage: " << program << " <file> [options]\n"
+        "  --geometry WxH|PRESET    frame geometry: Player, Square, Rainbow, Wide, Big\n"
+        "  --width N --height N     frame geometry in bytes (default 64x128)\n"
+        "  --scale N                integer pixel scale (default 4)\n"
+        "  --palette NAME           rainbow | heatmap | grayscale | byteclass\n"
+        "  --resampler NAME         nearest | linear | cubic | decimate\n"
+        "  --speed X                playback multiplier (default 1, negative plays backwards)\n"
+        "  --fps N                  output video frame rate (default 24)\n"
+        "  --sample-rate N          WAV sample rate (default 48000)\n"
+        "  --volume X               0..2 (default 1)\n"
+        "  --start FRAME            initial playhead frame\n"
+        "  --loop START END         loop between two frames\n"
+        "  --boomerang              reflect at the loop ends instead of jumping\n"
+        "  --frames N               number of video frames (default: one pass)\n"
+        "  --threads N              colorize workers (default: hardware threads)\n"
+        "  --images DIR             write a PPM image sequence\n"
+        "  --raw PATH               write raw RGB24 frames (\"-\" for stdout)\n"
+        "  --wav PATH               write the audio track\n";
+}
+
+static bool parseArguments(int argc, char** argv, ExportOptions& options) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = (i + 1 < argc);
+        if (arg == "--geometry" && hasValue) {
+            FrameGeometry geometry;
+            if (!parseFrameGeometry(argv[++i], geometry)) {
+                std::cerr << "Error: Invalid geometry: " << argv[i] << std::endl;
+                return false;
+            }
+            options.frameWidth = geometry.width;
+            options.frameHeight = geometry.height;
+        }
+        else if (arg == "--width" && hasValue) options.frameWidth = std::atoi(argv[++i]);
+        else if (arg == "--height" && hasValue) options.frameHeight = std::atoi(argv[++i]);
+        else if (arg == "--scale" && hasValue) options.scale = std::atoi(argv[++i]);
+        else if (arg == "--speed" && hasValue) options.speed = std::atof(argv[++i]);
+        else if (arg == "--fps" && hasValue) options.fps = std::atof(argv[++i]);
+        else if (arg == "--sample-rate" && hasValue) options.sampleRate = static_cast<unsigned>(std::atoi(argv[++i]));
+        else if (arg == "--volume" && hasValue) options.volume = static_cast<float>(std::atof(argv[++i]));
+        else if (arg == "--start" && hasValue) options.startFrame = std::atof(argv[++i]);
+        else if (arg == "--frames" && hasValue) options.maxFrames = std::atoll(argv[++i]);
+        else if (arg == "--threads" && hasValue) options.threads = static_cast<unsigned>(std::atoi(argv[++i]));
+        else if (arg == "--images" && hasValue) options.imageDir = argv[++i];
+        else if (arg == "--raw" && hasValue) options.rawPath = argv[++i];
+        else if (arg == "--wav" && hasValue) options.wavPath = argv[++i];
+        else if (arg == "--boomerang") options.boomerangMode = true;
+        else if (arg == "--loop" && i + 2 < argc) {
+            options.loopEnabled = true;
+            options.loopStartFrame = std::atof(argv[++i]);
+            options.loopEndFrame = std::atof(argv[++i]);
+        }
+        else if (arg == "--palette" && hasValue) {
+            if (!parsePalette(argv[++i], options.palette)) {
+                std::cerr << "Error: Unknown palette: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--resampler" && hasValue) {
+            if (!parseResampler(argv[++i], options.resampler)) {
+                std::cerr << "Error: Unknown resampler: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if (!arg.empty() && arg[0] != '-' && options.inputPath.empty()) options.inputPath = arg;
+        else {
+            std::cerr << "Error: Unrecognized argument: " << arg << std::endl;
+            return false;
+        }
+    }
+    if (options.inputPath.empty()) {
+        std::cerr << "Error: No input file given." << std::endl;
+        return false;
+    }
+    if (options.frameWidth <= 0 || options.frameHeight <= 0 || options.scale <= 0 ||
+        options.fps <= 0.0 || options.sampleRate == 0) {
+        std::cerr << "Error: Geometry, scale, fps and sample rate must be positive." << std::endl;
+        return false;
+    }
+    if (options.imageDir.empty() && options.rawPath.empty() && options.wavPath.empty()) {
+        std::cerr << "Error: Nothing to write; pass --images, --raw and/or --wav." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// --- WAV writer (mono, 32-bit IEEE float; sizes patched on close) ---
+struct WavWriter {
+    FILE* file = nullptr;
+    uint32_t dataBytes = 0;
+};
+
+static void writeLE32(FILE* file, uint32_t value) {
+    unsigned char bytes[4] = { static_cast<unsigned char>(value), static_cast<unsigned char>(value >> 8),
+        static_cast<unsigned char>(value >> 16), static_cast<unsigned char>(value >> 24) };
+    std::fwrite(bytes, 1, 4, file);
+}
+
+static void writeLE16(FILE* file, uint16_t value) {
+    unsigned char bytes[2] = { static_cast<unsigned char>(value), static_cast<unsigned char>(value >> 8) };
+    std::fwrite(bytes, 1, 2, file);
+}
+
+static bool openWav(WavWriter& wav, const std::string& path, unsigned sampleRate) {
+    wav.file = std::fopen(path.c_str(), "wb");
+    if (!wav.file) {
+        std::cerr << "Error: Could not create WAV file: " << path << std::endl;
+        return false;
+    }
+    std::fwrite("RIFF", 1, 4, wav.file);
+    writeLE32(wav.file, 0);
+    std::fwrite("WAVEfmt ", 1, 8, wav.file);
+    writeLE32(wav.file, 16);
+    writeLE16(wav.file, 3);                 // WAVE_FORMAT_IEEE_FLOAT
+    writeLE16(wav.file, 1);                 // mono (the player sends the same signal to both ports)
+    writeLE32(wav.file, sampleRate);
+    writeLE32(wav.file, sampleRate * 4);
+    writeLE16(wav.file, 4);
+    writeLE16(wav.file, 32);
+    std::fwrite("data", 1, 4, wav.file);
+    writeLE32(wav.file, 0);
+    return true;
+}
+
+static void writeWavSamples(WavWriter& wav, const float* samples, size_t count) {
+    if (!wav.file)
+        return;
+    // Samples are written in host order; every platform the player targets is little-endian.
+    std::fwrite(samples, sizeof(float), count, wav.file);
+    wav.dataBytes += static_cast<uint32_t>(count * sizeof(float));
+}
+
+static bool closeWav(WavWriter& wav) {
+    if (!wav.file)
+        return true;
+    std::fseek(wav.file, 4, SEEK_SET);
+    writeLE32(wav.file, 36 + wav.dataBytes);
+    std::fseek(wav.file, 40, SEEK_SET);
+    writeLE32(wav.file, wav.dataBytes);
+    bool ok = (std::fclose(wav.file) == 0);
+    wav.file = nullptr;
+    if (!ok)
+        std::cerr << "Error: Failed to finish WAV file." << std::endl;
+    return ok;
+}
+
+// --- Frame job (runs on a pool worker) ---
+// Colorizes one frame into `rgb` (scaled), and writes it to the image sequence if requested.
+// Raw stream output stays on the main thread so frames leave in order.
+static bool exportFrame(const ExportOptions& options, const ByteView& data, size_t frameIndex,
+    long long outputIndex, std::vector<unsigned char>& colorized, std::vector<unsigned char>& rgb) {
+    const size_t frameBytes = static_cast<size_t>(options.frameWidth) * options.frameHeight;
+    colorizeRGB24(data.data() + frameIndex * frameBytes, frameBytes, getPalette(options.palette), colorized.data());
+    scaleNearest(colorized.data(), options.frameWidth, options.frameHeight, 3, options.scale, rgb.data());
+    if (options.imageDir.empty())
+        return true;
+    char name[64];
+    std::snprintf(name, sizeof(name), "frame_%06lld.ppm", outputIndex);
+    std::string path = (std::filesystem::path(options.imageDir) / name).string();
+    FILE* file = std::fopen(path.c_str(), "wb");
+    if (!file) {
+        std::cerr << "Error: Could not create " << path << std::endl;
+        return false;
+    }
+    std::fprintf(file, "P6\n%d %d\n255\n", options.frameWidth * options.scale, options.frameHeight * options.scale);
+    bool ok = std::fwrite(rgb.data(), 1, rgb.size(), file) == rgb.size();
+    ok = (std::fclose(file) == 0) && ok;
+    if (!ok)
+        std::cerr << "Error: Failed to write " << path << std::endl;
+    return ok;
+}
+
+struct FrameSlot {
+    std::vector<unsigned char> colorized;
+    std::vector<unsigned char> rgb;
+    std::future<void> done;
+    bool ok = true;
+    bool busy = false;
+};
+
+int main(int argc, char** argv) {
+    ExportOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        printUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    MappedFile mediaFile;
+    if (!openMappedFile(mediaFile, options.inputPath))
+        return EXIT_FAILURE;
+    const ByteView data = mediaFile.view;
+    const size_t frameBytes = static_cast<size_t>(options.frameWidth) * options.frameHeight;
+    const size_t totalFrames = data.size() / frameBytes;
+    if (totalFrames == 0) {
+        std::cerr << "Error: File too small for even one frame." << std::endl;
+        closeMappedFile(mediaFile);
+        return EXIT_FAILURE;
+    }
+    const double fileSize = static_cast<double>(data.size());
+
+    // Same playhead setup the player's UI would produce.
+    PlaybackState playback;
+    playback.multiplier = options.speed;
+    playback.loopEnabled = options.loopEnabled;
+    playback.boomerangMode = options.boomerangMode;
+    playback.loopStart = options.loopStartFrame * static_cast<double>(frameBytes);
+    playback.loopEnd = options.loopEndFrame * static_cast<double>(frameBytes);
+    playback.position = wrapPosition(options.startFrame * static_cast<double>(frameBytes), fileSize);
+    if (playback.loopEnabled && playback.loopStart <= playback.loopEnd &&
+        (playback.position < playback.loopStart || playback.position > playback.loopEnd))
+        playback.position = playback.loopStart;
+
+    long long outputFrames = options.maxFrames;
+    if (outputFrames < 0) {
+        // One pass over the file (or the loop region) at the requested speed.
+        double span = static_cast<double>(totalFrames);
+        if (playback.loopEnabled) {
+            span = std::fabs(options.loopEndFrame - options.loopStartFrame);
+            if (playback.loopStart > playback.loopEnd)
+                span = static_cast<double>(totalFrames) - span;
+        }
+        double seconds = (options.speed != 0.0) ? span / (BASE_FRAME_RATE * std::fabs(options.speed)) : 1.0;
+        outputFrames = static_cast<long long>(std::ceil(seconds * options.fps));
+        if (outputFrames < 1)
+            outputFrames = 1;
+    }
+
+    if (!options.imageDir.empty()) {
+        std::error_code error;
+        std::filesystem::create_directories(options.imageDir, error);
+        if (error) {
+            std::cerr << "Error: Could not create directory " << options.imageDir << ": " << error.message() << std::endl;
+            closeMappedFile(mediaFile);
+            return EXIT_FAILURE;
+        }
+    }
+    FILE* rawFile = nullptr;
+    if (options.rawPath == "-") {
+#ifdef _WIN32
+        _setmode(_fileno(stdout), _O_BINARY);
+#endif
+        rawFile = stdout;
+    }
+    else if (!options.rawPath.empty()) {
+        rawFile = std::fopen(options.rawPath.c_str(), "wb");
+        if (!rawFile) {
+            std::cerr << "Error: Could not create raw output: " << options.rawPath << std::endl;
+            closeMappedFile(mediaFile);
+            return EXIT_FAILURE;
+        }
+    }
+    WavWriter wav;
+    if (!options.wavPath.empty() && !openWav(wav, options.wavPath, options.sampleRate)) {
+        if (rawFile && rawFile != stdout)
+            std::fclose(rawFile);
+        closeMappedFile(mediaFile);
+        return EXIT_FAILURE;
+    }
+
+    ThreadPool pool(options.threads ? options.threads : ThreadPool::defaultThreadCount());
+    // Bounded memory: at most two frames per worker are colorized or waiting to be written.
+    std::vector<FrameSlot> slots(pool.size() * 2);
+    const size_t scaledBytes = frameBytes * 3 * static_cast<size_t>(options.scale) * options.scale;
+    for (FrameSlot& slot : slots) {
+        slot.colorized.resize(frameBytes * 3);
+        slot.rgb.resize(scaledBytes);
+    }
+
+    const double baseAdvance = static_cast<double>(frameBytes) * BASE_FRAME_RATE / options.sampleRate;
+    std::vector<float> audio(static_cast<size_t>(std::ceil(options.sampleRate / options.fps)) + 1);
+    bool ok = true;
+    long long written = 0;
+    std::chrono::steady_clock::time_point exportStart = std::chrono::steady_clock::now();
+
+    // Waits for a slot's job and streams its frame; frames complete in submission order.
+    auto retireSlot = [&](FrameSlot& slot) {
+        if (!slot.busy)
+            return;
+        slot.done.get();
+        slot.busy = false;
+        ok = ok && slot.ok;
+        if (rawFile && ok && std::fwrite(slot.rgb.data(), 1, slot.rgb.size(), rawFile) != slot.rgb.size()) {
+            std::cerr << "Error: Failed to write raw frame." << std::endl;
+            ok = false;
+        }
+        written++;
+        if (written % 500 == 0)
+            std::cerr << "Exported " << written << "/" << outputFrames << " frames" << std::endl;
+    };
+
+    for (long long frame = 0; frame < outputFrames && ok; frame++) {
+        // The picture shown at this instant is the frame under the playhead, as in renderFrame.
+        size_t frameIndex = static_cast<size_t>(wrapPosition(playback.position, fileSize) / frameBytes) % totalFrames;
+        FrameSlot& slot = slots[static_cast<size_t>(frame) % slots.size()];
+        retireSlot(slot);
+        if (!ok)
+            break;
+        slot.busy = true;
+        slot.ok = true;
+        FrameSlot* target = &slot;
+        slot.done = pool.submit([&options, &data, frameIndex, frame, target] {
+            target->ok = exportFrame(options, data, frameIndex, frame, target->colorized, target->rgb);
+        });
+
+        // Then advance the playhead through this frame's share of the audio timeline exactly as
+        // the JACK callback would; sample counts are rounded per frame so nothing drifts.
+        size_t sampleStart = static_cast<size_t>(std::llround(frame * options.sampleRate / options.fps));
+        size_t sampleEnd = static_cast<size_t>(std::llround((frame + 1) * options.sampleRate / options.fps));
+        size_t samples = sampleEnd - sampleStart;
+        renderPlaybackBlock(playback, data, baseAdvance, options.volume, audio.data(), samples, options.resampler);
+        writeWavSamples(wav, audio.data(), samples);
+    }
+    // Drain the remaining jobs, oldest first.
+    for (size_t i = 0; i < slots.size(); i++)
+        retireSlot(slots[static_cast<size_t>(written) % slots.size()]);
+
+    ok = closeWav(wav) && ok;
+    if (rawFile) {
+        ok = (std::fflush(rawFile) == 0) && ok;
+        if (rawFile != stdout)
+            ok = (std::fclose(rawFile) == 0) && ok;
+    }
+    closeMappedFile(mediaFile);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - exportStart).count();
+    std::cerr << "Exported " << written << " frames (" << written / options.fps << " s of playback) in "
+        << elapsed << " s using " << pool.size() << " threads." << std::endl;
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,412 @@
+// Self-checks for the CPU paths whose fast cases are easy to get subtly wrong: the chunked
+// signature search, the compare-mode changed-byte count, block audio generation and the byte
+// ranges a live stream rewrites between redraws.
+// Every check compares the optimized code against a plain reference on deterministic data.
+// Failures are printed to stderr and make the exit status nonzero; ctest runs the whole suite.
+//
+// Example:
+//   BinaryWaterfallTests
+#include <iostream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include "FrameDiff.h"
+#include "MappedFile.h"
+#include "PatternSearch.h"
+#include "Playback.h"
+#include "StreamSource.h"
+
+static int failures = 0;
+
+static void check(bool ok, const std::string& what) {
+    if (!ok) {
+        std::cerr << "FAIL: " << what << std::endl;
+        failures++;
+    }
+}
+
+// Deterministic bytes drawn from `alphabet` values starting at `base`, so short patterns recur.
+static std::vector<unsigned char> makeBytes(size_t size, unsigned alphabet, unsigned base) {
+    std::vector<unsigned char> bytes(size);
+    uint64_t state = 0x9E3779B97F4A7C15ULL;
+    for (size_t i = 0; i < size; i++) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        bytes[i] = static_cast<unsigned char>(base + (state >> 32) % alphabet);
+    }
+    return bytes;
+}
+
+// --- Pattern search ---
+// Every position against every pattern, in the order scanSearchChunk reports them.
+static std::vector<SearchMatch> searchReference(const PatternSet& set, const std::vector<unsigned char>& data) {
+    std::vector<SearchMatch> matches;
+    for (size_t i = 0; i < data.size(); i++) {
+        for (uint32_t p = 0; p < set.patterns.size(); p++) {
+            const std::vector<unsigned char>& pattern = set.patterns[p];
+            if (pattern.size() <= data.size() - i && std::memcmp(&data[i], pattern.data(), pattern.size()) == 0) {
+                SearchMatch match = { static_cast<uint64_t>(i), p };
+                matches.push_back(match);
+            }
+        }
+    }
+    return matches;
+}
+
+static bool sameMatches(const std::vector<SearchMatch>& a, const std::vector<SearchMatch>& b) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (a[i].position != b[i].position || a[i].pattern != b[i].pattern)
+            return false;
+    }
+    return true;
+}
+
+static void checkSearch(const std::vector<std::string>& texts, const std::vector<unsigned char>& data,
+    const std::string& label) {
+    PatternSet set;
+    for (const std::string& text : texts)
+        check(addSearchPattern(set, text), label + ": pattern \"" + text + "\" rejected");
+    ByteView view;
+    view.bytes = data.data();
+    view.length = data.size();
+    const std::vector<SearchMatch> expected = searchReference(set, data);
+    // Chunk by chunk, as the background search cuts the file.
+    std::vector<SearchMatch> chunked;
+    for (size_t from = 0; from < data.size(); from += SEARCH_CHUNK_BYTES)
+        scanSearchChunk(set, view, from, std::min(from + SEARCH_CHUNK_BYTES, data.size()), chunked);
+    check(sameMatches(chunked, expected), label + ": scanSearchChunk found " + std::to_string(chunked.size()) +
+        " matches, expected " + std::to_string(expected.size()));
+    // The background search merges chunks as they finish, in any order.
+    PatternSearch search;
+    std::vector<SearchMatch> merged;
+    startPatternSearch(search, view, set);
+    while (patternSearchRunning(search)) {
+        pollPatternSearch(search, merged);
+        std::this_thread::yield();
+    }
+    pollPatternSearch(search, merged);
+    check(patternSearchComplete(search), label + ": background search did not complete");
+    check(sameMatches(merged, expected), label + ": background search found " + std::to_string(merged.size()) +
+        " matches, expected " + std::to_string(expected.size()));
+    stopPatternSearch(search);
+}
+
+// Two and a bit chunks of a 16-letter alphabet, with patterns planted straddling both chunk
+// boundaries, at the first and last bytes, overlapping themselves, and cut off by the end.
+static void testSearch() {
+    std::vector<unsigned char> data = makeBytes(2 * SEARCH_CHUNK_BYTES + 1000, 16, 'a');
+    auto plant = [&](size_t position, const char* text) {
+        std::memcpy(&data[position], text, std::strlen(text));
+    };
+    plant(0, "ELF!");
+    plant(SEARCH_CHUNK_BYTES - 2, "\x7F" "ELF");
+    plant(2 * SEARCH_CHUNK_BYTES - 5, "MAGIC-NUMBER");
+    plant(2 * SEARCH_CHUNK_BYTES + 100, "QQQQQQ");
+    plant(SEARCH_CHUNK_BYTES + 12345, "ZZZZZZZ");
+    plant(data.size() - 12, "MAGIC-NUM");
+    plant(data.size() - 3, "ELF");
+    const std::vector<std::string> few = { "\x7F" "ELF", "MAGIC-NUMBER", "QQQ", "ELF" };
+    checkSearch({ "\x7F" "ELF" }, data, "one pattern");
+    checkSearch(few, data, "memchr path");
+    // More than SEARCH_MEMCHR_PATTERNS: the pair table, with one-byte patterns (any second byte),
+    // patterns sharing first bytes, and short patterns that recur throughout the data.
+    std::vector<std::string> many = few;
+    many.insert(many.end(), { "ZZ", "Z", "MAGIC", "hex:5151", "abc", "ELF!" });
+    checkSearch(std::vector<std::string>(many.begin(), many.begin() + SEARCH_MEMCHR_PATTERNS + 1), data,
+        "pair table, 5 patterns");
+    checkSearch(many, data, "pair table, 10 patterns");
+}
+
+// --- Frame diff ---
+static size_t countChangedReference(const unsigned char* a, const unsigned char* b, size_t length) {
+    size_t changed = 0;
+    for (size_t i = 0; i < length; i++)
+        changed += a[i] != b[i];
+    return changed;
+}
+
+// The vector and 64-bit word kernels against a byte loop: every length and misalignment up to a
+// few vectors, and lengths past the 255 vectors (and 255 words) a lane counter may hold, with
+// nothing, everything and a random share of the bytes changed.
+static void testChangedBytes() {
+    const size_t maximum = 255 * 16 * 3 + 64;
+    const std::vector<unsigned char> a = makeBytes(maximum + 8, 256, 0);
+    std::vector<unsigned char> flipped(a.size()), sparse(a.size());
+    const std::vector<unsigned char> noise = makeBytes(a.size(), 7, 0);
+    for (size_t i = 0; i < a.size(); i++) {
+        flipped[i] = static_cast<unsigned char>(a[i] ^ 0x80);
+        sparse[i] = noise[(i * 31) % noise.size()] == 0 ? static_cast<unsigned char>(a[i] + 1) : a[i];
+    }
+    const std::vector<unsigned char>* others[] = { &a, &flipped, &sparse };
+    const char* otherNames[] = { "same", "all changed", "sparse" };
+    std::vector<size_t> lengths;
+    for (size_t length = 0; length <= 80; length++)
+        lengths.push_back(length);
+    for (size_t length : { size_t(255 * 8 - 1), size_t(255 * 8 + 1), size_t(255 * 8 * 2 + 5), size_t(255 * 16 - 3),
+        size_t(255 * 16 + 9), maximum })
+        lengths.push_back(length);
+    for (int o = 0; o < 3; o++) {
+        for (size_t offset = 0; offset < 8; offset++) {
+            for (size_t length : lengths) {
+                const unsigned char* x = a.data() + offset;
+                const unsigned char* y = others[o]->data() + offset;
+                const size_t expected = countChangedReference(x, y, length);
+                const std::string label = std::string(otherNames[o]) + ", length " + std::to_string(length) +
+                    ", offset " + std::to_string(offset);
+                check(countChangedBytes(x, y, length) == expected, "countChangedBytes: " + label);
+                check(countChangedBytesSwar(x, y, length) == expected, "countChangedBytesSwar: " + label);
+            }
+        }
+    }
+}
+
+// The pooled index over sources of different lengths and a frame size no vector width divides,
+// then next/previous-change navigation over a hand-made index.
+static void testFrameDiff() {
+    const size_t frameBytes = 1000 + 3;
+    const std::vector<unsigned char> a = makeBytes(frameBytes * 600 + 17, 256, 0);
+    std::vector<unsigned char> b(a.begin(), a.end() - 500);
+    const std::vector<unsigned char> noise = makeBytes(b.size(), 509, 0);
+    for (size_t i = 0; i < b.size(); i++) {
+        if (noise[i] == 0 || (i / frameBytes) % 97 == 5)
+            b[i] = static_cast<unsigned char>(b[i] ^ (1 + noise[i] % 255));
+    }
+    ByteView viewA, viewB;
+    viewA.bytes = a.data();
+    viewA.length = a.size();
+    viewB.bytes = b.data();
+    viewB.length = b.size();
+    ThreadPool pool(4);
+    FrameDiffIndex index;
+    check(buildFrameDiffIndex(pool, viewA, viewB, frameBytes, index), "buildFrameDiffIndex: cancelled");
+    check(index.changed.size() == b.size() / frameBytes, "buildFrameDiffIndex: frame count");
+    for (size_t frame = 0; frame < index.changed.size(); frame++) {
+        const size_t offset = frame * frameBytes;
+        check(index.changed[frame] == countChangedReference(&a[offset], &b[offset], frameBytes),
+            "buildFrameDiffIndex: frame " + std::to_string(frame));
+    }
+    // Frames 1-2 and 5 and 7 differ: jumps skip the rest of the run they start in and wrap.
+    FrameDiffIndex runs;
+    runs.frameBytes = 1;
+    runs.changed = { 0, 3, 3, 0, 0, 5, 0, 2 };
+    const struct { size_t from; int direction; long long expected; } jumps[] = {
+        { 0, 1, 1 }, { 1, 1, 5 }, { 2, 1, 5 }, { 5, 1, 7 }, { 7, 1, 1 }, { 11, 1, 5 },
+        { 0, -1, 7 }, { 2, -1, 7 }, { 1, -1, 7 }, { 5, -1, 2 }, { 4, -1, 2 }, { 7, -1, 5 },
+    };
+    for (const auto& jump : jumps) {
+        check(findChangedFrame(runs, jump.from, jump.direction) == jump.expected, "findChangedFrame from " +
+            std::to_string(jump.from) + (jump.direction > 0 ? " forward" : " backward"));
+    }
+    FrameDiffIndex one;
+    one.changed = { 0, 4, 0 };
+    check(findChangedFrame(one, 1, 1) == 1 && findChangedFrame(one, 1, -1) == 1,
+        "findChangedFrame: a lone run returns itself");
+    one.changed = { 0, 0, 0 };
+    check(findChangedFrame(one, 1, 1) == -1 && findChangedFrame(FrameDiffIndex(), 0, 1) == -1,
+        "findChangedFrame: -1 when nothing differs");
+}
+
+// --- Block audio generation ---
+// What jackProcessCallback did before blocks: move, handleLoop, then take the byte (or frame)
+// under the playhead, for every sample. Played runs follow the same rule as the block renderer:
+// a sample handleLoop moved starts a new run.
+static void renderReference(PlaybackState& state, const ByteView& data, const AudioLayout& layout,
+    double baseAdvance, float* const* outs, size_t nframes, PlayedRuns& played) {
+    const double fileSize = static_cast<double>(data.size());
+    ByteViewSource source;
+    source.data = data;
+    if (state.loopEnabled && state.loopStart == state.loopEnd) {
+        state.position = state.loopStart;
+        resumePlayedRun(played, state.position, 0.0);
+    }
+    else {
+        resumePlayedRun(played, state.position, baseAdvance * state.multiplier);
+    }
+    for (size_t i = 0; i < nframes; i++) {
+        if (!(state.loopEnabled && state.loopStart == state.loopEnd)) {
+            const double advance = baseAdvance * state.multiplier;
+            state.position += advance;
+            const double unhandled = state.position;
+            handleLoop(state, fileSize, advance);
+            if (state.position == unhandled)
+                played.to[played.count - 1] = state.position;
+            else
+                beginPlayedRun(played, state.position);
+        }
+        size_t index = boundaryIndex(state.position, fileSize, data.size());
+        if (isByteLayout(layout))
+            sourceSample(source, index, 1.0f / 128.0f, outs[0][i]);
+        else
+            sourceFrame(source, index, layout, 1.0f, outs, i);
+    }
+}
+
+static bool sameRuns(const PlayedRuns& a, const PlayedRuns& b) {
+    if (a.count != b.count)
+        return false;
+    for (unsigned r = 0; r < a.count; r++) {
+        if (a.from[r] != b.from[r] || a.to[r] != b.to[r])
+            return false;
+    }
+    return true;
+}
+
+// renderPlaybackFramesFrom over several periods against the per-sample reference, on small files
+// with short loops so most periods cross loop ends, boomerang reflections and file wraps, plain
+// and wrapped (loopStart > loopEnd) regions, degenerate loops and a stopped playhead. Advances
+// and loop points are dyadic, so run positions (start + i * advance) and the reference's running
+// sum agree exactly and every sample, the final state and the played runs must match bit for bit.
+static void testBlockRendering() {
+    const size_t size = 4096;
+    const std::vector<unsigned char> bytes = makeBytes(size, 256, 0);
+    ByteView data;
+    data.bytes = bytes.data();
+    data.length = bytes.size();
+    const double multipliers[] = { 1.0, -1.0, 0.25, -0.5, 3.0, -7.75, 37.5, 300.0, 0.0 };
+    const size_t periods[] = { 1, 7, 64, 256, 1000 };
+    AudioLayout stereo16;
+    stereo16.format = SAMPLE_S16LE;
+    stereo16.channels = 2;
+    const AudioLayout layouts[] = { AudioLayout(), stereo16 };
+    std::vector<std::vector<float>> got(2, std::vector<float>(1000)), want(2, std::vector<float>(1000));
+    float* gotOuts[2] = { got[0].data(), got[1].data() };
+    float* wantOuts[2] = { want[0].data(), want[1].data() };
+    uint64_t state = 12345;
+    auto next = [&](uint64_t range) {
+        state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+        return (state >> 33) % range;
+    };
+    int failed = 0;
+    for (int t = 0; t < 4000 && failed < 5; t++) {
+        PlaybackState playback;
+        playback.loopEnabled = next(4) != 0;
+        playback.boomerangMode = next(2) != 0;
+        playback.loopStart = static_cast<double>(next(size));
+        const double length = static_cast<double>(next(8) == 0 ? 0 : 1 + next(400));
+        playback.loopEnd = std::fmod(playback.loopStart + length, static_cast<double>(size));
+        if (next(2))
+            std::swap(playback.loopStart, playback.loopEnd);
+        const uint64_t where = next(4);
+        playback.position = where == 0 ? playback.loopStart : where == 1 ? playback.loopEnd
+            : static_cast<double>(next(size * 4)) / 4.0;
+        playback.multiplier = multipliers[next(sizeof(multipliers) / sizeof(multipliers[0]))];
+        const AudioLayout& layout = layouts[next(2)];
+        const double baseAdvance = isByteLayout(layout) ? 2.5 : static_cast<double>(audioFrameBytes(layout));
+        PlaybackState reference = playback;
+        PlayedRuns gotRuns, wantRuns;
+        for (int period = 0; period < 4; period++) {
+            const size_t nframes = periods[next(sizeof(periods) / sizeof(periods[0]))];
+            ByteViewSource source;
+            source.data = data;
+            renderPlaybackFramesFrom(playback, source, size, layout, baseAdvance, 1.0f, gotOuts, nframes,
+                RESAMPLE_NEAREST, &gotRuns);
+            renderReference(reference, data, layout, baseAdvance, wantOuts, nframes, wantRuns);
+            bool same = playback.position == reference.position && playback.multiplier == reference.multiplier &&
+                sameRuns(gotRuns, wantRuns);
+            for (unsigned c = 0; c < layout.channels; c++)
+                same = same && std::memcmp(got[c].data(), want[c].data(), nframes * sizeof(float)) == 0;
+            if (!same) {
+                check(false, "renderPlaybackFramesFrom: case " + std::to_string(t) + " period " +
+                    std::to_string(period) + " (loop " + std::to_string(playback.loopStart) + ".." +
+                    std::to_string(playback.loopEnd) + (playback.boomerangMode ? ", boomerang" : "") +
+                    (playback.loopEnabled ? "" : ", no loop") + ") differs from per-sample handleLoop");
+                failed++;
+                break;
+            }
+        }
+    }
+    // The other resamplers share the boundary handling, so the playhead must still match.
+    for (int mode = RESAMPLE_LINEAR; mode < RESAMPLE_COUNT; mode++) {
+        PlaybackState playback, reference;
+        playback.boomerangMode = true;
+        playback.loopStart = 1000.0;
+        playback.loopEnd = 1100.0;
+        playback.position = 1090.0;
+        playback.multiplier = 3.0;
+        reference = playback;
+        PlayedRuns gotRuns, wantRuns;
+        ByteViewSource source;
+        source.data = data;
+        renderPlaybackFramesFrom(playback, source, size, AudioLayout(), 2.5, 1.0f, gotOuts, 1000,
+            static_cast<ResampleMode>(mode), &gotRuns);
+        renderReference(reference, data, AudioLayout(), 2.5, wantOuts, 1000, wantRuns);
+        check(playback.position == reference.position && playback.multiplier == reference.multiplier &&
+            sameRuns(gotRuns, wantRuns), std::string("renderPlaybackFramesFrom: playhead with ") +
+            resampleModeName(static_cast<ResampleMode>(mode)));
+    }
+}
+
+// --- Live stream redraws ---
+// The ranges written between two counts of `received`, then the UI's per-redraw loop against a
+// frame cache: frames drawn before (or while) their bytes arrive must be redrawn once they have.
+static void testStreamChanges() {
+    StreamChanges none = streamChangesBetween(10, 10, 100);
+    check(none.count == 0, "streamChangesBetween: nothing new");
+    StreamChanges inside = streamChangesBetween(110, 140, 100);
+    check(inside.count == 1 && inside.first[0] == 10 && inside.end[0] == 40, "streamChangesBetween: one range");
+    StreamChanges wrapped = streamChangesBetween(90, 130, 100);
+    check(wrapped.count == 2 && wrapped.first[0] == 90 && wrapped.end[0] == 100 && wrapped.first[1] == 0 &&
+        wrapped.end[1] == 30, "streamChangesBetween: split at the wrap");
+    StreamChanges toEdge = streamChangesBetween(50, 100, 100);
+    check(toEdge.count == 1 && toEdge.first[0] == 50 && toEdge.end[0] == 100, "streamChangesBetween: up to the wrap");
+    StreamChanges lapped = streamChangesBetween(90, 190, 100);
+    check(lapped.count == 1 && lapped.first[0] == 0 && lapped.end[0] == 100, "streamChangesBetween: a whole history");
+    check(streamChangesTouch(wrapped, 95, 96) && streamChangesTouch(wrapped, 29, 31) &&
+        !streamChangesTouch(wrapped, 30, 90), "streamChangesTouch: overlap at both ends only");
+
+    // Frames do not line up with the wrap, and some chunks lap the whole history.
+    const size_t frameBytes = 48;
+    const size_t capacity = 7 * frameBytes + 20;
+    const size_t frames = capacity / frameBytes;
+    const std::vector<unsigned char> incoming = makeBytes(capacity * 12, 256, 0);
+    std::vector<unsigned char> history(capacity, 0);
+    std::vector<std::vector<unsigned char> > drawn(frames);
+    unsigned long long published = 0, written = 0, seen = 0;
+    for (int step = 0; written + 2 * capacity < incoming.size(); step++) {
+        // The reader publishes what it wrote last time, then starts on a chunk the UI cannot see yet.
+        published = written;
+        size_t chunk = (step % 9 == 8) ? capacity + 31 : 1 + (static_cast<size_t>(step) * 37) % 150;
+        for (size_t i = 0; i < chunk; i++, written++)
+            history[written % capacity] = incoming[written];
+        if (step % 3 == 0)
+            published = written;
+        // One redraw: drop what arrived since the last one, then draw every frame not cached.
+        StreamChanges changes = streamChangesBetween(seen, published, capacity);
+        seen = published;
+        for (size_t frame = 0; frame < frames; frame++) {
+            if (streamChangesTouch(changes, frame * frameBytes, (frame + 1) * frameBytes))
+                drawn[frame].clear();
+            if (drawn[frame].empty())
+                drawn[frame].assign(history.begin() + frame * frameBytes, history.begin() + (frame + 1) * frameBytes);
+        }
+        // Only frames the reader is still writing may differ from the history.
+        StreamChanges inFlight = streamChangesBetween(published, written, capacity);
+        for (size_t frame = 0; frame < frames; frame++) {
+            if (streamChangesTouch(inFlight, frame * frameBytes, (frame + 1) * frameBytes))
+                continue;
+            check(std::equal(drawn[frame].begin(), drawn[frame].end(), history.begin() + frame * frameBytes),
+                "stream redraw: frame " + std::to_string(frame) + " stale after step " + std::to_string(step));
+        }
+    }
+}
+
+int main() {
+    testSearch();
+    testChangedBytes();
+    testFrameDiff();
+    testBlockRendering();
+    testStreamChanges();
+    if (failures) {
+        std::cerr << failures << " check(s) failed." << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cerr << "All checks passed." << std::endl;
+    return EXIT_SUCCESS;
+}
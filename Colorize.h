@@ -0,0 +1,103 @@
+#pragma once
+// CPU colorize and scaling kernels shared by the exporter and the software paths.
+// All work is a table lookup per byte (see Palette.h); no per-pixel arithmetic.
+// Frame sizes are runtime values (FrameGeometry.h), so the inner loops are templates on a
+// compile-time block size / channel count / scale and dispatched once per call: the block loops
+// have constant trip counts and unroll the way the old hard-coded FRAME_WIDTH builds did.
+// There are no vector paths: a lookup per byte has no SSE2 gather, and the upscale is mostly row
+// memcpys bound by the stores. Bench colorize/rgba32-scale4-* (the software renderer's cache miss)
+// measures the same with -fno-tree-vectorize, and an SSE2 pixel expansion was no faster.
+#include "Palette.h"
+#include <cstddef>
+#include <cstring>
+
+// --- Colorize ---
+// `count` must be a multiple of Block.
+template <int Channels, int Block>
+static inline void colorizeBlocks(const unsigned char* src, size_t count, const PaletteLUT& palette, unsigned char* dst) {
+    for (size_t i = 0; i < count; i += Block) {
+        const unsigned char* block = src + i;
+        unsigned char* out = dst + i * Channels;
+        for (int j = 0; j < Block; j++)
+            std::memcpy(out + j * Channels, palette.rgba[block[j]], Channels);
+    }
+}
+
+// Whole frames are contiguous, so the block size follows the byte count (every preset is a
+// multiple of 64) rather than the row width.
+template <int Channels>
+static inline void colorizeRun(const unsigned char* src, size_t count, const PaletteLUT& palette, unsigned char* dst) {
+    if (count % 64 == 0)
+        colorizeBlocks<Channels, 64>(src, count, palette, dst);
+    else if (count % 32 == 0)
+        colorizeBlocks<Channels, 32>(src, count, palette, dst);
+    else if (count % 16 == 0)
+        colorizeBlocks<Channels, 16>(src, count, palette, dst);
+    else
+        colorizeBlocks<Channels, 1>(src, count, palette, dst);
+}
+
+// Expand `count` bytes into packed RGB24 through the palette.
+static inline void colorizeRGB24(const unsigned char* src, size_t count, const PaletteLUT& palette, unsigned char* dst) {
+    colorizeRun<3>(src, count, palette, dst);
+}
+
+// Expand `count` bytes into RGBA8 (one 32-bit copy per pixel).
+static inline void colorizeRGBA32(const unsigned char* src, size_t count, const PaletteLUT& palette, unsigned char* dst) {
+    colorizeRun<4>(src, count, palette, dst);
+}
+
+// --- Nearest-neighbour integer upscale ---
+// Each source row is expanded once and then duplicated `scale - 1` times.
+template <int Channels, int Scale>
+static inline void scaleRowsFixed(const unsigned char* src, int width, int height, unsigned char* dst) {
+    const size_t dstRowBytes = static_cast<size_t>(width) * Scale * Channels;
+    for (int y = 0; y < height; y++) {
+        const unsigned char* srcRow = src + static_cast<size_t>(y) * width * Channels;
+        unsigned char* dstRow = dst + static_cast<size_t>(y) * Scale * dstRowBytes;
+        unsigned char* out = dstRow;
+        for (int x = 0; x < width; x++) {
+            for (int s = 0; s < Scale; s++)
+                std::memcpy(out + s * Channels, srcRow + x * Channels, Channels);
+            out += Scale * Channels;
+        }
+        for (int s = 1; s < Scale; s++)
+            std::memcpy(dstRow + s * dstRowBytes, dstRow, dstRowBytes);
+    }
+}
+
+template <int Channels>
+static inline void scaleRows(const unsigned char* src, int width, int height, int scale, unsigned char* dst) {
+    switch (scale) {
+    case 2: scaleRowsFixed<Channels, 2>(src, width, height, dst); return;
+    case 4: scaleRowsFixed<Channels, 4>(src, width, height, dst); return;
+    case 8: scaleRowsFixed<Channels, 8>(src, width, height, dst); return;
+    default: break;
+    }
+    const size_t dstRowBytes = static_cast<size_t>(width) * scale * Channels;
+    for (int y = 0; y < height; y++) {
+        const unsigned char* srcRow = src + static_cast<size_t>(y) * width * Channels;
+        unsigned char* dstRow = dst + static_cast<size_t>(y) * scale * dstRowBytes;
+        unsigned char* out = dstRow;
+        for (int x = 0; x < width; x++) {
+            for (int s = 0; s < scale; s++) {
+                std::memcpy(out, srcRow + x * Channels, Channels);
+                out += Channels;
+            }
+        }
+        for (int s = 1; s < scale; s++)
+            std::memcpy(dstRow + s * dstRowBytes, dstRow, dstRowBytes);
+    }
+}
+
+// Upscale a packed image with `channels` (3 or 4) bytes per pixel.
+static inline void scaleNearest(const unsigned char* src, int width, int height, int channels, int scale, unsigned char* dst) {
+    if (scale <= 1) {
+        std::memcpy(dst, src, static_cast<size_t>(width) * height * channels);
+        return;
+    }
+    if (channels == 4)
+        scaleRows<4>(src, width, height, scale, dst);
+    else
+        scaleRows<3>(src, width, height, scale, dst);
+}
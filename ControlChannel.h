@@ -0,0 +1,355 @@
+#pragma once
+// Thread model between the UI (GLFW) thread and the JACK real-time thread.
+// The UI never writes playback state directly: it pushes PlaybackCommands into a lock-free
+// single-producer/single-consumer queue, and the audio thread applies them at the start of each
+// period. The audio thread publishes a PlayheadSnapshot through a seqlock, which the UI reads
+// for rendering and the title bar. Neither side ever blocks the other.
+#include "Playback.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// --- SPSC ring buffer ---
+// Capacity must be a power of two. push() is called only by the producer, pop() only by the
+// consumer; a full queue rejects the push instead of waiting.
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+public:
+    bool push(const T& item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head - tail_.load(std::memory_order_acquire) >= Capacity)
+            return false;
+        items_[head & (Capacity - 1)] = item;
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+    bool pop(T& item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail == head_.load(std::memory_order_acquire))
+            return false;
+        item = items_[tail & (Capacity - 1)];
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+private:
+    T items_[Capacity];
+    alignas(64) std::atomic<size_t> head_{ 0 };
+    alignas(64) std::atomic<size_t> tail_{ 0 };
+};
+
+// --- Seqlock ---
+// Single writer, any number of readers. The payload is stored as relaxed atomic words so a
+// reader racing with the writer sees a torn copy only transiently and retries; store() is
+// wait-free, which is what the RT thread needs.
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable<T>::value, "SeqLock payload must be trivially copyable");
+    static const size_t WORDS = (sizeof(T) + sizeof(uint64_t) - 1) / sizeof(uint64_t);
+public:
+    void store(const T& value) {
+        uint64_t words[WORDS] = { 0 };
+        std::memcpy(words, &value, sizeof(T));
+        unsigned seq = sequence_.load(std::memory_order_relaxed);
+        sequence_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < WORDS; i++)
+            words_[i].store(words[i], std::memory_order_relaxed);
+        sequence_.store(seq + 2, std::memory_order_release);
+    }
+    T load() const {
+        uint64_t words[WORDS];
+        unsigned before, after;
+        do {
+            before = sequence_.load(std::memory_order_acquire);
+            for (size_t i = 0; i < WORDS; i++)
+                words[i] = words_[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = sequence_.load(std::memory_order_relaxed);
+        } while ((before & 1u) || before != after);
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+private:
+    std::atomic<unsigned> sequence_{ 0 };
+    std::atomic<uint64_t> words_[WORDS] = {};
+};
+
+// The file being played (Playlist.h). The audio thread only reads through it; the UI owns it.
+struct MediaSource;
+
+// --- Commands (UI -> audio) ---
+enum PlaybackCommandType {
+    CMD_TOGGLE_PAUSE,
+    CMD_RESUME,
+    CMD_TOGGLE_AUDIO,
+    CMD_SEEK_RELATIVE,        // value: byte delta
+    CMD_SEEK_ABSOLUTE,        // value: byte position
+    CMD_SET_MULTIPLIER,       // value: new multiplier
+    CMD_STEP_MULTIPLIER,      // value: +1 / -1 logarithmic step (see calculateLogAdjustment)
+    CMD_REVERSE,              // negate multiplier (0 becomes -1)
+    CMD_FORWARD,              // absolute multiplier (0 becomes 1)
+    CMD_TOGGLE_LOOP,
+    CMD_TOGGLE_BOOMERANG,
+    CMD_MARK_LOOP_START,      // loopStart = current position (only while looping is off)
+    CMD_MARK_LOOP_END,        // loopEnd = current position (only while looping is off)
+    CMD_SET_LOOP,             // value: 1 loops, 0 does not (a restored session)
+    CMD_SET_LOOP_START,       // value: byte position
+    CMD_SET_LOOP_END,         // value: byte position
+    CMD_SET_BOOMERANG,        // value: 1 on, 0 off
+    CMD_ADJUST_VOLUME,        // value: volume delta, clamped to [0, 2]
+    CMD_CYCLE_RESAMPLER,
+    CMD_SET_FRAME_BYTES,      // value: bytes per frame (frame geometry changed)
+    CMD_SWAP_MEDIA,           // media: source to play from now on; value: new byte position
+    CMD_SET_AUDIO_LAYOUT,     // value: encodeAudioLayout (sample format and channel count)
+    CMD_SET_PCM_RATE          // value: native sample rate in Hz for PCM layouts
+};
+
+// A layout packed into a command value.
+static inline double encodeAudioLayout(const AudioLayout& layout) {
+    return static_cast<double>(layout.format + 256 * layout.channels);
+}
+
+static inline AudioLayout decodeAudioLayout(double value) {
+    unsigned packed = static_cast<unsigned>(value);
+    AudioLayout layout;
+    layout.format = static_cast<SampleFormat>((packed % 256) % SAMPLE_FORMAT_COUNT);
+    layout.channels = packed / 256;
+    if (layout.channels < 1 || layout.channels > MAX_AUDIO_CHANNELS)
+        layout.channels = 1;
+    return layout;
+}
+
+struct PlaybackCommand {
+    PlaybackCommandType type;
+    double value;
+    MediaSource* media;
+};
+
+// --- Snapshot (audio -> UI) ---
+struct PlayheadSnapshot {
+    double position;
+    double multiplier;
+    double loopStart;
+    double loopEnd;
+    float volume;
+    float blockMicros;        // smoothed cost of renderPlaybackBlock per period
+    double sampleAdvance;     // bytes per sample during the last period (0 while paused or muted)
+    uint32_t clockFrame;      // JACK frame time at the start of the last period
+    uint32_t periodFrames;    // length of the last period
+    uint32_t mediaGeneration; // CMD_SWAP_MEDIA commands applied so far
+    PlayedRuns played;        // bytes sampled since the UI last took them (see collectPlayedRuns)
+    uint32_t playedSerial;    // periods published so far
+    double pcmRate;
+    AudioLayout layout;
+    ResampleMode resampleMode;
+    bool paused;
+    bool audioEnabled;
+    bool loopEnabled;
+    bool boomerangMode;
+};
+
+// State owned by whichever thread consumes the command queue (the JACK thread while it runs).
+struct AudioEngineState {
+    PlaybackState playback;
+    bool paused = false;
+    bool audioEnabled = true;
+    float volume = 1.0f;
+    ResampleMode resampleMode = RESAMPLE_NEAREST;
+    float blockMicros = 0.0f;
+    double frameBytes = 64.0 * 128.0;  // bytes per frame; sets the 1x playhead speed
+    // Audio clock for UI extrapolation (see FrameScheduler.h).
+    double sampleAdvance = 0.0;
+    uint32_t clockFrame = 0;
+    uint32_t periodFrames = 0;
+    // Current source and the number of swaps applied; loop marks are kept across swaps so the
+    // same region can be compared between dumps.
+    MediaSource* media = nullptr;
+    uint32_t mediaGeneration = 0;
+    // What the periods have played since the UI last took it.
+    PlayedRuns played;
+    uint32_t playedSerial = 0;
+    // How bytes become samples. u8 mono keeps the frame-rate tempo (frameBytes per BASE_FRAME_RATE
+    // tick); any other layout plays one frame per sample at pcmRate, so real PCM sounds at its
+    // native rate at 1x.
+    AudioLayout layout;
+    double pcmRate = 44100.0;
+};
+
+// --- Logarithmic speed step for finer control ---
+static inline double calculateLogAdjustment(double currentMultiplier) {
+    double absVal = std::abs(currentMultiplier);
+    if (absVal < 1.0)
+        return 0.1;  // smallest step when near 0
+    if (absVal < 10.0)
+        return 0.5;  // moderate step
+    return 1.0;      // larger step when values are high
+}
+
+static inline void applyPlaybackCommand(AudioEngineState& engine, const PlaybackCommand& command) {
+    PlaybackState& playback = engine.playback;
+    switch (command.type) {
+    case CMD_TOGGLE_PAUSE:
+        engine.paused = !engine.paused;
+        break;
+    case CMD_RESUME:
+        engine.paused = false;
+        break;
+    case CMD_TOGGLE_AUDIO:
+        engine.audioEnabled = !engine.audioEnabled;
+        break;
+    case CMD_SEEK_RELATIVE:
+        playback.position += command.value;
+        break;
+    case CMD_SEEK_ABSOLUTE:
+        playback.position = command.value;
+        break;
+    case CMD_SET_MULTIPLIER:
+        playback.multiplier = command.value;
+        break;
+    case CMD_STEP_MULTIPLIER:
+        playback.multiplier += command.value * calculateLogAdjustment(playback.multiplier);
+        break;
+    case CMD_REVERSE:
+        playback.multiplier = -playback.multiplier;
+        if (playback.multiplier == 0)
+            playback.multiplier = -1.0;
+        break;
+    case CMD_FORWARD:
+        playback.multiplier = std::fabs(playback.multiplier);
+        if (playback.multiplier == 0)
+            playback.multiplier = 1.0;
+        break;
+    case CMD_TOGGLE_LOOP:
+        playback.loopEnabled = !playback.loopEnabled;
+        break;
+    case CMD_TOGGLE_BOOMERANG:
+        playback.boomerangMode = !playback.boomerangMode;
+        break;
+    case CMD_MARK_LOOP_START:
+        if (!playback.loopEnabled)
+            playback.loopStart = playback.position;
+        break;
+    case CMD_MARK_LOOP_END:
+        if (!playback.loopEnabled)
+            playback.loopEnd = playback.position;
+        break;
+    case CMD_SET_LOOP:
+        playback.loopEnabled = command.value != 0.0;
+        break;
+    case CMD_SET_LOOP_START:
+        playback.loopStart = command.value;
+        break;
+    case CMD_SET_LOOP_END:
+        playback.loopEnd = command.value;
+        break;
+    case CMD_SET_BOOMERANG:
+        playback.boomerangMode = command.value != 0.0;
+        break;
+    case CMD_ADJUST_VOLUME:
+        engine.volume += static_cast<float>(command.value);
+        if (engine.volume > 2.0f)
+            engine.volume = 2.0f;
+        if (engine.volume < 0.0f)
+            engine.volume = 0.0f;
+        break;
+    case CMD_CYCLE_RESAMPLER:
+        engine.resampleMode = nextResampleMode(engine.resampleMode);
+        engine.blockMicros = 0.0f;
+        break;
+    case CMD_SET_FRAME_BYTES:
+        if (command.value >= 1.0)
+            engine.frameBytes = command.value;
+        break;
+    case CMD_SET_AUDIO_LAYOUT:
+        engine.layout = decodeAudioLayout(command.value);
+        break;
+    case CMD_SET_PCM_RATE:
+        if (command.value > 0.0)
+            engine.pcmRate = command.value;
+        break;
+    case CMD_SWAP_MEDIA:
+        engine.media = command.media;
+        engine.mediaGeneration++;
+        engine.played = PlayedRuns();
+        playback.position = command.value;
+        break;
+    }
+}
+
+static inline PlayheadSnapshot makePlayheadSnapshot(const AudioEngineState& engine) {
+    PlayheadSnapshot snapshot;
+    snapshot.position = engine.playback.position;
+    snapshot.multiplier = engine.playback.multiplier;
+    snapshot.loopStart = engine.playback.loopStart;
+    snapshot.loopEnd = engine.playback.loopEnd;
+    snapshot.volume = engine.volume;
+    snapshot.blockMicros = engine.blockMicros;
+    snapshot.sampleAdvance = engine.sampleAdvance;
+    snapshot.clockFrame = engine.clockFrame;
+    snapshot.periodFrames = engine.periodFrames;
+    snapshot.mediaGeneration = engine.mediaGeneration;
+    snapshot.played = engine.played;
+    snapshot.playedSerial = engine.playedSerial;
+    snapshot.pcmRate = engine.pcmRate;
+    snapshot.layout = engine.layout;
+    snapshot.resampleMode = engine.resampleMode;
+    snapshot.paused = engine.paused;
+    snapshot.audioEnabled = engine.audioEnabled;
+    snapshot.loopEnabled = engine.playback.loopEnabled;
+    snapshot.boomerangMode = engine.playback.boomerangMode;
+    return snapshot;
+}
+
+// --- Control channel ---
+struct ControlChannel {
+    SpscQueue<PlaybackCommand, 256> commands;
+    SeqLock<PlayheadSnapshot> playhead;
+    std::atomic<uint32_t> playedTaken{ 0 };   // playedSerial of the last snapshot the UI took
+};
+
+// Producer side (UI thread). Returns false if the queue is full and the command was dropped.
+static inline bool sendPlaybackCommand(ControlChannel& channel, PlaybackCommandType type, double value = 0.0) {
+    PlaybackCommand command;
+    command.type = type;
+    command.value = value;
+    command.media = nullptr;
+    return channel.commands.push(command);
+}
+
+// Switch the audio thread to `media` at the start of its next period, seeking to `position`.
+static inline bool sendMediaSwap(ControlChannel& channel, MediaSource* media, double position) {
+    PlaybackCommand command;
+    command.type = CMD_SWAP_MEDIA;
+    command.value = position;
+    command.media = media;
+    return channel.commands.push(command);
+}
+
+// Consumer side: drain pending commands into the engine state. Wait-free.
+static inline void applyPendingCommands(ControlChannel& channel, AudioEngineState& engine) {
+    PlaybackCommand command;
+    while (channel.commands.pop(command))
+        applyPlaybackCommand(engine, command);
+}
+
+static inline void publishPlayhead(ControlChannel& channel, const AudioEngineState& engine) {
+    channel.playhead.store(makePlayheadSnapshot(engine));
+}
+
+// Audio thread, once per period before rendering: the runs to add this period's samples to. They
+// start afresh once the UI has taken the latest snapshot; if another period was published after
+// the one it took, they are kept, so the next snapshot repeats a little instead of missing bytes.
+static inline PlayedRuns* collectPlayedRuns(ControlChannel& channel, AudioEngineState& engine) {
+    if (channel.playedTaken.load(std::memory_order_acquire) == engine.playedSerial)
+        engine.played = PlayedRuns();
+    engine.playedSerial++;
+    return &engine.played;
+}
+
+// UI thread: the snapshot's runs have been drawn.
+static inline void takePlayedRuns(ControlChannel& channel, const PlayheadSnapshot& snapshot) {
+    channel.playedTaken.store(snapshot.playedSerial, std::memory_order_release);
+}
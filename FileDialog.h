@@ -0,0 +1,68 @@
+#pragma once
+// "Open file" for when nothing was given on the command line.
+// Windows shows the common dialog. Elsewhere the desktop's picker is run (zenity, then kdialog)
+// when there is a display; with neither, or on a headless box, the path is asked for on the
+// terminal. An empty result means nothing was chosen.
+#include <cstdio>
+#include <iostream>
+#include <string>
+#ifdef _WIN32
+#include <windows.h>
+#include <commdlg.h>
+#else
+#include <cstdlib>
+#include <unistd.h>
+#endif
+
+#ifndef _WIN32
+// First line a picker printed, or "" if it could not run or was cancelled.
+static inline std::string runFilePicker(const char* command) {
+    FILE* pipe = popen(command, "r");
+    if (!pipe)
+        return "";
+    std::string path;
+    char buffer[4096];
+    while (std::fgets(buffer, sizeof(buffer), pipe))
+        path += buffer;
+    if (pclose(pipe) != 0)
+        return "";
+    size_t end = path.find('\n');
+    return end == std::string::npos ? path : path.substr(0, end);
+}
+#endif
+
+static inline std::string openFileDialog(void) {
+#ifdef _WIN32
+    char filename[MAX_PATH] = { 0 };
+    OPENFILENAMEA ofn;
+    ZeroMemory(&ofn, sizeof(ofn));
+    ofn.lStructSize = sizeof(ofn);
+    ofn.hwndOwner = NULL;
+    ofn.lpstrFilter = "Raw Media Files\0*.*\0";
+    ofn.lpstrFile = filename;
+    ofn.nMaxFile = MAX_PATH;
+    ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST;
+    ofn.lpstrTitle = "Select Raw Media File";
+    if (GetOpenFileNameA(&ofn))
+        return filename;
+    return "";
+#else
+    if (std::getenv("DISPLAY") || std::getenv("WAYLAND_DISPLAY")) {
+        static const char* pickers[] = {
+            "zenity --file-selection --title='Select Raw Media File' 2>/dev/null",
+            "kdialog --getopenfilename . --title 'Select Raw Media File' 2>/dev/null"
+        };
+        for (const char* picker : pickers) {
+            std::string path = runFilePicker(picker);
+            if (!path.empty())
+                return path;
+        }
+    }
+    if (!isatty(STDIN_FILENO))
+        return "";
+    std::cout << "Raw media file to open: " << std::flush;
+    std::string path;
+    std::getline(std::cin, path);
+    return path;
+#endif
+}
@@ -0,0 +1,195 @@
+#pragma once
+// Per-frame statistics for finding compressed, encrypted, empty or textual regions.
+// A background pass splits the file into chunks of frames and scans them on a work-stealing
+// ThreadPool. Each frame gets Shannon entropy, the share of bytes inside zero runs and the share
+// of printable ASCII, packed as three bytes, so a 10 GB file at the player geometry needs ~4 MB.
+// Histograms use four interleaved count tables so consecutive equal bytes do not serialize on
+// one counter (byte histograms do not map onto SIMD lanes; this is the usual substitute).
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+const size_t ANALYSIS_ZERO_RUN_MIN = 8;            // shorter zero runs count as data
+const size_t ANALYSIS_CHUNK_BYTES = 1 << 20;       // work per pool task
+const unsigned char ANALYSIS_HIGH_ENTROPY = 239;   // 7.5 bits per byte: compressed or encrypted
+const unsigned char ANALYSIS_LOW_ENTROPY = 64;     // 2 bits per byte: padding, tables, sparse data
+
+struct FrameStats {
+    unsigned char entropy;      // bits per byte, scaled 0..8 -> 0..255
+    unsigned char zeroRuns;     // share of bytes in zero runs of at least ANALYSIS_ZERO_RUN_MIN
+    unsigned char ascii;        // share of printable ASCII (plus tab, LF, CR)
+};
+
+struct FrameAnalysis {
+    size_t frameBytes = 0;
+    std::vector<FrameStats> frames;
+
+    bool empty() const { return frames.empty(); }
+};
+
+static inline float frameEntropyBits(const FrameStats& stats) {
+    return static_cast<float>(stats.entropy) * 8.0f / 255.0f;
+}
+
+static inline unsigned char analysisRatio(size_t part, size_t total) {
+    return static_cast<unsigned char>(total ? (part * 255 + total / 2) / total : 0);
+}
+
+static inline FrameStats analyzeFrame(const unsigned char* bytes, size_t length) {
+    uint32_t counts[4][256];
+    std::memset(counts, 0, sizeof(counts));
+    size_t i = 0;
+    for (; i + 4 <= length; i += 4) {
+        counts[0][bytes[i]]++;
+        counts[1][bytes[i + 1]]++;
+        counts[2][bytes[i + 2]]++;
+        counts[3][bytes[i + 3]]++;
+    }
+    for (; i < length; i++)
+        counts[0][bytes[i]]++;
+
+    size_t zeroRunBytes = 0, run = 0;
+    for (size_t j = 0; j < length; j++) {
+        if (bytes[j] == 0) {
+            run++;
+            continue;
+        }
+        if (run >= ANALYSIS_ZERO_RUN_MIN)
+            zeroRunBytes += run;
+        run = 0;
+    }
+    if (run >= ANALYSIS_ZERO_RUN_MIN)
+        zeroRunBytes += run;
+
+    double entropy = 0.0;
+    size_t asciiBytes = 0;
+    const double inverse = length ? 1.0 / static_cast<double>(length) : 0.0;
+    for (int v = 0; v < 256; v++) {
+        uint32_t count = counts[0][v] + counts[1][v] + counts[2][v] + counts[3][v];
+        if (count == 0)
+            continue;
+        double p = static_cast<double>(count) * inverse;
+        entropy -= p * std::log2(p);
+        if ((v >= 0x20 && v < 0x7F) || v == '\t' || v == '\n' || v == '\r')
+            asciiBytes += count;
+    }
+    FrameStats stats;
+    stats.entropy = static_cast<unsigned char>(std::lround(entropy * 255.0 / 8.0));
+    stats.zeroRuns = analysisRatio(zeroRunBytes, length);
+    stats.ascii = analysisRatio(asciiBytes, length);
+    return stats;
+}
+
+// Scan every whole frame. Returns false if cancelled; `framesDone` (optional) counts progress.
+static inline bool analyzeFrames(ThreadPool& pool, const ByteView& view, size_t frameBytes, FrameAnalysis& analysis,
+    const std::atomic<bool>* cancel = nullptr, std::atomic<size_t>* framesDone = nullptr) {
+    analysis = FrameAnalysis();
+    analysis.frameBytes = frameBytes;
+    if (frameBytes == 0)
+        return true;
+    size_t frameCount = view.size() / frameBytes;
+    analysis.frames.resize(frameCount);
+    size_t grain = ANALYSIS_CHUNK_BYTES / frameBytes;
+    if (grain == 0)
+        grain = 1;
+    std::atomic<bool> cancelled(false);
+    pool.parallelFor(frameCount, grain, [&](size_t begin, size_t end) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) {
+            cancelled.store(true, std::memory_order_relaxed);
+            return;
+        }
+        for (size_t frame = begin; frame < end; frame++)
+            analysis.frames[frame] = analyzeFrame(view.data() + frame * frameBytes, frameBytes);
+        if (framesDone)
+            framesDone->fetch_add(end - begin, std::memory_order_relaxed);
+    });
+    if (cancelled.load()) {
+        analysis = FrameAnalysis();
+        return false;
+    }
+    return true;
+}
+
+// --- Navigation ---
+// Next (direction > 0) or previous frame after `from` that matches, skipping the rest of the region
+// `from` is in, so repeated jumps step from one region to the next. Wraps around; -1 if none.
+template <typename Predicate>
+static inline long long findFrameRegion(const FrameAnalysis& analysis, size_t from, int direction, Predicate matches) {
+    const size_t count = analysis.frames.size();
+    if (count == 0)
+        return -1;
+    from %= count;
+    bool inRegion = matches(analysis.frames[from]);
+    size_t frame = from;
+    for (size_t step = 1; step < count; step++) {
+        frame = (direction > 0) ? (frame + 1) % count : (frame + count - 1) % count;
+        bool match = matches(analysis.frames[frame]);
+        if (match && !inRegion)
+            return static_cast<long long>(frame);
+        inRegion = inRegion && match;
+    }
+    return inRegion ? -1 : (matches(analysis.frames[from]) ? static_cast<long long>(from) : -1);
+}
+
+static inline long long findHighEntropyFrame(const FrameAnalysis& analysis, size_t from, int direction) {
+    return findFrameRegion(analysis, from, direction, [](const FrameStats& stats) {
+        return stats.entropy >= ANALYSIS_HIGH_ENTROPY;
+    });
+}
+
+static inline long long findLowEntropyFrame(const FrameAnalysis& analysis, size_t from, int direction) {
+    return findFrameRegion(analysis, from, direction, [](const FrameStats& stats) {
+        return stats.entropy <= ANALYSIS_LOW_ENTROPY;
+    });
+}
+
+// --- Background analyzer ---
+// Owns the pool for the duration of a scan; the UI polls for completion like OverviewBuilder.
+struct FrameAnalyzer {
+    std::thread worker;
+    std::atomic<bool> cancel{ false };
+    std::atomic<bool> finished{ false };
+    std::atomic<size_t> framesDone{ 0 };
+    size_t frameCount = 0;
+    FrameAnalysis result;
+};
+
+static inline void stopFrameAnalysis(FrameAnalyzer& analyzer) {
+    if (analyzer.worker.joinable()) {
+        analyzer.cancel = true;
+        analyzer.worker.join();
+    }
+    analyzer.result = FrameAnalysis();
+}
+
+static inline void startFrameAnalysis(FrameAnalyzer& analyzer, const ByteView& view, size_t frameBytes) {
+    stopFrameAnalysis(analyzer);
+    analyzer.cancel = false;
+    analyzer.finished = false;
+    analyzer.framesDone = 0;
+    analyzer.frameCount = frameBytes ? view.size() / frameBytes : 0;
+    analyzer.worker = std::thread([&analyzer, view, frameBytes]() {
+        ThreadPool pool(ThreadPool::defaultThreadCount());
+        analyzeFrames(pool, view, frameBytes, analyzer.result, &analyzer.cancel, &analyzer.framesDone);
+        analyzer.finished.store(true, std::memory_order_release);
+    });
+}
+
+// True once the scan is done; the result is moved into `analysis` on that call.
+static inline bool pollFrameAnalysis(FrameAnalyzer& analyzer, FrameAnalysis& analysis) {
+    if (!analyzer.worker.joinable() || !analyzer.finished.load(std::memory_order_acquire))
+        return false;
+    analyzer.worker.join();
+    analysis = std::move(analyzer.result);
+    analyzer.result = FrameAnalysis();
+    return !analysis.empty();
+}
+
+static inline bool frameAnalysisRunning(const FrameAnalyzer& analyzer) {
+    return analyzer.worker.joinable();
+}
@@ -0,0 +1,220 @@
+#pragma once
+// Frame-by-frame comparison of two byte sources: two files, or one file against itself further on.
+// A background pass counts the changed bytes of every frame on a work-stealing ThreadPool (as
+// FrameAnalysis does) into one 32-bit count per frame, so jumping to the next differing frame is a
+// scan of that index (milliseconds even for multi-GB images) and never reads the files again.
+// Counting compares 16 bytes per instruction with SSE2 or NEON (Simd.h) and falls back to 64-bit
+// words, eight byte compares per XOR, elsewhere and for the tail; bench diff/count-* times both.
+#include "MappedFile.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+const size_t DIFF_CHUNK_BYTES = 4 << 20;          // work per pool task
+
+// How compare mode draws a frame.
+enum DiffDisplay {
+    DIFF_XOR = 0,       // a ^ b: which bits changed
+    DIFF_ABSOLUTE,      // |a - b|: how far values moved
+    DIFF_SOURCE,        // the first source unchanged
+    DIFF_DISPLAY_COUNT
+};
+
+static inline const char* diffDisplayName(DiffDisplay display) {
+    switch (display) {
+    case DIFF_XOR: return "XOR";
+    case DIFF_ABSOLUTE: return "Abs Diff";
+    case DIFF_SOURCE: return "Source";
+    default: return "Unknown";
+    }
+}
+
+// Number of positions where `a` and `b` differ, eight bytes per 64-bit word.
+static inline size_t countChangedBytesSwar(const unsigned char* a, const unsigned char* b, size_t length) {
+    const uint64_t low7 = 0x7F7F7F7F7F7F7F7FULL;
+    const uint64_t ones = 0x0101010101010101ULL;
+    const uint64_t evenBytes = 0x00FF00FF00FF00FFULL;
+    size_t changed = 0, i = 0;
+    while (length - i >= 8) {
+        // One counter per byte lane, folded before any can pass 255.
+        size_t words = (length - i) / 8;
+        if (words > 255)
+            words = 255;
+        uint64_t counters = 0;
+        for (size_t w = 0; w < words; w++, i += 8) {
+            uint64_t x, y;
+            std::memcpy(&x, a + i, 8);
+            std::memcpy(&y, b + i, 8);
+            uint64_t d = x ^ y;
+            // Bit 7 of each lane is set when any bit of that byte of d is.
+            counters += ((((d & low7) + low7) | d) >> 7) & ones;
+        }
+        uint64_t pairs = (counters & evenBytes) + ((counters >> 8) & evenBytes);
+        changed += static_cast<size_t>((pairs * 0x0001000100010001ULL) >> 48);
+    }
+    for (; i < length; i++)
+        changed += a[i] != b[i];
+    return changed;
+}
+
+// Number of positions where `a` and `b` differ. Each vector lane counts its equal bytes (a compare
+// yields -1 per match) and the lanes are summed before any can pass 255.
+static inline size_t countChangedBytes(const unsigned char* a, const unsigned char* b, size_t length) {
+    size_t changed = 0, i = 0;
+#if defined(BWF_SSE2)
+    while (length - i >= 16) {
+        size_t vectors = (length - i) / 16;
+        if (vectors > 255)
+            vectors = 255;
+        __m128i equal = _mm_setzero_si128();
+        for (size_t v = 0; v < vectors; v++, i += 16) {
+            __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i));
+            __m128i y = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i));
+            equal = _mm_sub_epi8(equal, _mm_cmpeq_epi8(x, y));
+        }
+        __m128i sums = _mm_sad_epu8(equal, _mm_setzero_si128());
+        size_t same = static_cast<size_t>(_mm_cvtsi128_si32(sums)) +
+            static_cast<size_t>(_mm_cvtsi128_si32(_mm_srli_si128(sums, 8)));
+        changed += vectors * 16 - same;
+    }
+#elif defined(BWF_NEON)
+    while (length - i >= 16) {
+        size_t vectors = (length - i) / 16;
+        if (vectors > 255)
+            vectors = 255;
+        uint8x16_t equal = vdupq_n_u8(0);
+        for (size_t v = 0; v < vectors; v++, i += 16)
+            equal = vsubq_u8(equal, vceqq_u8(vld1q_u8(a + i), vld1q_u8(b + i)));
+        uint64x2_t sums = vpaddlq_u32(vpaddlq_u16(vpaddlq_u8(equal)));
+        size_t same = static_cast<size_t>(vgetq_lane_u64(sums, 0) + vgetq_lane_u64(sums, 1));
+        changed += vectors * 16 - same;
+    }
+#endif
+    return changed + countChangedBytesSwar(a + i, b + i, length - i);
+}
+
+// The bytes compare mode shows for `length` bytes of the two sources.
+static inline void diffBytes(DiffDisplay display, const unsigned char* a, const unsigned char* b, size_t length,
+    unsigned char* dst) {
+    if (display == DIFF_XOR) {
+        for (size_t i = 0; i < length; i++)
+            dst[i] = static_cast<unsigned char>(a[i] ^ b[i]);
+    }
+    else if (display == DIFF_ABSOLUTE) {
+        for (size_t i = 0; i < length; i++)
+            dst[i] = static_cast<unsigned char>(a[i] > b[i] ? a[i] - b[i] : b[i] - a[i]);
+    }
+    else {
+        std::memcpy(dst, a, length);
+    }
+}
+
+// --- Changed-byte index ---
+struct FrameDiffIndex {
+    size_t frameBytes = 0;
+    std::vector<uint32_t> changed;      // per frame both sources hold whole
+
+    bool empty() const { return changed.empty(); }
+};
+
+// Returns false if cancelled; `framesDone` (optional) counts progress.
+static inline bool buildFrameDiffIndex(ThreadPool& pool, const ByteView& a, const ByteView& b, size_t frameBytes,
+    FrameDiffIndex& index, const std::atomic<bool>* cancel = nullptr, std::atomic<size_t>* framesDone = nullptr) {
+    index = FrameDiffIndex();
+    index.frameBytes = frameBytes;
+    if (frameBytes == 0)
+        return true;
+    size_t frameCount = (a.size() < b.size() ? a.size() : b.size()) / frameBytes;
+    index.changed.resize(frameCount);
+    size_t grain = DIFF_CHUNK_BYTES / frameBytes;
+    if (grain == 0)
+        grain = 1;
+    std::atomic<bool> cancelled(false);
+    pool.parallelFor(frameCount, grain, [&](size_t begin, size_t end) {
+        if (cancel && cancel->load(std::memory_order_relaxed)) {
+            cancelled.store(true, std::memory_order_relaxed);
+            return;
+        }
+        for (size_t frame = begin; frame < end; frame++) {
+            size_t offset = frame * frameBytes;
+            index.changed[frame] = static_cast<uint32_t>(countChangedBytes(a.data() + offset, b.data() + offset, frameBytes));
+        }
+        if (framesDone)
+            framesDone->fetch_add(end - begin, std::memory_order_relaxed);
+    });
+    if (cancelled.load()) {
+        index = FrameDiffIndex();
+        return false;
+    }
+    return true;
+}
+
+// Next (direction > 0) or previous frame after `from` with any changed byte, skipping the rest of
+// the differing run `from` is in, so repeated jumps step from one changed region to the next.
+// Wraps around; -1 if the sources match everywhere.
+static inline long long findChangedFrame(const FrameDiffIndex& index, size_t from, int direction) {
+    const size_t count = index.changed.size();
+    if (count == 0)
+        return -1;
+    from %= count;
+    bool inRegion = index.changed[from] != 0;
+    size_t frame = from;
+    for (size_t step = 1; step < count; step++) {
+        frame = (direction > 0) ? (frame + 1) % count : (frame + count - 1) % count;
+        bool match = index.changed[frame] != 0;
+        if (match && !inRegion)
+            return static_cast<long long>(frame);
+        inRegion = inRegion && match;
+    }
+    return index.changed[from] != 0 ? static_cast<long long>(from) : -1;
+}
+
+// --- Background builder ---
+// Same lifecycle as FrameAnalyzer: both views must stay mapped until it is stopped or polled done.
+struct FrameDiffer {
+    std::thread worker;
+    std::atomic<bool> cancel{ false };
+    std::atomic<bool> finished{ false };
+    std::atomic<size_t> framesDone{ 0 };
+    size_t frameCount = 0;
+    FrameDiffIndex result;
+};
+
+static inline void stopFrameDiff(FrameDiffer& differ) {
+    if (differ.worker.joinable()) {
+        differ.cancel = true;
+        differ.worker.join();
+    }
+    differ.result = FrameDiffIndex();
+}
+
+static inline void startFrameDiff(FrameDiffer& differ, const ByteView& a, const ByteView& b, size_t frameBytes) {
+    stopFrameDiff(differ);
+    differ.cancel = false;
+    differ.finished = false;
+    differ.framesDone = 0;
+    differ.frameCount = frameBytes ? (a.size() < b.size() ? a.size() : b.size()) / frameBytes : 0;
+    differ.worker = std::thread([&differ, a, b, frameBytes]() {
+        ThreadPool pool(ThreadPool::defaultThreadCount());
+        buildFrameDiffIndex(pool, a, b, frameBytes, differ.result, &differ.cancel, &differ.framesDone);
+        differ.finished.store(true, std::memory_order_release);
+    });
+}
+
+// True once the pass is done; the result is moved into `index` on that call.
+static inline bool pollFrameDiff(FrameDiffer& differ, FrameDiffIndex& index) {
+    if (!differ.worker.joinable() || !differ.finished.load(std::memory_order_acquire))
+        return false;
+    differ.worker.join();
+    index = std::move(differ.result);
+    differ.result = FrameDiffIndex();
+    return !index.empty();
+}
+
+static inline bool frameDiffRunning(const FrameDiffer& differ) {
+    return differ.worker.joinable();
+}
@@ -0,0 +1,88 @@
+#pragma once
+// Frame geometry (bytes per row x rows per frame) chosen at runtime.
+// The presets are the layouts the forked builds under burn/ used to hard-code, so one binary
+// covers all of them; any other WxH can be given on the command line. The pixel format decides
+// how many bytes a frame of that size takes.
+#include "PixelFormat.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+struct FrameGeometry {
+    int width = 64;
+    int height = 128;
+    int scale = 4;             // suggested window scale for this size
+    const char* name = "Player";
+    PixelFormat pixelFormat = PIXEL_INDEXED8;
+};
+
+static inline size_t frameByteCount(const FrameGeometry& geometry) {
+    return pixelFrameBytes(geometry.pixelFormat, geometry.width, geometry.height);
+}
+
+// --- Presets (cycled with G) ---
+static inline int geometryPresetCount(void) {
+    return 5;
+}
+
+static inline FrameGeometry geometryPreset(int index) {
+    static const FrameGeometry presets[] = {
+        { 64, 128, 4, "Player" },          // OpenBinaryWaterFall.cpp
+        { 64, 64, 8, "Square" },           // burn/binaryWaterfall.cpp
+        { 128, 72, 8, "Rainbow" },         // burn/Rainbow.cpp
+        { 455, 256, 4, "Wide" },           // burn/OPENBinarywaterFALL.cpp
+        { 910, 512, 2, "Big" }             // burn/bigMode.cpp
+    };
+    int count = geometryPresetCount();
+    index %= count;
+    if (index < 0)
+        index += count;
+    return presets[index];
+}
+
+// Index of the preset with this size, or -1 for a custom geometry.
+static inline int findGeometryPreset(int width, int height) {
+    for (int i = 0; i < geometryPresetCount(); i++) {
+        FrameGeometry preset = geometryPreset(i);
+        if (preset.width == width && preset.height == height)
+            return i;
+    }
+    return -1;
+}
+
+// Accepts a preset name (case-insensitive) or "WxH". Custom sizes keep `geometry.scale`; every
+// size keeps `geometry.pixelFormat`.
+static inline bool parseFrameGeometry(const char* text, FrameGeometry& geometry) {
+    const PixelFormat pixelFormat = geometry.pixelFormat;
+    for (int i = 0; i < geometryPresetCount(); i++) {
+        FrameGeometry preset = geometryPreset(i);
+        size_t length = std::strlen(preset.name);
+        bool match = std::strlen(text) == length;
+        for (size_t c = 0; match && c < length; c++) {
+            char a = text[c], b = preset.name[c];
+            if (a >= 'A' && a <= 'Z') a = static_cast<char>(a - 'A' + 'a');
+            if (b >= 'A' && b <= 'Z') b = static_cast<char>(b - 'A' + 'a');
+            match = (a == b);
+        }
+        if (match) {
+            geometry = preset;
+            geometry.pixelFormat = pixelFormat;
+            return true;
+        }
+    }
+    int width = 0, height = 0;
+    char trailing = 0;
+    if (std::sscanf(text, "%dx%d%c", &width, &height, &trailing) != 2 || width <= 0 || height <= 0)
+        return false;
+    int preset = findGeometryPreset(width, height);
+    if (preset >= 0) {
+        geometry = geometryPreset(preset);
+        geometry.pixelFormat = pixelFormat;
+        return true;
+    }
+    geometry.width = width;
+    geometry.height = height;
+    geometry.name = "Custom";
+    return true;
+}
@@ -0,0 +1,1446 @@
+#pragma once
+// Frame renderers for the tiled waterfall view.
+// renderTilesImmediate is the original per-pixel GL_QUADS path and is kept as a fallback;
+// TextureRenderer uploads each visible frame once into a GL_R8 atlas and lets a fragment
+// shader do the palette lookup and tiling, so a redraw costs one upload per frame shown.
+// TileArrayRenderer keeps frames resident in a texture array and draws the grid as one
+// instanced call, so a redraw only uploads the frames that scrolled into view.
+// WaterfallRenderer shows the file as one continuous strip of rows scrolled by a shader offset,
+// streaming new rows into a resident ring only at the leading edge.
+// All colorize through the shared PaletteLUT (direct index on the CPU, 1D texture on the GPU).
+// The tile renderers also show the other pixel formats: frames are uploaded as raw bytes,
+// frameWidth per texture row, and the fragment shader unpacks them (PixelFormat.h).
+// renderOverviewBar draws the whole-file scrub bar from the overview index, ThumbnailAtlas the
+// thumbnail strip (Thumbnails.h), SpectrogramRenderer the scrolling spectrum of the audio output,
+// and ScopeRenderer the trace of the bytes being played (Scope.h).
+#include "GLLoader.h"
+#include "OverviewIndex.h"
+#include "Palette.h"
+#include "PatternSearch.h"
+#include "PixelFormat.h"
+#include "Spectrogram.h"
+#include "Thumbnails.h"
+#include <algorithm>
+#include <cstddef>
+#include <unordered_map>
+#include <vector>
+
+// --- Tiling geometry shared by every backend ---
+// Each frame is drawn at a fixed pixel size (frameWidth*scale by frameHeight*scale). The number
+// of columns and rows uses ceiling division so the entire window is covered. A frame's bytes are
+// stored as storageRows texture rows of frameWidth bytes (frameHeight rows for Indexed8).
+struct TileLayout {
+    int windowWidth;
+    int windowHeight;
+    int frameWidth;
+    int frameHeight;
+    int scale;
+    int columns;
+    int rows;
+    PixelFormat pixelFormat;
+    int storageRows;
+    size_t frameBytes;
+};
+
+static inline TileLayout computeTileLayout(int windowWidth, int windowHeight, int frameWidth, int frameHeight, int scale,
+    PixelFormat pixelFormat = PIXEL_INDEXED8) {
+    TileLayout layout;
+    layout.windowWidth = windowWidth;
+    layout.windowHeight = windowHeight;
+    layout.frameWidth = frameWidth;
+    layout.frameHeight = frameHeight;
+    layout.scale = scale;
+    layout.pixelFormat = pixelFormat;
+    layout.storageRows = pixelStorageRows(pixelFormat, frameHeight);
+    layout.frameBytes = pixelFrameBytes(pixelFormat, frameWidth, frameHeight);
+    int framePixelWidth = frameWidth * scale;
+    int framePixelHeight = frameHeight * scale;
+    layout.columns = (windowWidth + framePixelWidth - 1) / framePixelWidth;
+    layout.rows = (windowHeight + framePixelHeight - 1) / framePixelHeight;
+    return layout;
+}
+
+// Setup orthographic projection matching window size (origin at top-left).
+static inline void setupPixelProjection(int windowWidth, int windowHeight) {
+    glViewport(0, 0, windowWidth, windowHeight);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(0, windowWidth, windowHeight, 0, -1, 1);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+}
+
+// --- Immediate-mode renderer (one quad per byte) ---
+static inline void renderTilesImmediate(const TileLayout& layout, const unsigned char* data,
+    size_t startFrame, size_t totalFrames, const PaletteLUT& palette) {
+    const int frameWidth = layout.frameWidth;
+    const int frameHeight = layout.frameHeight;
+    const int scale = layout.scale;
+    glBegin(GL_QUADS);
+    for (int r = 0; r < layout.rows; r++) {
+        for (int c = 0; c < layout.columns; c++) {
+            // Compute frame index (wrap around if needed).
+            size_t frameIndex = (startFrame + r * layout.columns + c) % totalFrames;
+            const unsigned char* frame = data + frameIndex * layout.frameBytes;
+            // Compute top-left corner for this frame.
+            int offsetX = c * frameWidth * scale;
+            int offsetY = r * frameHeight * scale;
+            for (int y = 0; y < frameHeight; y++) {
+                for (int x = 0; x < frameWidth; x++) {
+                    if (layout.pixelFormat == PIXEL_INDEXED8) {
+                        glColor4ubv(palette.rgba[frame[y * frameWidth + x]]);
+                    }
+                    else {
+                        unsigned char rgba[4];
+                        unpackPixel(layout.pixelFormat, frame, frameWidth, frameHeight, x, y, palette, rgba);
+                        glColor4ubv(rgba);
+                    }
+                    float x1 = offsetX + x * scale;
+                    float y1 = offsetY + y * scale;
+                    float x2 = offsetX + (x + 1) * scale;
+                    float y2 = offsetY + (y + 1) * scale;
+                    glVertex2f(x1, y1);
+                    glVertex2f(x2, y1);
+                    glVertex2f(x2, y2);
+                    glVertex2f(x1, y2);
+                }
+            }
+        }
+    }
+    glEnd();
+}
+
+// --- Texture-upload renderer ---
+// Visible frames are packed into a GL_R8 atlas (atlasColumns frames per texture row). The shader
+// maps every window pixel to (cell, texel), picks the atlas slot for that cell and unpacks the
+// pixel from the slot's bytes, so the whole grid is one quad regardless of window size or scale.
+// A slot is frameWidth x storageRows texels.
+static const char* TEXTURE_RENDERER_VS =
+    "#version 130\n"
+    "void main() {\n"
+    "    gl_Position = gl_ModelViewProjectionMatrix * gl_Vertex;\n"
+    "}\n";
+
+static const char* TEXTURE_RENDERER_FS =
+    "#version 130\n"
+    "uniform sampler2D uFrames;\n"
+    "uniform sampler1D uPalette;\n"
+    "uniform ivec2 uFrameSize;\n"
+    "uniform int uScale;\n"
+    "uniform int uColumns;\n"
+    "uniform int uSlots;\n"
+    "uniform int uAtlasColumns;\n"
+    "uniform int uWindowHeight;\n"
+    "uniform int uStorageRows;\n"
+    "ivec2 slotOrigin;\n"
+    "int fetchByte(int index) {\n"
+    "    ivec2 atlas = slotOrigin + ivec2(index % uFrameSize.x, index / uFrameSize.x);\n"
+    "    return int(texelFetch(uFrames, atlas, 0).r * 255.0 + 0.5);\n"
+    "}\n"
+    BWF_PIXEL_UNPACK_GLSL
+    "void main() {\n"
+    "    ivec2 p = ivec2(gl_FragCoord.xy);\n"
+    "    p.y = uWindowHeight - 1 - p.y;\n"
+    "    ivec2 cell = p / (uFrameSize * uScale);\n"
+    "    ivec2 texel = p / uScale - cell * uFrameSize;\n"
+    "    int slot = (cell.y * uColumns + cell.x) % uSlots;\n"
+    "    slotOrigin = ivec2(slot % uAtlasColumns, slot / uAtlasColumns) * ivec2(uFrameSize.x, uStorageRows);\n"
+    "    gl_FragColor = unpackPixel(texel, uFrameSize);\n"
+    "}\n";
+
+// --- Palette texture ---
+// 256x1 RGBA8 lookup texture sampled with texelFetch(byte value).
+static inline GLuint createPaletteTexture(void) {
+    GLuint texture = 0;
+    glGenTextures(1, &texture);
+    glBindTexture(GL_TEXTURE_1D, texture);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_RGBA8, 256, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    return texture;
+}
+
+static inline void updatePaletteTexture(GLuint texture, const PaletteLUT& palette) {
+    glBindTexture(GL_TEXTURE_1D, texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage1D(GL_TEXTURE_1D, 0, 0, 256, GL_RGBA, GL_UNSIGNED_BYTE, palette.rgba);
+}
+
+struct TextureRenderer {
+    bool ready = false;
+    GLuint program = 0;
+    GLuint texture = 0;
+    GLuint paletteTexture = 0;
+    const PaletteLUT* uploadedPalette = nullptr;
+    GLint maxTextureSize = 0;
+    // Current atlas allocation.
+    int frameWidth = 0;
+    int frameHeight = 0;
+    int atlasColumns = 0;
+    int atlasRows = 0;
+    // Uniform locations.
+    GLint locFrameSize = -1;
+    GLint locScale = -1;
+    GLint locColumns = -1;
+    GLint locSlots = -1;
+    GLint locAtlasColumns = -1;
+    GLint locWindowHeight = -1;
+    GLint locStorageRows = -1;
+    GLint locPixelFormat = -1;
+};
+
+// Needs a GL 3.0 context (GL_R8 textures, texelFetch). Leaves renderer.ready false otherwise.
+static inline bool initTextureRenderer(TextureRenderer& renderer) {
+    renderer.ready = false;
+    if (glContextMajorVersion() < 3 || !loadGLFunctions()) {
+        std::cerr << "OpenGL 3.0 not available; using immediate-mode renderer." << std::endl;
+        return false;
+    }
+    renderer.program = buildShaderProgram(TEXTURE_RENDERER_VS, TEXTURE_RENDERER_FS, "texture renderer");
+    if (!renderer.program)
+        return false;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &renderer.maxTextureSize);
+    renderer.locFrameSize = glGetUniformLocation(renderer.program, "uFrameSize");
+    renderer.locScale = glGetUniformLocation(renderer.program, "uScale");
+    renderer.locColumns = glGetUniformLocation(renderer.program, "uColumns");
+    renderer.locSlots = glGetUniformLocation(renderer.program, "uSlots");
+    renderer.locAtlasColumns = glGetUniformLocation(renderer.program, "uAtlasColumns");
+    renderer.locWindowHeight = glGetUniformLocation(renderer.program, "uWindowHeight");
+    renderer.locStorageRows = glGetUniformLocation(renderer.program, "uStorageRows");
+    renderer.locPixelFormat = glGetUniformLocation(renderer.program, "uPixelFormat");
+    glUseProgram(renderer.program);
+    glUniform1i(glGetUniformLocation(renderer.program, "uFrames"), 0);
+    glUniform1i(glGetUniformLocation(renderer.program, "uPalette"), 1);
+    glUseProgram(0);
+    glGenTextures(1, &renderer.texture);
+    renderer.paletteTexture = createPaletteTexture();
+    renderer.ready = true;
+    return true;
+}
+
+static inline void destroyTextureRenderer(TextureRenderer& renderer) {
+    if (renderer.texture)
+        glDeleteTextures(1, &renderer.texture);
+    if (renderer.paletteTexture)
+        glDeleteTextures(1, &renderer.paletteTexture);
+    if (renderer.program)
+        glDeleteProgram(renderer.program);
+    renderer = TextureRenderer();
+}
+
+// Grow the atlas so it holds at least `slots` frames. Returns false if that exceeds the
+// driver's texture size limit (caller falls back to the immediate renderer).
+static inline bool reserveAtlasSlots(TextureRenderer& renderer, int frameWidth, int frameHeight, int slots) {
+    if (renderer.frameWidth == frameWidth && renderer.frameHeight == frameHeight &&
+        renderer.atlasColumns * renderer.atlasRows >= slots)
+        return true;
+    int atlasColumns = renderer.maxTextureSize / frameWidth;
+    if (atlasColumns < 1)
+        return false;
+    if (atlasColumns > slots)
+        atlasColumns = slots;
+    int atlasRows = (slots + atlasColumns - 1) / atlasColumns;
+    if (atlasRows * frameHeight > renderer.maxTextureSize)
+        return false;
+    glBindTexture(GL_TEXTURE_2D, renderer.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, atlasColumns * frameWidth, atlasRows * frameHeight, 0,
+        GL_RED, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    renderer.frameWidth = frameWidth;
+    renderer.frameHeight = frameHeight;
+    renderer.atlasColumns = atlasColumns;
+    renderer.atlasRows = atlasRows;
+    return true;
+}
+
+// Upload the distinct visible frames and draw the grid. Cells beyond totalFrames repeat, so
+// only min(cells, totalFrames) frames are ever uploaded.
+static inline bool renderTilesTexture(TextureRenderer& renderer, const TileLayout& layout,
+    const unsigned char* data, size_t startFrame, size_t totalFrames, const PaletteLUT& palette) {
+    size_t cells = static_cast<size_t>(layout.columns) * static_cast<size_t>(layout.rows);
+    int slots = static_cast<int>(cells < totalFrames ? cells : totalFrames);
+    if (!renderer.ready || slots <= 0 ||
+        !reserveAtlasSlots(renderer, layout.frameWidth, layout.storageRows, slots))
+        return false;
+    glActiveTexture(GL_TEXTURE1);
+    if (renderer.uploadedPalette != &palette) {
+        updatePaletteTexture(renderer.paletteTexture, palette);
+        renderer.uploadedPalette = &palette;
+    }
+    glBindTexture(GL_TEXTURE_1D, renderer.paletteTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, renderer.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (int slot = 0; slot < slots; slot++) {
+        size_t frameIndex = (startFrame + slot) % totalFrames;
+        glTexSubImage2D(GL_TEXTURE_2D, 0,
+            (slot % renderer.atlasColumns) * layout.frameWidth,
+            (slot / renderer.atlasColumns) * layout.storageRows,
+            layout.frameWidth, layout.storageRows, GL_RED, GL_UNSIGNED_BYTE,
+            data + frameIndex * layout.frameBytes);
+    }
+    glUseProgram(renderer.program);
+    glUniform2i(renderer.locFrameSize, layout.frameWidth, layout.frameHeight);
+    glUniform1i(renderer.locScale, layout.scale);
+    glUniform1i(renderer.locColumns, layout.columns);
+    glUniform1i(renderer.locSlots, slots);
+    glUniform1i(renderer.locAtlasColumns, renderer.atlasColumns);
+    glUniform1i(renderer.locWindowHeight, layout.windowHeight);
+    glUniform1i(renderer.locStorageRows, layout.storageRows);
+    glUniform1i(renderer.locPixelFormat, layout.pixelFormat);
+    glBegin(GL_QUADS);
+    glVertex2f(0.0f, 0.0f);
+    glVertex2f(static_cast<float>(layout.windowWidth), 0.0f);
+    glVertex2f(static_cast<float>(layout.windowWidth), static_cast<float>(layout.windowHeight));
+    glVertex2f(0.0f, static_cast<float>(layout.windowHeight));
+    glEnd();
+    glUseProgram(0);
+    return true;
+}
+
+// --- Texture-array renderer (instanced grid, resident frames) ---
+// Each distinct visible frame lives in one layer of a GL_TEXTURE_2D_ARRAY and stays resident
+// across redraws, so scrolling only uploads the frames that came into view. The grid is a single
+// attribute-less instanced draw: one instance per cell, gl_VertexID picks the quad corner, and a
+// small integer texture maps each slot to its layer. Needs GL 3.1; otherwise the atlas renderer
+// above is used.
+static const char* TILE_ARRAY_RENDERER_VS =
+    "#version 140\n"
+    "uniform ivec2 uFrameSize;\n"
+    "uniform int uScale;\n"
+    "uniform int uColumns;\n"
+    "uniform int uSlots;\n"
+    "uniform ivec2 uWindowSize;\n"
+    "uniform isampler1D uSlotLayers;\n"
+    "flat out int vLayer;\n"
+    "out vec2 vTexel;\n"
+    "void main() {\n"
+    "    ivec2 corner = ivec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+    "    ivec2 cell = ivec2(gl_InstanceID % uColumns, gl_InstanceID / uColumns);\n"
+    "    vec2 pixel = vec2((cell + corner) * uFrameSize * uScale);\n"
+    "    vLayer = texelFetch(uSlotLayers, gl_InstanceID % uSlots, 0).r;\n"
+    "    vTexel = vec2(corner * uFrameSize);\n"
+    "    gl_Position = vec4(pixel.x / float(uWindowSize.x) * 2.0 - 1.0,\n"
+    "                       1.0 - pixel.y / float(uWindowSize.y) * 2.0, 0.0, 1.0);\n"
+    "}\n";
+
+static const char* TILE_ARRAY_RENDERER_FS =
+    "#version 140\n"
+    "uniform sampler2DArray uFrames;\n"
+    "uniform sampler1D uPalette;\n"
+    "uniform ivec2 uFrameSize;\n"
+    "flat in int vLayer;\n"
+    "in vec2 vTexel;\n"
+    "out vec4 fragColor;\n"
+    "int fetchByte(int index) {\n"
+    "    ivec3 texel = ivec3(index % uFrameSize.x, index / uFrameSize.x, vLayer);\n"
+    "    return int(texelFetch(uFrames, texel, 0).r * 255.0 + 0.5);\n"
+    "}\n"
+    BWF_PIXEL_UNPACK_GLSL
+    "void main() {\n"
+    "    fragColor = unpackPixel(ivec2(vTexel), uFrameSize);\n"
+    "}\n";
+
+struct TileArrayRenderer {
+    bool ready = false;
+    GLuint program = 0;
+    GLuint frameArray = 0;
+    GLuint slotTexture = 0;
+    GLuint paletteTexture = 0;
+    const PaletteLUT* uploadedPalette = nullptr;
+    GLint maxLayers = 0;
+    GLint maxTextureSize = 0;
+    // Current allocation and what each layer holds.
+    int frameWidth = 0;
+    int frameHeight = 0;
+    int layers = 0;
+    const unsigned char* residentData = nullptr;
+    uint32_t residentGeneration = 0;
+    size_t residentFrameBytes = 0;
+    std::vector<size_t> layerFrame;              // frame index per layer (NO_FRAME if empty)
+    std::vector<unsigned> layerStamp;            // redraw that last showed the layer
+    std::unordered_map<size_t, int> frameLayer;  // frame index -> layer
+    std::vector<int> slotLayers;                 // per redraw: slot -> layer
+    unsigned stamp = 0;
+    bool inPass = false;                        // between beginTilePass and endTilePass
+    int passSlots = 0;                          // slots drawn so far in the pass
+    int lastUploads = 0;                        // frames uploaded by the last redraw
+    // Uniform locations.
+    GLint locFrameSize = -1;
+    GLint locScale = -1;
+    GLint locColumns = -1;
+    GLint locSlots = -1;
+    GLint locWindowSize = -1;
+    GLint locPixelFormat = -1;
+};
+
+static const size_t NO_FRAME = static_cast<size_t>(-1);
+
+// Needs GL 3.1 (instanced draws, gl_InstanceID, integer textures). Leaves renderer.ready false otherwise.
+static inline bool initTileArrayRenderer(TileArrayRenderer& renderer) {
+    renderer.ready = false;
+    if (!glContextVersionAtLeast(3, 1) || !loadGLFunctions() || !loadGL31Functions()) {
+        std::cerr << "OpenGL 3.1 not available; using the atlas renderer for tiling." << std::endl;
+        return false;
+    }
+    renderer.program = buildShaderProgram(TILE_ARRAY_RENDERER_VS, TILE_ARRAY_RENDERER_FS, "tile array renderer");
+    if (!renderer.program)
+        return false;
+    glGetIntegerv(GL_MAX_ARRAY_TEXTURE_LAYERS, &renderer.maxLayers);
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &renderer.maxTextureSize);
+    renderer.locFrameSize = glGetUniformLocation(renderer.program, "uFrameSize");
+    renderer.locScale = glGetUniformLocation(renderer.program, "uScale");
+    renderer.locColumns = glGetUniformLocation(renderer.program, "uColumns");
+    renderer.locSlots = glGetUniformLocation(renderer.program, "uSlots");
+    renderer.locWindowSize = glGetUniformLocation(renderer.program, "uWindowSize");
+    renderer.locPixelFormat = glGetUniformLocation(renderer.program, "uPixelFormat");
+    glUseProgram(renderer.program);
+    glUniform1i(glGetUniformLocation(renderer.program, "uFrames"), 0);
+    glUniform1i(glGetUniformLocation(renderer.program, "uPalette"), 1);
+    glUniform1i(glGetUniformLocation(renderer.program, "uSlotLayers"), 2);
+    glUseProgram(0);
+    glGenTextures(1, &renderer.frameArray);
+    glGenTextures(1, &renderer.slotTexture);
+    renderer.paletteTexture = createPaletteTexture();
+    renderer.ready = true;
+    return true;
+}
+
+static inline void destroyTileArrayRenderer(TileArrayRenderer& renderer) {
+    if (renderer.frameArray)
+        glDeleteTextures(1, &renderer.frameArray);
+    if (renderer.slotTexture)
+        glDeleteTextures(1, &renderer.slotTexture);
+    if (renderer.paletteTexture)
+        glDeleteTextures(1, &renderer.paletteTexture);
+    if (renderer.program)
+        glDeleteProgram(renderer.program);
+    renderer = TileArrayRenderer();
+}
+
+// Forget every resident frame (new file or geometry); the layers are refilled on the next redraw.
+static inline void resetTileResidency(TileArrayRenderer& renderer) {
+    renderer.layerFrame.assign(renderer.layers, NO_FRAME);
+    renderer.layerStamp.assign(renderer.layers, 0);
+    renderer.frameLayer.clear();
+}
+
+// Forget the resident frames that overlap bytes [first, end), which a live stream has rewritten.
+// Their layers go first the next time one is needed.
+static inline void forgetTileBytes(TileArrayRenderer& renderer, size_t first, size_t end) {
+    const size_t frameBytes = renderer.residentFrameBytes;
+    if (frameBytes == 0)
+        return;
+    for (int layer = 0; layer < static_cast<int>(renderer.layerFrame.size()); layer++) {
+        size_t frame = renderer.layerFrame[layer];
+        if (frame == NO_FRAME || frame * frameBytes >= end || (frame + 1) * frameBytes <= first)
+            continue;
+        renderer.frameLayer.erase(frame);
+        renderer.layerFrame[layer] = NO_FRAME;
+        renderer.layerStamp[layer] = 0;
+    }
+}
+
+// Make room for `slots` distinct frames plus some slack, so frames that scroll out and straight
+// back (boomerang, small loops) are still resident. Returns false if the driver cannot hold the
+// grid, in which case the caller falls back to the atlas renderer.
+static inline bool reserveTileLayers(TileArrayRenderer& renderer, int frameWidth, int frameHeight,
+    int slots, size_t totalFrames) {
+    if (slots > renderer.maxLayers || slots > renderer.maxTextureSize ||
+        frameWidth > renderer.maxTextureSize || frameHeight > renderer.maxTextureSize)
+        return false;
+    if (renderer.frameWidth == frameWidth && renderer.frameHeight == frameHeight && renderer.layers >= slots)
+        return true;
+    size_t wanted = static_cast<size_t>(slots) * 2;
+    if (wanted > totalFrames)
+        wanted = totalFrames;
+    if (wanted > static_cast<size_t>(renderer.maxLayers))
+        wanted = static_cast<size_t>(renderer.maxLayers);
+    // Keep the array under 256 MB; it still must hold one full grid.
+    size_t frameBytes = static_cast<size_t>(frameWidth) * frameHeight;
+    size_t budget = (256u << 20) / frameBytes;
+    if (wanted > budget)
+        wanted = budget;
+    if (wanted < static_cast<size_t>(slots))
+        wanted = static_cast<size_t>(slots);
+    renderer.layers = static_cast<int>(wanted);
+    renderer.frameWidth = frameWidth;
+    renderer.frameHeight = frameHeight;
+    glBindTexture(GL_TEXTURE_2D_ARRAY, renderer.frameArray);
+    glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, GL_R8, frameWidth, frameHeight, renderer.layers, 0,
+        GL_RED, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    resetTileResidency(renderer);
+    return true;
+}
+
+// Several grids drawn between these (one per window of a shared context group) count as one
+// redraw: they share a stamp, so none evicts a frame another one shows in the same pass, and the
+// array is sized for all of them. A frame visible in several grids is uploaded once.
+static inline void beginTilePass(TileArrayRenderer& renderer) {
+    renderer.stamp++;
+    renderer.inPass = true;
+    renderer.passSlots = 0;
+}
+
+static inline void endTilePass(TileArrayRenderer& renderer) {
+    renderer.inPass = false;
+}
+
+// Draw the grid. Visible frames already resident are reused; missing ones replace the layers
+// that have gone longest without being shown. Cells beyond totalFrames repeat, so at most
+// min(cells, totalFrames) frames are resident at once, and each is uploaded once. `generation`
+// tells sources apart where `data` cannot: a freed mapping's address is often reused by the next.
+static inline bool renderTilesArray(TileArrayRenderer& renderer, const TileLayout& layout,
+    const unsigned char* data, uint32_t generation, size_t startFrame, size_t totalFrames, const PaletteLUT& palette) {
+    size_t cells = static_cast<size_t>(layout.columns) * static_cast<size_t>(layout.rows);
+    int slots = static_cast<int>(cells < totalFrames ? cells : totalFrames);
+    if (!renderer.ready || slots <= 0)
+        return false;
+    // Grids of one pass never need more layers than there are distinct frames.
+    int reserveSlots = renderer.inPass ? renderer.passSlots + slots : slots;
+    if (static_cast<size_t>(reserveSlots) > totalFrames)
+        reserveSlots = static_cast<int>(totalFrames);
+    if (!reserveTileLayers(renderer, layout.frameWidth, layout.storageRows, reserveSlots, totalFrames))
+        return false;
+    if (renderer.residentData != data || renderer.residentGeneration != generation ||
+        renderer.residentFrameBytes != layout.frameBytes) {
+        resetTileResidency(renderer);
+        renderer.residentData = data;
+        renderer.residentGeneration = generation;
+        renderer.residentFrameBytes = layout.frameBytes;
+    }
+    renderer.passSlots = reserveSlots;
+    const unsigned stamp = renderer.inPass ? renderer.stamp : ++renderer.stamp;
+
+    // Pass 1: claim the layers of frames that are already resident.
+    renderer.slotLayers.assign(slots, -1);
+    int missing = 0;
+    for (int slot = 0; slot < slots; slot++) {
+        size_t frameIndex = (startFrame + slot) % totalFrames;
+        std::unordered_map<size_t, int>::const_iterator found = renderer.frameLayer.find(frameIndex);
+        if (found != renderer.frameLayer.end()) {
+            renderer.slotLayers[slot] = found->second;
+            renderer.layerStamp[found->second] = stamp;
+        }
+        else {
+            missing++;
+        }
+    }
+
+    // Pass 2: stream the new frames into the least recently shown layers.
+    renderer.lastUploads = missing;
+    if (missing > 0) {
+        std::vector<int> victims;
+        victims.reserve(renderer.layers);
+        for (int layer = 0; layer < renderer.layers; layer++) {
+            if (renderer.layerStamp[layer] != stamp)
+                victims.push_back(layer);
+        }
+        std::partial_sort(victims.begin(), victims.begin() + missing, victims.end(), [&](int a, int b) {
+            return renderer.layerStamp[a] < renderer.layerStamp[b];
+        });
+        glBindTexture(GL_TEXTURE_2D_ARRAY, renderer.frameArray);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        int next = 0;
+        for (int slot = 0; slot < slots; slot++) {
+            if (renderer.slotLayers[slot] >= 0)
+                continue;
+            size_t frameIndex = (startFrame + slot) % totalFrames;
+            int layer = victims[next++];
+            if (renderer.layerFrame[layer] != NO_FRAME)
+                renderer.frameLayer.erase(renderer.layerFrame[layer]);
+            renderer.layerFrame[layer] = frameIndex;
+            renderer.layerStamp[layer] = stamp;
+            renderer.frameLayer[frameIndex] = layer;
+            renderer.slotLayers[slot] = layer;
+            glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, layout.frameWidth, layout.storageRows, 1,
+                GL_RED, GL_UNSIGNED_BYTE, data + frameIndex * layout.frameBytes);
+        }
+    }
+
+    glActiveTexture(GL_TEXTURE2);
+    glBindTexture(GL_TEXTURE_1D, renderer.slotTexture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glTexImage1D(GL_TEXTURE_1D, 0, GL_R32I, slots, 0, GL_RED_INTEGER, GL_INT, renderer.slotLayers.data());
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_1D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glActiveTexture(GL_TEXTURE1);
+    if (renderer.uploadedPalette != &palette) {
+        updatePaletteTexture(renderer.paletteTexture, palette);
+        renderer.uploadedPalette = &palette;
+    }
+    glBindTexture(GL_TEXTURE_1D, renderer.paletteTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D_ARRAY, renderer.frameArray);
+
+    glUseProgram(renderer.program);
+    glUniform2i(renderer.locFrameSize, layout.frameWidth, layout.frameHeight);
+    glUniform1i(renderer.locScale, layout.scale);
+    glUniform1i(renderer.locColumns, layout.columns);
+    glUniform1i(renderer.locSlots, slots);
+    glUniform2i(renderer.locWindowSize, layout.windowWidth, layout.windowHeight);
+    glUniform1i(renderer.locPixelFormat, layout.pixelFormat);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(cells));
+    glUseProgram(0);
+    return true;
+}
+
+// --- Search markers (drawn over the tile grid) ---
+// An outline around the pixels of each match visible in the grid (up to the end of the frame row
+// it starts in), colored by pattern, in every cell that shows the frame. The matches of each
+// visible frame are found by binary search; at most SEARCH_MARKERS_MAX are drawn per redraw.
+static const int SEARCH_MARKERS_MAX = 4096;
+
+static inline void renderSearchMarkers(const TileLayout& layout, size_t startFrame, size_t totalFrames,
+    const std::vector<SearchMatch>& matches, const PatternSet& set) {
+    size_t cells = static_cast<size_t>(layout.columns) * static_cast<size_t>(layout.rows);
+    size_t slots = cells < totalFrames ? cells : totalFrames;
+    if (matches.empty() || slots == 0)
+        return;
+    static const float colors[4][3] = { { 1.0f, 1.0f, 0.0f }, { 0.0f, 1.0f, 1.0f }, { 1.0f, 0.0f, 1.0f }, { 1.0f, 1.0f, 1.0f } };
+    const int bits = pixelFormatBits(layout.pixelFormat);
+    const int cellWidth = layout.frameWidth * layout.scale, cellHeight = layout.frameHeight * layout.scale;
+    int drawn = 0;
+    glBegin(GL_LINES);
+    for (size_t slot = 0; slot < slots && drawn < SEARCH_MARKERS_MAX; slot++) {
+        uint64_t frameStart = static_cast<uint64_t>((startFrame + slot) % totalFrames) * layout.frameBytes;
+        for (size_t i = firstMatchFrom(matches, frameStart);
+             i < matches.size() && matches[i].position < frameStart + layout.frameBytes && drawn < SEARCH_MARKERS_MAX; i++) {
+            int x, y;
+            pixelOfByte(layout.pixelFormat, layout.frameWidth, layout.frameHeight,
+                static_cast<size_t>(matches[i].position - frameStart), x, y);
+            int pixels = layout.pixelFormat == PIXEL_YUV420 ? 1
+                : static_cast<int>(std::max<size_t>(1, set.patterns[matches[i].pattern].size() * 8 / bits));
+            pixels = std::min(pixels, layout.frameWidth - x);
+            const float* color = colors[matches[i].pattern % 4];
+            glColor3f(color[0], color[1], color[2]);
+            for (size_t cell = slot; cell < cells; cell += slots) {
+                float left = static_cast<float>(static_cast<int>(cell % layout.columns) * cellWidth + x * layout.scale) - 0.5f;
+                float top = static_cast<float>(static_cast<int>(cell / layout.columns) * cellHeight + y * layout.scale) - 0.5f;
+                float right = left + static_cast<float>(pixels * layout.scale + 1);
+                float bottom = top + static_cast<float>(layout.scale + 1);
+                if (left > layout.windowWidth || top > layout.windowHeight)
+                    continue;
+                glVertex2f(left, top); glVertex2f(right, top);
+                glVertex2f(right, top); glVertex2f(right, bottom);
+                glVertex2f(right, bottom); glVertex2f(left, bottom);
+                glVertex2f(left, bottom); glVertex2f(left, top);
+                drawn++;
+            }
+        }
+    }
+    glEnd();
+    glColor3f(1.0f, 1.0f, 1.0f);
+}
+
+// --- Overview bar (whole file, drawn over the bottom of the window) ---
+// One column per pixel from the overview index: a thin entropy strip (dark = uniform, bright =
+// random) above the min..max byte range, colored by the mean. The loop region is tinted and the
+// playhead is a white line. While the index is still being built only the scan progress is shown.
+// Fractions are of the file size; pass a negative loopStart for no loop, or progress < 0 when done.
+static inline void renderOverviewBar(const std::vector<OverviewBlock>& columns, int x, int y, int width, int height,
+    const PaletteLUT& palette, double playhead, double loopStart, double loopEnd, double progress) {
+    const int entropyHeight = height / 8 > 2 ? height / 8 : 2;
+    const float top = static_cast<float>(y);
+    const float bottom = static_cast<float>(y + height);
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBegin(GL_QUADS);
+    glColor4ub(0, 0, 0, 192);
+    glVertex2f(static_cast<float>(x), top);
+    glVertex2f(static_cast<float>(x + width), top);
+    glVertex2f(static_cast<float>(x + width), bottom);
+    glVertex2f(static_cast<float>(x), bottom);
+    if (progress >= 0.0) {
+        float filled = static_cast<float>(x) + static_cast<float>(progress * width);
+        glColor4ub(96, 96, 96, 255);
+        glVertex2f(static_cast<float>(x), bottom - 3.0f);
+        glVertex2f(filled, bottom - 3.0f);
+        glVertex2f(filled, bottom);
+        glVertex2f(static_cast<float>(x), bottom);
+    }
+    const float rangeTop = top + static_cast<float>(entropyHeight) + 1.0f;
+    const float rangeHeight = bottom - rangeTop;
+    const int count = static_cast<int>(columns.size()) < width ? static_cast<int>(columns.size()) : width;
+    for (int c = 0; c < count; c++) {
+        const OverviewBlock& block = columns[c];
+        float x1 = static_cast<float>(x + c);
+        float x2 = x1 + 1.0f;
+        glColor4ub(block.entropy, block.entropy, block.entropy, 255);
+        glVertex2f(x1, top);
+        glVertex2f(x2, top);
+        glVertex2f(x2, top + static_cast<float>(entropyHeight));
+        glVertex2f(x1, top + static_cast<float>(entropyHeight));
+        float y1 = rangeTop + (255 - block.maximum) * rangeHeight / 256.0f;
+        float y2 = rangeTop + (256 - block.minimum) * rangeHeight / 256.0f;
+        glColor4ubv(palette.rgba[block.mean]);
+        glVertex2f(x1, y1);
+        glVertex2f(x2, y1);
+        glVertex2f(x2, y2);
+        glVertex2f(x1, y2);
+    }
+    if (loopStart >= 0.0 && loopEnd > loopStart) {
+        float x1 = static_cast<float>(x) + static_cast<float>(loopStart * width);
+        float x2 = static_cast<float>(x) + static_cast<float>(loopEnd * width);
+        if (x2 < x1 + 1.0f)
+            x2 = x1 + 1.0f;
+        glColor4ub(255, 255, 255, 48);
+        glVertex2f(x1, top);
+        glVertex2f(x2, top);
+        glVertex2f(x2, bottom);
+        glVertex2f(x1, bottom);
+    }
+    float px = static_cast<float>(x) + static_cast<float>(playhead * width);
+    glColor4ub(255, 255, 255, 255);
+    glVertex2f(px - 1.0f, top);
+    glVertex2f(px + 1.0f, top);
+    glVertex2f(px + 1.0f, bottom);
+    glVertex2f(px - 1.0f, bottom);
+    glEnd();
+    glDisable(GL_BLEND);
+    glColor4ub(255, 255, 255, 255);
+}
+
+// --- Thumbnail atlas (the strip and hover preview) ---
+// Finished thumbnails live in cells of a fixed GL_R8 atlas (THUMBNAIL_ATLAS_COLUMNS x
+// THUMBNAIL_ATLAS_ROWS cells of THUMBNAIL_SIZE texels, 1 MB), found by key. A missing one
+// replaces the cell that has gone longest without being drawn; cells drawn in the current pass are
+// never evicted. Each is drawn as a quad whose shader scales the cell and colors it through the
+// palette. Needs GL 3.0.
+const int THUMBNAIL_ATLAS_COLUMNS = 16;
+const int THUMBNAIL_ATLAS_ROWS = 16;
+
+static const char* THUMBNAIL_RENDERER_FS =
+    "#version 130\n"
+    "uniform sampler2D uAtlas;\n"
+    "uniform sampler1D uPalette;\n"
+    "uniform ivec4 uQuad;\n"
+    "uniform ivec4 uCell;\n"
+    "uniform int uWindowHeight;\n"
+    "void main() {\n"
+    "    ivec2 p = ivec2(gl_FragCoord.xy);\n"
+    "    p.y = uWindowHeight - 1 - p.y;\n"
+    "    ivec2 texel = clamp((p - uQuad.xy) * uCell.zw / uQuad.zw, ivec2(0), uCell.zw - 1);\n"
+    "    int value = int(texelFetch(uAtlas, uCell.xy + texel, 0).r * 255.0 + 0.5);\n"
+    "    gl_FragColor = texelFetch(uPalette, value, 0);\n"
+    "}\n";
+
+struct ThumbnailAtlas {
+    bool ready = false;
+    GLuint program = 0;
+    GLuint texture = 0;
+    GLuint paletteTexture = 0;
+    const PaletteLUT* uploadedPalette = nullptr;
+    int width = 0;                                  // thumbnail size the cells hold now
+    int height = 0;
+    std::vector<uint64_t> cellKey;
+    std::vector<bool> cellUsed;
+    std::vector<unsigned> cellStamp;                // pass that last drew the cell
+    std::unordered_map<uint64_t, int> keyCell;
+    unsigned stamp = 0;
+    // Uniform locations.
+    GLint locQuad = -1;
+    GLint locCell = -1;
+    GLint locWindowHeight = -1;
+};
+
+// One thumbnail to draw: atlas cell (-1 for a placeholder) and window rectangle.
+struct ThumbnailQuad {
+    int cell;
+    int x;
+    int y;
+    int width;
+    int height;
+};
+
+static inline bool initThumbnailAtlas(ThumbnailAtlas& atlas) {
+    atlas.ready = false;
+    if (glContextMajorVersion() < 3 || !loadGLFunctions())
+        return false;
+    atlas.program = buildShaderProgram(TEXTURE_RENDERER_VS, THUMBNAIL_RENDERER_FS, "thumbnail renderer");
+    if (!atlas.program)
+        return false;
+    atlas.locQuad = glGetUniformLocation(atlas.program, "uQuad");
+    atlas.locCell = glGetUniformLocation(atlas.program, "uCell");
+    atlas.locWindowHeight = glGetUniformLocation(atlas.program, "uWindowHeight");
+    glUseProgram(atlas.program);
+    glUniform1i(glGetUniformLocation(atlas.program, "uAtlas"), 0);
+    glUniform1i(glGetUniformLocation(atlas.program, "uPalette"), 1);
+    glUseProgram(0);
+    glGenTextures(1, &atlas.texture);
+    glBindTexture(GL_TEXTURE_2D, atlas.texture);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, THUMBNAIL_ATLAS_COLUMNS * THUMBNAIL_SIZE, THUMBNAIL_ATLAS_ROWS * THUMBNAIL_SIZE,
+        0, GL_RED, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    atlas.paletteTexture = createPaletteTexture();
+    atlas.ready = true;
+    return true;
+}
+
+static inline void destroyThumbnailAtlas(ThumbnailAtlas& atlas) {
+    if (atlas.texture)
+        glDeleteTextures(1, &atlas.texture);
+    if (atlas.paletteTexture)
+        glDeleteTextures(1, &atlas.paletteTexture);
+    if (atlas.program)
+        glDeleteProgram(atlas.program);
+    atlas = ThumbnailAtlas();
+}
+
+// Forget every thumbnail (new file or geometry); cells will hold width x height thumbnails.
+static inline void resetThumbnailAtlas(ThumbnailAtlas& atlas, int width, int height) {
+    const size_t cells = static_cast<size_t>(THUMBNAIL_ATLAS_COLUMNS) * THUMBNAIL_ATLAS_ROWS;
+    atlas.width = width;
+    atlas.height = height;
+    atlas.cellKey.assign(cells, 0);
+    atlas.cellUsed.assign(cells, false);
+    atlas.cellStamp.assign(cells, 0);
+    atlas.keyCell.clear();
+}
+
+// Cells touched between this and the next call count as drawn in one pass.
+static inline void beginThumbnailPass(ThumbnailAtlas& atlas) {
+    atlas.stamp++;
+}
+
+// The cell holding `key`, marked as drawn, or -1.
+static inline int findThumbnail(ThumbnailAtlas& atlas, uint64_t key) {
+    std::unordered_map<uint64_t, int>::const_iterator found = atlas.keyCell.find(key);
+    if (found == atlas.keyCell.end())
+        return -1;
+    atlas.cellStamp[found->second] = atlas.stamp;
+    return found->second;
+}
+
+// The resident thumbnail of the frame closest to `frame` (either kind), marked as drawn, or -1.
+static inline int nearestThumbnail(ThumbnailAtlas& atlas, size_t frame) {
+    int best = -1;
+    size_t bestDistance = 0;
+    for (size_t cell = 0; cell < atlas.cellKey.size(); cell++) {
+        if (!atlas.cellUsed[cell])
+            continue;
+        size_t other = thumbnailKeyFrame(atlas.cellKey[cell]);
+        size_t distance = other > frame ? other - frame : frame - other;
+        if (best < 0 || distance < bestDistance || (distance == bestDistance && !(atlas.cellKey[cell] & 1))) {
+            best = static_cast<int>(cell);
+            bestDistance = distance;
+        }
+    }
+    if (best >= 0)
+        atlas.cellStamp[best] = atlas.stamp;
+    return best;
+}
+
+// Upload a finished thumbnail into the least recently drawn cell. Returns the cell, or -1 if every
+// cell has been drawn in this pass.
+static inline int storeThumbnail(ThumbnailAtlas& atlas, uint64_t key, const unsigned char* pixels) {
+    if (!atlas.ready || atlas.cellKey.empty())
+        return -1;
+    int cell = findThumbnail(atlas, key);
+    if (cell < 0) {
+        for (size_t candidate = 0; candidate < atlas.cellKey.size(); candidate++) {
+            if (atlas.cellStamp[candidate] == atlas.stamp)
+                continue;
+            if (!atlas.cellUsed[candidate]) {
+                cell = static_cast<int>(candidate);
+                break;
+            }
+            if (cell < 0 || atlas.cellStamp[candidate] < atlas.cellStamp[cell])
+                cell = static_cast<int>(candidate);
+        }
+        if (cell < 0)
+            return -1;
+        if (atlas.cellUsed[cell])
+            atlas.keyCell.erase(atlas.cellKey[cell]);
+        atlas.cellKey[cell] = key;
+        atlas.cellUsed[cell] = true;
+        atlas.keyCell[key] = cell;
+    }
+    atlas.cellStamp[cell] = atlas.stamp;
+    glBindTexture(GL_TEXTURE_2D, atlas.texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexSubImage2D(GL_TEXTURE_2D, 0, (cell % THUMBNAIL_ATLAS_COLUMNS) * THUMBNAIL_SIZE,
+        (cell / THUMBNAIL_ATLAS_COLUMNS) * THUMBNAIL_SIZE, atlas.width, atlas.height, GL_RED, GL_UNSIGNED_BYTE, pixels);
+    return cell;
+}
+
+// Draw `quads` (placeholders as dark grey), each with a one-pixel border: white for the one at
+// `highlight`, grey for the rest (pass -1 for none).
+static inline void renderThumbnails(ThumbnailAtlas& atlas, const std::vector<ThumbnailQuad>& quads, int highlight,
+    int windowHeight, const PaletteLUT& palette) {
+    if (!atlas.ready || quads.empty())
+        return;
+    glBegin(GL_QUADS);
+    for (size_t i = 0; i < quads.size(); i++) {
+        const ThumbnailQuad& quad = quads[i];
+        if (static_cast<int>(i) == highlight)
+            glColor4ub(255, 255, 255, 255);
+        else
+            glColor4ub(quad.cell < 0 ? 48 : 96, quad.cell < 0 ? 48 : 96, quad.cell < 0 ? 48 : 96, 255);
+        glVertex2f(static_cast<float>(quad.x - 1), static_cast<float>(quad.y - 1));
+        glVertex2f(static_cast<float>(quad.x + quad.width + 1), static_cast<float>(quad.y - 1));
+        glVertex2f(static_cast<float>(quad.x + quad.width + 1), static_cast<float>(quad.y + quad.height + 1));
+        glVertex2f(static_cast<float>(quad.x - 1), static_cast<float>(quad.y + quad.height + 1));
+        if (quad.cell >= 0)
+            continue;
+        glColor4ub(24, 24, 24, 255);
+        glVertex2f(static_cast<float>(quad.x), static_cast<float>(quad.y));
+        glVertex2f(static_cast<float>(quad.x + quad.width), static_cast<float>(quad.y));
+        glVertex2f(static_cast<float>(quad.x + quad.width), static_cast<float>(quad.y + quad.height));
+        glVertex2f(static_cast<float>(quad.x), static_cast<float>(quad.y + quad.height));
+    }
+    glEnd();
+    glColor4ub(255, 255, 255, 255);
+    glActiveTexture(GL_TEXTURE1);
+    if (atlas.uploadedPalette != &palette) {
+        updatePaletteTexture(atlas.paletteTexture, palette);
+        atlas.uploadedPalette = &palette;
+    }
+    glBindTexture(GL_TEXTURE_1D, atlas.paletteTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, atlas.texture);
+    glUseProgram(atlas.program);
+    glUniform1i(atlas.locWindowHeight, windowHeight);
+    for (const ThumbnailQuad& quad : quads) {
+        if (quad.cell < 0 || quad.width <= 0 || quad.height <= 0)
+            continue;
+        glUniform4i(atlas.locQuad, quad.x, quad.y, quad.width, quad.height);
+        glUniform4i(atlas.locCell, (quad.cell % THUMBNAIL_ATLAS_COLUMNS) * THUMBNAIL_SIZE,
+            (quad.cell / THUMBNAIL_ATLAS_COLUMNS) * THUMBNAIL_SIZE, atlas.width, atlas.height);
+        glBegin(GL_QUADS);
+        glVertex2f(static_cast<float>(quad.x), static_cast<float>(quad.y));
+        glVertex2f(static_cast<float>(quad.x + quad.width), static_cast<float>(quad.y));
+        glVertex2f(static_cast<float>(quad.x + quad.width), static_cast<float>(quad.y + quad.height));
+        glVertex2f(static_cast<float>(quad.x), static_cast<float>(quad.y + quad.height));
+        glEnd();
+    }
+    glUseProgram(0);
+}
+
+// The strip: a translucent band across the window at `y`, then its thumbnails.
+static inline void renderThumbnailStrip(ThumbnailAtlas& atlas, const std::vector<ThumbnailQuad>& quads, int highlight,
+    int y, int width, int height, int windowHeight, const PaletteLUT& palette) {
+    if (!atlas.ready)
+        return;
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBegin(GL_QUADS);
+    glColor4ub(0, 0, 0, 192);
+    glVertex2f(0.0f, static_cast<float>(y));
+    glVertex2f(static_cast<float>(width), static_cast<float>(y));
+    glVertex2f(static_cast<float>(width), static_cast<float>(y + height));
+    glVertex2f(0.0f, static_cast<float>(y + height));
+    glEnd();
+    glDisable(GL_BLEND);
+    renderThumbnails(atlas, quads, highlight, windowHeight, palette);
+}
+
+// --- Waterfall renderer (continuous scroll from a resident row ring) ---
+// The file is treated as one long strip of frameWidth-byte rows, laid out in window columns that
+// continue each other (column c starts where column c-1 ends). Rows live in a GL_R8 ring texture
+// split into pages side by side; virtual row v sits in slot v mod capacity. Scrolling only moves
+// the top-row uniform (with a fractional part for sub-row motion), and each redraw uploads just
+// the rows that entered the resident range at the leading edge, plus a read-ahead margin in the
+// direction of playback. A jump outside the resident range refills it. Needs GL 3.0.
+static const char* WATERFALL_RENDERER_FS =
+    "#version 130\n"
+    "uniform sampler2D uRing;\n"
+    "uniform sampler1D uPalette;\n"
+    "uniform int uFrameWidth;\n"
+    "uniform int uScale;\n"
+    "uniform int uRowsPerColumn;\n"
+    "uniform int uPageRows;\n"
+    "uniform int uCapacity;\n"
+    "uniform int uTopSlot;\n"
+    "uniform float uRowFraction;\n"
+    "uniform int uWindowHeight;\n"
+    "void main() {\n"
+    "    ivec2 p = ivec2(gl_FragCoord.xy);\n"
+    "    p.y = uWindowHeight - 1 - p.y;\n"
+    "    int column = p.x / (uFrameWidth * uScale);\n"
+    "    int x = p.x / uScale - column * uFrameWidth;\n"
+    "    int row = int(floor((float(p.y) + 0.5) / float(uScale) + uRowFraction)) + column * uRowsPerColumn;\n"
+    "    int slot = (uTopSlot + row) % uCapacity;\n"
+    "    int page = slot / uPageRows;\n"
+    "    ivec2 texel = ivec2(page * uFrameWidth + x, slot - page * uPageRows);\n"
+    "    int value = int(texelFetch(uRing, texel, 0).r * 255.0 + 0.5);\n"
+    "    gl_FragColor = texelFetch(uPalette, value, 0);\n"
+    "}\n";
+
+const size_t WATERFALL_MAX_RING_BYTES = 256u << 20;
+
+struct WaterfallRenderer {
+    bool ready = false;
+    GLuint program = 0;
+    GLuint ring = 0;
+    GLuint paletteTexture = 0;
+    const PaletteLUT* uploadedPalette = nullptr;
+    GLint maxTextureSize = 0;
+    // Ring allocation.
+    int frameWidth = 0;
+    int pageRows = 0;
+    int pages = 0;
+    long long capacity = 0;             // rows, pages * pageRows
+    // Resident virtual rows [residentFirst, residentEnd); virtual rows wrap onto file rows.
+    const unsigned char* residentData = nullptr;
+    uint32_t residentGeneration = 0;
+    long long totalRows = 0;
+    bool resident = false;
+    long long residentFirst = 0;
+    long long residentEnd = 0;
+    long long virtualTop = 0;           // unwrapped top row of the previous draw
+    long long lastUploadRows = 0;
+    // Uniform locations.
+    GLint locFrameWidth = -1;
+    GLint locScale = -1;
+    GLint locRowsPerColumn = -1;
+    GLint locPageRows = -1;
+    GLint locCapacity = -1;
+    GLint locTopSlot = -1;
+    GLint locRowFraction = -1;
+    GLint locWindowHeight = -1;
+};
+
+static inline long long floorMod(long long value, long long modulus) {
+    long long result = value % modulus;
+    return (result < 0) ? result + modulus : result;
+}
+
+static inline bool initWaterfallRenderer(WaterfallRenderer& renderer) {
+    renderer.ready = false;
+    if (glContextMajorVersion() < 3 || !loadGLFunctions())
+        return false;
+    renderer.program = buildShaderProgram(TEXTURE_RENDERER_VS, WATERFALL_RENDERER_FS, "waterfall renderer");
+    if (!renderer.program)
+        return false;
+    glGetIntegerv(GL_MAX_TEXTURE_SIZE, &renderer.maxTextureSize);
+    renderer.locFrameWidth = glGetUniformLocation(renderer.program, "uFrameWidth");
+    renderer.locScale = glGetUniformLocation(renderer.program, "uScale");
+    renderer.locRowsPerColumn = glGetUniformLocation(renderer.program, "uRowsPerColumn");
+    renderer.locPageRows = glGetUniformLocation(renderer.program, "uPageRows");
+    renderer.locCapacity = glGetUniformLocation(renderer.program, "uCapacity");
+    renderer.locTopSlot = glGetUniformLocation(renderer.program, "uTopSlot");
+    renderer.locRowFraction = glGetUniformLocation(renderer.program, "uRowFraction");
+    renderer.locWindowHeight = glGetUniformLocation(renderer.program, "uWindowHeight");
+    glUseProgram(renderer.program);
+    glUniform1i(glGetUniformLocation(renderer.program, "uRing"), 0);
+    glUniform1i(glGetUniformLocation(renderer.program, "uPalette"), 1);
+    glUseProgram(0);
+    glGenTextures(1, &renderer.ring);
+    renderer.paletteTexture = createPaletteTexture();
+    renderer.ready = true;
+    return true;
+}
+
+static inline void destroyWaterfallRenderer(WaterfallRenderer& renderer) {
+    if (renderer.ring)
+        glDeleteTextures(1, &renderer.ring);
+    if (renderer.paletteTexture)
+        glDeleteTextures(1, &renderer.paletteTexture);
+    if (renderer.program)
+        glDeleteProgram(renderer.program);
+    renderer = WaterfallRenderer();
+}
+
+// Grow the ring to at least `rows` rows of `frameWidth` bytes; false if the driver or the memory
+// cap cannot hold that many.
+static inline bool reserveWaterfallRows(WaterfallRenderer& renderer, int frameWidth, long long rows) {
+    if (renderer.frameWidth == frameWidth && renderer.capacity >= rows)
+        return true;
+    if (frameWidth > renderer.maxTextureSize ||
+        static_cast<size_t>(rows) * static_cast<size_t>(frameWidth) > WATERFALL_MAX_RING_BYTES)
+        return false;
+    int pageRows = static_cast<int>(std::min<long long>(rows, renderer.maxTextureSize));
+    long long pages = (rows + pageRows - 1) / pageRows;
+    if (pages * frameWidth > renderer.maxTextureSize)
+        return false;
+    glBindTexture(GL_TEXTURE_2D, renderer.ring);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, static_cast<GLsizei>(pages * frameWidth), pageRows, 0,
+        GL_RED, GL_UNSIGNED_BYTE, NULL);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    renderer.frameWidth = frameWidth;
+    renderer.pageRows = pageRows;
+    renderer.pages = static_cast<int>(pages);
+    renderer.capacity = pages * pageRows;
+    renderer.resident = false;
+    return true;
+}
+
+// Copy virtual rows [first, end) into their ring slots, split at file wrap and page edges.
+static inline void uploadWaterfallRows(WaterfallRenderer& renderer, const unsigned char* data, long long first, long long end) {
+    glBindTexture(GL_TEXTURE_2D, renderer.ring);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    renderer.lastUploadRows += end - first;
+    while (first < end) {
+        long long fileRow = floorMod(first, renderer.totalRows);
+        long long slot = floorMod(first, renderer.capacity);
+        int page = static_cast<int>(slot / renderer.pageRows);
+        int y = static_cast<int>(slot - static_cast<long long>(page) * renderer.pageRows);
+        long long count = std::min(end - first, std::min(renderer.totalRows - fileRow,
+            static_cast<long long>(renderer.pageRows - y)));
+        glTexSubImage2D(GL_TEXTURE_2D, 0, page * renderer.frameWidth, y, renderer.frameWidth, static_cast<GLsizei>(count),
+            GL_RED, GL_UNSIGNED_BYTE, data + fileRow * renderer.frameWidth);
+        first += count;
+    }
+}
+
+// Forget the resident rows that overlap bytes [first, end), which a live stream has rewritten.
+// What stays is the clean run of rows around the last top, so the next draw refills the rest the
+// way it fills rows that scroll into view.
+static inline void forgetWaterfallBytes(WaterfallRenderer& renderer, size_t first, size_t end) {
+    if (!renderer.resident)
+        return;
+    const long long width = renderer.frameWidth;
+    const long long totalRows = renderer.totalRows;
+    const long long rowFirst = static_cast<long long>(first) / width;
+    const long long rowEnd = std::min((static_cast<long long>(end) + width - 1) / width, totalRows);
+    if (rowFirst >= rowEnd)
+        return;
+    // Nearest rewritten virtual rows at or after the anchor and before it.
+    const long long anchor = std::min(std::max(renderer.virtualTop, renderer.residentFirst), renderer.residentEnd - 1);
+    const long long at = floorMod(anchor, totalRows);
+    const long long after = (at < rowFirst) ? rowFirst - at : (at < rowEnd ? 0 : rowFirst + totalRows - at);
+    const long long below = floorMod(anchor - 1, totalRows);
+    const long long before = (below >= rowEnd) ? below - (rowEnd - 1)
+        : (below >= rowFirst ? 0 : below + totalRows - (rowEnd - 1));
+    renderer.residentEnd = std::min(renderer.residentEnd, anchor + after);
+    renderer.residentFirst = std::max(renderer.residentFirst, anchor - before);
+    if (renderer.residentFirst >= renderer.residentEnd)
+        renderer.resident = false;
+}
+
+// Draw the waterfall with the top-left pixel at byte offset `position`; `direction` is the sign
+// of playback (0 when still) and decides which edge gets the read-ahead. `generation` identifies
+// the source as in renderTilesArray.
+static inline bool renderWaterfall(WaterfallRenderer& renderer, int windowWidth, int windowHeight, int frameWidth,
+    int scale, const unsigned char* data, uint32_t generation, size_t fileBytes, double position, int direction,
+    const PaletteLUT& palette) {
+    if (!renderer.ready || frameWidth <= 0 || scale <= 0)
+        return false;
+    const long long totalRows = static_cast<long long>(fileBytes / static_cast<size_t>(frameWidth));
+    if (totalRows <= 0)
+        return false;
+    const int columns = (windowWidth + frameWidth * scale - 1) / (frameWidth * scale);
+    const int rowsPerColumn = (windowHeight + scale - 1) / scale;
+    const long long visible = static_cast<long long>(columns) * rowsPerColumn + 2;
+    const long long ahead = std::max<long long>(visible / 2, 64);
+    if (!reserveWaterfallRows(renderer, frameWidth, visible + 2 * ahead))
+        return false;
+    if (renderer.residentData != data || renderer.residentGeneration != generation || renderer.totalRows != totalRows) {
+        renderer.residentData = data;
+        renderer.residentGeneration = generation;
+        renderer.totalRows = totalRows;
+        renderer.resident = false;
+    }
+
+    // Unwrap the top row against the previous draw, so wrapping past the end of the file keeps
+    // scrolling instead of refilling.
+    double rowPosition = position / static_cast<double>(frameWidth);
+    long long topRow = static_cast<long long>(std::floor(rowPosition));
+    float fraction = static_cast<float>(rowPosition - std::floor(rowPosition));
+    long long delta = floorMod(topRow - renderer.virtualTop, totalRows);
+    if (delta > totalRows / 2)
+        delta -= totalRows;
+    long long top = renderer.virtualTop + delta;
+    renderer.virtualTop = top;
+
+    // Keep [top, top + visible) resident, plus `ahead` rows on the leading edge.
+    long long wantFirst = top - (direction < 0 ? ahead : 0);
+    long long wantEnd = top + visible + (direction > 0 ? ahead : 0);
+    renderer.lastUploadRows = 0;
+    bool covered = renderer.resident && top >= renderer.residentFirst && top + visible <= renderer.residentEnd;
+    if (!renderer.resident || wantEnd <= renderer.residentFirst || wantFirst >= renderer.residentEnd) {
+        uploadWaterfallRows(renderer, data, wantFirst, wantEnd);
+        renderer.residentFirst = wantFirst;
+        renderer.residentEnd = wantEnd;
+        renderer.resident = true;
+    }
+    else if (!covered || direction != 0) {
+        if (wantEnd > renderer.residentEnd) {
+            uploadWaterfallRows(renderer, data, renderer.residentEnd, wantEnd);
+            renderer.residentEnd = wantEnd;
+            if (renderer.residentEnd - renderer.residentFirst > renderer.capacity)
+                renderer.residentFirst = renderer.residentEnd - renderer.capacity;
+        }
+        if (wantFirst < renderer.residentFirst) {
+            uploadWaterfallRows(renderer, data, wantFirst, renderer.residentFirst);
+            renderer.residentFirst = wantFirst;
+            if (renderer.residentEnd - renderer.residentFirst > renderer.capacity)
+                renderer.residentEnd = renderer.residentFirst + renderer.capacity;
+        }
+    }
+
+    glActiveTexture(GL_TEXTURE1);
+    if (renderer.uploadedPalette != &palette) {
+        updatePaletteTexture(renderer.paletteTexture, palette);
+        renderer.uploadedPalette = &palette;
+    }
+    glBindTexture(GL_TEXTURE_1D, renderer.paletteTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, renderer.ring);
+    glUseProgram(renderer.program);
+    glUniform1i(renderer.locFrameWidth, frameWidth);
+    glUniform1i(renderer.locScale, scale);
+    glUniform1i(renderer.locRowsPerColumn, rowsPerColumn);
+    glUniform1i(renderer.locPageRows, renderer.pageRows);
+    glUniform1i(renderer.locCapacity, static_cast<GLint>(renderer.capacity));
+    glUniform1i(renderer.locTopSlot, static_cast<GLint>(floorMod(top, renderer.capacity)));
+    glUniform1f(renderer.locRowFraction, fraction);
+    glUniform1i(renderer.locWindowHeight, windowHeight);
+    glBegin(GL_QUADS);
+    glVertex2f(0.0f, 0.0f);
+    glVertex2f(static_cast<float>(windowWidth), 0.0f);
+    glVertex2f(static_cast<float>(windowWidth), static_cast<float>(windowHeight));
+    glVertex2f(0.0f, static_cast<float>(windowHeight));
+    glEnd();
+    glUseProgram(0);
+    return true;
+}
+
+// --- Spectrogram panel ---
+// Rows from the SpectrogramAnalyzer stream into a GL_R8 ring (SPECTROGRAM_BINS wide,
+// SPECTROGRAM_HISTORY tall); row r sits in texture row r mod history, so each redraw uploads only
+// the rows computed since the last one. The shader maps the panel with frequency left to right
+// and time top to bottom (newest at the top) and colors levels through the palette. Needs GL 3.0.
+static const char* SPECTROGRAM_RENDERER_FS =
+    "#version 130\n"
+    "uniform sampler2D uRows;\n"
+    "uniform sampler1D uPalette;\n"
+    "uniform ivec4 uPanel;\n"
+    "uniform int uNewestRow;\n"
+    "uniform int uWindowHeight;\n"
+    "void main() {\n"
+    "    ivec2 p = ivec2(gl_FragCoord.xy);\n"
+    "    p.y = uWindowHeight - 1 - p.y;\n"
+    "    ivec2 size = textureSize(uRows, 0);\n"
+    "    ivec2 local = p - uPanel.xy;\n"
+    "    int bin = local.x * size.x / uPanel.z;\n"
+    "    int age = local.y * size.y / uPanel.w;\n"
+    "    int row = (uNewestRow - age + size.y) % size.y;\n"
+    "    int value = int(texelFetch(uRows, ivec2(bin, row), 0).r * 255.0 + 0.5);\n"
+    "    gl_FragColor = texelFetch(uPalette, value, 0);\n"
+    "}\n";
+
+struct SpectrogramRenderer {
+    bool ready = false;
+    GLuint program = 0;
+    GLuint rows = 0;
+    GLuint paletteTexture = 0;
+    const PaletteLUT* uploadedPalette = nullptr;
+    unsigned long long rowsUploaded = 0;          // analyzer rows [0, rowsUploaded) are in the ring
+    std::vector<unsigned char> staging;
+    // Uniform locations.
+    GLint locPanel = -1;
+    GLint locNewestRow = -1;
+    GLint locWindowHeight = -1;
+};
+
+static inline bool initSpectrogramRenderer(SpectrogramRenderer& renderer) {
+    renderer.ready = false;
+    if (glContextMajorVersion() < 3 || !loadGLFunctions())
+        return false;
+    renderer.program = buildShaderProgram(TEXTURE_RENDERER_VS, SPECTROGRAM_RENDERER_FS, "spectrogram renderer");
+    if (!renderer.program)
+        return false;
+    renderer.locPanel = glGetUniformLocation(renderer.program, "uPanel");
+    renderer.locNewestRow = glGetUniformLocation(renderer.program, "uNewestRow");
+    renderer.locWindowHeight = glGetUniformLocation(renderer.program, "uWindowHeight");
+    glUseProgram(renderer.program);
+    glUniform1i(glGetUniformLocation(renderer.program, "uRows"), 0);
+    glUniform1i(glGetUniformLocation(renderer.program, "uPalette"), 1);
+    glUseProgram(0);
+    std::vector<unsigned char> silence(static_cast<size_t>(SPECTROGRAM_BINS) * SPECTROGRAM_HISTORY, 0);
+    glGenTextures(1, &renderer.rows);
+    glBindTexture(GL_TEXTURE_2D, renderer.rows);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_R8, SPECTROGRAM_BINS, SPECTROGRAM_HISTORY, 0, GL_RED, GL_UNSIGNED_BYTE,
+        silence.data());
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    renderer.paletteTexture = createPaletteTexture();
+    renderer.ready = true;
+    return true;
+}
+
+static inline void destroySpectrogramRenderer(SpectrogramRenderer& renderer) {
+    if (renderer.rows)
+        glDeleteTextures(1, &renderer.rows);
+    if (renderer.paletteTexture)
+        glDeleteTextures(1, &renderer.paletteTexture);
+    if (renderer.program)
+        glDeleteProgram(renderer.program);
+    renderer = SpectrogramRenderer();
+}
+
+// Upload the rows computed since the last call and draw the panel at (x, y, width, height).
+static inline bool renderSpectrogram(SpectrogramRenderer& renderer, SpectrogramAnalyzer& analyzer, int x, int y,
+    int width, int height, int windowHeight, const PaletteLUT& palette) {
+    if (!renderer.ready || width <= 0 || height <= 0)
+        return false;
+    unsigned long long first = renderer.rowsUploaded;
+    size_t count = takeSpectrogramRows(analyzer, first, renderer.staging);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, renderer.rows);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    for (size_t done = 0; done < count;) {
+        int slot = static_cast<int>((first + done) % SPECTROGRAM_HISTORY);
+        size_t run = std::min(count - done, static_cast<size_t>(SPECTROGRAM_HISTORY - slot));
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, slot, SPECTROGRAM_BINS, static_cast<GLsizei>(run), GL_RED, GL_UNSIGNED_BYTE,
+            renderer.staging.data() + done * SPECTROGRAM_BINS);
+        done += run;
+    }
+    renderer.rowsUploaded = first + count;
+
+    glActiveTexture(GL_TEXTURE1);
+    if (renderer.uploadedPalette != &palette) {
+        updatePaletteTexture(renderer.paletteTexture, palette);
+        renderer.uploadedPalette = &palette;
+    }
+    glBindTexture(GL_TEXTURE_1D, renderer.paletteTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glUseProgram(renderer.program);
+    glUniform4i(renderer.locPanel, x, y, width, height);
+    glUniform1i(renderer.locNewestRow, static_cast<GLint>((renderer.rowsUploaded + SPECTROGRAM_HISTORY - 1) % SPECTROGRAM_HISTORY));
+    glUniform1i(renderer.locWindowHeight, windowHeight);
+    glBegin(GL_QUADS);
+    glVertex2f(static_cast<float>(x), static_cast<float>(y));
+    glVertex2f(static_cast<float>(x + width), static_cast<float>(y));
+    glVertex2f(static_cast<float>(x + width), static_cast<float>(y + height));
+    glVertex2f(static_cast<float>(x), static_cast<float>(y + height));
+    glEnd();
+    glUseProgram(0);
+    return true;
+}
+
+// --- Oscilloscope overlay ---
+// Draws the (min, max) column pairs of Scope.h: they are uploaded as one GL_RG8 row, and one
+// attribute-less GL_LINES draw puts a vertical segment from min to max in every panel column,
+// colored through the palette by height so every pixel shows the value it stands for. Needs GL 3.0.
+static const char* SCOPE_RENDERER_VS =
+    "#version 130\n"
+    "uniform sampler2D uColumns;\n"
+    "uniform ivec4 uPanel;\n"
+    "uniform ivec2 uWindowSize;\n"
+    "out float vValue;\n"
+    "void main() {\n"
+    "    int column = gl_VertexID / 2;\n"
+    "    bool bottom = (gl_VertexID & 1) == 1;\n"
+    "    vec2 range = texelFetch(uColumns, ivec2(column, 0), 0).rg * 255.0;\n"
+    "    vValue = bottom ? range.x : range.y;\n"
+    "    float x = float(uPanel.x + column) + 0.5;\n"
+    "    float y = float(uPanel.y) + (255.0 - vValue) * float(uPanel.w - 1) / 255.0 + (bottom ? 1.0 : 0.0);\n"
+    "    gl_Position = vec4(x / float(uWindowSize.x) * 2.0 - 1.0, 1.0 - y / float(uWindowSize.y) * 2.0, 0.0, 1.0);\n"
+    "}\n";
+
+static const char* SCOPE_RENDERER_FS =
+    "#version 130\n"
+    "uniform sampler1D uPalette;\n"
+    "in float vValue;\n"
+    "void main() {\n"
+    "    gl_FragColor = vec4(texelFetch(uPalette, int(vValue + 0.5), 0).rgb, 1.0);\n"
+    "}\n";
+
+struct ScopeRenderer {
+    bool ready = false;
+    GLuint program = 0;
+    GLuint columns = 0;
+    GLuint paletteTexture = 0;
+    const PaletteLUT* uploadedPalette = nullptr;
+    int columnCapacity = 0;       // width of the columns texture
+    // Uniform locations.
+    GLint locPanel = -1;
+    GLint locWindowSize = -1;
+};
+
+static inline bool initScopeRenderer(ScopeRenderer& renderer) {
+    renderer.ready = false;
+    if (glContextMajorVersion() < 3 || !loadGLFunctions())
+        return false;
+    renderer.program = buildShaderProgram(SCOPE_RENDERER_VS, SCOPE_RENDERER_FS, "scope renderer");
+    if (!renderer.program)
+        return false;
+    renderer.locPanel = glGetUniformLocation(renderer.program, "uPanel");
+    renderer.locWindowSize = glGetUniformLocation(renderer.program, "uWindowSize");
+    glUseProgram(renderer.program);
+    glUniform1i(glGetUniformLocation(renderer.program, "uColumns"), 0);
+    glUniform1i(glGetUniformLocation(renderer.program, "uPalette"), 1);
+    glUseProgram(0);
+    glGenTextures(1, &renderer.columns);
+    glBindTexture(GL_TEXTURE_2D, renderer.columns);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    renderer.paletteTexture = createPaletteTexture();
+    renderer.ready = true;
+    return true;
+}
+
+static inline void destroyScopeRenderer(ScopeRenderer& renderer) {
+    if (renderer.columns)
+        glDeleteTextures(1, &renderer.columns);
+    if (renderer.paletteTexture)
+        glDeleteTextures(1, &renderer.paletteTexture);
+    if (renderer.program)
+        glDeleteProgram(renderer.program);
+    renderer = ScopeRenderer();
+}
+
+// Draw the panel at (x, y, width, height) on a translucent background, with the trace of
+// `columns` (2 * width bytes: min and max per column, see reduceScopeColumns) when it is not null.
+static inline bool renderScope(ScopeRenderer& renderer, const unsigned char* columns, int x, int y, int width,
+    int height, int windowWidth, int windowHeight, const PaletteLUT& palette) {
+    if (!renderer.ready || width <= 0 || height <= 1)
+        return false;
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBegin(GL_QUADS);
+    glColor4ub(0, 0, 0, 160);
+    glVertex2f(static_cast<float>(x), static_cast<float>(y));
+    glVertex2f(static_cast<float>(x + width), static_cast<float>(y));
+    glVertex2f(static_cast<float>(x + width), static_cast<float>(y + height));
+    glVertex2f(static_cast<float>(x), static_cast<float>(y + height));
+    glEnd();
+    glDisable(GL_BLEND);
+    glColor4ub(255, 255, 255, 255);
+    if (!columns)
+        return true;
+
+    glActiveTexture(GL_TEXTURE1);
+    if (renderer.uploadedPalette != &palette) {
+        updatePaletteTexture(renderer.paletteTexture, palette);
+        renderer.uploadedPalette = &palette;
+    }
+    glBindTexture(GL_TEXTURE_1D, renderer.paletteTexture);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, renderer.columns);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    if (width > renderer.columnCapacity) {
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG8, width, 1, 0, GL_RG, GL_UNSIGNED_BYTE, columns);
+        renderer.columnCapacity = width;
+    }
+    else
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, width, 1, GL_RG, GL_UNSIGNED_BYTE, columns);
+    glUseProgram(renderer.program);
+    glUniform4i(renderer.locPanel, x, y, width, height);
+    glUniform2i(renderer.locWindowSize, windowWidth, windowHeight);
+    glDrawArrays(GL_LINES, 0, 2 * width);
+    glUseProgram(0);
+    return true;
+}
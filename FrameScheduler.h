@@ -0,0 +1,106 @@
+#pragma once
+// Presentation pacing for the UI thread.
+// Output frames sit on a fixed grid (frame n is due at epoch + n / targetFps) of whatever clock
+// the caller supplies: the JACK frame clock while audio runs, glfwGetTime otherwise. A wakeup
+// renders the newest due grid frame, and the playhead is evaluated at that frame's grid time
+// rather than at the moment the loop happened to wake. Late wakeups skip grid frames (counted as
+// dropped) and a target above the refresh rate is trimmed by vsync in the same way, so which
+// frames are shown depends only on the clock and the target rate. Below the refresh rate the
+// previous image is simply held. Playback speed never enters into it.
+#include "ControlChannel.h"
+#include <cmath>
+#include <cstdint>
+
+struct FrameScheduler {
+    double targetFps = 60.0;
+    bool started = false;
+    double epoch = 0.0;             // clock time of grid frame 0
+    long long lastFrame = -1;       // last grid frame presented
+    unsigned long long presented = 0;
+    unsigned long long dropped = 0;
+};
+
+// Restart the grid at the next call (clock source or target rate changed).
+static inline void resetFrameScheduler(FrameScheduler& scheduler) {
+    scheduler.started = false;
+    scheduler.lastFrame = -1;
+}
+
+static inline void setTargetFps(FrameScheduler& scheduler, double fps) {
+    if (fps < 1.0)
+        fps = 1.0;
+    scheduler.targetFps = fps;
+    resetFrameScheduler(scheduler);
+}
+
+// True if a new grid frame is due at `now`; `frameTime` receives its grid time.
+static inline bool scheduleFrame(FrameScheduler& scheduler, double now, double& frameTime) {
+    if (!scheduler.started) {
+        scheduler.epoch = now;
+        scheduler.started = true;
+    }
+    long long frame = static_cast<long long>(std::floor((now - scheduler.epoch) * scheduler.targetFps));
+    if (frame < scheduler.lastFrame - 1) {
+        // The clock went backwards (e.g. JACK restarted); start a new grid.
+        scheduler.epoch = now;
+        scheduler.lastFrame = -1;
+        frame = 0;
+    }
+    if (frame <= scheduler.lastFrame)
+        return false;
+    if (scheduler.lastFrame >= 0)
+        scheduler.dropped += static_cast<unsigned long long>(frame - scheduler.lastFrame - 1);
+    scheduler.lastFrame = frame;
+    scheduler.presented++;
+    frameTime = scheduler.epoch + static_cast<double>(frame) / scheduler.targetFps;
+    return true;
+}
+
+// How long the loop may block on events before the next grid frame is due.
+static inline double secondsUntilNextFrame(const FrameScheduler& scheduler, double now) {
+    if (!scheduler.started)
+        return 0.0;
+    double next = scheduler.epoch + static_cast<double>(scheduler.lastFrame + 1) / scheduler.targetFps;
+    return (next > now) ? next - now : 0.0;
+}
+
+// --- Playhead at a presentation time ---
+// The snapshot describes the playhead right after the period that started at clockFrame. Between
+// periods it moves by sampleAdvance bytes per sample; stepping it through handleLoop keeps the
+// estimate on the loop/boomerang path the audio thread will take. Extrapolation is limited to two
+// periods so a stalled audio thread freezes the picture instead of running away. Output latency
+// is not compensated: it is a constant offset of a period or two, far below one frame at 1x.
+static inline double extrapolatePlayhead(const PlayheadSnapshot& playhead, uint32_t presentFrame, double fileSize) {
+    if (playhead.sampleAdvance == 0.0 || fileSize <= 0.0)
+        return playhead.position;
+    double elapsed = static_cast<double>(static_cast<int32_t>(presentFrame - playhead.clockFrame));
+    double limit = 2.0 * static_cast<double>(playhead.periodFrames);
+    if (elapsed <= 0.0)
+        return playhead.position;
+    if (elapsed > limit)
+        elapsed = limit;
+    PlaybackState state;
+    state.position = playhead.position;
+    state.multiplier = playhead.multiplier;
+    state.loopEnabled = playhead.loopEnabled;
+    state.boomerangMode = playhead.boomerangMode;
+    state.loopStart = playhead.loopStart;
+    state.loopEnd = playhead.loopEnd;
+    double delta = playhead.sampleAdvance * elapsed;
+    state.position += delta;
+    handleLoop(state, fileSize, delta);
+    return state.position;
+}
+
+// --- Throttle for title bar and overlay text ---
+struct UpdateThrottle {
+    double interval = 0.25;
+    double last = -1.0e30;
+};
+
+static inline bool throttleReady(UpdateThrottle& throttle, double now) {
+    if (now - throttle.last < throttle.interval)
+        return false;
+    throttle.last = now;
+    return true;
+}
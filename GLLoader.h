@@ -0,0 +1,239 @@
+#pragma once
+// Minimal loader for the OpenGL entry points above 1.1 used by the renderers.
+// Include after <GLFW/glfw3.h> and call loadGLFunctions() once a context is current.
+#include <GLFW/glfw3.h>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#ifndef APIENTRY
+#define APIENTRY
+#endif
+
+typedef char GLchar;
+
+// --- Enums not present in the GL 1.1 headers shipped with Windows ---
+#ifndef GL_CLAMP_TO_EDGE
+#define GL_CLAMP_TO_EDGE 0x812F
+#endif
+#ifndef GL_TEXTURE0
+#define GL_TEXTURE0 0x84C0
+#endif
+#ifndef GL_TEXTURE1
+#define GL_TEXTURE1 0x84C1
+#endif
+#ifndef GL_RGBA8
+#define GL_RGBA8 0x8058
+#endif
+#ifndef GL_RED
+#define GL_RED 0x1903
+#endif
+#ifndef GL_R8
+#define GL_R8 0x8229
+#endif
+#ifndef GL_RG
+#define GL_RG 0x8227
+#endif
+#ifndef GL_RG8
+#define GL_RG8 0x822B
+#endif
+#ifndef GL_FRAGMENT_SHADER
+#define GL_FRAGMENT_SHADER 0x8B30
+#endif
+#ifndef GL_VERTEX_SHADER
+#define GL_VERTEX_SHADER 0x8B31
+#endif
+#ifndef GL_COMPILE_STATUS
+#define GL_COMPILE_STATUS 0x8B81
+#endif
+#ifndef GL_LINK_STATUS
+#define GL_LINK_STATUS 0x8B82
+#endif
+#ifndef GL_INFO_LOG_LENGTH
+#define GL_INFO_LOG_LENGTH 0x8B84
+#endif
+#ifndef GL_TEXTURE_2D_ARRAY
+#define GL_TEXTURE_2D_ARRAY 0x8C1A
+#endif
+#ifndef GL_MAX_ARRAY_TEXTURE_LAYERS
+#define GL_MAX_ARRAY_TEXTURE_LAYERS 0x88FF
+#endif
+#ifndef GL_R32I
+#define GL_R32I 0x8235
+#endif
+#ifndef GL_RED_INTEGER
+#define GL_RED_INTEGER 0x8D94
+#endif
+#ifndef GL_TEXTURE2
+#define GL_TEXTURE2 0x84C2
+#endif
+#ifndef GL_TIME_ELAPSED
+#define GL_TIME_ELAPSED 0x88BF
+#endif
+#ifndef GL_QUERY_RESULT
+#define GL_QUERY_RESULT 0x8866
+#endif
+#ifndef GL_QUERY_RESULT_AVAILABLE
+#define GL_QUERY_RESULT_AVAILABLE 0x8867
+#endif
+
+// X-macro list: return type, name (without the gl prefix), parameter list.
+#define BWF_GL_FUNCTIONS(X) \
+    X(GLuint, CreateShader, (GLenum type)) \
+    X(void, ShaderSource, (GLuint shader, GLsizei count, const GLchar* const* string, const GLint* length)) \
+    X(void, CompileShader, (GLuint shader)) \
+    X(void, GetShaderiv, (GLuint shader, GLenum pname, GLint* params)) \
+    X(void, GetShaderInfoLog, (GLuint shader, GLsizei bufSize, GLsizei* length, GLchar* infoLog)) \
+    X(void, DeleteShader, (GLuint shader)) \
+    X(GLuint, CreateProgram, (void)) \
+    X(void, AttachShader, (GLuint program, GLuint shader)) \
+    X(void, LinkProgram, (GLuint program)) \
+    X(void, GetProgramiv, (GLuint program, GLenum pname, GLint* params)) \
+    X(void, GetProgramInfoLog, (GLuint program, GLsizei bufSize, GLsizei* length, GLchar* infoLog)) \
+    X(void, DeleteProgram, (GLuint program)) \
+    X(void, UseProgram, (GLuint program)) \
+    X(GLint, GetUniformLocation, (GLuint program, const GLchar* name)) \
+    X(void, Uniform1i, (GLint location, GLint v0)) \
+    X(void, Uniform2i, (GLint location, GLint v0, GLint v1)) \
+    X(void, Uniform1f, (GLint location, GLfloat v0)) \
+    X(void, Uniform4i, (GLint location, GLint v0, GLint v1, GLint v2, GLint v3)) \
+    X(void, ActiveTexture, (GLenum texture)) \
+    X(void, TexImage3D, (GLenum target, GLint level, GLint internalformat, GLsizei width, GLsizei height, GLsizei depth, GLint border, GLenum format, GLenum type, const void* pixels)) \
+    X(void, TexSubImage3D, (GLenum target, GLint level, GLint xoffset, GLint yoffset, GLint zoffset, GLsizei width, GLsizei height, GLsizei depth, GLenum format, GLenum type, const void* pixels))
+
+// GL 3.1 entry points, loaded separately so a 3.0 context keeps the renderers that need only the list above.
+#define BWF_GL_FUNCTIONS_31(X) \
+    X(void, DrawArraysInstanced, (GLenum mode, GLint first, GLsizei count, GLsizei instancecount))
+
+// Timer queries (GL 3.3 or ARB_timer_query), used only by the instrumentation overlay.
+#define BWF_GL_FUNCTIONS_TIMER(X) \
+    X(void, GenQueries, (GLsizei n, GLuint* ids)) \
+    X(void, DeleteQueries, (GLsizei n, const GLuint* ids)) \
+    X(void, BeginQuery, (GLenum target, GLuint id)) \
+    X(void, EndQuery, (GLenum target)) \
+    X(void, GetQueryObjectiv, (GLuint id, GLenum pname, GLint* params)) \
+    X(void, GetQueryObjectui64v, (GLuint id, GLenum pname, unsigned long long* params))
+
+#define BWF_GL_DECLARE(ret, name, params) \
+    typedef ret (APIENTRY* PFN_bwf_gl##name) params; \
+    static PFN_bwf_gl##name bwf_gl##name = nullptr;
+BWF_GL_FUNCTIONS(BWF_GL_DECLARE)
+BWF_GL_FUNCTIONS_31(BWF_GL_DECLARE)
+BWF_GL_FUNCTIONS_TIMER(BWF_GL_DECLARE)
+#undef BWF_GL_DECLARE
+
+// Route the usual names to the loaded pointers (same trick glad uses).
+#define glCreateShader bwf_glCreateShader
+#define glShaderSource bwf_glShaderSource
+#define glCompileShader bwf_glCompileShader
+#define glGetShaderiv bwf_glGetShaderiv
+#define glGetShaderInfoLog bwf_glGetShaderInfoLog
+#define glDeleteShader bwf_glDeleteShader
+#define glCreateProgram bwf_glCreateProgram
+#define glAttachShader bwf_glAttachShader
+#define glLinkProgram bwf_glLinkProgram
+#define glGetProgramiv bwf_glGetProgramiv
+#define glGetProgramInfoLog bwf_glGetProgramInfoLog
+#define glDeleteProgram bwf_glDeleteProgram
+#define glUseProgram bwf_glUseProgram
+#define glGetUniformLocation bwf_glGetUniformLocation
+#define glUniform1i bwf_glUniform1i
+#define glUniform2i bwf_glUniform2i
+#define glUniform1f bwf_glUniform1f
+#define glUniform4i bwf_glUniform4i
+#define glActiveTexture bwf_glActiveTexture
+#define glTexImage3D bwf_glTexImage3D
+#define glTexSubImage3D bwf_glTexSubImage3D
+#define glDrawArraysInstanced bwf_glDrawArraysInstanced
+#define glGenQueries bwf_glGenQueries
+#define glDeleteQueries bwf_glDeleteQueries
+#define glBeginQuery bwf_glBeginQuery
+#define glEndQuery bwf_glEndQuery
+#define glGetQueryObjectiv bwf_glGetQueryObjectiv
+#define glGetQueryObjectui64v bwf_glGetQueryObjectui64v
+
+// Returns the context major version parsed from GL_VERSION (0 if unknown).
+static inline int glContextMajorVersion(void) {
+    const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    return version ? std::atoi(version) : 0;
+}
+
+// True if the context version is at least major.minor.
+static inline bool glContextVersionAtLeast(int major, int minor) {
+    const char* version = reinterpret_cast<const char*>(glGetString(GL_VERSION));
+    if (!version)
+        return false;
+    int contextMajor = std::atoi(version);
+    const char* dot = std::strchr(version, '.');
+    int contextMinor = dot ? std::atoi(dot + 1) : 0;
+    return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+}
+
+// --- Load every entry point; false if any is missing ---
+#define BWF_GL_LOAD(ret, name, params) \
+    bwf_gl##name = reinterpret_cast<PFN_bwf_gl##name>(glfwGetProcAddress("gl" #name)); \
+    if (!bwf_gl##name) ok = false;
+
+static inline bool loadGLFunctions(void) {
+    bool ok = true;
+    BWF_GL_FUNCTIONS(BWF_GL_LOAD)
+    return ok;
+}
+
+static inline bool loadGL31Functions(void) {
+    bool ok = true;
+    BWF_GL_FUNCTIONS_31(BWF_GL_LOAD)
+    return ok;
+}
+
+static inline bool loadGLTimerFunctions(void) {
+    if (!glContextVersionAtLeast(3, 3) && !glfwExtensionSupported("GL_ARB_timer_query"))
+        return false;
+    bool ok = true;
+    BWF_GL_FUNCTIONS_TIMER(BWF_GL_LOAD)
+    return ok;
+}
+#undef BWF_GL_LOAD
+
+// --- Compile and link a vertex/fragment program; 0 on failure (log goes to std::cerr) ---
+static inline GLuint compileShaderStage(GLenum type, const char* source, const char* label) {
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    GLint status = 0;
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+    if (!status) {
+        char log[1024] = { 0 };
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        std::cerr << "Shader compile failed (" << label << "): " << log << std::endl;
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
+
+static inline GLuint buildShaderProgram(const char* vertexSource, const char* fragmentSource, const char* label) {
+    GLuint vs = compileShaderStage(GL_VERTEX_SHADER, vertexSource, label);
+    GLuint fs = compileShaderStage(GL_FRAGMENT_SHADER, fragmentSource, label);
+    if (!vs || !fs) {
+        if (vs) glDeleteShader(vs);
+        if (fs) glDeleteShader(fs);
+        return 0;
+    }
+    GLuint program = glCreateProgram();
+    glAttachShader(program, vs);
+    glAttachShader(program, fs);
+    glLinkProgram(program);
+    glDeleteShader(vs);
+    glDeleteShader(fs);
+    GLint status = 0;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (!status) {
+        char log[1024] = { 0 };
+        glGetProgramInfoLog(program, sizeof(log), NULL, log);
+        std::cerr << "Shader link failed (" << label << "): " << log << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
@@ -0,0 +1,384 @@
+#pragma once
+// Performance counters for diagnosing stutter, and the overlay that shows them (F3).
+// The JACK thread only touches relaxed atomics it alone writes (callback count, busy time, peak,
+// periods over budget); xruns come from the JACK xrun callback. The UI thread adds render CPU time,
+// GPU time from GL_TIME_ELAPSED queries read back a few frames late (so nothing stalls), presented
+// and dropped frames, prefetch misses and the process's major page faults. Every sampleInterval the
+// UI turns the counters into an InstrumentationSample for the overlay and the optional CSV/JSON log.
+// While `enabled` is false the JACK thread skips the clock reads and no queries are issued.
+#include "GLLoader.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+// --- Audio thread counters (single writer) ---
+struct AudioCounters {
+    std::atomic<unsigned long long> callbacks{ 0 };
+    std::atomic<unsigned long long> busyNanos{ 0 };
+    std::atomic<unsigned long long> peakNanos{ 0 };      // longest callback since the last sample
+    std::atomic<unsigned long long> budgetNanos{ 0 };    // length of the last period
+    std::atomic<unsigned long long> overBudget{ 0 };     // callbacks that took longer than their period
+    std::atomic<unsigned long long> xruns{ 0 };
+};
+
+static inline void recordCallback(AudioCounters& counters, unsigned long long nanos, unsigned long long budgetNanos) {
+    counters.callbacks.store(counters.callbacks.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    counters.busyNanos.store(counters.busyNanos.load(std::memory_order_relaxed) + nanos, std::memory_order_relaxed);
+    if (nanos > counters.peakNanos.load(std::memory_order_relaxed))
+        counters.peakNanos.store(nanos, std::memory_order_relaxed);
+    counters.budgetNanos.store(budgetNanos, std::memory_order_relaxed);
+    if (nanos > budgetNanos)
+        counters.overBudget.store(counters.overBudget.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+// --- GPU timer ---
+const int GPU_TIMER_QUERIES = 4;
+
+struct GpuTimer {
+    bool ready = false;
+    GLuint queries[GPU_TIMER_QUERIES] = { 0 };
+    bool issued[GPU_TIMER_QUERIES] = { false };
+    int next = 0;
+    bool active = false;
+    double millis = 0.0;             // smoothed
+};
+
+static inline bool initGpuTimer(GpuTimer& timer) {
+    if (timer.ready)
+        return true;
+    if (!loadGLTimerFunctions())
+        return false;
+    glGenQueries(GPU_TIMER_QUERIES, timer.queries);
+    timer.ready = true;
+    return true;
+}
+
+static inline void destroyGpuTimer(GpuTimer& timer) {
+    if (timer.ready)
+        glDeleteQueries(GPU_TIMER_QUERIES, timer.queries);
+    timer = GpuTimer();
+}
+
+// Reads back every finished query, then starts one in the next free slot (skipped if all four
+// are still in flight).
+static inline void beginGpuTimer(GpuTimer& timer) {
+    timer.active = false;
+    if (!timer.ready)
+        return;
+    for (int i = 0; i < GPU_TIMER_QUERIES; i++) {
+        if (!timer.issued[i])
+            continue;
+        GLint available = 0;
+        glGetQueryObjectiv(timer.queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+        if (!available)
+            continue;
+        unsigned long long nanos = 0;
+        glGetQueryObjectui64v(timer.queries[i], GL_QUERY_RESULT, &nanos);
+        // Some drivers return garbage for a query spanning a disjoint event; nothing here takes a second.
+        if (nanos < 1000000000ULL)
+            timer.millis += (static_cast<double>(nanos) * 1.0e-6 - timer.millis) * 0.1;
+        timer.issued[i] = false;
+    }
+    if (timer.issued[timer.next])
+        return;
+    glBeginQuery(GL_TIME_ELAPSED, timer.queries[timer.next]);
+    timer.active = true;
+}
+
+static inline void endGpuTimer(GpuTimer& timer) {
+    if (!timer.active)
+        return;
+    glEndQuery(GL_TIME_ELAPSED);
+    timer.issued[timer.next] = true;
+    timer.next = (timer.next + 1) % GPU_TIMER_QUERIES;
+    timer.active = false;
+}
+
+// --- Samples and log ---
+struct InstrumentationSample {
+    double time = 0.0;
+    unsigned long long callbacks = 0;
+    double callbackAvgMicros = 0.0;     // over the last interval
+    double callbackPeakMicros = 0.0;
+    double budgetMicros = 0.0;
+    unsigned long long overBudget = 0;
+    unsigned long long xruns = 0;
+    double renderCpuMillis = 0.0;
+    double renderGpuMillis = -1.0;      // -1 without timer queries
+    unsigned long long presented = 0;
+    unsigned long long dropped = 0;
+    unsigned long long prefetchMisses = 0;
+    unsigned long long pageFaults = 0;  // major faults since startup
+};
+
+struct Instrumentation {
+    std::atomic<bool> enabled{ false };
+    bool overlayVisible = false;
+    double sampleInterval = 0.5;
+    AudioCounters audio;
+    GpuTimer gpu;
+    double renderCpuMillis = 0.0;       // smoothed
+    std::chrono::steady_clock::time_point renderStart;
+    unsigned long long sampledCallbacks = 0;
+    unsigned long long sampledBusyNanos = 0;
+    double lastSampleTime = -1.0e30;
+    InstrumentationSample sample;
+    FILE* log = nullptr;
+    bool logJson = false;
+};
+
+// Hard faults are what stall on disk; Windows only reports all faults together.
+static inline unsigned long long processPageFaults(void) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+        return counters.PageFaultCount;
+    return 0;
+#else
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        return static_cast<unsigned long long>(usage.ru_majflt);
+    return 0;
+#endif
+}
+
+// A path ending in .json or .jsonl gets one JSON object per line, anything else CSV.
+static inline bool openInstrumentationLog(Instrumentation& instrumentation, const std::string& path) {
+    instrumentation.log = std::fopen(path.c_str(), "w");
+    if (!instrumentation.log) {
+        std::cerr << "Error: Could not create stats log: " << path << std::endl;
+        return false;
+    }
+    size_t dot = path.find_last_of('.');
+    std::string extension = (dot == std::string::npos) ? "" : path.substr(dot);
+    instrumentation.logJson = (extension == ".json" || extension == ".jsonl");
+    if (!instrumentation.logJson)
+        std::fprintf(instrumentation.log, "time,callbacks,callback_avg_us,callback_peak_us,budget_us,over_budget,xruns,"
+            "render_cpu_ms,render_gpu_ms,presented,dropped,prefetch_misses,page_faults\n");
+    instrumentation.enabled = true;
+    return true;
+}
+
+static inline void closeInstrumentationLog(Instrumentation& instrumentation) {
+    if (instrumentation.log)
+        std::fclose(instrumentation.log);
+    instrumentation.log = nullptr;
+}
+
+static inline void writeInstrumentationSample(FILE* file, bool json, const InstrumentationSample& s) {
+    if (json)
+        std::fprintf(file, "{\"time\": %.3f, \"callbacks\": %llu, \"callback_avg_us\": %.2f, \"callback_peak_us\": %.2f, "
+            "\"budget_us\": %.2f, \"over_budget\": %llu, \"xruns\": %llu, \"render_cpu_ms\": %.3f, \"render_gpu_ms\": %.3f, "
+            "\"presented\": %llu, \"dropped\": %llu, \"prefetch_misses\": %llu, \"page_faults\": %llu}\n",
+            s.time, s.callbacks, s.callbackAvgMicros, s.callbackPeakMicros, s.budgetMicros, s.overBudget, s.xruns,
+            s.renderCpuMillis, s.renderGpuMillis, s.presented, s.dropped, s.prefetchMisses, s.pageFaults);
+    else
+        std::fprintf(file, "%.3f,%llu,%.2f,%.2f,%.2f,%llu,%llu,%.3f,%.3f,%llu,%llu,%llu,%llu\n",
+            s.time, s.callbacks, s.callbackAvgMicros, s.callbackPeakMicros, s.budgetMicros, s.overBudget, s.xruns,
+            s.renderCpuMillis, s.renderGpuMillis, s.presented, s.dropped, s.prefetchMisses, s.pageFaults);
+    std::fflush(file);
+}
+
+// --- UI thread hooks ---
+static inline void beginRenderTiming(Instrumentation& instrumentation) {
+    if (!instrumentation.enabled.load(std::memory_order_relaxed))
+        return;
+    instrumentation.renderStart = std::chrono::steady_clock::now();
+    beginGpuTimer(instrumentation.gpu);
+}
+
+static inline void endRenderTiming(Instrumentation& instrumentation) {
+    if (!instrumentation.enabled.load(std::memory_order_relaxed))
+        return;
+    endGpuTimer(instrumentation.gpu);
+    double millis = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - instrumentation.renderStart).count();
+    instrumentation.renderCpuMillis += (millis - instrumentation.renderCpuMillis) * 0.1;
+}
+
+// Takes a sample once per sampleInterval (and logs it); returns true when it did.
+static inline bool updateInstrumentation(Instrumentation& instrumentation, double now, unsigned long long presented,
+    unsigned long long dropped, unsigned long long prefetchMisses) {
+    if (!instrumentation.enabled.load(std::memory_order_relaxed) ||
+        now - instrumentation.lastSampleTime < instrumentation.sampleInterval)
+        return false;
+    instrumentation.lastSampleTime = now;
+    AudioCounters& audio = instrumentation.audio;
+    InstrumentationSample& sample = instrumentation.sample;
+    unsigned long long callbacks = audio.callbacks.load(std::memory_order_relaxed);
+    unsigned long long busy = audio.busyNanos.load(std::memory_order_relaxed);
+    unsigned long long intervalCallbacks = callbacks - instrumentation.sampledCallbacks;
+    sample.time = now;
+    sample.callbacks = callbacks;
+    sample.callbackAvgMicros = intervalCallbacks
+        ? static_cast<double>(busy - instrumentation.sampledBusyNanos) * 1.0e-3 / static_cast<double>(intervalCallbacks) : 0.0;
+    sample.callbackPeakMicros = static_cast<double>(audio.peakNanos.exchange(0, std::memory_order_relaxed)) * 1.0e-3;
+    sample.budgetMicros = static_cast<double>(audio.budgetNanos.load(std::memory_order_relaxed)) * 1.0e-3;
+    sample.overBudget = audio.overBudget.load(std::memory_order_relaxed);
+    sample.xruns = audio.xruns.load(std::memory_order_relaxed);
+    sample.renderCpuMillis = instrumentation.renderCpuMillis;
+    sample.renderGpuMillis = instrumentation.gpu.ready ? instrumentation.gpu.millis : -1.0;
+    sample.presented = presented;
+    sample.dropped = dropped;
+    sample.prefetchMisses = prefetchMisses;
+    sample.pageFaults = processPageFaults();
+    instrumentation.sampledCallbacks = callbacks;
+    instrumentation.sampledBusyNanos = busy;
+    if (instrumentation.log)
+        writeInstrumentationSample(instrumentation.log, instrumentation.logJson, sample);
+    return true;
+}
+
+// --- Overlay ---
+// 5x7 bitmap font for ' '..'_' (lowercase is drawn as uppercase); bit 4 is the leftmost column.
+static const unsigned char OVERLAY_FONT[64][7] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // ' '
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '!'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '"'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '#'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '$'
+    { 0x18, 0x19, 0x02, 0x04, 0x08, 0x13, 0x03 },   // '%'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '&'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '''
+    { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 },   // '('
+    { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 },   // ')'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '*'
+    { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 },   // '+'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // ','
+    { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 },   // '-'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C },   // '.'
+    { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 },   // '/'
+    { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E },   // '0'
+    { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E },   // '1'
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F },   // '2'
+    { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E },   // '3'
+    { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 },   // '4'
+    { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E },   // '5'
+    { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E },   // '6'
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 },   // '7'
+    { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E },   // '8'
+    { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C },   // '9'
+    { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 },   // ':'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // ';'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '<'
+    { 0x00, 0x00, 0x1F, 0x00, 0x1F, 0x00, 0x00 },   // '='
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '>'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '?'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '@'
+    { 0x0E, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },   // 'A'
+    { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E },   // 'B'
+    { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E },   // 'C'
+    { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C },   // 'D'
+    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F },   // 'E'
+    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 },   // 'F'
+    { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F },   // 'G'
+    { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 },   // 'H'
+    { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E },   // 'I'
+    { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C },   // 'J'
+    { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 },   // 'K'
+    { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F },   // 'L'
+    { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 },   // 'M'
+    { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 },   // 'N'
+    { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },   // 'O'
+    { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 },   // 'P'
+    { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D },   // 'Q'
+    { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 },   // 'R'
+    { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E },   // 'S'
+    { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 },   // 'T'
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E },   // 'U'
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 },   // 'V'
+    { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A },   // 'W'
+    { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 },   // 'X'
+    { 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04, 0x04 },   // 'Y'
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F },   // 'Z'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '['
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '\'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // ']'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '^'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 },   // '_'
+};
+
+static inline void drawOverlayText(float x, float y, float pixel, const char* text) {
+    for (const char* c = text; *c; c++, x += 6.0f * pixel) {
+        int code = static_cast<unsigned char>(*c);
+        if (code >= 'a' && code <= 'z')
+            code -= 'a' - 'A';
+        if (code < 32 || code >= 96)
+            continue;
+        const unsigned char* glyph = OVERLAY_FONT[code - 32];
+        for (int row = 0; row < 7; row++) {
+            for (int column = 0; column < 5; column++) {
+                if (!(glyph[row] & (0x10 >> column)))
+                    continue;
+                float x1 = x + column * pixel, y1 = y + row * pixel;
+                glVertex2f(x1, y1);
+                glVertex2f(x1 + pixel, y1);
+                glVertex2f(x1 + pixel, y1 + pixel);
+                glVertex2f(x1, y1 + pixel);
+            }
+        }
+    }
+}
+
+// Top-left panel; the bar under the audio line is the peak callback time against the period.
+static inline void renderInstrumentationOverlay(const Instrumentation& instrumentation) {
+    const InstrumentationSample& s = instrumentation.sample;
+    char lines[6][96];
+    double load = (s.budgetMicros > 0.0) ? s.callbackPeakMicros / s.budgetMicros : 0.0;
+    std::snprintf(lines[0], sizeof(lines[0]), "JACK %.1f US AVG  %.1f US PEAK  / %.1f US (%.0f%%)",
+        s.callbackAvgMicros, s.callbackPeakMicros, s.budgetMicros, load * 100.0);
+    std::snprintf(lines[1], sizeof(lines[1]), "XRUNS %llu  LATE CALLBACKS %llu", s.xruns, s.overBudget);
+    if (s.renderGpuMillis >= 0.0)
+        std::snprintf(lines[2], sizeof(lines[2]), "RENDER CPU %.2f MS  GPU %.2f MS", s.renderCpuMillis, s.renderGpuMillis);
+    else
+        std::snprintf(lines[2], sizeof(lines[2]), "RENDER CPU %.2f MS  GPU N/A", s.renderCpuMillis);
+    std::snprintf(lines[3], sizeof(lines[3]), "FRAMES %llu SHOWN  %llu DROPPED", s.presented, s.dropped);
+    std::snprintf(lines[4], sizeof(lines[4]), "PREFETCH MISSES %llu  PAGE FAULTS %llu", s.prefetchMisses, s.pageFaults);
+    std::snprintf(lines[5], sizeof(lines[5]), "%llu CALLBACKS", s.callbacks);
+    const float pixel = 2.0f, lineHeight = 9.0f * pixel, margin = 8.0f;
+    size_t longest = 0;
+    for (int i = 0; i < 6; i++)
+        longest = std::max(longest, std::strlen(lines[i]));
+    float width = static_cast<float>(longest) * 6.0f * pixel + 2.0f * margin;
+    float height = 6.0f * lineHeight + 8.0f + 2.0f * margin;
+    const float barWidth = width - 2.0f * margin;
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    glBegin(GL_QUADS);
+    glColor4ub(0, 0, 0, 176);
+    glVertex2f(0.0f, 0.0f);
+    glVertex2f(width, 0.0f);
+    glVertex2f(width, height);
+    glVertex2f(0.0f, height);
+    // Callback load bar: green below half the period, then yellow, red when late.
+    float barTop = margin + lineHeight;
+    float filled = static_cast<float>(std::min(load, 1.0)) * barWidth;
+    glColor4ub(48, 48, 48, 255);
+    glVertex2f(margin, barTop);
+    glVertex2f(margin + barWidth, barTop);
+    glVertex2f(margin + barWidth, barTop + 4.0f);
+    glVertex2f(margin, barTop + 4.0f);
+    if (load < 0.5) glColor4ub(64, 200, 64, 255);
+    else if (load < 1.0) glColor4ub(220, 200, 48, 255);
+    else glColor4ub(230, 48, 48, 255);
+    glVertex2f(margin, barTop);
+    glVertex2f(margin + filled, barTop);
+    glVertex2f(margin + filled, barTop + 4.0f);
+    glVertex2f(margin, barTop + 4.0f);
+    glColor4ub(255, 255, 255, 255);
+    float y = margin;
+    for (int i = 0; i < 6; i++) {
+        drawOverlayText(margin, y, pixel, lines[i]);
+        y += lineHeight + (i == 0 ? 8.0f : 0.0f);
+    }
+    glEnd();
+    glDisable(GL_BLEND);
+}
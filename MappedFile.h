@@ -0,0 +1,108 @@
+#pragma once
+// Read-only memory-mapped file source.
+// The file is mapped instead of read, so startup cost does not depend on file size and the
+// resident set only covers the pages that playback and rendering actually touch.
+#include <cstddef>
+#include <string>
+#include <iostream>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// --- Read-only byte view ---
+// Mirrors the parts of std::vector<unsigned char> the player uses, so jackProcessCallback and
+// renderFrame work the same whether the bytes come from a mapping or from memory.
+struct ByteView {
+    const unsigned char* bytes = nullptr;
+    size_t length = 0;
+
+    const unsigned char* data() const { return bytes; }
+    size_t size() const { return length; }
+    bool empty() const { return length == 0; }
+    const unsigned char& operator[](size_t index) const { return bytes[index]; }
+};
+
+// --- Mapped file ---
+struct MappedFile {
+    ByteView view;
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+    HANDLE mappingHandle = NULL;
+#else
+    int fd = -1;
+#endif
+};
+
+static inline void closeMappedFile(MappedFile& file) {
+#ifdef _WIN32
+    if (file.view.bytes)
+        UnmapViewOfFile(file.view.bytes);
+    if (file.mappingHandle)
+        CloseHandle(file.mappingHandle);
+    if (file.fileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle(file.fileHandle);
+    file.mappingHandle = NULL;
+    file.fileHandle = INVALID_HANDLE_VALUE;
+#else
+    if (file.view.bytes)
+        munmap(const_cast<unsigned char*>(file.view.bytes), file.view.length);
+    if (file.fd >= 0)
+        ::close(file.fd);
+    file.fd = -1;
+#endif
+    file.view = ByteView();
+}
+
+// Map the whole file read-only. Empty files are rejected since they cannot be mapped.
+static inline bool openMappedFile(MappedFile& file, const std::string& filename) {
+    closeMappedFile(file);
+#ifdef _WIN32
+    file.fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file.fileHandle == INVALID_HANDLE_VALUE) {
+        std::cerr << "Error: Could not open file: " << filename << std::endl;
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file.fileHandle, &fileSize) || fileSize.QuadPart <= 0) {
+        std::cerr << "Error: File is empty." << std::endl;
+        closeMappedFile(file);
+        return false;
+    }
+    file.mappingHandle = CreateFileMappingA(file.fileHandle, NULL, PAGE_READONLY, 0, 0, NULL);
+    const void* base = file.mappingHandle ? MapViewOfFile(file.mappingHandle, FILE_MAP_READ, 0, 0, 0) : NULL;
+    if (!base) {
+        std::cerr << "Error: Failed to map file: " << filename << std::endl;
+        closeMappedFile(file);
+        return false;
+    }
+    file.view.bytes = static_cast<const unsigned char*>(base);
+    file.view.length = static_cast<size_t>(fileSize.QuadPart);
+#else
+    file.fd = ::open(filename.c_str(), O_RDONLY);
+    if (file.fd < 0) {
+        std::cerr << "Error: Could not open file: " << filename << std::endl;
+        return false;
+    }
+    struct stat st;
+    if (fstat(file.fd, &st) != 0 || st.st_size <= 0) {
+        std::cerr << "Error: File is empty." << std::endl;
+        closeMappedFile(file);
+        return false;
+    }
+    void* base = mmap(NULL, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, file.fd, 0);
+    if (base == MAP_FAILED) {
+        std::cerr << "Error: Failed to map file: " << filename << std::endl;
+        closeMappedFile(file);
+        return false;
+    }
+    file.view.bytes = static_cast<const unsigned char*>(base);
+    file.view.length = static_cast<size_t>(st.st_size);
+#endif
+    return true;
+}
@@ -0,0 +1,40 @@
+#pragma once
+// Pinning the memory the audio thread reads (--realtime): a page it touches must never need a
+// disk read, and a swapped-out buffer stalls the JACK callback just as a page of the mapping
+// would. Locking also faults the pages in. Locks count against RLIMIT_MEMLOCK on POSIX (raised
+// for the audio group on most JACK setups) and against the working-set minimum on Windows, which
+// is grown as needed. The mapped file itself is never locked, only the buffers fed from it.
+#include <cstddef>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#endif
+
+static inline bool lockMemory(const void* address, size_t length) {
+    if (!address || length == 0)
+        return true;
+#ifdef _WIN32
+    void* pages = const_cast<void*>(address);
+    if (VirtualLock(pages, length))
+        return true;
+    SIZE_T minimum = 0, maximum = 0;
+    if (GetLastError() != ERROR_WORKING_SET_QUOTA ||
+        !GetProcessWorkingSetSize(GetCurrentProcess(), &minimum, &maximum) ||
+        !SetProcessWorkingSetSize(GetCurrentProcess(), minimum + length, maximum + length))
+        return false;
+    return VirtualLock(pages, length) != 0;
+#else
+    return mlock(address, length) == 0;
+#endif
+}
+
+static inline void unlockMemory(const void* address, size_t length) {
+    if (!address || length == 0)
+        return;
+#ifdef _WIN32
+    VirtualUnlock(const_cast<void*>(address), length);
+#else
+    munlock(address, length);
+#endif
+}
@@ -1,207 +1,513 @@
 #include <GLFW/glfw3.h>
+#ifdef _WIN32
+#include <winsock2.h>  // before windows.h, for StreamSource.h
 #include <windows.h>
-#include <commdlg.h>
+#endif
 #include <iostream>
-#include <fstream>
-#include <vector>
 #include <string>
 #include <cmath>
+#include <cctype>
+#include <cstring>
 #include <jack/jack.h>
-#include <thread>
 #include <chrono>
+#include <atomic>
+#include "FrameRenderer.h"
+#include "MappedFile.h"
+#include "Playback.h"
+#include "ControlChannel.h"
+#include "FrameGeometry.h"
+#include "FrameScheduler.h"
+#include "PrefetchRing.h"
+#include "Scope.h"
+#include "FrameAnalysis.h"
+#include "FrameDiff.h"
+#include "FileDialog.h"
+#include "Instrumentation.h"
+#include "PatternSearch.h"
+#include "Playlist.h"
+#include "Session.h"
+#include "SoftwareRenderer.h"
+#include "StreamSource.h"
 
 // Configuration constants
-#define FRAME_WIDTH 64
-#define FRAME_HEIGHT 128
 #define BASE_FRAME_RATE 24   // The baseline visual frame rate (24 FPS)
 #define WINDOW_SCALE 4       // Fixed pixel size scale
 
-const double VISUAL_FPS_CAP = 24.0; // How often we redraw the window
+const int OVERVIEW_BAR_HEIGHT = 48;      // Height of the whole-file overview bar (toggled with O)
+const int THUMBNAIL_STRIP_HEIGHT = 72;   // Height of the thumbnail strip (toggled with T)
+const int THUMBNAIL_PREVIEW_SCALE = 4;   // Hover preview size, in strip thumbnails
+const double DEFAULT_TARGET_FPS = 60.0; // Presentation rate when --fps is not given and the refresh rate is unknown
 
 // Global file data and state
-std::vector<unsigned char> fileData;
+// Files to play (command line, directories, drag-and-drop), switched with Tab / Shift+Tab
+Playlist playlist;
+MediaLoader mediaLoader;
+std::unique_ptr<MediaSource> currentMedia;   // mapping, prefetch ring and overview of the open file
+std::unique_ptr<MediaSource> retiringMedia;  // previous source until the audio thread has let go of it
+uint32_t mediaGeneration = 0;                // CMD_SWAP_MEDIA commands sent
+long long pendingPlaylistIndex = -1;         // entry to switch to once the loader has opened it
+ByteView fileData;       // View of the current mapping used by rendering
 size_t totalFrames = 0;  // Total number of frames in the file
 
+// Live stream (--stream) instead of files: its history size (--stream-history) and the follower
+// that keeps the playhead --stream-latency seconds behind the arriving bytes (toggled with E)
+std::string streamSpec;
+size_t streamHistoryBytes = STREAM_DEFAULT_HISTORY_BYTES;
+StreamFollower streamFollower;
+bool followStream = true;
+unsigned long long streamSeen = 0;   // stream bytes received as of the last redraw
+
+// Frame geometry (--geometry on the command line, cycled with G) and pixel format (--pixel-format, V)
+FrameGeometry frameGeometry;
+
 // Playback state
-bool isPaused = false;
 bool isFullscreen = false;
-bool isAudioEnabled = true;
-// playbackMultiplier multiplies the baseline frame rate (default = 1.0 means 24 FPS)
-double playbackMultiplier = 1.0;
-float audioVolume = 1.0f;
-// audioPosition is measured in bytes (the offset into fileData)
-double audioPosition = 0.0;
-
-// Looping/boomerang (loopStart/loopEnd in bytes)
-bool loopEnabled = true;
-bool boomerangMode = false;
-double loopStart = 0.0;
-double loopEnd = 0.0;
+// Playhead, speed, loop, pause, mute and volume. Owned by the JACK thread while it runs (the UI
+// thread owns it otherwise); everyone else talks to it through controlChannel.
+AudioEngineState audioEngine;
+ControlChannel controlChannel;
+std::atomic<bool> audioThreadActive(false);
 
 // JACK globals
 jack_client_t* jackClient = NULL;
-jack_port_t* outputPortLeft = NULL;
-jack_port_t* outputPortRight = NULL;
-jack_nframes_t sampleRate = 44100; // Determined at runtime
+// output_left and output_right, then output_3 ... as layouts with more channels need them. Ports below
+// outputPortCount never change while the client runs, so the callback reads them without locking.
+jack_port_t* outputPorts[MAX_AUDIO_CHANNELS] = { NULL };
+std::atomic<unsigned> outputPortCount(0);
+// Server rate and period length. Written by the JACK callbacks when the server changes them, read
+// everywhere else.
+std::atomic<jack_nframes_t> sampleRate(44100);
+std::atomic<jack_nframes_t> bufferFrames(0);
+// Set by the shutdown callback; the UI thread then drops the dead client and reconnects
+// (maintainJackAudio) every JACK_RECONNECT_SECONDS until the server is back.
+const double JACK_RECONNECT_SECONDS = 2.0;
+std::atomic<bool> jackServerLost(false);
+bool jackReconnecting = false;
+double nextJackReconnect = 0.0;
+// --realtime: ring buffers and audio state locked in memory, no fallback reads of the mapping
+// from the callback, and a warning when the server is not running with real-time scheduling.
+bool realtimeMode = false;
 
 // Visual scaling (for fixed pixel size)
 int windowScale = WINDOW_SCALE;
 
+// Sample format (cycled with S) and channel count (Shift+S) the audio thread decodes, and the
+// native rate layouts other than u8 mono play at (--pcm-rate)
+AudioLayout audioLayout;
+double pcmRate = 44100.0;
+
+// Active color map (cycled with P)
+PaletteId currentPalette = PALETTE_RAINBOW;
+
+// GPU renderer state: the texture-array renderer needs GL 3.1, the atlas renderer GL 3.0
+TileArrayRenderer tileArrayRenderer;
+TextureRenderer textureRenderer;
+
+// CPU tile renderer with a cache of colorized frames: the fallback below GL 3.0, forced with --cpu or C
+SoftwareRenderer softwareRenderer;
+bool softwareRendering = false;
+
+// Waterfall mode (W): one continuous, smoothly scrolling strip of rows instead of whole frames
+WaterfallRenderer waterfallRenderer;
+bool waterfallMode = false;
+
+// Extra views (--view): more windows in the main window's GL share group, each showing the file at
+// its own offset from the playhead, with its own geometry, scale and palette when given (otherwise
+// the main window's). They are drawn in the main window's scheduler pass; views with the main
+// frame size share its texture-array renderer, so a frame visible in several views is uploaded once.
+struct PlayerView {
+    GLFWwindow* window = NULL;
+    double offset = 0.0;               // bytes from the playhead
+    bool ownGeometry = false;
+    FrameGeometry geometry;
+    int scale = WINDOW_SCALE;
+    bool ownPalette = false;
+    PaletteId palette = PALETTE_RAINBOW;
+    int monitor = -1;                  // fullscreen on this monitor at start (-1: windowed)
+    TileArrayRenderer tiles;           // used while the frame size differs from the main window's
+    WaterfallRenderer waterfall;
+    SoftwareRenderer software;
+    std::string title;
+};
+std::vector<std::unique_ptr<PlayerView>> views;
+GLFWwindow* mainWindow = NULL;
+
+// Whole-file overview: loaded from <file>.bwfov or built in the background on first open
+OverviewIndex overviewIndex;
+OverviewBuilder overviewBuilder;
+std::vector<OverviewBlock> overviewColumns;  // per-pixel summaries for the current window width
+bool showOverview = false;
+bool overviewScrubbing = false;
+
+// Thumbnail strip (T): previews spread across the file along the bottom (above the overview bar),
+// built off the render thread and kept in a GPU atlas. Hovering a thumbnail or the overview bar
+// shows a larger preview from the atlas; clicking a thumbnail seeks to its frame.
+ThumbnailBuilder thumbnailBuilder;
+ThumbnailAtlas thumbnailAtlas;
+bool showThumbnails = false;
+std::vector<size_t> thumbnailFrames;         // per strip slot, as last drawn
+std::vector<ThumbnailQuad> thumbnailQuads;   // where they were drawn (framebuffer pixels)
+std::vector<Thumbnail> thumbnailResults;
+int thumbnailPressedSlot = -1;               // slot the left button went down on
+
+// Spectrogram panel (A): the audio output analyzed on its own thread, drawn over the right third
+SpectrogramAnalyzer spectrogram;
+SpectrogramRenderer spectrogramRenderer;
+bool showSpectrogram = false;
+
+// Oscilloscope overlay (Y): the byte runs the audio played since the last presented frame, traced
+// across the top quarter of the window; the last ones stay up while nothing plays
+ScopeRenderer scopeRenderer;
+bool showScope = false;
+PlayedRuns scopeRuns;
+std::vector<unsigned char> scopeColumns;
+
+// Per-frame entropy/zero-run/ASCII statistics, rescanned when the geometry changes (H/J jump)
+FrameAnalysis frameAnalysis;
+FrameAnalyzer frameAnalyzer;
+
+// Compare mode (--diff FILE and/or --diff-offset BYTES): every frame is shown against the same
+// frame of the other file, or of this file OFFSET bytes further on. X cycles the display, D jumps
+// between differing frames using the changed-byte index built in the background.
+MappedFile diffFile;
+std::string diffPath;
+size_t diffOffset = 0;
+bool diffEnabled = false;
+DiffDisplay diffDisplay = DIFF_XOR;
+FrameDiffIndex diffIndex;
+FrameDiffer frameDiffer;
+std::vector<unsigned char> diffFrames;   // the visible frames of the difference, rebuilt each redraw
+
+// Pattern search (--search, or / to type one): matches are marked on the tiles as the scan finds
+// them, and N / Shift+N jump to the frame of the next or previous one.
+PatternSet searchPatterns;
+PatternSearch patternSearch;
+std::vector<SearchMatch> searchMatches;
+bool searchPromptActive = false;
+std::string searchPromptText;
+
+// Sessions (<file>.bwfsession): saved on switching away from a file and at exit, restored when it
+// is opened again along with the analysis and search indexes they point to. Off with --no-session.
+bool useSessions = true;
+
 // Monitor and timing
 GLFWmonitor* primaryMonitor = NULL;
 double lastInputTime = 0.0;
 
+// Counters and timing for the F3 overlay and the --stats-log file
+Instrumentation instrumentation;
+std::string statsLogPath;
+
+// Presentation pacing (--fps sets the target; 0 means the monitor refresh rate)
+FrameScheduler frameScheduler;
+double requestedFps = 0.0;
+bool usingAudioClock = false;
+uint64_t audioClockFrames = 0;   // jack_frame_time() extended to 64 bits
+
 // --- Forward declarations ---
-std::string openFileDialog(void);
 bool loadMediaFile(const std::string& filename);
-double calculateLogAdjustment(double currentMultiplier);
+bool activateMediaSource(std::unique_ptr<MediaSource> source);
+void switchPlaylistEntry(int step);
+void updatePlaylist(void);
+bool applyFrameGeometry(GLFWwindow* window, const FrameGeometry& geometry);
+void useFrameGeometry(GLFWwindow* window, const FrameGeometry& geometry);
+void saveCurrentSession(void);
 void processInput(GLFWwindow* window);
-void renderFrame(GLFWwindow* window);
+void renderFrame(GLFWwindow* window, const PlayheadSnapshot& playhead);
+void renderViews(const PlayheadSnapshot& playhead);
+void renderOverview(int windowWidth, int windowHeight, const PlayheadSnapshot& playhead, const PaletteLUT& palette);
+void renderThumbnailStrip(GLFWwindow* window, int windowWidth, int windowHeight, const PlayheadSnapshot& playhead,
+    const PaletteLUT& palette);
 void toggleFullscreen(GLFWwindow* window, int windowWidth, int windowHeight);
+GLFWmonitor* monitorForWindow(GLFWwindow* window);
 void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
-bool initJackAudio(void);
+void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods);
+int thumbnailSlotAt(GLFWwindow* window, double x, double y);
+void cursorPosCallback(GLFWwindow* window, double x, double y);
+void dropCallback(GLFWwindow* window, int count, const char** paths);
+void charCallback(GLFWwindow* window, unsigned int codepoint);
+bool initJackAudio(bool reconnect);
+void maintainJackAudio(double now);
+bool ensureOutputPorts(unsigned count);
+void connectOutputPorts(unsigned first);
+bool setAudioLayout(const AudioLayout& layout);
 void closeJackAudio(void);
 
-// --- Utility: Wrap a position into [0, fileSize) ---
-static inline double wrapPosition(double pos, double fileSize) {
-    if (pos < 0.0) {
-        pos = std::fmod(pos, fileSize);
-        if (pos < 0.0) pos += fileSize;
-    }
-    else if (pos >= fileSize) {
-        pos = std::fmod(pos, fileSize);
-    }
-    return pos;
-}
+// --- Period plan ---
+// What the callback derives from the server rate, period length, frame size and layout, kept by
+// the audio thread and recomputed only when one of them changes (not every period).
+struct AudioPeriodPlan {
+    jack_nframes_t sampleRate = 0;
+    jack_nframes_t bufferFrames = 0;
+    double frameBytes = 0.0;
+    double pcmRate = 0.0;
+    AudioLayout layout;
+    double baseAdvance = 0.0;                 // bytes per output sample at multiplier 1
+    unsigned long long budgetNanos = 0;       // length of one period
+};
 
-// --- Loop handling ---
-static inline void handleLoop(double fileSize, double advance) {
-    if (!loopEnabled) {
-        audioPosition = wrapPosition(audioPosition, fileSize);
+AudioPeriodPlan periodPlan;
+
+void updatePeriodPlan(AudioPeriodPlan& plan, jack_nframes_t nframes) {
+    const jack_nframes_t rate = sampleRate.load(std::memory_order_relaxed);
+    const AudioLayout& layout = audioEngine.layout;
+    if (rate == plan.sampleRate && nframes == plan.bufferFrames && audioEngine.frameBytes == plan.frameBytes &&
+        audioEngine.pcmRate == plan.pcmRate && encodeAudioLayout(layout) == encodeAudioLayout(plan.layout))
         return;
-    }
-    bool forward = (advance > 0.0);
-    if (loopStart == loopEnd) {
-        audioPosition = loopStart;
+    plan.sampleRate = rate;
+    plan.bufferFrames = nframes;
+    plan.frameBytes = audioEngine.frameBytes;
+    plan.pcmRate = audioEngine.pcmRate;
+    plan.layout = layout;
+    plan.baseAdvance = isByteLayout(layout)
+        ? (plan.frameBytes * BASE_FRAME_RATE) / static_cast<double>(rate)
+        : static_cast<double>(audioFrameBytes(layout)) * plan.pcmRate / static_cast<double>(rate);
+    plan.budgetNanos = static_cast<unsigned long long>(nframes) * 1000000000ULL / rate;
+}
+
+// --- JACK period ---
+// Applies queued UI commands, then generates the period in blocks: runs between loop/boomerang/wrap
+// boundaries are filled by a tight loop, and loop handling only runs at the split points (see
+// renderPlaybackBlock). Samples come from the current source's prefetch ring when it is running
+// (chunks around the playhead, read ahead so the callback never page-faults on the mapping), so a
+// chunk that is not resident yet plays silence instead of faulting. A playlist switch arrives as
+// CMD_SWAP_MEDIA and takes effect for the whole period. Mono goes to both the left and right
+// ports; a layout with N channels fills the first N ports and silences the rest. The resulting
+// playhead is published for the UI and the I/O thread, with the byte runs played since the UI last
+// took them (for the scope). Never blocks, allocates or does I/O; with --realtime a file whose
+// ring is not running plays silence rather than touch the mapping.
+void processAudioPeriod(jack_nframes_t nframes) {
+    const unsigned portCount = outputPortCount.load(std::memory_order_acquire);
+    jack_default_audio_sample_t* outs[MAX_AUDIO_CHANNELS];
+    for (unsigned port = 0; port < portCount; port++)
+        outs[port] = (jack_default_audio_sample_t*)jack_port_get_buffer(outputPorts[port], nframes);
+    applyPendingCommands(controlChannel, audioEngine);
+    PlayedRuns* played = collectPlayedRuns(controlChannel, audioEngine);
+    updatePeriodPlan(periodPlan, nframes);
+    audioEngine.clockFrame = jack_last_frame_time(jackClient);
+    audioEngine.periodFrames = nframes;
+    MediaSource* media = audioEngine.media;
+    const AudioLayout layout = audioEngine.layout;
+    if (audioEngine.paused || !audioEngine.audioEnabled || !media || media->file.view.empty() ||
+        layout.channels > portCount) {
+        audioEngine.sampleAdvance = 0.0;
+        for (unsigned port = 0; port < portCount; port++)
+            std::memset(outs[port], 0, nframes * sizeof(jack_default_audio_sample_t));
+        publishPlayhead(controlChannel, audioEngine);
+        if (media && media->ring.running)
+            publishPrefetchHint(media->ring, audioEngine.playback, 0.0);
         return;
     }
-    if (loopStart < loopEnd) {
-        if (forward && audioPosition > loopEnd) {
-            if (boomerangMode) {
-                double overshoot = audioPosition - loopEnd;
-                audioPosition = loopEnd - overshoot;
-                playbackMultiplier = -playbackMultiplier;
-            }
-            else {
-                audioPosition = loopStart;
-            }
-        }
-        else if (!forward && audioPosition < loopStart) {
-            if (boomerangMode) {
-                double overshoot = loopStart - audioPosition;
-                audioPosition = loopStart + overshoot;
-                playbackMultiplier = -playbackMultiplier;
-            }
-            else {
-                audioPosition = loopEnd;
-            }
-        }
+    const double baseAdvancement = periodPlan.baseAdvance;
+    // Measure the block cost so resampler modes can be compared (steady_clock is a vDSO read).
+    std::chrono::steady_clock::time_point blockStart = std::chrono::steady_clock::now();
+    bool stalled = false;   // the playhead holds still while --realtime plays silence
+    if (media->ring.running)
+        renderPrefetchedFrames(media->ring, audioEngine.playback, layout, baseAdvancement, audioEngine.volume, outs,
+            nframes, audioEngine.resampleMode, played);
+    else if (realtimeMode && !media->stream) {
+        for (unsigned channel = 0; channel < layout.channels; channel++)
+            std::memset(outs[channel], 0, nframes * sizeof(jack_default_audio_sample_t));
+        media->ring.underruns.fetch_add(1, std::memory_order_relaxed);
+        stalled = true;
     }
-    else {
-        // Wrapped region: [loopStart, fileSize) U [0, loopEnd]
-        audioPosition = wrapPosition(audioPosition, fileSize);
-        if (forward && audioPosition > loopEnd && audioPosition < loopStart) {
-            if (boomerangMode) {
-                double overshoot = audioPosition - loopEnd;
-                audioPosition = loopEnd - overshoot;
-                playbackMultiplier = -playbackMultiplier;
-            }
-            else {
-                audioPosition = loopStart;
-            }
-        }
-        else if (!forward && (audioPosition < loopEnd || audioPosition > loopStart)) {
-            if (boomerangMode) {
-                double overshoot = (audioPosition < loopEnd) ? (loopEnd - audioPosition) : (audioPosition - loopStart);
-                audioPosition = (audioPosition < loopEnd) ? (loopEnd + overshoot) : (loopStart - overshoot);
-                playbackMultiplier = -playbackMultiplier;
-            }
-            else {
-                audioPosition = loopEnd;
-            }
-        }
+    else
+        renderPlaybackFrames(audioEngine.playback, media->file.view, layout, baseAdvancement, audioEngine.volume, outs,
+            nframes, audioEngine.resampleMode, played);
+    float blockMicros = std::chrono::duration<float, std::micro>(std::chrono::steady_clock::now() - blockStart).count();
+    audioEngine.blockMicros += (blockMicros - audioEngine.blockMicros) * 0.05f;
+    unsigned filled = layout.channels;
+    if (filled == 1) {
+        std::memcpy(outs[1], outs[0], nframes * sizeof(jack_default_audio_sample_t));
+        filled = 2;
     }
+    for (unsigned port = filled; port < portCount; port++)
+        std::memset(outs[port], 0, nframes * sizeof(jack_default_audio_sample_t));
+    pushSpectrogramSamples(spectrogram, outs[0], nframes);
+    audioEngine.sampleAdvance = stalled ? 0.0 : baseAdvancement * audioEngine.playback.multiplier;
+    publishPlayhead(controlChannel, audioEngine);
+    if (media->ring.running)
+        publishPrefetchHint(media->ring, audioEngine.playback, audioEngine.sampleAdvance);
 }
 
 // --- JACK process callback ---
+// Timed against the period length only while instrumentation is enabled.
 int jackProcessCallback(jack_nframes_t nframes, void* arg) {
-    jack_default_audio_sample_t* outLeft = (jack_default_audio_sample_t*)jack_port_get_buffer(outputPortLeft, nframes);
-    jack_default_audio_sample_t* outRight = (jack_default_audio_sample_t*)jack_port_get_buffer(outputPortRight, nframes);
-    if (isPaused || !isAudioEnabled || fileData.empty()) {
-        for (jack_nframes_t i = 0; i < nframes; i++) {
-            outLeft[i] = 0.0f;
-            outRight[i] = 0.0f;
-        }
+    if (!instrumentation.enabled.load(std::memory_order_relaxed)) {
+        processAudioPeriod(nframes);
         return 0;
     }
-    double fileSize = static_cast<double>(fileData.size());
-    double frameBytes = static_cast<double>(FRAME_WIDTH * FRAME_HEIGHT);
-    double baseAdvancement = (frameBytes * BASE_FRAME_RATE) / static_cast<double>(sampleRate);
-    double effectiveAdvance = baseAdvancement * playbackMultiplier;
-    for (jack_nframes_t i = 0; i < nframes; i++) {
-        audioPosition += effectiveAdvance;
-        handleLoop(fileSize, effectiveAdvance);
-        size_t index = static_cast<size_t>(audioPosition);
-        if (index >= fileData.size())
-            index = fileData.size() - 1;
-        unsigned char val = fileData[index];
-        float sample = (static_cast<int>(val) - 128) / 128.0f;
-        sample *= audioVolume;
-        outLeft[i] = sample;
-        outRight[i] = sample;
-    }
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    processAudioPeriod(nframes);
+    unsigned long long nanos = static_cast<unsigned long long>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    recordCallback(instrumentation.audio, nanos, periodPlan.budgetNanos);
+    return 0;
+}
+
+// --- JACK rate and period callbacks ---
+// Only record the new values; the callback picks them up at its next period (updatePeriodPlan).
+int jackSampleRateCallback(jack_nframes_t nframes, void* arg) {
+    sampleRate.store(nframes, std::memory_order_relaxed);
+    return 0;
+}
+
+int jackBufferSizeCallback(jack_nframes_t nframes, void* arg) {
+    bufferFrames.store(nframes, std::memory_order_relaxed);
+    return 0;
+}
+
+// --- JACK xrun callback ---
+int jackXrunCallback(void* arg) {
+    instrumentation.audio.xruns.fetch_add(1, std::memory_order_relaxed);
     return 0;
 }
 
 // --- JACK shutdown callback ---
+// Runs on a JACK thread, so it only hands the engine state back to the UI thread and flags the
+// loss; the client is closed and reopened by maintainJackAudio.
 void jackShutdownCallback(void* arg) {
-    std::cerr << "JACK server shutdown." << std::endl;
+    audioThreadActive = false;
+    jackServerLost = true;
+}
+
+// Everything the callback touches besides the ring buffers, locked with --realtime.
+bool lockAudioThreadMemory(void) {
+    bool locked = lockMemory(&audioEngine, sizeof(audioEngine));
+    locked = lockMemory(&controlChannel, sizeof(controlChannel)) && locked;
+    locked = lockMemory(&periodPlan, sizeof(periodPlan)) && locked;
+    locked = lockMemory(&spectrogram.ring, sizeof(spectrogram.ring)) && locked;
+    locked = lockMemory(&instrumentation.audio, sizeof(instrumentation.audio)) && locked;
+    return locked;
+}
+
+void closeJackClient(void) {
+    if (jackClient)
+        jack_client_close(jackClient);
     jackClient = NULL;
-    isAudioEnabled = false;
+    outputPortCount = 0;
 }
 
 // --- Initialize JACK ---
-bool initJackAudio() {
+// On a reconnect the server is not started and a failed open stays quiet (it is retried); a ring
+// that is already running is kept unless the server came back at another rate.
+bool initJackAudio(bool reconnect) {
     jack_status_t status;
-    jackClient = jack_client_open("BinaryWaterfallPlayer", JackNullOption, &status);
+    jackClient = jack_client_open("BinaryWaterfallPlayer", reconnect ? JackNoStartServer : JackNullOption, &status);
     if (!jackClient) {
-        std::cerr << "Failed to connect to JACK server." << std::endl;
+        if (!reconnect)
+            std::cerr << "Failed to connect to JACK server." << std::endl;
         return false;
     }
+    jackServerLost = false;
     jack_set_process_callback(jackClient, jackProcessCallback, NULL);
     jack_on_shutdown(jackClient, jackShutdownCallback, NULL);
-    sampleRate = jack_get_sample_rate(jackClient);
-    outputPortLeft = jack_port_register(jackClient, "output_left", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-    outputPortRight = jack_port_register(jackClient, "output_right", JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
-    if (!outputPortLeft || !outputPortRight) {
+    jack_set_xrun_callback(jackClient, jackXrunCallback, NULL);
+    jack_set_sample_rate_callback(jackClient, jackSampleRateCallback, NULL);
+    jack_set_buffer_size_callback(jackClient, jackBufferSizeCallback, NULL);
+    const jack_nframes_t rate = jack_get_sample_rate(jackClient);
+    sampleRate = rate;
+    bufferFrames = jack_get_buffer_size(jackClient);
+    outputPortCount = 0;
+    if (!ensureOutputPorts(audioLayout.channels > 2 ? audioLayout.channels : 2)) {
         std::cerr << "Failed to create JACK output ports." << std::endl;
-        jack_client_close(jackClient);
+        closeJackClient();
         return false;
     }
+    // Without the ring the callback falls back to reading the mapping directly (or plays silence
+    // with --realtime). Sources the loader opens from now on start their own ring. A stream's
+    // history is in memory already.
+    MediaSource& media = *currentMedia;
+    if (media.ring.running && media.ring.sampleRate != rate)
+        stopPrefetchRing(media.ring);
+    if (!media.stream && !media.ring.running &&
+        !startPrefetchRing(media.ring, media.path, fileData.size(), rate, realtimeMode))
+        std::cerr << "Prefetch disabled; audio reads the mapped file directly." << std::endl;
+    mediaLoader.lockMemory = realtimeMode;
+    mediaLoader.sampleRate = rate;
+    if (realtimeMode) {
+        if (!lockAudioThreadMemory())
+            std::cerr << "Warning: Could not lock the audio state in memory (memlock limit?)." << std::endl;
+        if (!jack_is_realtime(jackClient))
+            std::cerr << "Warning: JACK is not running with real-time scheduling." << std::endl;
+    }
+    // Hand the engine state to the RT thread before it can start calling back.
+    audioThreadActive = true;
     if (jack_activate(jackClient)) {
         std::cerr << "Failed to activate JACK client." << std::endl;
-        jack_client_close(jackClient);
+        audioThreadActive = false;
+        closeJackClient();
+        mediaLoader.sampleRate = 0;
+        stopPrefetchRing(media.ring);
         return false;
     }
+    connectOutputPorts(0);
+    std::cout << "JACK audio initialized at " << rate << " Hz, " << bufferFrames.load() << " frames per period."
+              << std::endl;
+    return true;
+}
+
+// --- JACK reconnect ---
+// Once the server has gone away, close its client here (never from the shutdown callback) and
+// try again every JACK_RECONNECT_SECONDS. The UI thread plays the engine meanwhile, so the
+// playhead, loop and the rest carry over to the new client.
+void maintainJackAudio(double now) {
+    if (jackServerLost.exchange(false)) {
+        std::cerr << "JACK server shutdown; reconnecting." << std::endl;
+        closeJackClient();
+        jackReconnecting = true;
+        nextJackReconnect = now + JACK_RECONNECT_SECONDS;
+    }
+    if (!jackReconnecting || now < nextJackReconnect)
+        return;
+    nextJackReconnect = now + JACK_RECONNECT_SECONDS;
+    if (initJackAudio(true))
+        jackReconnecting = false;
+}
+
+// --- Output ports ---
+// Registers ports up to `count` (ports are never unregistered, so switching back to fewer channels
+// only silences the extras). Safe while the client is active; without JACK there is nothing to do.
+bool ensureOutputPorts(unsigned count) {
+    if (!jackClient)
+        return true;
+    unsigned have = outputPortCount.load();
+    unsigned first = have;
+    for (; have < count && have < MAX_AUDIO_CHANNELS; have++) {
+        std::string name = (have == 0) ? "output_left" : (have == 1) ? "output_right" : "output_" + std::to_string(have + 1);
+        outputPorts[have] = jack_port_register(jackClient, name.c_str(), JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput, 0);
+        if (!outputPorts[have])
+            break;
+        // Published one at a time, after the port exists.
+        outputPortCount.store(have + 1, std::memory_order_release);
+    }
+    if (audioThreadActive && have > first)
+        connectOutputPorts(first);
+    return have >= count;
+}
+
+// Connects ports from `first` on to the physical playback ports of the same index.
+void connectOutputPorts(unsigned first) {
     const char** ports = jack_get_ports(jackClient, NULL, NULL, JackPortIsPhysical | JackPortIsInput);
-    if (ports) {
-        if (ports[0])
-            jack_connect(jackClient, jack_port_name(outputPortLeft), ports[0]);
-        if (ports[1])
-            jack_connect(jackClient, jack_port_name(outputPortRight), ports[1]);
-        jack_free(ports);
-    }
-    std::cout << "JACK audio initialized at " << sampleRate << " Hz." << std::endl;
+    if (!ports)
+        return;
+    unsigned count = outputPortCount.load();
+    for (unsigned port = 0; port < count && ports[port]; port++) {
+        if (port >= first)
+            jack_connect(jackClient, jack_port_name(outputPorts[port]), ports[port]);
+    }
+    jack_free(ports);
+}
+
+// --- Sample layout ---
+// The ports for every channel exist before the audio thread is told about the layout.
+bool setAudioLayout(const AudioLayout& layout) {
+    if (!ensureOutputPorts(layout.channels)) {
+        std::cerr << "Could not create " << layout.channels << " JACK output ports." << std::endl;
+        return false;
+    }
+    audioLayout = layout;
+    sendPlaybackCommand(controlChannel, CMD_SET_AUDIO_LAYOUT, encodeAudioLayout(layout));
     return true;
 }
 
@@ -212,62 +518,353 @@ void closeJackAudio() {
         jack_client_close(jackClient);
         jackClient = NULL;
     }
+    audioThreadActive = false;
+    mediaLoader.sampleRate = 0;
+    if (currentMedia)
+        stopPrefetchRing(currentMedia->ring);
+}
+
+// --- Presentation clock ---
+// The JACK frame clock while audio runs (so the picture is paced by the same clock as the sound),
+// glfwGetTime otherwise. Switching source restarts the scheduler's frame grid.
+double presentationClock(void) {
+    bool audioClock = audioThreadActive && jackClient;
+    if (audioClock != usingAudioClock) {
+        usingAudioClock = audioClock;
+        if (audioClock)
+            audioClockFrames = jack_frame_time(jackClient);
+        resetFrameScheduler(frameScheduler);
+    }
+    if (!audioClock)
+        return glfwGetTime();
+    jack_nframes_t now = jack_frame_time(jackClient);
+    audioClockFrames += static_cast<jack_nframes_t>(now - static_cast<jack_nframes_t>(audioClockFrames));
+    return static_cast<double>(audioClockFrames) / static_cast<double>(sampleRate.load());
 }
 
-// --- Open file dialog ---
-std::string openFileDialog(void) {
-    char filename[MAX_PATH] = { 0 };
-    OPENFILENAMEA ofn;
-    ZeroMemory(&ofn, sizeof(ofn));
-    ofn.lStructSize = sizeof(ofn);
-    ofn.hwndOwner = NULL;
-    ofn.lpstrFilter = "Raw Media Files\0*.*\0";
-    ofn.lpstrFile = filename;
-    ofn.nMaxFile = MAX_PATH;
-    ofn.Flags = OFN_FILEMUSTEXIST | OFN_PATHMUSTEXIST;
-    ofn.lpstrTitle = "Select Raw Media File";
-    if (GetOpenFileNameA(&ofn))
-        return filename;
-    return "";
+// Playhead position to show for a frame presented at clock time `frameTime`.
+double presentedPosition(const PlayheadSnapshot& playhead, double frameTime) {
+    if (!usingAudioClock)
+        return playhead.position;
+    uint32_t presentFrame = static_cast<uint32_t>(static_cast<uint64_t>(std::llround(frameTime * sampleRate.load())));
+    return extrapolatePlayhead(playhead, presentFrame, static_cast<double>(fileData.size()));
+}
+
+// --- Compare source ---
+// What the current file is compared with: the other file, or the current one, from diffOffset on.
+ByteView diffSource(void) {
+    ByteView base = diffPath.empty() ? fileData : diffFile.view;
+    ByteView source;
+    if (diffOffset < base.size()) {
+        source.bytes = base.data() + diffOffset;
+        source.length = base.size() - diffOffset;
+    }
+    return source;
+}
+
+// Rebuild the changed-byte index for the current file and geometry. Streams get none.
+void restartFrameDiff(void) {
+    stopFrameDiff(frameDiffer);
+    diffIndex = FrameDiffIndex();
+    if (diffEnabled && !currentMedia->stream)
+        startFrameDiff(frameDiffer, fileData, diffSource(), frameByteCount(frameGeometry));
+}
+
+// Search the current file for searchPatterns from the start. Streams are not searched.
+void restartPatternSearch(void) {
+    stopPatternSearch(patternSearch);
+    searchMatches.clear();
+    if (!searchPatterns.empty() && !currentMedia->stream)
+        startPatternSearch(patternSearch, fileData, searchPatterns);
 }
 
 // --- Load raw media file ---
+// The file is memory-mapped rather than read, so opening is instant and only the pages being
+// played or shown become resident. Used for the first file, before the audio thread runs; later
+// entries come from the loader thread.
 bool loadMediaFile(const std::string& filename) {
-    std::ifstream file(filename, std::ios::binary);
-    if (!file) {
-        std::cerr << "Error: Could not open file: " << filename << std::endl;
+    std::unique_ptr<MediaSource> source(new MediaSource());
+    if (!openMediaSource(*source, filename, 0)) {
+        closeMediaSource(*source);
         return false;
     }
-    file.seekg(0, std::ios::end);
-    std::streamsize fileSize = file.tellg();
-    file.seekg(0, std::ios::beg);
-    if (fileSize <= 0) {
-        std::cerr << "Error: File is empty." << std::endl;
+    return activateMediaSource(std::move(source));
+}
+
+// --- Open a live stream ---
+// Used instead of the playlist with --stream; connecting may block until the other end is there.
+bool loadStreamSource(const std::string& spec) {
+    std::unique_ptr<MediaSource> source(new MediaSource());
+    if (!openStreamMediaSource(*source, spec, streamHistoryBytes, realtimeMode)) {
+        closeMediaSource(*source);
         return false;
     }
-    size_t bytesPerFrame = FRAME_WIDTH * FRAME_HEIGHT;
-    totalFrames = fileSize / bytesPerFrame;
-    if (totalFrames == 0) {
-        std::cerr << "Error: File too small for even one frame." << std::endl;
+    return activateMediaSource(std::move(source));
+}
+
+// --- Make a source current ---
+// UI-side state switches at once; the audio thread follows at its next period (or right here when
+// it is not running). The previous source stays alive in retiringMedia until then, and its session
+// is saved. A file with a saved session comes back at its position, loop, geometry and palette,
+// with its analysis and search results. Rejected if the file cannot hold one frame of the geometry.
+bool activateMediaSource(std::unique_ptr<MediaSource> source) {
+    const bool restore = useSessions && source->sessionLoaded;
+    const SessionState& session = source->session;
+    FrameGeometry geometry = frameGeometry;
+    if (restore && pixelFormatFits(session.geometry.pixelFormat, session.geometry.width, session.geometry.height) &&
+        source->file.view.size() >= frameByteCount(session.geometry))
+        geometry = session.geometry;
+    size_t bytesPerFrame = frameByteCount(geometry);
+    size_t frames = source->file.view.size() / bytesPerFrame;
+    if (frames == 0) {
+        std::cerr << "Error: File too small for even one frame: " << source->path << std::endl;
+        retireMediaSource(mediaLoader, std::move(source));
         return false;
     }
-    fileData.resize(fileSize);
-    if (!file.read(reinterpret_cast<char*>(fileData.data()), fileSize)) {
-        std::cerr << "Error: Failed to read file data." << std::endl;
-        return false;
+    double position = restore ? wrapPosition(session.position, static_cast<double>(source->file.view.size())) : 0.0;
+    if (currentMedia) {
+        saveCurrentSession();
+        if (!sendMediaSwap(controlChannel, source.get(), position)) {
+            std::cerr << "Command queue full; file switch dropped." << std::endl;
+            retireMediaSource(mediaLoader, std::move(source));
+            return false;
+        }
+        if (restore) {
+            sendPlaybackCommand(controlChannel, CMD_SET_LOOP_START, session.loopStart);
+            sendPlaybackCommand(controlChannel, CMD_SET_LOOP_END, session.loopEnd);
+            sendPlaybackCommand(controlChannel, CMD_SET_LOOP, session.loopEnabled ? 1.0 : 0.0);
+            sendPlaybackCommand(controlChannel, CMD_SET_BOOMERANG, session.boomerangMode ? 1.0 : 0.0);
+        }
+        mediaGeneration++;
+        retiringMedia = std::move(currentMedia);
+    }
+    else {
+        // Nothing else runs yet, so the engine can be pointed at it directly.
+        audioEngine.media = source.get();
+        if (restore) {
+            audioEngine.playback.position = position;
+            audioEngine.playback.loopStart = session.loopStart;
+            audioEngine.playback.loopEnd = session.loopEnd;
+            audioEngine.playback.loopEnabled = session.loopEnabled;
+            audioEngine.playback.boomerangMode = session.boomerangMode;
+        }
+    }
+    currentMedia = std::move(source);
+    fileData = currentMedia->file.view;
+    scopeRuns = PlayedRuns();
+    totalFrames = frames;
+    if (restore) {
+        currentPalette = currentMedia->session.palette;
+        if (searchPatterns.empty())
+            searchPatterns = sessionPatternSet(currentMedia->session.patterns);
+        std::cout << "Restored session: " << sessionPath(currentMedia->path) << std::endl;
+    }
+    if (restore && (geometry.width != frameGeometry.width || geometry.height != frameGeometry.height ||
+        geometry.pixelFormat != frameGeometry.pixelFormat || geometry.scale != windowScale))
+        useFrameGeometry(mainWindow, geometry);
+    std::cout << (currentMedia->stream ? "Streaming " : "Mapped ") << fileData.size() << " bytes of "
+        << currentMedia->path << ". Total frames: " << totalFrames << std::endl;
+    // The background passes read the old mapping, so they must stop before it is retired. A
+    // stream's contents keep changing, so it gets none of them.
+    stopOverviewBuild(overviewBuilder);
+    stopThumbnails(thumbnailBuilder);
+    overviewColumns.clear();
+    frameAnalysis = FrameAnalysis();
+    restartFrameDiff();
+    // Saved matches stand in for the scan only if they are for the patterns now in use.
+    if (restore && currentMedia->searchLoaded &&
+        patternSetHash(searchPatterns) == patternSetHash(sessionPatternSet(currentMedia->session.patterns))) {
+        stopPatternSearch(patternSearch);
+        searchMatches = std::move(currentMedia->searchMatches);
+        currentMedia->searchMatches.clear();
+    }
+    else {
+        restartPatternSearch();
+    }
+    if (currentMedia->stream) {
+        stopFrameAnalysis(frameAnalyzer);
+        overviewIndex = OverviewIndex();
+        streamFollower.rate = 0.0;
+        streamFollower.lastTime = -1.0;
+        streamSeen = 0;
+        return true;
+    }
+    if (currentMedia->overviewLoaded) {
+        overviewIndex = std::move(currentMedia->overview);
+        currentMedia->overview = OverviewIndex();
+    }
+    else {
+        overviewIndex = OverviewIndex();
+        startOverviewBuild(overviewBuilder, fileData, overviewIndexPath(currentMedia->path));
+    }
+    if (restore && currentMedia->analysisLoaded && currentMedia->analysis.frameBytes == bytesPerFrame) {
+        stopFrameAnalysis(frameAnalyzer);
+        frameAnalysis = std::move(currentMedia->analysis);
+        currentMedia->analysis = FrameAnalysis();
+    }
+    else {
+        startFrameAnalysis(frameAnalyzer, fileData, bytesPerFrame);
     }
-    std::cout << "Loaded " << fileData.size() << " bytes. Total frames: " << totalFrames << std::endl;
     return true;
 }
 
-// --- Updated logarithmic adjustment function for finer control ---
-double calculateLogAdjustment(double currentMultiplier) {
-    double absVal = std::abs(currentMultiplier);
-    if (absVal < 1.0)
-        return 0.1;  // smallest step when near 0
-    if (absVal < 10.0)
-        return 0.5;  // moderate step
-    return 1.0;      // larger step when values are high
+// --- Session ---
+// Nothing is saved for a stream, or before the audio thread has picked the file up (the playhead
+// still belongs to the previous one then).
+void saveCurrentSession(void) {
+    if (!useSessions || !currentMedia || currentMedia->stream)
+        return;
+    PlayheadSnapshot playhead = controlChannel.playhead.load();
+    if (playhead.mediaGeneration != mediaGeneration)
+        return;
+    const std::string& path = currentMedia->path;
+    SessionState session;
+    session.fileSize = fileData.size();
+    session.modified = fileModifiedTime(path);
+    session.fingerprint = overviewFingerprint(fileData);
+    session.position = wrapPosition(playhead.position, static_cast<double>(fileData.size()));
+    session.loopEnabled = playhead.loopEnabled;
+    session.loopStart = playhead.loopStart;
+    session.loopEnd = playhead.loopEnd;
+    session.boomerangMode = playhead.boomerangMode;
+    session.geometry = frameGeometry;
+    session.geometry.scale = windowScale;
+    session.palette = currentPalette;
+    for (const std::vector<unsigned char>& pattern : searchPatterns.patterns)
+        session.patterns.push_back(searchPatternText(pattern));
+    session.overviewIndex = sessionIndexName(overviewIndexPath(path));
+    session.analysisIndex = sessionIndexName(analysisIndexPath(path));
+    session.searchIndex = sessionIndexName(searchIndexPath(path));
+    saveSession(session, path);
+}
+
+// --- Playlist switching ---
+// Tab / Shift+Tab and drops only record the target; updatePlaylist makes the switch once the
+// loader has the file open, so neither the UI nor the audio thread waits for it.
+void switchPlaylistEntry(int step) {
+    if (playlist.paths.size() < 2)
+        return;
+    size_t from = (pendingPlaylistIndex >= 0) ? static_cast<size_t>(pendingPlaylistIndex) : playlist.current;
+    long long count = static_cast<long long>(playlist.paths.size());
+    long long index = (static_cast<long long>(from) + step) % count;
+    pendingPlaylistIndex = index < 0 ? index + count : index;
+    preloadMedia(mediaLoader, playlist.paths[static_cast<size_t>(pendingPlaylistIndex)]);
+}
+
+// Called once per loop iteration on the UI thread.
+void updatePlaylist(void) {
+    // The audio thread has started a period with the current source: the old one can go.
+    if (retiringMedia && (!audioThreadActive || controlChannel.playhead.load().mediaGeneration == mediaGeneration))
+        retireMediaSource(mediaLoader, std::move(retiringMedia));
+    if (pendingPlaylistIndex < 0 || retiringMedia)
+        return;
+    size_t index = static_cast<size_t>(pendingPlaylistIndex);
+    bool failed = false;
+    std::unique_ptr<MediaSource> source = takePreloadedMedia(mediaLoader, playlist.paths[index], failed);
+    if (failed) {
+        pendingPlaylistIndex = -1;
+        return;
+    }
+    if (!source)
+        return;
+    pendingPlaylistIndex = -1;
+    if (!activateMediaSource(std::move(source)))
+        return;
+    playlist.current = index;
+    // Have the following entry open before it is asked for.
+    if (playlist.paths.size() > 1)
+        preloadMedia(mediaLoader, playlist.paths[playlistNeighbor(playlist, 1)]);
+}
+
+// --- Follow a live stream ---
+// Called once per loop iteration on the UI thread. With audio running the speed tracks the
+// arrival rate (so sound and picture stay continuous) and jumps are only for large gaps; without
+// it nothing moves the playhead, so it is placed at the target every time.
+void followLiveEdge(void) {
+    if (!currentMedia->stream || !followStream || retiringMedia)
+        return;
+    const StreamSource& stream = *currentMedia->stream;
+    measureStreamRate(streamFollower, stream, glfwGetTime());
+    PlayheadSnapshot playhead = controlChannel.playhead.load();
+    if (playhead.paused || playhead.mediaGeneration != mediaGeneration)
+        return;
+    double frameBytes = static_cast<double>(frameByteCount(frameGeometry));
+    double nominalRate = isByteLayout(playhead.layout) ? frameBytes * BASE_FRAME_RATE
+        : static_cast<double>(audioFrameBytes(playhead.layout)) * playhead.pcmRate;
+    double target = streamTargetLag(streamFollower, frameBytes);
+    double lag = streamLag(stream, playhead.position);
+    bool audio = audioThreadActive;
+    if (audio ? streamNeedsJump(streamFollower, stream, lag, target, nominalRate) : std::fabs(lag - target) >= 1.0) {
+        sendPlaybackCommand(controlChannel, CMD_SEEK_ABSOLUTE,
+            wrapPosition(playhead.position + lag - target, static_cast<double>(streamCapacity(stream))));
+        lag = target;
+    }
+    if (!audio)
+        return;
+    double multiplier = streamFollowMultiplier(streamFollower, lag, target, nominalRate);
+    if (std::fabs(multiplier - playhead.multiplier) > 0.01 * std::max(multiplier, 0.1))
+        sendPlaybackCommand(controlChannel, CMD_SET_MULTIPLIER, multiplier);
+}
+
+// --- Redraw what a live stream rewrote ---
+// The renderers keep frames and rows by offset, and the history reuses offsets as bytes arrive.
+// Called before each redraw: whatever was written since the last one is dropped from every
+// renderer, including those of views not drawn this time. Bytes landing during the redraw are
+// past the count read here, so they are dropped before the next one.
+void forgetStreamBytes(void) {
+    if (!currentMedia->stream)
+        return;
+    const StreamSource& stream = *currentMedia->stream;
+    unsigned long long received = stream.received.load(std::memory_order_acquire);
+    StreamChanges changes = streamChangesBetween(streamSeen, received, streamCapacity(stream));
+    streamSeen = received;
+    for (int i = 0; i < changes.count; i++) {
+        const size_t first = changes.first[i], end = changes.end[i];
+        forgetTileBytes(tileArrayRenderer, first, end);
+        forgetWaterfallBytes(waterfallRenderer, first, end);
+        forgetSoftwareBytes(softwareRenderer, first, end);
+        for (size_t v = 0; v < views.size(); v++) {
+            PlayerView& view = *views[v];
+            forgetTileBytes(view.tiles, first, end);
+            forgetWaterfallBytes(view.waterfall, first, end);
+            forgetSoftwareBytes(view.software, first, end);
+        }
+    }
+}
+
+// --- Switch frame geometry ---
+// The playhead stays at the same byte offset; the audio engine is told the new frame size so 1x
+// speed remains one frame per BASE_FRAME_RATE tick. Presets also bring their window scale.
+void useFrameGeometry(GLFWwindow* window, const FrameGeometry& geometry) {
+    frameGeometry = geometry;
+    totalFrames = fileData.size() / frameByteCount(geometry);
+    windowScale = geometry.scale;
+    sendPlaybackCommand(controlChannel, CMD_SET_FRAME_BYTES, static_cast<double>(frameByteCount(geometry)));
+    if (window && !isFullscreen)
+        glfwSetWindowSize(window, geometry.width * windowScale, geometry.height * windowScale);
+}
+
+// Rejected if the file cannot hold one frame of the new size or the pixel format cannot lay out a
+// frame of that size. The background passes are restarted for the new frame size.
+bool applyFrameGeometry(GLFWwindow* window, const FrameGeometry& geometry) {
+    if (!pixelFormatFits(geometry.pixelFormat, geometry.width, geometry.height)) {
+        std::cerr << pixelFormatName(geometry.pixelFormat) << " does not fit a " << geometry.width << "x"
+                  << geometry.height << " frame." << std::endl;
+        return false;
+    }
+    size_t frames = fileData.size() / frameByteCount(geometry);
+    if (frames == 0) {
+        std::cerr << "File too small for a " << geometry.width << "x" << geometry.height << " "
+                  << pixelFormatName(geometry.pixelFormat) << " frame." << std::endl;
+        return false;
+    }
+    useFrameGeometry(window, geometry);
+    if (!currentMedia->stream) {
+        frameAnalysis = FrameAnalysis();
+        startFrameAnalysis(frameAnalyzer, fileData, frameByteCount(geometry));
+    }
+    restartFrameDiff();
+    return true;
 }
 
 // --- Process repeated key input with finer control ---
@@ -277,24 +874,14 @@ void processInput(GLFWwindow* window) {
     if (deltaTime < 0.1f)
         return;
     lastInputTime = currentTime;
-    if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS) {
-        double step = calculateLogAdjustment(playbackMultiplier);
-        playbackMultiplier += step;
-    }
-    if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS) {
-        double step = calculateLogAdjustment(playbackMultiplier);
-        playbackMultiplier -= step;
-    }
-    if (glfwGetKey(window, GLFW_KEY_KP_ADD) == GLFW_PRESS) {
-        audioVolume += 0.05f;
-        if (audioVolume > 2.0f)
-            audioVolume = 2.0f;
-    }
-    if (glfwGetKey(window, GLFW_KEY_KP_SUBTRACT) == GLFW_PRESS) {
-        audioVolume -= 0.05f;
-        if (audioVolume < 0.0f)
-            audioVolume = 0.0f;
-    }
+    if (glfwGetKey(window, GLFW_KEY_UP) == GLFW_PRESS)
+        sendPlaybackCommand(controlChannel, CMD_STEP_MULTIPLIER, 1.0);
+    if (glfwGetKey(window, GLFW_KEY_DOWN) == GLFW_PRESS)
+        sendPlaybackCommand(controlChannel, CMD_STEP_MULTIPLIER, -1.0);
+    if (glfwGetKey(window, GLFW_KEY_KP_ADD) == GLFW_PRESS)
+        sendPlaybackCommand(controlChannel, CMD_ADJUST_VOLUME, 0.05);
+    if (glfwGetKey(window, GLFW_KEY_KP_SUBTRACT) == GLFW_PRESS)
+        sendPlaybackCommand(controlChannel, CMD_ADJUST_VOLUME, -0.05);
     if (glfwGetKey(window, GLFW_KEY_LEFT_BRACKET) == GLFW_PRESS) {
         if (windowScale > 1)
             windowScale--;
@@ -306,104 +893,569 @@ void processInput(GLFWwindow* window) {
 
 // --- Render frame ---
 // This version fills the window by tiling frames. Each frame is drawn at a fixed pixel size 
-// (FRAME_WIDTH*windowScale by FRAME_HEIGHT*windowScale). The number of columns and rows is computed 
+// (frameGeometry.width*windowScale by frameGeometry.height*windowScale). The number of columns and rows is computed 
 // using ceiling division so that the entire window is covered, even if that means drawing a partial frame.
-void renderFrame(GLFWwindow* window) {
+// The texture-array renderer keeps frames resident between redraws and is preferred; the atlas
+// renderer re-uploads the visible frames. Without GL 3.0 (or with --cpu) the software renderer
+// draws cached CPU-colorized tiles; the per-byte quad path is the last resort.
+// In waterfall mode the view starts at the exact playhead byte rather than at a frame boundary
+// and scrolls continuously; it falls back to tiles if the row ring cannot be allocated, and is
+// only used for Indexed8 (packed pixel formats are drawn as tiles). Compare mode draws tiles of
+// the difference (drawDiffTiles).
+void drawDiffTiles(const TileLayout& layout, size_t startFrame, size_t frames, const PaletteLUT& palette,
+    SoftwareRenderer& software);
+
+void drawTiles(int windowWidth, int windowHeight, const FrameGeometry& geometry, int scale, double position,
+    int direction, const PaletteLUT& palette, TileArrayRenderer& tiles, WaterfallRenderer& waterfall,
+    SoftwareRenderer& software) {
+    size_t frameBytes = frameByteCount(geometry);
+    size_t frames = fileData.size() / frameBytes;
+    TileLayout layout = computeTileLayout(windowWidth, windowHeight, geometry.width, geometry.height, scale,
+        geometry.pixelFormat);
+    setupPixelProjection(windowWidth, windowHeight);
+
+    // Starting frame index based on the playhead position.
+    size_t startFrame = static_cast<size_t>(wrapPosition(position, static_cast<double>(fileData.size())) / frameBytes);
+
+    // Clear the screen.
+    glClear(GL_COLOR_BUFFER_BIT);
+
+    if (diffEnabled && diffDisplay != DIFF_SOURCE) {
+        drawDiffTiles(layout, startFrame, frames, palette, software);
+        renderSearchMarkers(layout, startFrame, frames, searchMatches, searchPatterns);
+        return;
+    }
+    size_t wholeFrameBytes = frames * frameBytes;
+    // Search markers follow the tile grid, so the waterfall has none.
+    if (!softwareRendering && waterfallMode && geometry.pixelFormat == PIXEL_INDEXED8 &&
+        renderWaterfall(waterfall, windowWidth, windowHeight, geometry.width, scale, fileData.data(), mediaGeneration,
+            wholeFrameBytes, wrapPosition(position, static_cast<double>(wholeFrameBytes)), direction, palette))
+        return;
+    bool drawn = !softwareRendering &&
+        (renderTilesArray(tiles, layout, fileData.data(), mediaGeneration, startFrame, frames, palette) ||
+            renderTilesTexture(textureRenderer, layout, fileData.data(), startFrame, frames, palette));
+    if (!drawn && !renderTilesSoftware(software, layout, fileData.data(), mediaGeneration, startFrame, frames, palette))
+        renderTilesImmediate(layout, fileData.data(), startFrame, frames, palette);
+    renderSearchMarkers(layout, startFrame, frames, searchMatches, searchPatterns);
+}
+
+// The visible frames of the difference are computed into diffFrames (one grid's worth of bytes)
+// and drawn as a file of just those frames: through the atlas renderer, which uploads every redraw
+// anyway, or the software renderer with its cache emptied, since the frames change under the same
+// indices. Past the end of the other source a frame is compared with zeros, i.e. shown as is.
+void drawDiffTiles(const TileLayout& layout, size_t startFrame, size_t frames, const PaletteLUT& palette,
+    SoftwareRenderer& software) {
+    size_t cells = static_cast<size_t>(layout.columns) * static_cast<size_t>(layout.rows);
+    size_t slots = cells < frames ? cells : frames;
+    ByteView other = diffSource();
+    diffFrames.resize(slots * layout.frameBytes);
+    for (size_t slot = 0; slot < slots; slot++) {
+        size_t offset = ((startFrame + slot) % frames) * layout.frameBytes;
+        size_t common = other.size() > offset ? std::min(other.size() - offset, layout.frameBytes) : 0;
+        unsigned char* dst = diffFrames.data() + slot * layout.frameBytes;
+        diffBytes(diffDisplay, fileData.data() + offset, other.data() + offset, common, dst);
+        std::memcpy(dst + common, fileData.data() + offset + common, layout.frameBytes - common);
+    }
+    if (!softwareRendering && renderTilesTexture(textureRenderer, layout, diffFrames.data(), 0, slots, palette))
+        return;
+    resetSoftwareCache(software);
+    if (!renderTilesSoftware(software, layout, diffFrames.data(), mediaGeneration, 0, slots, palette))
+        renderTilesImmediate(layout, diffFrames.data(), 0, slots, palette);
+}
+
+int playheadDirection(const PlayheadSnapshot& playhead) {
+    return playhead.paused ? 0 : (playhead.multiplier > 0.0 ? 1 : (playhead.multiplier < 0.0 ? -1 : 0));
+}
+
+// --- Oscilloscope overlay ---
+// Draws the runs the audio thread published with the playhead: exactly the bytes its periods
+// sampled since the previous frame took them, split where a loop, boomerang or wrap jumped.
+void renderScopeOverlay(int windowWidth, int windowHeight, const PlayheadSnapshot& playhead, const PaletteLUT& palette) {
+    if (playhead.mediaGeneration == mediaGeneration && playhead.played.count > 0)
+        scopeRuns = playhead.played;
+    bool traced = reduceScopeColumns(scopeRuns, fileData.data(), fileData.size(), &overviewIndex,
+        static_cast<size_t>(windowWidth), scopeColumns);
+    setupPixelProjection(windowWidth, windowHeight);
+    renderScope(scopeRenderer, traced ? scopeColumns.data() : nullptr, 0, 0, windowWidth, std::max(windowHeight / 4, 2),
+        windowWidth, windowHeight, palette);
+}
+
+// The main window adds the spectrogram, scope, overview and thumbnail panels.
+void renderFrame(GLFWwindow* window, const PlayheadSnapshot& playhead) {
     // Get full window size.
     int windowWidth, windowHeight;
     glfwGetFramebufferSize(window, &windowWidth, &windowHeight);
+    const PaletteLUT& palette = getPalette(currentPalette);
+    drawTiles(windowWidth, windowHeight, frameGeometry, windowScale, playhead.position, playheadDirection(playhead),
+        palette, tileArrayRenderer, waterfallRenderer, softwareRenderer);
+    if (showSpectrogram) {
+        int panelWidth = std::max(windowWidth / 3, 1);
+        renderSpectrogram(spectrogramRenderer, spectrogram, windowWidth - panelWidth, 0, panelWidth, windowHeight,
+            windowHeight, palette);
+    }
+    if (showScope)
+        renderScopeOverlay(windowWidth, windowHeight, playhead, palette);
+    if (showOverview)
+        renderOverview(windowWidth, windowHeight, playhead, palette);
+    if (showThumbnails)
+        renderThumbnailStrip(window, windowWidth, windowHeight, playhead, palette);
+}
+
+// --- Extra views ---
+// Drawn right after the main window, each in its own context. Every context is flushed before the
+// next one touches the shared textures. The views swap without vsync (set when they are opened),
+// so only the main window's swap paces the pass; the main context is current again afterwards.
+FrameGeometry viewGeometry(const PlayerView& view) {
+    return view.ownGeometry ? view.geometry : frameGeometry;
+}
 
-    // Fixed size for each frame (in pixels).
-    int framePixelWidth = FRAME_WIDTH * windowScale;
-    int framePixelHeight = FRAME_HEIGHT * windowScale;
+int viewScale(const PlayerView& view) {
+    return view.ownGeometry ? view.scale : windowScale;
+}
 
-    // Calculate number of columns and rows to fill the window completely.
-    int columns = (windowWidth + framePixelWidth - 1) / framePixelWidth;
-    int rows = (windowHeight + framePixelHeight - 1) / framePixelHeight;
+PaletteId viewPalette(const PlayerView& view) {
+    return view.ownPalette ? view.palette : currentPalette;
+}
 
-    // Setup orthographic projection matching window size.
-    glViewport(0, 0, windowWidth, windowHeight);
-    glMatrixMode(GL_PROJECTION);
-    glLoadIdentity();
-    glOrtho(0, windowWidth, windowHeight, 0, -1, 1);
-    glMatrixMode(GL_MODELVIEW);
-    glLoadIdentity();
+void renderViews(const PlayheadSnapshot& playhead) {
+    if (views.empty())
+        return;
+    glFlush();
+    int direction = playheadDirection(playhead);
+    for (size_t i = 0; i < views.size(); i++) {
+        PlayerView& view = *views[i];
+        FrameGeometry geometry = viewGeometry(view);
+        int scale = viewScale(view);
+        PaletteId palette = viewPalette(view);
+        glfwMakeContextCurrent(view.window);
+        int windowWidth, windowHeight;
+        glfwGetFramebufferSize(view.window, &windowWidth, &windowHeight);
+        // Layers hold frameWidth x storageRows bytes per frame index, so only views laid out like
+        // the main window can share its resident frames.
+        bool shared = geometry.width == frameGeometry.width &&
+            pixelStorageRows(geometry.pixelFormat, geometry.height) == pixelStorageRows(frameGeometry.pixelFormat, frameGeometry.height);
+        drawTiles(windowWidth, windowHeight, geometry, scale, playhead.position + view.offset, direction,
+            getPalette(palette), shared ? tileArrayRenderer : view.tiles, view.waterfall, view.software);
+        glFlush();
+        glfwSwapBuffers(view.window);
+        char title[256];
+        std::snprintf(title, sizeof(title), "Binary Waterfall View %zu - Offset: %+.0f bytes - Geometry: %dx%d %s - Fixed Pixel Size: %d - Palette: %s",
+            i + 1, view.offset, geometry.width, geometry.height, pixelFormatName(geometry.pixelFormat), scale, paletteName(palette));
+        if (view.title != title) {
+            glfwSetWindowTitle(view.window, title);
+            view.title = title;
+        }
+    }
+    glfwMakeContextCurrent(mainWindow);
+}
 
-    // Starting frame index based on audioPosition.
-    size_t startFrame = static_cast<size_t>(wrapPosition(audioPosition, static_cast<double>(fileData.size()))
-        / (FRAME_WIDTH * FRAME_HEIGHT));
+// Open the window of a view parsed from --view, sharing the main window's GL objects. Rejected if
+// the file cannot hold one frame of the view's geometry.
+bool openView(PlayerView& view, size_t number) {
+    FrameGeometry geometry = viewGeometry(view);
+    int scale = viewScale(view);
+    if (fileData.size() / frameByteCount(geometry) == 0) {
+        std::cerr << "View " << number << ": file too small for a " << geometry.width << "x" << geometry.height
+                  << " frame." << std::endl;
+        return false;
+    }
+    GLFWmonitor* monitor = NULL;
+    if (view.monitor >= 0) {
+        int count = 0;
+        GLFWmonitor** monitors = glfwGetMonitors(&count);
+        if (view.monitor < count)
+            monitor = monitors[view.monitor];
+        else
+            std::cerr << "View " << number << ": no monitor " << view.monitor << "; opening a window." << std::endl;
+    }
+    const GLFWvidmode* mode = monitor ? glfwGetVideoMode(monitor) : NULL;
+    view.window = mode ? glfwCreateWindow(mode->width, mode->height, "Binary Waterfall View", monitor, mainWindow)
+        : glfwCreateWindow(geometry.width * scale, geometry.height * scale, "Binary Waterfall View", NULL, mainWindow);
+    if (!view.window) {
+        std::cerr << "View " << number << ": failed to create window." << std::endl;
+        return false;
+    }
+    glfwMakeContextCurrent(view.window);
+    glfwSwapInterval(0);
+    glfwSetKeyCallback(view.window, keyCallback);
+    glfwSetDropCallback(view.window, dropCallback);
+    glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
+    if (tileArrayRenderer.ready)
+        initTileArrayRenderer(view.tiles);
+    if (waterfallRenderer.ready)
+        initWaterfallRenderer(view.waterfall);
+    glfwMakeContextCurrent(mainWindow);
+    return true;
+}
 
-    // Clear the screen.
-    glClear(GL_COLOR_BUFFER_BIT);
+void closeView(PlayerView& view) {
+    glfwMakeContextCurrent(view.window);
+    destroyTileArrayRenderer(view.tiles);
+    destroyWaterfallRenderer(view.waterfall);
+    destroySoftwareRenderer(view.software);
+    glfwDestroyWindow(view.window);
+    view.window = NULL;
+    glfwMakeContextCurrent(mainWindow);
+}
 
-    // Render the grid of frames.
-    glBegin(GL_QUADS);
-    for (int r = 0; r < rows; r++) {
-        for (int c = 0; c < columns; c++) {
-            // Compute frame index (wrap around if needed).
-            size_t frameIndex = (startFrame + r * columns + c) % totalFrames;
-            size_t frameOffset = frameIndex * FRAME_WIDTH * FRAME_HEIGHT;
-            // Compute top-left corner for this frame.
-            int offsetX = c * framePixelWidth;
-            int offsetY = r * framePixelHeight;
-
-            // Render each pixel in the frame.
-            for (int y = 0; y < FRAME_HEIGHT; y++) {
-                for (int x = 0; x < FRAME_WIDTH; x++) {
-                    unsigned char value = fileData[frameOffset + y * FRAME_WIDTH + x];
-                    // 18-color rainbow palette.
-                    const struct { float r, g, b; } rainbow[18] = {
-                        {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f},
-                        {1.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 1.0f}, {1.0f, 1.0f, 0.0f},
-                        {1.0f, 0.75f, 0.8f}, {0.5f, 1.0f, 0.0f}, {0.0f, 0.75f, 1.0f},
-                        {0.76f, 0.7f, 0.0f}, {0.9f, 0.3f, 0.0f}, {0.58f, 0.0f, 0.83f},
-                        {0.29f, 0.0f, 0.51f}, {0.0f, 0.42f, 0.5f}, {0.0f, 1.0f, 0.5f},
-                        {0.42f, 0.56f, 0.14f}, {1.0f, 0.65f, 0.0f}, {0.4f, 0.0f, 1.0f}
-                    };
-                    int colorIndex = (value / 14) % 18;
-                    float intensity = ((value % 14) + 1) / 14.0f;
-                    glColor3f(rainbow[colorIndex].r * intensity,
-                        rainbow[colorIndex].g * intensity,
-                        rainbow[colorIndex].b * intensity);
-
-                    // Compute quad coordinates for the pixel.
-                    float x1 = offsetX + x * windowScale;
-                    float y1 = offsetY + y * windowScale;
-                    float x2 = offsetX + (x + 1) * windowScale;
-                    float y2 = offsetY + (y + 1) * windowScale;
-                    glVertex2f(x1, y1);
-                    glVertex2f(x2, y1);
-                    glVertex2f(x2, y2);
-                    glVertex2f(x1, y2);
-                }
+PlayerView* findView(GLFWwindow* window) {
+    for (std::unique_ptr<PlayerView>& view : views) {
+        if (view->window == window)
+            return view.get();
+    }
+    return nullptr;
+}
+
+// Keys that belong to one view: Esc, F/F11, P and [ ]. Returns false for everything else, which
+// the main window handles as if pressed there.
+bool handleViewKey(PlayerView& view, int key) {
+    FrameGeometry geometry = viewGeometry(view);
+    int scale = viewScale(view);
+    switch (key) {
+    case GLFW_KEY_ESCAPE:
+        if (glfwGetWindowMonitor(view.window))
+            toggleFullscreen(view.window, geometry.width * scale, geometry.height * scale);
+        else
+            glfwSetWindowShouldClose(view.window, GLFW_TRUE);
+        return true;
+    case GLFW_KEY_F:
+    case GLFW_KEY_F11:
+        toggleFullscreen(view.window, geometry.width * scale, geometry.height * scale);
+        return true;
+    case GLFW_KEY_P:
+        view.palette = nextPalette(viewPalette(view));
+        view.ownPalette = true;
+        return true;
+    case GLFW_KEY_LEFT_BRACKET:
+    case GLFW_KEY_RIGHT_BRACKET:
+        view.geometry = geometry;
+        view.scale = (key == GLFW_KEY_RIGHT_BRACKET) ? scale + 1 : std::max(scale - 1, 1);
+        view.ownGeometry = true;
+        return true;
+    default:
+        return false;
+    }
+}
+
+// --- Overview bar ---
+// Takes the index over once the background build is done.
+void pollOverviewIndex(void) {
+    if (pollOverviewBuild(overviewBuilder, overviewIndex))
+        overviewColumns.clear();
+}
+
+// Drawn from the overview index only (a few KB per redraw), never from the file itself.
+void renderOverview(int windowWidth, int windowHeight, const PlayheadSnapshot& playhead, const PaletteLUT& palette) {
+    pollOverviewIndex();
+    if (!overviewIndex.empty() && overviewColumns.size() != static_cast<size_t>(windowWidth))
+        summarizeOverviewColumns(overviewIndex, static_cast<size_t>(windowWidth), overviewColumns);
+    double fileSize = static_cast<double>(fileData.size());
+    double loopStart = playhead.loopEnabled ? playhead.loopStart / fileSize : -1.0;
+    double loopEnd = playhead.loopEnabled ? playhead.loopEnd / fileSize : -1.0;
+    double progress = -1.0;
+    if (overviewBuildRunning(overviewBuilder) && overviewBuilder.total > 0)
+        progress = static_cast<double>(overviewBuilder.progress.load()) / static_cast<double>(overviewBuilder.total);
+    renderOverviewBar(overviewColumns, 0, windowHeight - OVERVIEW_BAR_HEIGHT, windowWidth, OVERVIEW_BAR_HEIGHT,
+        palette, wrapPosition(playhead.position, fileSize) / fileSize, loopStart, loopEnd, progress);
+}
+
+// Seek to the frame under the cursor (window coordinates) if it is over the overview bar.
+bool scrubOverview(GLFWwindow* window, double x, double y, bool requireInside) {
+    int width, height, framebufferWidth, framebufferHeight;
+    glfwGetWindowSize(window, &width, &height);
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    if (width <= 0 || height <= 0 || framebufferHeight <= 0)
+        return false;
+    double barTop = height - OVERVIEW_BAR_HEIGHT * static_cast<double>(height) / framebufferHeight;
+    if (requireInside && y < barTop)
+        return false;
+    double fraction = x / width;
+    fraction = fraction < 0.0 ? 0.0 : (fraction > 1.0 ? 1.0 : fraction);
+    size_t frame = static_cast<size_t>(fraction * static_cast<double>(totalFrames));
+    if (frame >= totalFrames)
+        frame = totalFrames - 1;
+    double position = static_cast<double>(frame) * static_cast<double>(frameByteCount(frameGeometry));
+    requestPrefetch(currentMedia->ring, position);
+    sendPlaybackCommand(controlChannel, CMD_SEEK_ABSOLUTE, position);
+    return true;
+}
+
+void mouseButtonCallback(GLFWwindow* window, int button, int action, int mods) {
+    if (button != GLFW_MOUSE_BUTTON_LEFT)
+        return;
+    double x, y;
+    glfwGetCursorPos(window, &x, &y);
+    int slot = showThumbnails ? thumbnailSlotAt(window, x, y) : -1;
+    if (action == GLFW_RELEASE) {
+        overviewScrubbing = false;
+        // A click on a thumbnail seeks to it; the strip then recenters on the new playhead.
+        if (slot >= 0 && slot == thumbnailPressedSlot && thumbnailFrames[static_cast<size_t>(slot)] != NO_THUMBNAIL) {
+            double position = static_cast<double>(thumbnailFrames[static_cast<size_t>(slot)]) *
+                static_cast<double>(frameByteCount(frameGeometry));
+            requestPrefetch(currentMedia->ring, position);
+            sendPlaybackCommand(controlChannel, CMD_SEEK_ABSOLUTE, position);
+        }
+        thumbnailPressedSlot = -1;
+        return;
+    }
+    thumbnailPressedSlot = slot;
+    overviewScrubbing = slot < 0 && showOverview && scrubOverview(window, x, y, true);
+}
+
+void cursorPosCallback(GLFWwindow* window, double x, double y) {
+    if (overviewScrubbing && showOverview)
+        scrubOverview(window, x, y, false);
+}
+
+// --- Thumbnail strip ---
+// Cursor position (window coordinates) in framebuffer pixels.
+void cursorToFramebuffer(GLFWwindow* window, double x, double y, int& pixelX, int& pixelY) {
+    int width, height, framebufferWidth, framebufferHeight;
+    glfwGetWindowSize(window, &width, &height);
+    glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+    pixelX = width > 0 ? static_cast<int>(x * framebufferWidth / width) : 0;
+    pixelY = height > 0 ? static_cast<int>(y * framebufferHeight / height) : 0;
+}
+
+// Strip slot under the cursor (window coordinates) as last drawn, or -1.
+int thumbnailSlotAt(GLFWwindow* window, double x, double y) {
+    int pixelX, pixelY;
+    cursorToFramebuffer(window, x, y, pixelX, pixelY);
+    for (size_t slot = 0; slot < thumbnailQuads.size() && slot < thumbnailFrames.size(); slot++) {
+        const ThumbnailQuad& quad = thumbnailQuads[slot];
+        if (pixelX >= quad.x - 2 && pixelX < quad.x + quad.width + 2 && pixelY >= quad.y && pixelY < quad.y + quad.height)
+            return static_cast<int>(slot);
+    }
+    return -1;
+}
+
+// Restart the builder when the file, the frame size or the overview's availability changes. Only
+// a new file or frame size empties the atlas; banded thumbnails just join the others.
+void updateThumbnailSource(void) {
+    ThumbnailSource source;
+    source.view = fileData;
+    source.shape = chooseThumbnailShape(frameGeometry.width, frameByteCount(frameGeometry));
+    const ThumbnailSource& running = thumbnailBuilder.source;
+    bool sameFrames = thumbnailsRunning(thumbnailBuilder) && running.view.data() == source.view.data() &&
+        running.view.size() == source.view.size() && running.shape.frameWidth == source.shape.frameWidth &&
+        running.shape.frameBytes == source.shape.frameBytes;
+    if (sameFrames && static_cast<bool>(running.blockMeans) == !overviewIndex.empty())
+        return;
+    if (!overviewIndex.empty()) {
+        source.blockMeans = std::make_shared<const std::vector<unsigned char>>(overviewBlockMeans(overviewIndex));
+        source.blockSize = overviewIndex.levels[0].blockSize;
+    }
+    if (!sameFrames)
+        resetThumbnailAtlas(thumbnailAtlas, source.shape.width, source.shape.height);
+    startThumbnails(thumbnailBuilder, source);
+}
+
+// Slots are laid out from the middle (the playhead's frame) outward. Each redraw uploads what the
+// builder finished, then asks it for whatever is still missing: the preview first, then the
+// slots nearest the playhead. A missing thumbnail is drawn as a placeholder (or as the other kind
+// of the same frame, when that one is resident); the preview falls back to the nearest resident
+// frame, so it shows something the moment the cursor moves.
+void renderThumbnailStrip(GLFWwindow* window, int windowWidth, int windowHeight, const PlayheadSnapshot& playhead,
+    const PaletteLUT& palette) {
+    thumbnailQuads.clear();
+    if (!thumbnailAtlas.ready || currentMedia->stream || totalFrames == 0)
+        return;
+    pollOverviewIndex();
+    updateThumbnailSource();
+    if (!thumbnailsRunning(thumbnailBuilder))
+        return;
+    const ThumbnailSource& source = thumbnailBuilder.source;
+    const ThumbnailShape& shape = source.shape;
+    const int boxHeight = THUMBNAIL_STRIP_HEIGHT - 8;
+    const int boxWidth = std::clamp(boxHeight * shape.width / shape.height, boxHeight / 4, boxHeight * 4);
+    const int pitch = boxWidth + 4;
+    int count = std::max(windowWidth / pitch, 1);
+    if (count % 2 == 0)
+        count = std::max(count - 1, 1);
+    const int stripTop = windowHeight - THUMBNAIL_STRIP_HEIGHT - (showOverview ? OVERVIEW_BAR_HEIGHT : 0);
+    const int left = (windowWidth - count * pitch) / 2 + 2;
+    const double fileSize = static_cast<double>(fileData.size());
+    const size_t playFrame = static_cast<size_t>(wrapPosition(playhead.position, fileSize) / shape.frameBytes);
+    thumbnailStripFrames(playFrame, totalFrames, count, thumbnailFrames);
+    const bool banded = source.blockMeans && thumbnailsUseOverview(shape, source.blockSize);
+    const int middle = count / 2;
+    std::vector<uint64_t> keys(thumbnailFrames.size(), 0);
+    for (int slot = 0; slot < count; slot++) {
+        if (thumbnailFrames[slot] != NO_THUMBNAIL)
+            keys[slot] = thumbnailKey(thumbnailFrames[slot], banded && std::abs(slot - middle) > THUMBNAIL_FINE_SLOTS);
+    }
+
+    // What the cursor is over: a slot, or a point of the overview bar.
+    size_t previewFrame = NO_THUMBNAIL;
+    int hoverSlot = -1, cursorX = 0, cursorY = 0;
+    if (glfwGetWindowAttrib(window, GLFW_HOVERED)) {
+        double x, y;
+        glfwGetCursorPos(window, &x, &y);
+        cursorToFramebuffer(window, x, y, cursorX, cursorY);
+        for (int slot = 0; slot < count; slot++) {
+            int slotX = left + slot * pitch;
+            if (cursorY >= stripTop && cursorY < stripTop + THUMBNAIL_STRIP_HEIGHT && cursorX >= slotX - 2 &&
+                cursorX < slotX + pitch - 2 && thumbnailFrames[slot] != NO_THUMBNAIL) {
+                hoverSlot = slot;
+                previewFrame = thumbnailFrames[slot];
             }
         }
+        if (hoverSlot < 0 && showOverview && cursorY >= windowHeight - OVERVIEW_BAR_HEIGHT && windowWidth > 0) {
+            double fraction = std::clamp(static_cast<double>(cursorX) / windowWidth, 0.0, 1.0);
+            previewFrame = std::min(static_cast<size_t>(fraction * static_cast<double>(totalFrames)), totalFrames - 1);
+        }
+    }
+    const uint64_t previewKey = hoverSlot >= 0 ? keys[hoverSlot] : thumbnailKey(previewFrame, false);
+
+    // Claim what is resident before uploading, so nothing drawn this pass is evicted.
+    beginThumbnailPass(thumbnailAtlas);
+    for (int slot = 0; slot < count; slot++) {
+        if (thumbnailFrames[slot] != NO_THUMBNAIL)
+            findThumbnail(thumbnailAtlas, keys[slot]);
+    }
+    pollThumbnails(thumbnailBuilder, thumbnailResults);
+    for (const Thumbnail& thumbnail : thumbnailResults)
+        storeThumbnail(thumbnailAtlas, thumbnail.key, thumbnail.pixels.data());
+
+    std::vector<uint64_t> wanted;
+    if (previewFrame != NO_THUMBNAIL && findThumbnail(thumbnailAtlas, previewKey) < 0)
+        wanted.push_back(previewKey);
+    for (int step = 0; step <= middle; step++) {
+        for (int side = -1; side <= 1; side += 2) {
+            int slot = middle + side * step;
+            if ((step == 0 && side > 0) || thumbnailFrames[slot] == NO_THUMBNAIL)
+                continue;
+            if (findThumbnail(thumbnailAtlas, keys[slot]) < 0 && keys[slot] != previewKey)
+                wanted.push_back(keys[slot]);
+        }
+    }
+    requestThumbnails(thumbnailBuilder, wanted);
+
+    for (int slot = 0; slot < count; slot++) {
+        ThumbnailQuad quad = { -1, left + slot * pitch, stripTop + 4, boxWidth, boxHeight };
+        if (thumbnailFrames[slot] != NO_THUMBNAIL) {
+            quad.cell = findThumbnail(thumbnailAtlas, keys[slot]);
+            if (quad.cell < 0)
+                quad.cell = findThumbnail(thumbnailAtlas, keys[slot] ^ 1);
+        }
+        thumbnailQuads.push_back(quad);
+    }
+    setupPixelProjection(windowWidth, windowHeight);
+    renderThumbnailStrip(thumbnailAtlas, thumbnailQuads, hoverSlot >= 0 ? hoverSlot : middle, stripTop, windowWidth,
+        THUMBNAIL_STRIP_HEIGHT, windowHeight, palette);
+    if (previewFrame == NO_THUMBNAIL)
+        return;
+    int cell = findThumbnail(thumbnailAtlas, previewKey);
+    if (cell < 0)
+        cell = findThumbnail(thumbnailAtlas, previewKey ^ 1);
+    if (cell < 0)
+        cell = nearestThumbnail(thumbnailAtlas, previewFrame);
+    ThumbnailQuad preview = { cell, 0, 0, boxWidth * THUMBNAIL_PREVIEW_SCALE, boxHeight * THUMBNAIL_PREVIEW_SCALE };
+    preview.x = std::clamp(cursorX - preview.width / 2, 2, std::max(windowWidth - preview.width - 2, 2));
+    preview.y = std::max(stripTop - preview.height - 8, 2);
+    renderThumbnails(thumbnailAtlas, std::vector<ThumbnailQuad>(1, preview), 0, windowHeight, palette);
+}
+
+// --- Drag and drop ---
+// Dropped files and directories are appended to the playlist; playback moves to the first of them.
+void dropCallback(GLFWwindow* window, int count, const char** paths) {
+    size_t first = playlist.paths.size();
+    for (int i = 0; i < count; i++)
+        addPlaylistPath(playlist, paths[i]);
+    if (playlist.paths.size() == first)
+        return;
+    pendingPlaylistIndex = static_cast<long long>(first);
+    preloadMedia(mediaLoader, playlist.paths[first]);
+}
+
+// --- Search prompt ---
+// "/" starts typing a pattern (see parseSearchPattern); keyCallback handles Enter, Esc and Backspace.
+void charCallback(GLFWwindow* window, unsigned int codepoint) {
+    if (!searchPromptActive) {
+        if (codepoint == '/') {
+            searchPromptActive = true;
+            searchPromptText.clear();
+        }
+        return;
+    }
+    if (codepoint >= 0x20 && codepoint < 0x7F && searchPromptText.size() < SEARCH_MAX_PATTERN_BYTES * 2 + 4)
+        searchPromptText += static_cast<char>(codepoint);
+}
+
+// A typed pattern replaces the current ones.
+void runSearchPrompt(void) {
+    searchPromptActive = false;
+    PatternSet patterns;
+    if (!addSearchPattern(patterns, searchPromptText)) {
+        std::cerr << "Invalid search pattern: " << searchPromptText << std::endl;
+        return;
     }
-    glEnd();
+    searchPatterns = patterns;
+    restartPatternSearch();
 }
 
 // --- Toggle fullscreen ---
+// Goes fullscreen on the monitor the window is on and comes back on the same monitor.
 void toggleFullscreen(GLFWwindow* window, int windowWidth, int windowHeight) {
-    if (isFullscreen) {
-        glfwSetWindowMonitor(window, NULL, windowWidth / 10, windowHeight / 10,
+    GLFWmonitor* current = glfwGetWindowMonitor(window);
+    if (current) {
+        int x = 0, y = 0;
+        glfwGetMonitorPos(current, &x, &y);
+        glfwSetWindowMonitor(window, NULL, x + windowWidth / 10, y + windowHeight / 10,
             windowWidth, windowHeight, GLFW_DONT_CARE);
-        isFullscreen = false;
     }
     else {
-        primaryMonitor = glfwGetPrimaryMonitor();
-        const GLFWvidmode* mode = glfwGetVideoMode(primaryMonitor);
-        glfwSetWindowMonitor(window, primaryMonitor, 0, 0,
+        GLFWmonitor* monitor = monitorForWindow(window);
+        const GLFWvidmode* mode = glfwGetVideoMode(monitor);
+        glfwSetWindowMonitor(window, monitor, 0, 0,
             mode->width, mode->height, mode->refreshRate);
-        isFullscreen = true;
     }
+    if (window == mainWindow)
+        isFullscreen = !current;
+}
+
+// The monitor under the window's center, or the primary monitor if there is none.
+GLFWmonitor* monitorForWindow(GLFWwindow* window) {
+    int x, y, width, height, count = 0;
+    glfwGetWindowPos(window, &x, &y);
+    glfwGetWindowSize(window, &width, &height);
+    int centerX = x + width / 2, centerY = y + height / 2;
+    GLFWmonitor** monitors = glfwGetMonitors(&count);
+    for (int i = 0; i < count; i++) {
+        int monitorX, monitorY;
+        glfwGetMonitorPos(monitors[i], &monitorX, &monitorY);
+        const GLFWvidmode* mode = glfwGetVideoMode(monitors[i]);
+        if (mode && centerX >= monitorX && centerX < monitorX + mode->width && centerY >= monitorY &&
+            centerY < monitorY + mode->height)
+            return monitors[i];
+    }
+    return glfwGetPrimaryMonitor();
 }
 
 // --- Key callback ---
 void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     if (action != GLFW_PRESS)
         return;
-    static int fixedWindowWidth = FRAME_WIDTH * windowScale;
-    static int fixedWindowHeight = FRAME_HEIGHT * windowScale;
+    if (searchPromptActive) {
+        if (key == GLFW_KEY_ENTER || key == GLFW_KEY_KP_ENTER)
+            runSearchPrompt();
+        else if (key == GLFW_KEY_ESCAPE)
+            searchPromptActive = false;
+        else if (key == GLFW_KEY_BACKSPACE && !searchPromptText.empty())
+            searchPromptText.erase(searchPromptText.size() - 1);
+        return;
+    }
+    if (PlayerView* view = findView(window)) {
+        if (!handleViewKey(*view, key))
+            keyCallback(mainWindow, key, scancode, action, mods);
+        return;
+    }
+    int fixedWindowWidth = frameGeometry.width * windowScale;
+    int fixedWindowHeight = frameGeometry.height * windowScale;
+    double frameBytes = static_cast<double>(frameByteCount(frameGeometry));
+    // Seeks also go to the prefetch ring, so the target chunk is read before the audio thread
+    // gets there.
+    double playheadPosition = controlChannel.playhead.load().position;
     switch (key) {
     case GLFW_KEY_ESCAPE:
         if (isFullscreen)
@@ -411,74 +1463,200 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
         else
             glfwSetWindowShouldClose(window, GLFW_TRUE);
         break;
+    case GLFW_KEY_F3:
+        // Collection stays on while a stats log is being written.
+        instrumentation.overlayVisible = !instrumentation.overlayVisible;
+        instrumentation.enabled = instrumentation.overlayVisible || instrumentation.log != nullptr;
+        if (instrumentation.enabled)
+            initGpuTimer(instrumentation.gpu);
+        break;
     case GLFW_KEY_F:
     case GLFW_KEY_F11:
         toggleFullscreen(window, fixedWindowWidth, fixedWindowHeight);
         break;
     case GLFW_KEY_SPACE:
-        isPaused = !isPaused;
+        sendPlaybackCommand(controlChannel, CMD_TOGGLE_PAUSE);
+        break;
+    case GLFW_KEY_TAB:
+        // Next playlist entry (Shift: previous).
+        switchPlaylistEntry((mods & GLFW_MOD_SHIFT) ? -1 : 1);
         break;
     case GLFW_KEY_RIGHT:
-        audioPosition += static_cast<double>(FRAME_WIDTH * FRAME_HEIGHT);
+        sendPlaybackCommand(controlChannel, CMD_SEEK_RELATIVE, frameBytes);
+        requestPrefetch(currentMedia->ring, playheadPosition + frameBytes);
         break;
     case GLFW_KEY_LEFT:
-        audioPosition -= static_cast<double>(FRAME_WIDTH * FRAME_HEIGHT);
+        sendPlaybackCommand(controlChannel, CMD_SEEK_RELATIVE, -frameBytes);
+        requestPrefetch(currentMedia->ring, playheadPosition - frameBytes);
+        break;
+    case GLFW_KEY_H:
+    case GLFW_KEY_J: {
+        // H: next high-entropy region (compressed/encrypted), J: next low-entropy region.
+        // Shift searches backwards. Does nothing until the analysis pass has finished.
+        size_t frame = static_cast<size_t>(wrapPosition(playheadPosition, static_cast<double>(fileData.size())) / frameBytes);
+        int direction = (mods & GLFW_MOD_SHIFT) ? -1 : 1;
+        long long target = (key == GLFW_KEY_H) ? findHighEntropyFrame(frameAnalysis, frame, direction)
+            : findLowEntropyFrame(frameAnalysis, frame, direction);
+        if (target >= 0) {
+            requestPrefetch(currentMedia->ring, static_cast<double>(target) * frameBytes);
+            sendPlaybackCommand(controlChannel, CMD_SEEK_ABSOLUTE, static_cast<double>(target) * frameBytes);
+        }
+        break;
+    }
+    case GLFW_KEY_D: {
+        // Compare mode: next frame that differs (Shift: previous), from the changed-byte index.
+        // Does nothing until the index is built.
+        size_t frame = static_cast<size_t>(wrapPosition(playheadPosition, static_cast<double>(fileData.size())) / frameBytes);
+        long long target = findChangedFrame(diffIndex, frame, (mods & GLFW_MOD_SHIFT) ? -1 : 1);
+        if (target >= 0) {
+            requestPrefetch(currentMedia->ring, static_cast<double>(target) * frameBytes);
+            sendPlaybackCommand(controlChannel, CMD_SEEK_ABSOLUTE, static_cast<double>(target) * frameBytes);
+        }
+        break;
+    }
+    case GLFW_KEY_N: {
+        // Frame of the next search match (Shift: previous).
+        size_t frame = static_cast<size_t>(wrapPosition(playheadPosition, static_cast<double>(fileData.size())) / frameBytes);
+        long long target = findMatchFrame(searchMatches, static_cast<size_t>(frameBytes), frame, (mods & GLFW_MOD_SHIFT) ? -1 : 1);
+        if (target >= 0) {
+            requestPrefetch(currentMedia->ring, static_cast<double>(target) * frameBytes);
+            sendPlaybackCommand(controlChannel, CMD_SEEK_ABSOLUTE, static_cast<double>(target) * frameBytes);
+        }
+        break;
+    }
+    case GLFW_KEY_X:
+        // Compare mode: XOR, absolute difference, or the file itself.
+        if (diffEnabled)
+            diffDisplay = static_cast<DiffDisplay>((diffDisplay + 1) % DIFF_DISPLAY_COUNT);
         break;
     case GLFW_KEY_0:
-        playbackMultiplier = 1.0;
+        sendPlaybackCommand(controlChannel, CMD_SET_MULTIPLIER, 1.0);
         break;
     case GLFW_KEY_MINUS:
-        playbackMultiplier = -playbackMultiplier;
-        if (playbackMultiplier == 0)
-            playbackMultiplier = -1.0;
+        sendPlaybackCommand(controlChannel, CMD_REVERSE);
         break;
     case GLFW_KEY_EQUAL:
-        playbackMultiplier = std::fabs(playbackMultiplier);
-        if (playbackMultiplier == 0)
-            playbackMultiplier = 1.0;
+        sendPlaybackCommand(controlChannel, CMD_FORWARD);
         break;
     case GLFW_KEY_M:
-        isAudioEnabled = !isAudioEnabled;
+        sendPlaybackCommand(controlChannel, CMD_TOGGLE_AUDIO);
         break;
     case GLFW_KEY_R:
-        playbackMultiplier = -playbackMultiplier;
-        if (playbackMultiplier == 0)
-            playbackMultiplier = -1.0;
+        sendPlaybackCommand(controlChannel, CMD_REVERSE);
         break;
     case GLFW_KEY_BACKSPACE:
-        audioPosition = 0.0;
-        playbackMultiplier = 1.0;
-        isPaused = false;
+        requestPrefetch(currentMedia->ring, 0.0);
+        sendPlaybackCommand(controlChannel, CMD_SEEK_ABSOLUTE, 0.0);
+        sendPlaybackCommand(controlChannel, CMD_SET_MULTIPLIER, 1.0);
+        sendPlaybackCommand(controlChannel, CMD_RESUME);
         break;
-    case GLFW_KEY_PAGE_UP: {
-        double step = calculateLogAdjustment(playbackMultiplier);
-        playbackMultiplier += step;
+    case GLFW_KEY_PAGE_UP:
+        sendPlaybackCommand(controlChannel, CMD_STEP_MULTIPLIER, 1.0);
         break;
-    }
-    case GLFW_KEY_PAGE_DOWN: {
-        double step = calculateLogAdjustment(playbackMultiplier);
-        playbackMultiplier -= step;
+    case GLFW_KEY_PAGE_DOWN:
+        sendPlaybackCommand(controlChannel, CMD_STEP_MULTIPLIER, -1.0);
         break;
-    }
     case GLFW_KEY_HOME:
-        audioPosition = 0.0;
+        requestPrefetch(currentMedia->ring, 0.0);
+        sendPlaybackCommand(controlChannel, CMD_SEEK_ABSOLUTE, 0.0);
         break;
     case GLFW_KEY_END:
-        audioPosition = static_cast<double>(FRAME_WIDTH * FRAME_HEIGHT) * (static_cast<double>(totalFrames - 1));
+        requestPrefetch(currentMedia->ring, frameBytes * (static_cast<double>(totalFrames - 1)));
+        sendPlaybackCommand(controlChannel, CMD_SEEK_ABSOLUTE,
+            frameBytes * (static_cast<double>(totalFrames - 1)));
         break;
     case GLFW_KEY_L:
-        loopEnabled = !loopEnabled;
+        sendPlaybackCommand(controlChannel, CMD_TOGGLE_LOOP);
         break;
     case GLFW_KEY_B:
-        boomerangMode = !boomerangMode;
+        sendPlaybackCommand(controlChannel, CMD_TOGGLE_BOOMERANG);
+        break;
+    case GLFW_KEY_P:
+        currentPalette = nextPalette(currentPalette);
+        break;
+    case GLFW_KEY_C:
+        softwareRendering = !softwareRendering;
+        break;
+    case GLFW_KEY_W:
+        waterfallMode = !waterfallMode;
+        break;
+    case GLFW_KEY_E:
+        // Follow the live edge of a stream; turning it off leaves the playhead where it is at 1x.
+        if (!currentMedia->stream)
+            break;
+        followStream = !followStream;
+        if (!followStream)
+            sendPlaybackCommand(controlChannel, CMD_SET_MULTIPLIER, 1.0);
+        break;
+    case GLFW_KEY_A:
+        if (!showSpectrogram && !spectrogramRenderer.ready) {
+            std::cerr << "The spectrogram needs OpenGL 3.0." << std::endl;
+            break;
+        }
+        showSpectrogram = !showSpectrogram;
+        if (showSpectrogram)
+            startSpectrogram(spectrogram);
+        else
+            stopSpectrogram(spectrogram);
+        break;
+    case GLFW_KEY_O:
+        showOverview = !showOverview;
+        overviewScrubbing = false;
+        break;
+    case GLFW_KEY_Y:
+        showScope = !showScope;
         break;
+    case GLFW_KEY_T:
+        showThumbnails = !showThumbnails;
+        thumbnailPressedSlot = -1;
+        if (!showThumbnails) {
+            stopThumbnails(thumbnailBuilder);
+            thumbnailQuads.clear();
+        }
+        break;
+    case GLFW_KEY_Q:
+        sendPlaybackCommand(controlChannel, CMD_CYCLE_RESAMPLER);
+        break;
+    case GLFW_KEY_S: {
+        // Next sample format; Shift: double the channel count (1, 2, 4, 8, back to 1).
+        AudioLayout layout = audioLayout;
+        if (mods & GLFW_MOD_SHIFT)
+            layout.channels = (layout.channels >= MAX_AUDIO_CHANNELS) ? 1 : layout.channels * 2;
+        else
+            layout.format = nextSampleFormat(layout.format);
+        setAudioLayout(layout);
+        break;
+    }
+    case GLFW_KEY_G: {
+        // Next preset (Shift: previous); a custom size steps to the first preset.
+        int preset = findGeometryPreset(frameGeometry.width, frameGeometry.height);
+        int step = (mods & GLFW_MOD_SHIFT) ? -1 : 1;
+        int next = (preset < 0) ? 0 : preset + step;
+        for (int tries = 0; tries < geometryPresetCount(); tries++, next += step) {
+            FrameGeometry geometry = geometryPreset(next);
+            geometry.pixelFormat = frameGeometry.pixelFormat;
+            if (applyFrameGeometry(window, geometry))
+                break;
+        }
+        break;
+    }
+    case GLFW_KEY_V: {
+        // Next pixel format (Shift: previous), skipping formats that do not fit the frame size.
+        int step = (mods & GLFW_MOD_SHIFT) ? -1 : 1;
+        FrameGeometry geometry = frameGeometry;
+        geometry.scale = windowScale;
+        for (int tries = 1; tries < PIXEL_FORMAT_COUNT; tries++) {
+            geometry.pixelFormat = nextPixelFormat(frameGeometry.pixelFormat, step * tries);
+            if (applyFrameGeometry(window, geometry))
+                break;
+        }
+        break;
+    }
     case GLFW_KEY_COMMA:  // '<'
-        if (!loopEnabled)
-            loopStart = audioPosition;
+        sendPlaybackCommand(controlChannel, CMD_MARK_LOOP_START);
         break;
     case GLFW_KEY_PERIOD: // '>'
-        if (!loopEnabled)
-            loopEnd = audioPosition;
+        sendPlaybackCommand(controlChannel, CMD_MARK_LOOP_END);
         break;
     case GLFW_KEY_LEFT_BRACKET:
         if (windowScale > 1)
@@ -490,30 +1668,297 @@ void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods
     }
 }
 
-int main(void) {
-    std::string filename = openFileDialog();
-    if (filename.empty()) {
+// --- Sample format names for --audio-format ---
+bool parseSampleFormat(const std::string& name, SampleFormat& format) {
+    for (int i = 0; i < SAMPLE_FORMAT_COUNT; i++) {
+        if (name == sampleFormatName(static_cast<SampleFormat>(i))) {
+            format = static_cast<SampleFormat>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// --- Pixel format names for --pixel-format (case-insensitive) ---
+bool parsePixelFormat(const std::string& name, PixelFormat& format) {
+    for (int i = 0; i < PIXEL_FORMAT_COUNT; i++) {
+        const char* candidate = pixelFormatName(static_cast<PixelFormat>(i));
+        bool match = name.size() == std::strlen(candidate);
+        for (size_t c = 0; match && c < name.size(); c++)
+            match = std::tolower(static_cast<unsigned char>(name[c])) == std::tolower(static_cast<unsigned char>(candidate[c]));
+        if (match) {
+            format = static_cast<PixelFormat>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+bool parsePalette(const std::string& name, PaletteId& palette) {
+    for (int i = 0; i < PALETTE_COUNT; i++) {
+        // Names are compared without case or spaces ("byteclass" is "Byte Class").
+        std::string candidate;
+        for (const char* c = paletteName(static_cast<PaletteId>(i)); *c; c++) {
+            if (*c != ' ')
+                candidate += static_cast<char>(std::tolower(static_cast<unsigned char>(*c)));
+        }
+        std::string wanted;
+        for (char c : name) {
+            if (c != ' ')
+                wanted += static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+        }
+        if (wanted == candidate) {
+            palette = static_cast<PaletteId>(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+// --view OFFSET[,geometry=WxH|preset][,format=FMT][,scale=N][,palette=NAME][,monitor=K]
+// OFFSET is in bytes from the playhead (negative: behind). Geometry, format and scale given for
+// a view are its own; anything left out follows the main window.
+bool parseViewSpec(const std::string& spec, PlayerView& view) {
+    size_t comma = spec.find(',');
+    std::string offset = spec.substr(0, comma);
+    char* end = nullptr;
+    view.offset = std::strtod(offset.c_str(), &end);
+    if (offset.empty() || *end != '\0') {
+        std::cerr << "Invalid --view offset: " << offset << std::endl;
+        return false;
+    }
+    view.geometry = frameGeometry;
+    view.scale = frameGeometry.scale;
+    bool scaleGiven = false;
+    while (comma != std::string::npos) {
+        size_t next = spec.find(',', comma + 1);
+        std::string option = spec.substr(comma + 1, next == std::string::npos ? std::string::npos : next - comma - 1);
+        comma = next;
+        size_t equals = option.find('=');
+        std::string key = option.substr(0, equals), value = equals == std::string::npos ? "" : option.substr(equals + 1);
+        bool valid = !value.empty();
+        if (valid && key == "geometry") {
+            valid = parseFrameGeometry(value.c_str(), view.geometry);
+            if (!scaleGiven)
+                view.scale = view.geometry.scale;
+            view.ownGeometry = true;
+        }
+        else if (valid && key == "format") {
+            valid = parsePixelFormat(value, view.geometry.pixelFormat);
+            view.ownGeometry = true;
+        }
+        else if (valid && key == "scale") {
+            view.scale = std::atoi(value.c_str());
+            valid = view.scale > 0;
+            scaleGiven = true;
+            view.ownGeometry = true;
+        }
+        else if (valid && key == "palette") {
+            valid = parsePalette(value, view.palette);
+            view.ownPalette = true;
+        }
+        else if (valid && key == "monitor") {
+            view.monitor = std::atoi(value.c_str());
+            valid = view.monitor >= 0;
+        }
+        else {
+            valid = false;
+        }
+        if (!valid) {
+            std::cerr << "Invalid --view option: " << option << " (geometry=, format=, scale=, palette=, monitor=)" << std::endl;
+            return false;
+        }
+    }
+    if (!pixelFormatFits(view.geometry.pixelFormat, view.geometry.width, view.geometry.height)) {
+        std::cerr << "--view: " << pixelFormatName(view.geometry.pixelFormat) << " does not fit a " << view.geometry.width
+                  << "x" << view.geometry.height << " frame." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// --- Command line: [--geometry WxH|preset] [--pixel-format FMT] [--cpu] [--fps N] [--stats-log PATH]
+//     [--stats-interval S] [--audio-format FMT] [--channels N] [--pcm-rate HZ]
+//     [--stream SPEC [--stream-history MB] [--stream-latency S]] [--view SPEC ...]
+//     [--diff FILE] [--diff-offset BYTES] [--search PATTERN ...] [--no-session] [--realtime]
+//     [file|dir ...] ---
+bool parseCommandLine(int argc, char** argv) {
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--geometry" && i + 1 < argc) {
+            if (!parseFrameGeometry(argv[++i], frameGeometry)) {
+                std::cerr << "Invalid geometry: " << argv[i] << " (use WxH or a preset name)" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--pixel-format" && i + 1 < argc) {
+            if (!parsePixelFormat(argv[++i], frameGeometry.pixelFormat)) {
+                std::cerr << "Invalid --pixel-format: " << argv[i] << " (indexed8, rgb24, bgra32, rgb565, 4bpp, 1bpp, yuv420)" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--cpu") {
+            softwareRendering = true;
+        }
+        else if (arg == "--fps" && i + 1 < argc) {
+            requestedFps = std::atof(argv[++i]);
+            if (requestedFps <= 0.0) {
+                std::cerr << "Invalid --fps: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--stats-log" && i + 1 < argc) {
+            statsLogPath = argv[++i];
+        }
+        else if (arg == "--stats-interval" && i + 1 < argc) {
+            instrumentation.sampleInterval = std::atof(argv[++i]);
+            if (instrumentation.sampleInterval <= 0.0) {
+                std::cerr << "Invalid --stats-interval: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--audio-format" && i + 1 < argc) {
+            if (!parseSampleFormat(argv[++i], audioLayout.format)) {
+                std::cerr << "Invalid --audio-format: " << argv[i] << " (u8, s8, s16le, s16be, s24le, s32le, f32le)" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--channels" && i + 1 < argc) {
+            int channels = std::atoi(argv[++i]);
+            if (channels < 1 || channels > static_cast<int>(MAX_AUDIO_CHANNELS)) {
+                std::cerr << "Invalid --channels: " << argv[i] << " (1.." << MAX_AUDIO_CHANNELS << ")" << std::endl;
+                return false;
+            }
+            audioLayout.channels = static_cast<unsigned>(channels);
+        }
+        else if (arg == "--pcm-rate" && i + 1 < argc) {
+            pcmRate = std::atof(argv[++i]);
+            if (pcmRate <= 0.0) {
+                std::cerr << "Invalid --pcm-rate: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--stream" && i + 1 < argc) {
+            streamSpec = argv[++i];
+            if (!isStreamSpec(streamSpec)) {
+                std::cerr << "Invalid --stream: " << streamSpec << " (-, pipe:PATH, tcp:HOST:PORT, serial:PORT[@BAUD])" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--stream-history" && i + 1 < argc) {
+            double megabytes = std::atof(argv[++i]);
+            if (megabytes < 1.0) {
+                std::cerr << "Invalid --stream-history: " << argv[i] << " (MB, at least 1)" << std::endl;
+                return false;
+            }
+            streamHistoryBytes = static_cast<size_t>(megabytes * 1024.0 * 1024.0);
+        }
+        else if (arg == "--stream-latency" && i + 1 < argc) {
+            streamFollower.latencySeconds = std::atof(argv[++i]);
+            if (streamFollower.latencySeconds < 0.0) {
+                std::cerr << "Invalid --stream-latency: " << argv[i] << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--diff" && i + 1 < argc) {
+            diffPath = argv[++i];
+            diffEnabled = true;
+        }
+        else if (arg == "--diff-offset" && i + 1 < argc) {
+            char* end = nullptr;
+            unsigned long long offset = std::strtoull(argv[++i], &end, 0);
+            if (*end != '\0' || argv[i][0] == '-') {
+                std::cerr << "Invalid --diff-offset: " << argv[i] << " (bytes)" << std::endl;
+                return false;
+            }
+            diffOffset = static_cast<size_t>(offset);
+            diffEnabled = true;
+        }
+        else if (arg == "--search" && i + 1 < argc) {
+            if (!addSearchPattern(searchPatterns, argv[++i])) {
+                std::cerr << "Invalid --search: " << argv[i] << " (text, or hex:BYTES / 0xBYTES, up to "
+                          << SEARCH_MAX_PATTERN_BYTES << " bytes)" << std::endl;
+                return false;
+            }
+        }
+        else if (arg == "--no-session") {
+            useSessions = false;
+        }
+        else if (arg == "--realtime") {
+            realtimeMode = true;
+        }
+        else if (arg == "--view" && i + 1 < argc) {
+            std::unique_ptr<PlayerView> view(new PlayerView());
+            if (!parseViewSpec(argv[++i], *view))
+                return false;
+            views.push_back(std::move(view));
+        }
+        else if (!arg.empty() && arg[0] != '-') {
+            addPlaylistPath(playlist, arg);
+        }
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--geometry WxH|Player|Square|Rainbow|Wide|Big] [--pixel-format indexed8|rgb24|bgra32|rgb565|4bpp|1bpp|yuv420] [--cpu] [--fps N] [--stats-log PATH.csv|.json] [--stats-interval S] [--audio-format u8|s8|s16le|s16be|s24le|s32le|f32le] [--channels N] [--pcm-rate HZ] [--stream -|pipe:PATH|tcp:HOST:PORT|serial:PORT[@BAUD]] [--stream-history MB] [--stream-latency S] [--view OFFSET[,geometry=G][,format=F][,scale=N][,palette=P][,monitor=K] ...] [--diff FILE] [--diff-offset BYTES] [--search TEXT|hex:BYTES ...] [--no-session] [--realtime] [file|directory ...]" << std::endl;
+            return false;
+        }
+    }
+    if (!pixelFormatFits(frameGeometry.pixelFormat, frameGeometry.width, frameGeometry.height)) {
+        std::cerr << pixelFormatName(frameGeometry.pixelFormat) << " does not fit a " << frameGeometry.width << "x"
+                  << frameGeometry.height << " frame." << std::endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    if (!parseCommandLine(argc, argv))
+        return EXIT_FAILURE;
+    windowScale = frameGeometry.scale;
+    if (playlist.paths.empty() && streamSpec.empty()) {
+        std::string filename = openFileDialog();
+        if (!filename.empty())
+            playlist.paths.push_back(filename);
+    }
+    if (playlist.paths.empty() && streamSpec.empty()) {
         std::cerr << "No file selected. Exiting." << std::endl;
         return EXIT_FAILURE;
     }
-    if (!loadMediaFile(filename))
+    if (!diffPath.empty() && !openMappedFile(diffFile, diffPath))
+        return EXIT_FAILURE;
+    // Default loop: from frame 1 to frame 34 (off for a stream, which follows its live edge), unless
+    // the first file's session restores its own. Nothing else runs yet, so the engine state can be
+    // set directly.
+    audioEngine.playback.loopStart = 0.0;
+    audioEngine.playback.loopEnd = 34.0 * static_cast<double>(frameByteCount(frameGeometry));
+    audioEngine.playback.position = audioEngine.playback.loopStart;
+    audioEngine.playback.loopEnabled = streamSpec.empty();
+    audioEngine.playback.boomerangMode = false;
+    startMediaLoader(mediaLoader);
+    // Start with the stream, or with the first entry that opens and holds a frame.
+    if (!streamSpec.empty())
+        loadStreamSource(streamSpec);
+    else while (playlist.current < playlist.paths.size() && !loadMediaFile(playlist.paths[playlist.current]))
+        playlist.current++;
+    if (!currentMedia) {
+        stopMediaLoader(mediaLoader);
         return EXIT_FAILURE;
-    size_t bytesPerFrame = FRAME_WIDTH * FRAME_HEIGHT;
-    // Default loop: from frame 1 to frame 34.
-    loopStart = 0.0;
-    loopEnd = 34.0 * static_cast<double>(bytesPerFrame);
-    audioPosition = loopStart;
-    loopEnabled = true;
-    boomerangMode = false;
-    if (!initJackAudio())
+    }
+    if (!statsLogPath.empty() && !openInstrumentationLog(instrumentation, statsLogPath))
+        return EXIT_FAILURE;
+    audioEngine.frameBytes = static_cast<double>(frameByteCount(frameGeometry));
+    audioEngine.layout = audioLayout;
+    audioEngine.pcmRate = pcmRate;
+    publishPlayhead(controlChannel, audioEngine);
+    if (!initJackAudio(false))
         std::cerr << "Warning: JACK audio init failed; continuing without audio." << std::endl;
+    if (playlist.paths.size() > 1)
+        preloadMedia(mediaLoader, playlist.paths[playlistNeighbor(playlist, 1)]);
     if (!glfwInit()) {
         std::cerr << "Failed to initialize GLFW." << std::endl;
         return EXIT_FAILURE;
     }
     primaryMonitor = glfwGetPrimaryMonitor();
-    int windowWidth = FRAME_WIDTH * windowScale;
-    int windowHeight = FRAME_HEIGHT * windowScale;
+    int windowWidth = frameGeometry.width * windowScale;
+    int windowHeight = frameGeometry.height * windowScale;
     bool startFullscreen = false;
     GLFWwindow* window = startFullscreen ?
         glfwCreateWindow(glfwGetVideoMode(primaryMonitor)->width,
@@ -525,41 +1970,183 @@ int main(void) {
         glfwTerminate();
         return EXIT_FAILURE;
     }
+    mainWindow = window;
     glfwMakeContextCurrent(window);
     // Enable VSync
     glfwSwapInterval(1);
     glfwSetKeyCallback(window, keyCallback);
+    glfwSetMouseButtonCallback(window, mouseButtonCallback);
+    glfwSetCursorPosCallback(window, cursorPosCallback);
+    glfwSetDropCallback(window, dropCallback);
+    glfwSetCharCallback(window, charCallback);
     glClearColor(0.0f, 0.0f, 0.0f, 1.0f);
-    double lastVisualUpdate = glfwGetTime();
+    if (initTextureRenderer(textureRenderer))
+        initTileArrayRenderer(tileArrayRenderer);
+    initWaterfallRenderer(waterfallRenderer);
+    initSpectrogramRenderer(spectrogramRenderer);
+    initThumbnailAtlas(thumbnailAtlas);
+    initScopeRenderer(scopeRenderer);
+    for (size_t i = 0; i < views.size();) {
+        if (openView(*views[i], i + 1))
+            i++;
+        else
+            views.erase(views.begin() + static_cast<long>(i));
+    }
+    if (instrumentation.enabled)
+        initGpuTimer(instrumentation.gpu);
+    // Present at the requested rate, or at the monitor refresh rate by default.
+    const GLFWvidmode* videoMode = glfwGetVideoMode(primaryMonitor);
+    double targetFps = requestedFps;
+    if (targetFps <= 0.0)
+        targetFps = (videoMode && videoMode->refreshRate > 0) ? videoMode->refreshRate : DEFAULT_TARGET_FPS;
+    setTargetFps(frameScheduler, targetFps);
+    UpdateThrottle titleThrottle;
+    std::string lastTitle;
     while (!glfwWindowShouldClose(window)) {
-        double currentTime = glfwGetTime();
         processInput(window);
-        // Update title bar: show current frame and effective visual FPS.
-        double fileSize = static_cast<double>(fileData.size());
-        double wrappedPos = wrapPosition(audioPosition, fileSize);
-        size_t currentFrame = static_cast<size_t>(wrappedPos / static_cast<double>(bytesPerFrame));
-        if (currentFrame >= totalFrames)
-            currentFrame = totalFrames - 1;
-        char title[512];
-        std::snprintf(title, sizeof(title),
-            "Binary Waterfall Player - Frame: %zu/%zu - FPS: %.1f%s - Fixed Pixel Size: %d",
-            currentFrame + 1, totalFrames,
-            BASE_FRAME_RATE * playbackMultiplier,
-            (isPaused ? " [PAUSED]" : ""),
-            windowScale);
-        glfwSetWindowTitle(window, title);
-        if (currentTime - lastVisualUpdate >= 1.0 / VISUAL_FPS_CAP) {
-            renderFrame(window);
+        maintainJackAudio(glfwGetTime());
+        // Without a running JACK thread the UI consumes its own commands.
+        if (!audioThreadActive) {
+            applyPendingCommands(controlChannel, audioEngine);
+            audioEngine.sampleAdvance = 0.0;
+            publishPlayhead(controlChannel, audioEngine);
+        }
+        updatePlaylist();
+        followLiveEdge();
+        double frameTime;
+        if (scheduleFrame(frameScheduler, presentationClock(), frameTime)) {
+            PlayheadSnapshot playhead = controlChannel.playhead.load();
+            takePlayedRuns(controlChannel, playhead);
+            // Until the audio thread has taken a switch, its playhead still belongs to the old file.
+            if (playhead.mediaGeneration != mediaGeneration) {
+                playhead.position = 0.0;
+                playhead.sampleAdvance = 0.0;
+            }
+            playhead.position = presentedPosition(playhead, frameTime);
+            forgetStreamBytes();
+            // Every window is drawn in this pass, all from the same playhead.
+            beginTilePass(tileArrayRenderer);
+            beginRenderTiming(instrumentation);
+            renderFrame(window, playhead);
+            endRenderTiming(instrumentation);
+            updateInstrumentation(instrumentation, glfwGetTime(), frameScheduler.presented, frameScheduler.dropped,
+                currentMedia->ring.underruns.load(std::memory_order_relaxed));
+            if (instrumentation.overlayVisible)
+                renderInstrumentationOverlay(instrumentation);
+            renderViews(playhead);
+            endTilePass(tileArrayRenderer);
+            // Blocks on vsync; a target above the refresh rate is trimmed here.
             glfwSwapBuffers(window);
-            lastVisualUpdate = currentTime;
+            // Finished indexes are saved for the session to point to.
+            if (pollFrameAnalysis(frameAnalyzer, frameAnalysis) && useSessions)
+                saveAnalysisIndex(frameAnalysis, analysisIndexPath(currentMedia->path), fileData);
+            pollFrameDiff(frameDiffer, diffIndex);
+            bool searching = patternSearchRunning(patternSearch);
+            pollPatternSearch(patternSearch, searchMatches);
+            if (searching && patternSearchComplete(patternSearch) && useSessions)
+                saveSearchIndex(searchMatches, searchPatterns, searchIndexPath(currentMedia->path), fileData);
+            // Update title bar (a few times per second, and only when the text changes).
+            if (throttleReady(titleThrottle, glfwGetTime())) {
+                double fileSize = static_cast<double>(fileData.size());
+                double wrappedPos = wrapPosition(playhead.position, fileSize);
+                size_t currentFrame = static_cast<size_t>(wrappedPos / static_cast<double>(frameByteCount(frameGeometry)));
+                if (currentFrame >= totalFrames)
+                    currentFrame = totalFrames - 1;
+                char analysis[64] = "";
+                if (currentFrame < frameAnalysis.frames.size())
+                    std::snprintf(analysis, sizeof(analysis), " - Entropy: %.2f bits",
+                        frameEntropyBits(frameAnalysis.frames[currentFrame]));
+                else if (frameAnalysisRunning(frameAnalyzer) && frameAnalyzer.frameCount > 0)
+                    std::snprintf(analysis, sizeof(analysis), " - Analyzing %.0f%%",
+                        100.0 * frameAnalyzer.framesDone.load() / frameAnalyzer.frameCount);
+                char file[96] = "";
+                if (playlist.paths.size() > 1)
+                    std::snprintf(file, sizeof(file), " - File %zu/%zu: %s", playlist.current + 1, playlist.paths.size(),
+                        playlistEntryName(playlist, playlist.current).c_str());
+                char audio[64] = "";
+                if (!isByteLayout(playhead.layout))
+                    std::snprintf(audio, sizeof(audio), " - Audio: %s x%u @ %.0f Hz", sampleFormatName(playhead.layout.format),
+                        playhead.layout.channels, playhead.pcmRate);
+                char pixels[32] = "";
+                if (frameGeometry.pixelFormat != PIXEL_INDEXED8)
+                    std::snprintf(pixels, sizeof(pixels), " %s", pixelFormatName(frameGeometry.pixelFormat));
+                char diff[96] = "";
+                if (diffEnabled && currentFrame < diffIndex.changed.size())
+                    std::snprintf(diff, sizeof(diff), " - Diff: %s (%u bytes changed)", diffDisplayName(diffDisplay),
+                        diffIndex.changed[currentFrame]);
+                else if (diffEnabled && frameDiffRunning(frameDiffer) && frameDiffer.frameCount > 0)
+                    std::snprintf(diff, sizeof(diff), " - Diff: %s (indexing %.0f%%)", diffDisplayName(diffDisplay),
+                        100.0 * frameDiffer.framesDone.load() / frameDiffer.frameCount);
+                else if (diffEnabled)
+                    std::snprintf(diff, sizeof(diff), " - Diff: %s", diffDisplayName(diffDisplay));
+                char search[128] = "";
+                if (searchPromptActive)
+                    std::snprintf(search, sizeof(search), " - Search: %s_", searchPromptText.c_str());
+                else if (!searchPatterns.empty())
+                    std::snprintf(search, sizeof(search), " - Search: %zu matches%s", searchMatches.size(),
+                        patternSearchRunning(patternSearch) ? " (scanning)" : "");
+                char live[96] = "";
+                if (currentMedia->stream) {
+                    const StreamSource& stream = *currentMedia->stream;
+                    std::snprintf(live, sizeof(live), " - Stream: %.1f MB at %.0f KB/s%s%s",
+                        stream.received.load() / (1024.0 * 1024.0), streamFollower.rate / 1024.0,
+                        stream.ended.load() ? " (ended)" : "", followStream ? " [LIVE]" : "");
+                }
+                const char* renderer = (softwareRendering || !textureRenderer.ready) ? " - Renderer: CPU" : "";
+                char title[1024];
+                std::snprintf(title, sizeof(title),
+                    "Binary Waterfall Player%s - Frame: %zu/%zu - FPS: %.1f%s - Display: %.0f Hz (%llu dropped) - Geometry: %dx%d%s - Fixed Pixel Size: %d - Palette: %s - Resampler: %s (%.1f us)%s - Underruns: %llu%s%s%s%s%s",
+                    file, currentFrame + 1, totalFrames,
+                    BASE_FRAME_RATE * playhead.multiplier,
+                    (playhead.paused ? " [PAUSED]" : (waterfallMode ? " [WATERFALL]" : "")),
+                    frameScheduler.targetFps, frameScheduler.dropped,
+                    frameGeometry.width, frameGeometry.height, pixels, windowScale, paletteName(currentPalette),
+                    resampleModeName(playhead.resampleMode), playhead.blockMicros, audio,
+                    currentMedia->ring.underruns.load(std::memory_order_relaxed), renderer, live, diff, search, analysis);
+                if (lastTitle != title) {
+                    glfwSetWindowTitle(window, title);
+                    lastTitle = title;
+                }
+            }
+        }
+        // Sleep until the next frame is due or an event arrives.
+        glfwWaitEventsTimeout(secondsUntilNextFrame(frameScheduler, presentationClock()));
+        for (size_t i = 0; i < views.size();) {
+            if (!glfwWindowShouldClose(views[i]->window)) {
+                i++;
+                continue;
+            }
+            closeView(*views[i]);
+            views.erase(views.begin() + static_cast<long>(i));
         }
-        // Wait for events or timeout to avoid busy looping
-        glfwWaitEventsTimeout(1.0 / VISUAL_FPS_CAP);
-        // Additional short sleep to yield CPU time
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
     }
+    for (std::unique_ptr<PlayerView>& view : views)
+        closeView(*view);
+    views.clear();
+    saveCurrentSession();
     closeJackAudio();
+    stopSpectrogram(spectrogram);
+    stopOverviewBuild(overviewBuilder);
+    stopFrameAnalysis(frameAnalyzer);
+    stopFrameDiff(frameDiffer);
+    stopPatternSearch(patternSearch);
+    stopThumbnails(thumbnailBuilder);
+    stopMediaLoader(mediaLoader);
+    closeInstrumentationLog(instrumentation);
+    destroyGpuTimer(instrumentation.gpu);
+    destroyTileArrayRenderer(tileArrayRenderer);
+    destroyTextureRenderer(textureRenderer);
+    destroySoftwareRenderer(softwareRenderer);
+    destroyWaterfallRenderer(waterfallRenderer);
+    destroySpectrogramRenderer(spectrogramRenderer);
+    destroyThumbnailAtlas(thumbnailAtlas);
+    destroyScopeRenderer(scopeRenderer);
     glfwDestroyWindow(window);
     glfwTerminate();
+    fileData = ByteView();
+    if (retiringMedia)
+        closeMediaSource(*retiringMedia);
+    closeMediaSource(*currentMedia);
+    closeMappedFile(diffFile);
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,379 @@
+#pragma once
+// Whole-file overview index (a mip pyramid of block summaries).
+// Level 0 splits the file into power-of-two blocks (at least OVERVIEW_MIN_BLOCK bytes, and no more
+// than OVERVIEW_MAX_BLOCKS of them); each level above merges pairs of blocks, up to a single
+// block for the whole file. A block records min, max, mean, Shannon entropy and a 16-bin byte
+// histogram. Upper levels are merged from exact 256-bin counts during the build (one accumulator
+// per level), so their entropy is exact rather than averaged.
+//
+// The index is built once by a background pass over the mapping and saved next to the file as
+// <file>.bwfov; later opens load it after checking the file size and a content fingerprint. A
+// whole-file view reads a level with roughly one block per pixel column, i.e. a few KB.
+#include "MappedFile.h"
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+const size_t OVERVIEW_MIN_BLOCK = 4096;
+const size_t OVERVIEW_MAX_BLOCKS = 65536;   // level-0 blocks, bounds the index at ~2.5 MB
+const int OVERVIEW_HISTOGRAM_BINS = 16;      // 16 byte values per bin
+const char OVERVIEW_MAGIC[8] = { 'B', 'W', 'F', 'O', 'V', '0', '0', '1' };
+
+struct OverviewBlock {
+    unsigned char minimum;
+    unsigned char maximum;
+    unsigned char mean;
+    unsigned char entropy;                               // bits per byte, scaled 0..8 -> 0..255
+    unsigned char histogram[OVERVIEW_HISTOGRAM_BINS];    // share of each bin, scaled to 0..255
+};
+
+struct OverviewLevel {
+    size_t blockSize = 0;
+    std::vector<OverviewBlock> blocks;
+};
+
+struct OverviewIndex {
+    size_t fileSize = 0;
+    unsigned long long fingerprint = 0;
+    std::vector<OverviewLevel> levels;   // levels[0] is the finest
+
+    bool empty() const { return levels.empty(); }
+};
+
+static inline std::string overviewIndexPath(const std::string& filename) {
+    return filename + ".bwfov";
+}
+
+// Smallest power-of-two block size that keeps level 0 within OVERVIEW_MAX_BLOCKS blocks.
+static inline size_t chooseOverviewBlockSize(size_t fileSize) {
+    size_t blockSize = OVERVIEW_MIN_BLOCK;
+    while (fileSize / blockSize >= OVERVIEW_MAX_BLOCKS)
+        blockSize *= 2;
+    return blockSize;
+}
+
+// FNV-1a over the size and three 4 KB samples (start, middle, end). Cheap enough to run on every
+// open and catches a file replaced by one of the same size in all but contrived cases.
+static inline unsigned long long overviewFingerprint(const ByteView& view) {
+    unsigned long long hash = 1469598103934665603ULL;
+    unsigned long long size = view.size();
+    for (int i = 0; i < 8; i++) {
+        hash ^= (size >> (i * 8)) & 0xFF;
+        hash *= 1099511628211ULL;
+    }
+    const size_t sample = 4096;
+    size_t offsets[3] = { 0, view.size() / 2, view.size() > sample ? view.size() - sample : 0 };
+    for (int s = 0; s < 3; s++) {
+        size_t end = offsets[s] + sample < view.size() ? offsets[s] + sample : view.size();
+        for (size_t i = offsets[s]; i < end; i++) {
+            hash ^= view[i];
+            hash *= 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+// --- Build ---
+// Exact byte counts of a block that is still being merged.
+struct OverviewAccumulator {
+    unsigned long long counts[256];
+    int children;
+};
+
+static inline void clearOverviewAccumulator(OverviewAccumulator& accumulator) {
+    std::memset(accumulator.counts, 0, sizeof(accumulator.counts));
+    accumulator.children = 0;
+}
+
+static inline OverviewBlock summarizeCounts(const unsigned long long* counts) {
+    OverviewBlock block;
+    unsigned long long total = 0;
+    double sum = 0.0;
+    int minimum = -1, maximum = 0;
+    for (int v = 0; v < 256; v++) {
+        if (counts[v] == 0)
+            continue;
+        if (minimum < 0)
+            minimum = v;
+        maximum = v;
+        total += counts[v];
+        sum += static_cast<double>(v) * static_cast<double>(counts[v]);
+    }
+    double entropy = 0.0;
+    for (int v = 0; v < 256; v++) {
+        if (counts[v] == 0)
+            continue;
+        double p = static_cast<double>(counts[v]) / static_cast<double>(total);
+        entropy -= p * std::log2(p);
+    }
+    block.minimum = static_cast<unsigned char>(minimum < 0 ? 0 : minimum);
+    block.maximum = static_cast<unsigned char>(maximum);
+    block.mean = static_cast<unsigned char>(total ? std::lround(sum / static_cast<double>(total)) : 0);
+    block.entropy = static_cast<unsigned char>(std::lround(entropy * 255.0 / 8.0));
+    for (int bin = 0; bin < OVERVIEW_HISTOGRAM_BINS; bin++) {
+        unsigned long long binCount = 0;
+        for (int v = bin * 16; v < bin * 16 + 16; v++)
+            binCount += counts[v];
+        block.histogram[bin] = static_cast<unsigned char>(total ? (binCount * 255 + total / 2) / total : 0);
+    }
+    return block;
+}
+
+// Emit a finished block at `level` and fold it into its parent; a parent with both children
+// is finished in turn.
+static inline void pushOverviewBlock(OverviewIndex& index, std::vector<OverviewAccumulator>& pending,
+    size_t level, const unsigned long long* counts) {
+    index.levels[level].blocks.push_back(summarizeCounts(counts));
+    size_t parent = level + 1;
+    if (parent >= pending.size()) {
+        pending.resize(parent + 1);
+        clearOverviewAccumulator(pending[parent]);
+    }
+    if (parent >= index.levels.size()) {
+        index.levels.resize(parent + 1);
+        index.levels[parent].blockSize = index.levels[level].blockSize * 2;
+    }
+    OverviewAccumulator& accumulator = pending[parent];
+    for (int v = 0; v < 256; v++)
+        accumulator.counts[v] += counts[v];
+    if (++accumulator.children == 2) {
+        pushOverviewBlock(index, pending, parent, accumulator.counts);
+        clearOverviewAccumulator(pending[parent]);
+    }
+}
+
+// Returns false if cancelled. `progress` (optional) receives the bytes scanned so far.
+static inline bool buildOverviewIndex(const ByteView& view, OverviewIndex& index,
+    const std::atomic<bool>* cancel = nullptr, std::atomic<size_t>* progress = nullptr) {
+    index = OverviewIndex();
+    index.fileSize = view.size();
+    index.fingerprint = overviewFingerprint(view);
+    if (view.empty())
+        return true;
+    index.levels.resize(1);
+    index.levels[0].blockSize = chooseOverviewBlockSize(view.size());
+    const size_t blockSize = index.levels[0].blockSize;
+    std::vector<OverviewAccumulator> pending(1);
+    unsigned long long counts[256];
+    for (size_t offset = 0; offset < view.size(); offset += blockSize) {
+        if (cancel && cancel->load(std::memory_order_relaxed))
+            return false;
+        size_t end = (offset + blockSize < view.size()) ? offset + blockSize : view.size();
+        std::memset(counts, 0, sizeof(counts));
+        const unsigned char* bytes = view.data();
+        for (size_t i = offset; i < end; i++)
+            counts[bytes[i]]++;
+        pushOverviewBlock(index, pending, 0, counts);
+        if (progress)
+            progress->store(end, std::memory_order_relaxed);
+    }
+    // Flush the partial blocks at the ragged right edge of each level, bottom up, until a level
+    // holds a single block. Anything merged above that level is dropped.
+    for (size_t level = 0; level < index.levels.size(); level++) {
+        if (index.levels[level].blocks.size() <= 1) {
+            index.levels.resize(level + 1);
+            break;
+        }
+        size_t parent = level + 1;
+        if (parent < pending.size() && pending[parent].children > 0) {
+            OverviewAccumulator partial = pending[parent];
+            clearOverviewAccumulator(pending[parent]);
+            pushOverviewBlock(index, pending, parent, partial.counts);
+        }
+    }
+    return true;
+}
+
+// --- Persistence ---
+struct OverviewFileHeader {
+    char magic[8];
+    uint64_t fileSize;
+    uint64_t fingerprint;
+    uint64_t baseBlockSize;
+    uint32_t levelCount;
+    uint32_t blockBytes;   // sizeof(OverviewBlock), guards against layout changes
+};
+
+// Written to a temporary name and renamed, so an interrupted save never leaves a torn index.
+static inline bool saveOverviewIndex(const OverviewIndex& index, const std::string& path) {
+    if (index.empty())
+        return false;
+    std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "Warning: Could not write overview index: " << path << std::endl;
+            return false;
+        }
+        OverviewFileHeader header;
+        std::memcpy(header.magic, OVERVIEW_MAGIC, sizeof(header.magic));
+        header.fileSize = index.fileSize;
+        header.fingerprint = index.fingerprint;
+        header.baseBlockSize = index.levels[0].blockSize;
+        header.levelCount = static_cast<uint32_t>(index.levels.size());
+        header.blockBytes = static_cast<uint32_t>(sizeof(OverviewBlock));
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (size_t level = 0; level < index.levels.size(); level++) {
+            uint64_t count = index.levels[level].blocks.size();
+            out.write(reinterpret_cast<const char*>(&count), sizeof(count));
+        }
+        for (size_t level = 0; level < index.levels.size(); level++) {
+            const std::vector<OverviewBlock>& blocks = index.levels[level].blocks;
+            out.write(reinterpret_cast<const char*>(blocks.data()), blocks.size() * sizeof(OverviewBlock));
+        }
+        if (!out) {
+            std::cerr << "Warning: Could not write overview index: " << path << std::endl;
+            out.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    std::remove(path.c_str());
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Loads only an index that was built from this exact file (size and fingerprint match).
+static inline bool loadOverviewIndex(OverviewIndex& index, const std::string& path, const ByteView& view) {
+    std::ifstream in(path.c_str(), std::ios::binary);
+    if (!in)
+        return false;
+    OverviewFileHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) ||
+        std::memcmp(header.magic, OVERVIEW_MAGIC, sizeof(header.magic)) != 0 ||
+        header.blockBytes != sizeof(OverviewBlock) || header.fileSize != view.size() ||
+        header.baseBlockSize != chooseOverviewBlockSize(view.size()) || header.levelCount == 0 ||
+        header.levelCount > 64 || header.fingerprint != overviewFingerprint(view))
+        return false;
+    OverviewIndex loaded;
+    loaded.fileSize = static_cast<size_t>(header.fileSize);
+    loaded.fingerprint = header.fingerprint;
+    loaded.levels.resize(header.levelCount);
+    size_t blockSize = static_cast<size_t>(header.baseBlockSize);
+    for (size_t level = 0; level < loaded.levels.size(); level++) {
+        uint64_t count = 0;
+        if (!in.read(reinterpret_cast<char*>(&count), sizeof(count)) ||
+            count != (view.size() + blockSize - 1) / blockSize)
+            return false;
+        loaded.levels[level].blockSize = blockSize;
+        loaded.levels[level].blocks.resize(static_cast<size_t>(count));
+        blockSize *= 2;
+    }
+    for (size_t level = 0; level < loaded.levels.size(); level++) {
+        std::vector<OverviewBlock>& blocks = loaded.levels[level].blocks;
+        if (!in.read(reinterpret_cast<char*>(blocks.data()), blocks.size() * sizeof(OverviewBlock)))
+            return false;
+    }
+    index = loaded;
+    return true;
+}
+
+// --- Queries ---
+// Coarsest level that still has at least `columns` blocks (level 0 if none does).
+static inline const OverviewLevel* overviewLevelFor(const OverviewIndex& index, size_t columns) {
+    if (index.empty())
+        return nullptr;
+    size_t chosen = 0;
+    for (size_t level = 0; level < index.levels.size(); level++) {
+        if (index.levels[level].blocks.size() >= columns)
+            chosen = level;
+    }
+    return &index.levels[chosen];
+}
+
+// One summary per column for the whole file. Columns covering several blocks take the min/max
+// over them and average the rest; columns narrower than a block repeat it.
+static inline void summarizeOverviewColumns(const OverviewIndex& index, size_t columns,
+    std::vector<OverviewBlock>& out) {
+    out.clear();
+    const OverviewLevel* level = overviewLevelFor(index, columns);
+    if (!level || columns == 0)
+        return;
+    const std::vector<OverviewBlock>& blocks = level->blocks;
+    out.resize(columns);
+    for (size_t c = 0; c < columns; c++) {
+        size_t first = c * blocks.size() / columns;
+        size_t last = (c + 1) * blocks.size() / columns;
+        if (last <= first)
+            last = first + 1;
+        OverviewBlock merged = blocks[first];
+        if (last - first > 1) {
+            unsigned sumMean = 0, sumEntropy = 0;
+            unsigned sumBins[OVERVIEW_HISTOGRAM_BINS] = { 0 };
+            for (size_t b = first; b < last; b++) {
+                const OverviewBlock& block = blocks[b];
+                if (block.minimum < merged.minimum) merged.minimum = block.minimum;
+                if (block.maximum > merged.maximum) merged.maximum = block.maximum;
+                sumMean += block.mean;
+                sumEntropy += block.entropy;
+                for (int bin = 0; bin < OVERVIEW_HISTOGRAM_BINS; bin++)
+                    sumBins[bin] += block.histogram[bin];
+            }
+            unsigned count = static_cast<unsigned>(last - first);
+            merged.mean = static_cast<unsigned char>((sumMean + count / 2) / count);
+            merged.entropy = static_cast<unsigned char>((sumEntropy + count / 2) / count);
+            for (int bin = 0; bin < OVERVIEW_HISTOGRAM_BINS; bin++)
+                merged.histogram[bin] = static_cast<unsigned char>((sumBins[bin] + count / 2) / count);
+        }
+        out[c] = merged;
+    }
+}
+
+// --- Background builder ---
+// Scans the mapping on its own thread and saves the result; the UI polls for completion.
+struct OverviewBuilder {
+    std::thread worker;
+    std::atomic<bool> cancel{ false };
+    std::atomic<bool> finished{ false };
+    std::atomic<size_t> progress{ 0 };
+    size_t total = 0;
+    OverviewIndex result;
+};
+
+static inline void startOverviewBuild(OverviewBuilder& builder, const ByteView& view, const std::string& path) {
+    builder.cancel = false;
+    builder.finished = false;
+    builder.progress = 0;
+    builder.total = view.size();
+    builder.worker = std::thread([&builder, view, path]() {
+        if (buildOverviewIndex(view, builder.result, &builder.cancel, &builder.progress)) {
+            if (saveOverviewIndex(builder.result, path))
+                std::cout << "Saved overview index: " << path << std::endl;
+        }
+        else {
+            builder.result = OverviewIndex();
+        }
+        builder.finished.store(true, std::memory_order_release);
+    });
+}
+
+// True once the build is done; the result is moved into `index` on that call.
+static inline bool pollOverviewBuild(OverviewBuilder& builder, OverviewIndex& index) {
+    if (!builder.worker.joinable() || !builder.finished.load(std::memory_order_acquire))
+        return false;
+    builder.worker.join();
+    index = std::move(builder.result);
+    builder.result = OverviewIndex();
+    return !index.empty();
+}
+
+static inline bool overviewBuildRunning(const OverviewBuilder& builder) {
+    return builder.worker.joinable();
+}
+
+static inline void stopOverviewBuild(OverviewBuilder& builder) {
+    if (builder.worker.joinable()) {
+        builder.cancel = true;
+        builder.worker.join();
+    }
+    builder.result = OverviewIndex();
+}
@@ -0,0 +1,143 @@
+#pragma once
+// Byte-to-color lookup tables shared by every renderer.
+// Each color map is expanded once into a 256-entry RGBA8 table, so colorizing a pixel is a single
+// index: the CPU paths read the table directly and the GPU paths upload it as a 1D texture.
+#include <cmath>
+
+enum PaletteId {
+    PALETTE_RAINBOW = 0,   // 18 hues x 14 intensity levels (the original player palette)
+    PALETTE_HEATMAP,       // black -> red -> yellow -> white (burn/binaryWaterfall.cpp)
+    PALETTE_GRAYSCALE,     // linear ramp
+    PALETTE_BYTECLASS,     // zero / control / printable ASCII / high / 0xFF classes
+    PALETTE_COUNT
+};
+
+struct PaletteLUT {
+    unsigned char rgba[256][4];
+};
+
+static inline const char* paletteName(PaletteId id) {
+    switch (id) {
+    case PALETTE_RAINBOW: return "Rainbow";
+    case PALETTE_HEATMAP: return "Heatmap";
+    case PALETTE_GRAYSCALE: return "Grayscale";
+    case PALETTE_BYTECLASS: return "Byte Class";
+    default: return "Unknown";
+    }
+}
+
+static inline unsigned char paletteChannel(float value) {
+    if (value <= 0.0f) return 0;
+    if (value >= 1.0f) return 255;
+    return static_cast<unsigned char>(std::lround(value * 255.0f));
+}
+
+static inline void setPaletteEntry(PaletteLUT& lut, int value, float r, float g, float b) {
+    lut.rgba[value][0] = paletteChannel(r);
+    lut.rgba[value][1] = paletteChannel(g);
+    lut.rgba[value][2] = paletteChannel(b);
+    lut.rgba[value][3] = 255;
+}
+
+// --- Color map definitions (evaluated once per entry when the tables are built) ---
+static inline void buildRainbowPalette(PaletteLUT& lut) {
+    // 18-color rainbow palette.
+    static const float rainbow[18][3] = {
+        {1.0f, 0.0f, 0.0f},     // Red
+        {0.0f, 1.0f, 0.0f},     // Lime
+        {0.0f, 0.0f, 1.0f},     // Blue
+        {1.0f, 0.0f, 1.0f},     // Magenta
+        {0.0f, 1.0f, 1.0f},     // Cyan
+        {1.0f, 1.0f, 0.0f},     // Yellow
+        {1.0f, 0.75f, 0.8f},    // Pink
+        {0.5f, 1.0f, 0.0f},     // Chartreuse
+        {0.0f, 0.75f, 1.0f},    // Cerulean
+        {0.76f, 0.7f, 0.0f},    // Mustard
+        {0.9f, 0.3f, 0.0f},     // Infrared (approximation)
+        {0.58f, 0.0f, 0.83f},   // Violet
+        {0.29f, 0.0f, 0.51f},   // Indigo
+        {0.0f, 0.42f, 0.5f},    // Thalo
+        {0.0f, 1.0f, 0.5f},     // Mint
+        {0.42f, 0.56f, 0.14f},  // Camo
+        {1.0f, 0.65f, 0.0f},    // Orange
+        {0.4f, 0.0f, 1.0f}      // Ultraviolet (approximation)
+    };
+    // Split the 256 possible values into 18 colors x 14 intensities
+    // (18*14=252, so the last 4 values wrap).
+    for (int value = 0; value < 256; value++) {
+        int colorIndex = (value / 14) % 18;
+        float intensity = (value % 14 + 1) / 14.0f;
+        setPaletteEntry(lut, value, rainbow[colorIndex][0] * intensity,
+            rainbow[colorIndex][1] * intensity, rainbow[colorIndex][2] * intensity);
+    }
+}
+
+static inline void buildHeatmapPalette(PaletteLUT& lut) {
+    for (int value = 0; value < 256; value++) {
+        float r = 0.0f, g = 0.0f, b = 0.0f;
+        if (value < 64) {
+            // Black to Red (0-63)
+            r = value / 63.0f;
+        }
+        else if (value < 128) {
+            // Red to Yellow (64-127)
+            r = 1.0f;
+            g = (value - 64) / 63.0f;
+        }
+        else if (value < 192) {
+            // Yellow to White (128-191)
+            r = 1.0f;
+            g = 1.0f;
+            b = (value - 128) / 63.0f;
+        }
+        else {
+            // Full white (192-255)
+            r = g = b = 1.0f;
+        }
+        setPaletteEntry(lut, value, r, g, b);
+    }
+}
+
+static inline void buildGrayscalePalette(PaletteLUT& lut) {
+    for (int value = 0; value < 256; value++) {
+        float v = value / 255.0f;
+        setPaletteEntry(lut, value, v, v, v);
+    }
+}
+
+static inline void buildByteClassPalette(PaletteLUT& lut) {
+    for (int value = 0; value < 256; value++) {
+        if (value == 0x00)
+            setPaletteEntry(lut, value, 0.0f, 0.0f, 0.0f);                     // Zero padding
+        else if (value == 0xFF)
+            setPaletteEntry(lut, value, 1.0f, 1.0f, 1.0f);                     // Erased flash
+        else if (value < 0x20 || value == 0x7F)
+            setPaletteEntry(lut, value, 0.0f, 0.35f + value / 64.0f, 0.0f);    // Control
+        else if (value < 0x7F)
+            setPaletteEntry(lut, value, 0.2f, 0.4f, 0.5f + value / 254.0f);    // Printable ASCII
+        else
+            setPaletteEntry(lut, value, 0.4f + (value - 0x80) / 212.0f, 0.1f, 0.1f); // High bytes
+    }
+}
+
+// --- Table access ---
+// All tables are built on first use (thread-safe static initialization) and never change.
+static inline const PaletteLUT& getPalette(PaletteId id) {
+    struct PaletteTables {
+        PaletteLUT luts[PALETTE_COUNT];
+        PaletteTables() {
+            buildRainbowPalette(luts[PALETTE_RAINBOW]);
+            buildHeatmapPalette(luts[PALETTE_HEATMAP]);
+            buildGrayscalePalette(luts[PALETTE_GRAYSCALE]);
+            buildByteClassPalette(luts[PALETTE_BYTECLASS]);
+        }
+    };
+    static const PaletteTables tables;
+    if (id < 0 || id >= PALETTE_COUNT)
+        id = PALETTE_RAINBOW;
+    return tables.luts[id];
+}
+
+static inline PaletteId nextPalette(PaletteId id) {
+    return static_cast<PaletteId>((id + 1) % PALETTE_COUNT);
+}
@@ -0,0 +1,280 @@
+#pragma once
+// Signature search over the mapped file: magic numbers, strings, opcode sequences.
+// The file is cut into chunks that are scanned in parallel on a work-stealing ThreadPool; each
+// chunk also reads the few bytes after it, so matches across chunk boundaries are found exactly
+// once (by the chunk they start in). Matches reach the UI chunk by chunk while the scan runs.
+// With a few patterns each is found with memchr on its least common byte and verified with
+// memcmp; memchr is the C library's vectorized byte filter, so this runs at memory bandwidth on
+// typical data. Larger sets go through a 64 Kbit table of the pattern's first two bytes and are
+// verified per first byte.
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+const size_t SEARCH_CHUNK_BYTES = 4 << 20;         // work per pool task
+const size_t SEARCH_MAX_MATCHES = 1 << 22;         // the scan stops collecting past this
+const size_t SEARCH_MAX_PATTERN_BYTES = 256;
+const size_t SEARCH_MEMCHR_PATTERNS = 4;           // more patterns use the pair table
+
+struct SearchMatch {
+    uint64_t position;
+    uint32_t pattern;
+};
+
+struct PatternSet {
+    std::vector<std::vector<unsigned char>> patterns;
+    std::vector<std::string> names;                // as given, for the title bar
+    std::vector<size_t> anchors;                   // per pattern: the byte memchr looks for
+    size_t maxLength = 0;
+    std::vector<uint64_t> pairBits;                // bit (b0 | b1 << 8): some pattern starts b0 b1
+    std::vector<std::vector<uint32_t>> byFirstByte;
+
+    bool empty() const { return patterns.empty(); }
+};
+
+// "hex:7F454C46" or "0x7f 45 4c 46" (spaces allowed) for bytes, anything else for its text.
+static inline bool parseSearchPattern(const std::string& text, std::vector<unsigned char>& bytes) {
+    bytes.clear();
+    size_t start = 0;
+    if (text.compare(0, 4, "hex:") == 0)
+        start = 4;
+    else if (text.compare(0, 2, "0x") == 0 || text.compare(0, 2, "0X") == 0)
+        start = 2;
+    if (start == 0) {
+        bytes.assign(text.begin(), text.end());
+        return !bytes.empty() && bytes.size() <= SEARCH_MAX_PATTERN_BYTES;
+    }
+    int high = -1;
+    for (size_t i = start; i < text.size(); i++) {
+        char c = text[i];
+        if (c == ' ')
+            continue;
+        int digit = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+            : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+        if (digit < 0)
+            return false;
+        if (high < 0) {
+            high = digit;
+            continue;
+        }
+        bytes.push_back(static_cast<unsigned char>(high << 4 | digit));
+        high = -1;
+    }
+    return high < 0 && !bytes.empty() && bytes.size() <= SEARCH_MAX_PATTERN_BYTES;
+}
+
+// Rough rarity of a byte value in binaries: zero and 0xFF fill padding, text is common, the
+// high half least so. The anchor with the highest rank gives memchr the fewest false hits.
+static inline int byteRarity(unsigned char value) {
+    if (value == 0x00)
+        return 0;
+    if (value == 0xFF)
+        return 1;
+    if ((value >= 'a' && value <= 'z') || value == ' ')
+        return 2;
+    if (value < 0x80)
+        return 3;
+    return 4;
+}
+
+static inline bool addSearchPattern(PatternSet& set, const std::string& text) {
+    std::vector<unsigned char> bytes;
+    if (!parseSearchPattern(text, bytes))
+        return false;
+    size_t anchor = 0;
+    for (size_t i = 1; i < bytes.size(); i++) {
+        if (byteRarity(bytes[i]) > byteRarity(bytes[anchor]))
+            anchor = i;
+    }
+    set.patterns.push_back(bytes);
+    set.names.push_back(text);
+    set.anchors.push_back(anchor);
+    set.maxLength = std::max(set.maxLength, bytes.size());
+    set.pairBits.assign(65536 / 64, 0);
+    set.byFirstByte.assign(256, std::vector<uint32_t>());
+    for (uint32_t p = 0; p < set.patterns.size(); p++) {
+        const std::vector<unsigned char>& pattern = set.patterns[p];
+        set.byFirstByte[pattern[0]].push_back(p);
+        for (unsigned second = 0; second < 256; second++) {
+            if (pattern.size() > 1 && second != pattern[1])
+                continue;
+            unsigned pair = pattern[0] | (second << 8);
+            set.pairBits[pair / 64] |= 1ULL << (pair % 64);
+        }
+    }
+    return true;
+}
+
+// Append the matches that start in [begin, end) to `out`, in position order.
+static inline void scanSearchChunk(const PatternSet& set, const ByteView& view, size_t begin, size_t end,
+    std::vector<SearchMatch>& out) {
+    const unsigned char* data = view.data();
+    const size_t total = view.size();
+    size_t first = out.size();
+    if (set.patterns.size() <= SEARCH_MEMCHR_PATTERNS) {
+        for (uint32_t p = 0; p < set.patterns.size(); p++) {
+            const std::vector<unsigned char>& pattern = set.patterns[p];
+            const size_t length = pattern.size(), anchor = set.anchors[p];
+            if (length > total)
+                continue;
+            size_t lastStart = std::min(end, total - length + 1);
+            if (begin >= lastStart)
+                continue;
+            const unsigned char* hit = data + begin + anchor;
+            const unsigned char* stop = data + lastStart + anchor;
+            while (hit < stop) {
+                hit = static_cast<const unsigned char*>(std::memchr(hit, pattern[anchor], static_cast<size_t>(stop - hit)));
+                if (!hit)
+                    break;
+                const unsigned char* start = hit - anchor;
+                if (std::memcmp(start, pattern.data(), length) == 0) {
+                    SearchMatch match = { static_cast<uint64_t>(start - data), p };
+                    out.push_back(match);
+                }
+                hit++;
+            }
+        }
+        std::sort(out.begin() + static_cast<long>(first), out.end(), [](const SearchMatch& a, const SearchMatch& b) {
+            return a.position < b.position || (a.position == b.position && a.pattern < b.pattern);
+        });
+        return;
+    }
+    end = std::min(end, total);
+    for (size_t i = begin; i < end; i++) {
+        unsigned pair = data[i] | ((i + 1 < total ? data[i + 1] : 0) << 8);
+        if (i + 1 < total && !(set.pairBits[pair / 64] & (1ULL << (pair % 64))))
+            continue;
+        for (uint32_t p : set.byFirstByte[data[i]]) {
+            const std::vector<unsigned char>& pattern = set.patterns[p];
+            if (pattern.size() <= total - i && std::memcmp(data + i, pattern.data(), pattern.size()) == 0) {
+                SearchMatch match = { static_cast<uint64_t>(i), p };
+                out.push_back(match);
+            }
+        }
+    }
+}
+
+// --- Background search ---
+// Finished chunks queue their matches in `pending`; the UI merges them in with pollPatternSearch.
+// The view must stay mapped until the search is stopped or has finished.
+struct PatternSearch {
+    std::thread worker;
+    std::atomic<bool> cancel{ false };
+    std::atomic<bool> finished{ false };
+    std::atomic<size_t> bytesDone{ 0 };
+    std::atomic<size_t> found{ 0 };
+    size_t totalBytes = 0;
+    std::mutex mutex;
+    std::vector<SearchMatch> pending;              // guarded by mutex
+};
+
+static inline void stopPatternSearch(PatternSearch& search) {
+    if (search.worker.joinable()) {
+        search.cancel = true;
+        search.worker.join();
+    }
+    std::lock_guard<std::mutex> lock(search.mutex);
+    search.pending.clear();
+}
+
+static inline void startPatternSearch(PatternSearch& search, const ByteView& view, const PatternSet& set) {
+    stopPatternSearch(search);
+    search.cancel = false;
+    search.finished = false;
+    search.bytesDone = 0;
+    search.found = 0;
+    search.totalBytes = view.size();
+    if (set.empty()) {
+        search.finished = true;
+        return;
+    }
+    search.worker = std::thread([&search, view, set]() {
+        ThreadPool pool(ThreadPool::defaultThreadCount());
+        size_t chunks = (view.size() + SEARCH_CHUNK_BYTES - 1) / SEARCH_CHUNK_BYTES;
+        pool.parallelFor(chunks, 1, [&](size_t begin, size_t end) {
+            std::vector<SearchMatch> matches;
+            for (size_t chunk = begin; chunk < end; chunk++) {
+                if (search.cancel.load(std::memory_order_relaxed) ||
+                    search.found.load(std::memory_order_relaxed) >= SEARCH_MAX_MATCHES)
+                    return;
+                size_t from = chunk * SEARCH_CHUNK_BYTES;
+                size_t to = std::min(from + SEARCH_CHUNK_BYTES, view.size());
+                matches.clear();
+                scanSearchChunk(set, view, from, to, matches);
+                search.found.fetch_add(matches.size(), std::memory_order_relaxed);
+                search.bytesDone.fetch_add(to - from, std::memory_order_relaxed);
+                std::lock_guard<std::mutex> lock(search.mutex);
+                search.pending.insert(search.pending.end(), matches.begin(), matches.end());
+            }
+        });
+        search.finished.store(true, std::memory_order_release);
+    });
+}
+
+// Merge matches found since the last call into `matches` (kept in position order). Returns true
+// if any were added.
+static inline bool pollPatternSearch(PatternSearch& search, std::vector<SearchMatch>& matches) {
+    if (search.worker.joinable() && search.finished.load(std::memory_order_acquire))
+        search.worker.join();
+    std::vector<SearchMatch> batch;
+    {
+        std::lock_guard<std::mutex> lock(search.mutex);
+        batch.swap(search.pending);
+    }
+    if (batch.empty())
+        return false;
+    size_t middle = matches.size();
+    matches.insert(matches.end(), batch.begin(), batch.end());
+    std::sort(matches.begin() + static_cast<long>(middle), matches.end(), [](const SearchMatch& a, const SearchMatch& b) {
+        return a.position < b.position || (a.position == b.position && a.pattern < b.pattern);
+    });
+    std::inplace_merge(matches.begin(), matches.begin() + static_cast<long>(middle), matches.end(),
+        [](const SearchMatch& a, const SearchMatch& b) {
+            return a.position < b.position || (a.position == b.position && a.pattern < b.pattern);
+        });
+    return true;
+}
+
+static inline bool patternSearchRunning(const PatternSearch& search) {
+    return search.worker.joinable();
+}
+
+// True once a search has covered the whole file without being stopped or hitting the match cap
+// (and pollPatternSearch has merged everything it found).
+static inline bool patternSearchComplete(const PatternSearch& search) {
+    return !search.worker.joinable() && search.finished.load(std::memory_order_acquire) &&
+        search.bytesDone.load() == search.totalBytes && search.found.load() < SEARCH_MAX_MATCHES;
+}
+
+// --- Navigation ---
+// First match at or after `position`, as an index into `matches` (matches.size() if none).
+static inline size_t firstMatchFrom(const std::vector<SearchMatch>& matches, uint64_t position) {
+    return static_cast<size_t>(std::lower_bound(matches.begin(), matches.end(), position,
+        [](const SearchMatch& match, uint64_t value) { return match.position < value; }) - matches.begin());
+}
+
+// Frame of the next (direction > 0) or previous match outside frame `from`. Wraps around; -1 if
+// there are no matches.
+static inline long long findMatchFrame(const std::vector<SearchMatch>& matches, size_t frameBytes, size_t from,
+    int direction) {
+    if (matches.empty() || frameBytes == 0)
+        return -1;
+    size_t index;
+    if (direction > 0) {
+        index = firstMatchFrom(matches, static_cast<uint64_t>(from + 1) * frameBytes);
+        if (index == matches.size())
+            index = 0;
+    }
+    else {
+        index = firstMatchFrom(matches, static_cast<uint64_t>(from) * frameBytes);
+        index = (index == 0) ? matches.size() - 1 : index - 1;
+    }
+    return static_cast<long long>(matches[index].position / frameBytes);
+}
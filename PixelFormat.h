@@ -0,0 +1,184 @@
+#pragma once
+// How the bytes of a frame become pixels.
+// Indexed8 is the original one byte per pixel through the palette. The other formats show the
+// bytes as the packed image they may really be: RGB24, BGRA32, RGB565 (little-endian), 4bpp
+// (packed nibbles through the palette, high nibble first), 1bpp (MSB first) and planar YUV420
+// (I420: the Y plane, then the quarter-size U and V planes, BT.601). The frame byte count follows
+// the format. The GPU renderers upload the raw bytes unchanged, frameWidth bytes per texture row,
+// and unpack them in the fragment shader (BWF_PIXEL_UNPACK_GLSL); unpackPixel is the same
+// mapping for the CPU paths.
+#include "Palette.h"
+#include <cstddef>
+
+enum PixelFormat {
+    PIXEL_INDEXED8 = 0,
+    PIXEL_RGB24,
+    PIXEL_BGRA32,
+    PIXEL_RGB565,
+    PIXEL_INDEXED4,
+    PIXEL_MONO1,
+    PIXEL_YUV420,
+    PIXEL_FORMAT_COUNT
+};
+
+static inline const char* pixelFormatName(PixelFormat format) {
+    switch (format) {
+    case PIXEL_INDEXED8: return "Indexed8";
+    case PIXEL_RGB24: return "RGB24";
+    case PIXEL_BGRA32: return "BGRA32";
+    case PIXEL_RGB565: return "RGB565";
+    case PIXEL_INDEXED4: return "4bpp";
+    case PIXEL_MONO1: return "1bpp";
+    case PIXEL_YUV420: return "YUV420";
+    default: return "Unknown";
+    }
+}
+
+static inline int pixelFormatBits(PixelFormat format) {
+    switch (format) {
+    case PIXEL_RGB24: return 24;
+    case PIXEL_BGRA32: return 32;
+    case PIXEL_RGB565: return 16;
+    case PIXEL_INDEXED4: return 4;
+    case PIXEL_MONO1: return 1;
+    case PIXEL_YUV420: return 12;
+    default: return 8;
+    }
+}
+
+// Frames are uploaded as frameWidth-byte rows, so the byte count must be a whole number of rows
+// (height * bits divisible by 8); YUV420 also needs even dimensions for its chroma planes.
+static inline bool pixelFormatFits(PixelFormat format, int width, int height) {
+    if (width <= 0 || height <= 0 || (static_cast<long long>(height) * pixelFormatBits(format)) % 8 != 0)
+        return false;
+    return format != PIXEL_YUV420 || (width % 2 == 0 && height % 2 == 0);
+}
+
+static inline size_t pixelFrameBytes(PixelFormat format, int width, int height) {
+    return static_cast<size_t>(width) * static_cast<size_t>(height) * pixelFormatBits(format) / 8;
+}
+
+// Texture rows of frameWidth bytes that hold one frame.
+static inline int pixelStorageRows(PixelFormat format, int height) {
+    return static_cast<int>(static_cast<long long>(height) * pixelFormatBits(format) / 8);
+}
+
+static inline PixelFormat nextPixelFormat(PixelFormat format, int step) {
+    int next = (static_cast<int>(format) + step) % PIXEL_FORMAT_COUNT;
+    return static_cast<PixelFormat>(next < 0 ? next + PIXEL_FORMAT_COUNT : next);
+}
+
+// Pixel of a frame that shows byte `offset` of it (YUV420 chroma bytes map to the top-left pixel
+// of the 2x2 block they color).
+static inline void pixelOfByte(PixelFormat format, int width, int height, size_t offset, int& x, int& y) {
+    size_t pixel = offset * 8 / pixelFormatBits(format);
+    if (format == PIXEL_YUV420) {
+        const size_t area = static_cast<size_t>(width) * height;
+        if (offset < area) {
+            pixel = offset;
+        }
+        else {
+            size_t chroma = (offset - area) % (area / 4);
+            x = static_cast<int>(chroma % (width / 2)) * 2;
+            y = static_cast<int>(chroma / (width / 2)) * 2;
+            return;
+        }
+    }
+    x = static_cast<int>(pixel % width);
+    y = static_cast<int>(pixel / width);
+}
+
+// --- GPU unpacking ---
+// Spliced into a fragment shader after `uniform sampler1D uPalette` and a definition of
+// `int fetchByte(int index)` (byte `index` of the current frame). uPixelFormat is a PixelFormat.
+#define BWF_PIXEL_UNPACK_GLSL \
+    "uniform int uPixelFormat;\n" \
+    "vec4 unpackPixel(ivec2 texel, ivec2 size) {\n" \
+    "    int i = texel.y * size.x + texel.x;\n" \
+    "    if (uPixelFormat == 1)\n" \
+    "        return vec4(fetchByte(i * 3), fetchByte(i * 3 + 1), fetchByte(i * 3 + 2), 255) / 255.0;\n" \
+    "    if (uPixelFormat == 2)\n" \
+    "        return vec4(fetchByte(i * 4 + 2), fetchByte(i * 4 + 1), fetchByte(i * 4), 255) / 255.0;\n" \
+    "    if (uPixelFormat == 3) {\n" \
+    "        int v = fetchByte(i * 2) | (fetchByte(i * 2 + 1) << 8);\n" \
+    "        return vec4(float(v >> 11) / 31.0, float((v >> 5) & 63) / 63.0, float(v & 31) / 31.0, 1.0);\n" \
+    "    }\n" \
+    "    if (uPixelFormat == 4) {\n" \
+    "        int b = fetchByte(i / 2);\n" \
+    "        return texelFetch(uPalette, ((i & 1) == 0 ? (b >> 4) : (b & 15)) * 17, 0);\n" \
+    "    }\n" \
+    "    if (uPixelFormat == 5)\n" \
+    "        return vec4(vec3(float((fetchByte(i / 8) >> (7 - (i & 7))) & 1)), 1.0);\n" \
+    "    if (uPixelFormat == 6) {\n" \
+    "        int area = size.x * size.y;\n" \
+    "        int c = (texel.y / 2) * (size.x / 2) + texel.x / 2;\n" \
+    "        float y = 1.164 * (float(fetchByte(i)) - 16.0);\n" \
+    "        float u = float(fetchByte(area + c)) - 128.0;\n" \
+    "        float v = float(fetchByte(area + area / 4 + c)) - 128.0;\n" \
+    "        vec3 rgb = vec3(y + 1.596 * v, y - 0.392 * u - 0.813 * v, y + 2.017 * u) / 255.0;\n" \
+    "        return vec4(clamp(rgb, 0.0, 1.0), 1.0);\n" \
+    "    }\n" \
+    "    return texelFetch(uPalette, fetchByte(i), 0);\n" \
+    "}\n"
+
+// --- CPU unpacking ---
+static inline unsigned char clampColor(float value) {
+    return static_cast<unsigned char>(value <= 0.0f ? 0.0f : (value >= 255.0f ? 255.0f : value + 0.5f));
+}
+
+// RGBA of pixel (x, y) of a frame in `format`; `frame` points at the frame's first byte.
+static inline void unpackPixel(PixelFormat format, const unsigned char* frame, int width, int height, int x, int y,
+    const PaletteLUT& palette, unsigned char rgba[4]) {
+    const size_t i = static_cast<size_t>(y) * width + x;
+    rgba[3] = 255;
+    switch (format) {
+    case PIXEL_RGB24:
+        rgba[0] = frame[i * 3];
+        rgba[1] = frame[i * 3 + 1];
+        rgba[2] = frame[i * 3 + 2];
+        return;
+    case PIXEL_BGRA32:
+        rgba[0] = frame[i * 4 + 2];
+        rgba[1] = frame[i * 4 + 1];
+        rgba[2] = frame[i * 4];
+        return;
+    case PIXEL_RGB565: {
+        unsigned v = frame[i * 2] | (frame[i * 2 + 1] << 8);
+        rgba[0] = static_cast<unsigned char>(((v >> 11) * 255 + 15) / 31);
+        rgba[1] = static_cast<unsigned char>((((v >> 5) & 63) * 255 + 31) / 63);
+        rgba[2] = static_cast<unsigned char>(((v & 31) * 255 + 15) / 31);
+        return;
+    }
+    case PIXEL_INDEXED4: {
+        unsigned char b = frame[i / 2];
+        const unsigned char* color = palette.rgba[((i & 1) == 0 ? (b >> 4) : (b & 15)) * 17];
+        rgba[0] = color[0];
+        rgba[1] = color[1];
+        rgba[2] = color[2];
+        return;
+    }
+    case PIXEL_MONO1: {
+        unsigned char level = ((frame[i / 8] >> (7 - (i & 7))) & 1) ? 255 : 0;
+        rgba[0] = rgba[1] = rgba[2] = level;
+        return;
+    }
+    case PIXEL_YUV420: {
+        const size_t area = static_cast<size_t>(width) * height;
+        const size_t c = static_cast<size_t>(y / 2) * (width / 2) + x / 2;
+        float luma = 1.164f * (frame[i] - 16.0f);
+        float u = frame[area + c] - 128.0f;
+        float v = frame[area + area / 4 + c] - 128.0f;
+        rgba[0] = clampColor(luma + 1.596f * v);
+        rgba[1] = clampColor(luma - 0.392f * u - 0.813f * v);
+        rgba[2] = clampColor(luma + 2.017f * u);
+        return;
+    }
+    default: {
+        const unsigned char* color = palette.rgba[frame[i]];
+        rgba[0] = color[0];
+        rgba[1] = color[1];
+        rgba[2] = color[2];
+        return;
+    }
+    }
+}
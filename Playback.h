@@ -0,0 +1,665 @@
+#pragma once
+// Playhead, loop/boomerang handling and block audio generation.
+// Positions are measured in bytes (the offset into the file); the playhead advances by
+// baseAdvance * multiplier bytes per audio sample.
+#include "MappedFile.h"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+struct PlaybackState {
+    // position is measured in bytes (the offset into the file data)
+    double position = 0.0;
+    // multiplier scales the baseline frame rate (1.0 = BASE_FRAME_RATE frames per second)
+    double multiplier = 1.0;
+    // Looping/boomerang (loopStart/loopEnd in bytes)
+    bool loopEnabled = true;
+    bool boomerangMode = false;
+    double loopStart = 0.0;
+    double loopEnd = 0.0;
+};
+
+// --- Utility: Wrap a position into [0, fileSize) ---
+static inline double wrapPosition(double pos, double fileSize) {
+    if (pos < 0.0) {
+        pos = std::fmod(pos, fileSize);
+        if (pos < 0.0) pos += fileSize;
+    }
+    else if (pos >= fileSize) {
+        pos = std::fmod(pos, fileSize);
+    }
+    return pos;
+}
+
+// --- Loop handling ---
+// Applied after the playhead has moved by `advance`. Boomerang reflections flip the multiplier.
+static inline void handleLoop(PlaybackState& state, double fileSize, double advance) {
+    if (!state.loopEnabled) {
+        state.position = wrapPosition(state.position, fileSize);
+        return;
+    }
+    bool forward = (advance > 0.0);
+    if (state.loopStart == state.loopEnd) {
+        state.position = state.loopStart;
+        return;
+    }
+    if (state.loopStart < state.loopEnd) {
+        if (forward && state.position > state.loopEnd) {
+            if (state.boomerangMode) {
+                double overshoot = state.position - state.loopEnd;
+                state.position = state.loopEnd - overshoot;
+                state.multiplier = -state.multiplier;
+            }
+            else {
+                state.position = state.loopStart;
+            }
+        }
+        else if (!forward && state.position < state.loopStart) {
+            if (state.boomerangMode) {
+                double overshoot = state.loopStart - state.position;
+                state.position = state.loopStart + overshoot;
+                state.multiplier = -state.multiplier;
+            }
+            else {
+                state.position = state.loopEnd;
+            }
+        }
+    }
+    else {
+        // Wrapped region: [loopStart, fileSize) U [0, loopEnd]
+        state.position = wrapPosition(state.position, fileSize);
+        if (forward && state.position > state.loopEnd && state.position < state.loopStart) {
+            if (state.boomerangMode) {
+                double overshoot = state.position - state.loopEnd;
+                state.position = state.loopEnd - overshoot;
+                state.multiplier = -state.multiplier;
+            }
+            else {
+                state.position = state.loopStart;
+            }
+        }
+        else if (!forward && (state.position < state.loopEnd || state.position > state.loopStart)) {
+            if (state.boomerangMode) {
+                double overshoot = (state.position < state.loopEnd) ? (state.loopEnd - state.position) : (state.position - state.loopStart);
+                state.position = (state.position < state.loopEnd) ? (state.loopEnd + overshoot) : (state.loopStart - overshoot);
+                state.multiplier = -state.multiplier;
+            }
+            else {
+                state.position = state.loopEnd;
+            }
+        }
+    }
+}
+
+// --- Steady interval ---
+// Finds the closed range [lo, hi] around `pos` in which handleLoop is a no-op and every position
+// indexes a valid byte. Returns false when `pos` itself needs boundary handling.
+static inline bool steadyInterval(const PlaybackState& state, double fileSize, bool forward,
+    double pos, double& lo, double& hi) {
+    const double lastValid = std::nextafter(fileSize, 0.0);
+    lo = 0.0;
+    hi = lastValid;
+    if (state.loopEnabled) {
+        if (state.loopStart < state.loopEnd) {
+            if (forward)
+                hi = std::fmin(state.loopEnd, lastValid);
+            else
+                lo = std::fmax(state.loopStart, 0.0);
+        }
+        else if (forward) {
+            if (pos <= state.loopEnd)
+                hi = std::fmin(state.loopEnd, lastValid);
+            else
+                lo = state.loopStart;
+        }
+        else {
+            lo = std::fmax(state.loopEnd, 0.0);
+            hi = std::fmin(state.loopStart, lastValid);
+        }
+    }
+    return pos >= lo && pos <= hi;
+}
+
+// Number of samples (at most `limit`) that can be generated from `pos` before the next loop,
+// boomerang or wrap boundary. Zero means the next sample must go through handleLoop.
+static inline size_t samplesUntilBoundary(const PlaybackState& state, double fileSize,
+    double advance, size_t limit) {
+    double lo, hi;
+    const double pos = state.position;
+    if (!steadyInterval(state, fileSize, advance > 0.0, pos + advance, lo, hi))
+        return 0;
+    if (advance == 0.0)
+        return limit;
+    double bound = (advance > 0.0) ? (hi - pos) / advance : (lo - pos) / advance;
+    size_t count = (bound >= static_cast<double>(limit)) ? limit : static_cast<size_t>(bound);
+    // Guard against rounding in the division: the last position must still be in range.
+    while (count > 0) {
+        double last = pos + static_cast<double>(count) * advance;
+        if (last >= lo && last <= hi)
+            break;
+        count--;
+    }
+    return count;
+}
+
+// Byte index for a position that may sit outside [0, fileSize) at a boundary sample.
+static inline size_t boundaryIndex(double pos, double fileSize, size_t size) {
+    if (pos < 0.0 || pos >= fileSize)
+        pos = wrapPosition(pos, fileSize);
+    size_t index = static_cast<size_t>(pos);
+    return (index >= size) ? size - 1 : index;
+}
+
+// --- Resampling ---
+// How a fractional playhead position becomes a sample. Every mode has its own run kernel, chosen
+// once per run rather than per sample; the kernels use only clamped (min/max) neighbor indices,
+// so their loops stay branch-free.
+enum ResampleMode {
+    RESAMPLE_NEAREST = 0,  // the byte under the playhead (original behaviour)
+    RESAMPLE_LINEAR,       // 2-point linear interpolation
+    RESAMPLE_CUBIC,        // 4-point Catmull-Rom interpolation
+    RESAMPLE_DECIMATE,     // box filter over every byte skipped since the previous sample
+    RESAMPLE_COUNT
+};
+
+static inline const char* resampleModeName(ResampleMode mode) {
+    switch (mode) {
+    case RESAMPLE_NEAREST: return "Nearest";
+    case RESAMPLE_LINEAR: return "Linear";
+    case RESAMPLE_CUBIC: return "Cubic";
+    case RESAMPLE_DECIMATE: return "Decimate";
+    default: return "Unknown";
+    }
+}
+
+static inline ResampleMode nextResampleMode(ResampleMode mode) {
+    return static_cast<ResampleMode>((mode + 1) % RESAMPLE_COUNT);
+}
+
+// Run kernels: dst[j] is the sample at start + (first + j + 1) * advance, which the caller
+// guarantees to be inside [base, base + size). bytes[i] holds file byte base + i. Positions stay in
+// file coordinates relative to the run's start, so a run split across windows of the file computes
+// exactly the samples the unsplit run would.
+static inline void resampleRunNearest(const unsigned char* bytes, size_t base, size_t size, double start,
+    double advance, size_t first, float scale, float* dst, size_t run) {
+    (void)size;
+    for (size_t j = 0; j < run; j++) {
+        size_t index = static_cast<size_t>(start + static_cast<double>(first + j + 1) * advance);
+        dst[j] = (static_cast<int>(bytes[index - base]) - 128) * scale;
+    }
+}
+
+static inline void resampleRunLinear(const unsigned char* bytes, size_t base, size_t size, double start,
+    double advance, size_t first, float scale, float* dst, size_t run) {
+    const size_t last = base + size - 1;
+    for (size_t j = 0; j < run; j++) {
+        double pos = start + static_cast<double>(first + j + 1) * advance;
+        size_t index = static_cast<size_t>(pos);
+        size_t next = (index + 1 < last) ? index + 1 : last;
+        float frac = static_cast<float>(pos - static_cast<double>(index));
+        float a = bytes[index - base];
+        float b = bytes[next - base];
+        dst[j] = (a + (b - a) * frac - 128.0f) * scale;
+    }
+}
+
+static inline void resampleRunCubic(const unsigned char* bytes, size_t base, size_t size, double start,
+    double advance, size_t first, float scale, float* dst, size_t run) {
+    const size_t last = base + size - 1;
+    for (size_t j = 0; j < run; j++) {
+        double pos = start + static_cast<double>(first + j + 1) * advance;
+        size_t index = static_cast<size_t>(pos);
+        size_t prev = (index > base) ? index - 1 : base;
+        size_t next = (index + 1 < last) ? index + 1 : last;
+        size_t next2 = (index + 2 < last) ? index + 2 : last;
+        float f = static_cast<float>(pos - static_cast<double>(index));
+        float ym1 = bytes[prev - base], y0 = bytes[index - base], y1 = bytes[next - base], y2 = bytes[next2 - base];
+        float value = y0 + 0.5f * f * (y1 - ym1 + f * (2.0f * ym1 - 5.0f * y0 + 4.0f * y1 - y2 +
+            f * (3.0f * (y0 - y1) + y2 - ym1)));
+        dst[j] = (value - 128.0f) * scale;
+    }
+}
+
+// Averages the bytes crossed between consecutive sample positions, so large speedups (e.g. the
+// ~583 bytes per sample of a 14 kHz playback frequency) low-pass the skipped data instead of
+// point-sampling it. At |advance| <= 1 each span holds at most one byte and this reduces to
+// nearest. The per-span sum is a plain byte reduction that compilers vectorize. A span reaching
+// back past the start of the window is cut at the window edge.
+static inline void resampleRunDecimate(const unsigned char* bytes, size_t base, size_t size, double start,
+    double advance, size_t first, float scale, float* dst, size_t run) {
+    const long long first0 = static_cast<long long>(base);
+    const long long last = first0 + static_cast<long long>(size) - 1;
+    long long prev = (first == 0) ? static_cast<long long>(std::floor(start))
+        : static_cast<long long>(start + static_cast<double>(first) * advance);
+    if (prev < first0 - 1) prev = first0 - 1;
+    if (prev > last + 1) prev = last + 1;
+    for (size_t j = 0; j < run; j++) {
+        long long index = static_cast<long long>(start + static_cast<double>(first + j + 1) * advance);
+        // Forward spans cover (prev, index], backward spans [index, prev).
+        long long spanFirst = (index >= prev) ? prev + 1 : index;
+        long long end = (index >= prev) ? index + 1 : prev;
+        if (spanFirst > index) spanFirst = index;
+        if (end > last + 1) end = last + 1;
+        const unsigned char* span = bytes + (spanFirst - first0);
+        const size_t count = static_cast<size_t>(end - spanFirst);
+        unsigned sum = 0;
+        for (size_t k = 0; k < count; k++)
+            sum += span[k];
+        float mean = (count > 0) ? static_cast<float>(sum) / static_cast<float>(count) : bytes[index - first0];
+        dst[j] = (mean - 128.0f) * scale;
+        prev = index;
+    }
+}
+
+// --- Sample formats ---
+// How the bytes under the playhead become PCM. The default (u8 mono) is the byte waterfall itself
+// and keeps the resampler kernels above; every other layout decodes whole frames of `channels`
+// interleaved samples through a kernel specialized for the format, chosen once per run, so the
+// sample loop never branches on the format. Frames are aligned to the start of the file.
+enum SampleFormat {
+    SAMPLE_U8 = 0,
+    SAMPLE_S8,
+    SAMPLE_S16LE,
+    SAMPLE_S16BE,
+    SAMPLE_S24LE,
+    SAMPLE_S32LE,
+    SAMPLE_F32LE,
+    SAMPLE_FORMAT_COUNT
+};
+
+const unsigned MAX_AUDIO_CHANNELS = 8;   // widest frame: 8 x 4 bytes
+
+struct AudioLayout {
+    SampleFormat format = SAMPLE_U8;
+    unsigned channels = 1;
+};
+
+static inline const char* sampleFormatName(SampleFormat format) {
+    switch (format) {
+    case SAMPLE_U8: return "u8";
+    case SAMPLE_S8: return "s8";
+    case SAMPLE_S16LE: return "s16le";
+    case SAMPLE_S16BE: return "s16be";
+    case SAMPLE_S24LE: return "s24le";
+    case SAMPLE_S32LE: return "s32le";
+    case SAMPLE_F32LE: return "f32le";
+    default: return "unknown";
+    }
+}
+
+static inline size_t sampleFormatBytes(SampleFormat format) {
+    switch (format) {
+    case SAMPLE_S16LE: case SAMPLE_S16BE: return 2;
+    case SAMPLE_S24LE: return 3;
+    case SAMPLE_S32LE: case SAMPLE_F32LE: return 4;
+    default: return 1;
+    }
+}
+
+static inline SampleFormat nextSampleFormat(SampleFormat format) {
+    return static_cast<SampleFormat>((format + 1) % SAMPLE_FORMAT_COUNT);
+}
+
+static inline size_t audioFrameBytes(const AudioLayout& layout) {
+    return sampleFormatBytes(layout.format) * layout.channels;
+}
+
+// The original interpretation: one unsigned byte per mono sample.
+static inline bool isByteLayout(const AudioLayout& layout) {
+    return layout.format == SAMPLE_U8 && layout.channels == 1;
+}
+
+// One sample in [-1, 1]. Raw bytes read as float can be anything, so NaN becomes 0 and the rest
+// is clamped.
+template <SampleFormat Format>
+static inline float decodeSample(const unsigned char* p) {
+    if (Format == SAMPLE_U8)
+        return (static_cast<int>(p[0]) - 128) * (1.0f / 128.0f);
+    if (Format == SAMPLE_S8)
+        return static_cast<signed char>(p[0]) * (1.0f / 128.0f);
+    if (Format == SAMPLE_S16LE)
+        return static_cast<int16_t>(static_cast<uint16_t>(p[0] | (p[1] << 8))) * (1.0f / 32768.0f);
+    if (Format == SAMPLE_S16BE)
+        return static_cast<int16_t>(static_cast<uint16_t>((p[0] << 8) | p[1])) * (1.0f / 32768.0f);
+    if (Format == SAMPLE_S24LE) {
+        uint32_t bits = (static_cast<uint32_t>(p[0]) << 8) | (static_cast<uint32_t>(p[1]) << 16) |
+            (static_cast<uint32_t>(p[2]) << 24);
+        return static_cast<float>(static_cast<int32_t>(bits) >> 8) * (1.0f / 8388608.0f);
+    }
+    uint32_t bits = static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+        (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    if (Format == SAMPLE_S32LE)
+        return static_cast<float>(static_cast<int32_t>(bits)) * (1.0f / 2147483648.0f);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    value = (value == value) ? value : 0.0f;
+    return std::fmin(std::fmax(value, -1.0f), 1.0f);
+}
+
+// Frame run kernel: outs[c][offset + j] is channel c of the frame under
+// start + (first + j + 1) * advance, or (Interpolate) the blend of that frame and the next by the
+// position's fraction of a frame. Frame indices are clamped to whole frames inside the window,
+// which the guard bytes of the sources make a no-op away from the file ends. At 1x native rate
+// (one frame per sample, aligned start) the run is a straight deinterleave of contiguous frames.
+template <SampleFormat Format, bool Interpolate>
+static inline void decodeFrameRun(const unsigned char* bytes, size_t base, size_t size, double start,
+    double advance, size_t first, unsigned channels, float volume, float* const* outs, size_t offset, size_t run) {
+    const size_t width = sampleFormatBytes(Format);
+    const size_t frameBytes = width * channels;
+    const size_t firstFrame = (base + frameBytes - 1) / frameBytes;
+    if ((base + size) / frameBytes <= firstFrame) {
+        // Not one whole frame in the window (a file shorter than a frame).
+        for (unsigned c = 0; c < channels; c++)
+            std::memset(outs[c] + offset, 0, run * sizeof(float));
+        return;
+    }
+    const double frameSize = static_cast<double>(frameBytes);
+    const size_t lastFrame = (base + size) / frameBytes - 1;
+    const double startFrame = (start + static_cast<double>(first + 1) * advance) / frameSize;
+    if (advance == frameSize && startFrame == std::floor(startFrame) && startFrame >= static_cast<double>(firstFrame) &&
+        startFrame + static_cast<double>(run - 1) <= static_cast<double>(lastFrame)) {
+        const unsigned char* src = bytes + (static_cast<size_t>(startFrame) * frameBytes - base);
+        for (unsigned c = 0; c < channels; c++) {
+            const unsigned char* in = src + c * width;
+            float* dst = outs[c] + offset;
+            for (size_t j = 0; j < run; j++)
+                dst[j] = decodeSample<Format>(in + j * frameBytes) * volume;
+        }
+        return;
+    }
+    for (unsigned c = 0; c < channels; c++) {
+        const unsigned char* in = bytes + c * width;
+        float* dst = outs[c] + offset;
+        for (size_t j = 0; j < run; j++) {
+            double frame = (start + static_cast<double>(first + j + 1) * advance) / frameSize;
+            size_t index = static_cast<size_t>(frame);
+            index = (index < firstFrame) ? firstFrame : (index > lastFrame ? lastFrame : index);
+            float value = decodeSample<Format>(in + (index * frameBytes - base));
+            if (Interpolate) {
+                size_t next = (index + 1 > lastFrame) ? lastFrame : index + 1;
+                float frac = static_cast<float>(frame - static_cast<double>(index));
+                frac = std::fmin(std::fmax(frac, 0.0f), 1.0f);
+                value += (decodeSample<Format>(in + (next * frameBytes - base)) - value) * frac;
+            }
+            dst[j] = value * volume;
+        }
+    }
+}
+
+template <bool Interpolate>
+static inline void decodeFrameRunAs(SampleFormat format, const unsigned char* bytes, size_t base, size_t size,
+    double start, double advance, size_t first, unsigned channels, float volume, float* const* outs, size_t offset,
+    size_t run) {
+    switch (format) {
+    case SAMPLE_S8:
+        decodeFrameRun<SAMPLE_S8, Interpolate>(bytes, base, size, start, advance, first, channels, volume, outs, offset, run);
+        break;
+    case SAMPLE_S16LE:
+        decodeFrameRun<SAMPLE_S16LE, Interpolate>(bytes, base, size, start, advance, first, channels, volume, outs, offset, run);
+        break;
+    case SAMPLE_S16BE:
+        decodeFrameRun<SAMPLE_S16BE, Interpolate>(bytes, base, size, start, advance, first, channels, volume, outs, offset, run);
+        break;
+    case SAMPLE_S24LE:
+        decodeFrameRun<SAMPLE_S24LE, Interpolate>(bytes, base, size, start, advance, first, channels, volume, outs, offset, run);
+        break;
+    case SAMPLE_S32LE:
+        decodeFrameRun<SAMPLE_S32LE, Interpolate>(bytes, base, size, start, advance, first, channels, volume, outs, offset, run);
+        break;
+    case SAMPLE_F32LE:
+        decodeFrameRun<SAMPLE_F32LE, Interpolate>(bytes, base, size, start, advance, first, channels, volume, outs, offset, run);
+        break;
+    default:
+        decodeFrameRun<SAMPLE_U8, Interpolate>(bytes, base, size, start, advance, first, channels, volume, outs, offset, run);
+        break;
+    }
+}
+
+// --- Sample sources ---
+// renderPlaybackBlock reads through a source that hands out resident windows of the file. A
+// window maps bytes[i] to file byte base + i; sample positions inside [coreFirst, coreLast] may be
+// generated from it, and the kernels' neighbor reads (a few bytes either side) stay inside it.
+// acquire() may fail (the bytes are not resident yet); the block then plays silence for that run
+// instead of waiting, and counts a miss.
+struct SampleWindow {
+    const unsigned char* bytes = nullptr;
+    size_t base = 0;
+    size_t length = 0;
+    double coreFirst = 0.0;
+    double coreLast = 0.0;
+    int slot = -1;               // source-specific handle for release()
+};
+
+// The whole file is resident (memory, or a mapping the caller accepts faults on).
+struct ByteViewSource {
+    ByteView data;
+    bool acquire(size_t index, SampleWindow& window) {
+        (void)index;
+        window.bytes = data.data();
+        window.base = 0;
+        window.length = data.size();
+        window.coreFirst = 0.0;
+        window.coreLast = std::nextafter(static_cast<double>(data.size()), 0.0);
+        return true;
+    }
+    void release(SampleWindow& window) { (void)window; }
+};
+
+// How many of samples first+1 .. first+limit of a run from `start` stay inside the window's core.
+// The caller acquired the window for sample first+1, so the result is at least 1.
+static inline size_t samplesInWindow(const SampleWindow& window, double start, double advance,
+    size_t first, size_t limit) {
+    if (advance == 0.0)
+        return limit;
+    double bound = ((advance > 0.0) ? (window.coreLast - start) / advance : (window.coreFirst - start) / advance)
+        - static_cast<double>(first);
+    size_t count = (bound >= static_cast<double>(limit)) ? limit : (bound > 0.0 ? static_cast<size_t>(bound) : 0);
+    while (count > 1) {
+        double last = start + static_cast<double>(first + count) * advance;
+        if (last >= window.coreFirst && last <= window.coreLast)
+            break;
+        count--;
+    }
+    return (count > 0) ? count : 1;
+}
+
+// One byte through the source; false (and a silent sample) if it is not resident.
+template <typename Source>
+static inline bool sourceSample(Source& source, size_t index, float scale, float& sample) {
+    SampleWindow window;
+    if (!source.acquire(index, window)) {
+        sample = 0.0f;
+        return false;
+    }
+    sample = (static_cast<int>(window.bytes[index - window.base]) - 128) * scale;
+    source.release(window);
+    return true;
+}
+
+// One frame through the source (channel c into outs[c][offset]); false and silence if not resident.
+template <typename Source>
+static inline bool sourceFrame(Source& source, size_t index, const AudioLayout& layout, float volume,
+    float* const* outs, size_t offset) {
+    SampleWindow window;
+    if (!source.acquire(index, window)) {
+        for (unsigned c = 0; c < layout.channels; c++)
+            outs[c][offset] = 0.0f;
+        return false;
+    }
+    const double frameSize = static_cast<double>(audioFrameBytes(layout));
+    double start = static_cast<double>(index) - frameSize;   // the kernel samples start + frameSize
+    decodeFrameRunAs<false>(layout.format, window.bytes, window.base, window.length, start, frameSize, 0,
+        layout.channels, volume, outs, offset, 1);
+    source.release(window);
+    return true;
+}
+
+// --- Played runs ---
+// The stretches of the file a block sampled, in playing order, for displays of what was just heard:
+// a run goes from the position of its first sample to that of its last (from > to when playing
+// backwards). Loop, boomerang and wrap jumps, seeks and reversals start a new run; only the last
+// PLAYED_RUN_COUNT are kept, so a loop shorter than the period keeps its most recent passes.
+const unsigned PLAYED_RUN_COUNT = 2;
+
+struct PlayedRuns {
+    unsigned count = 0;
+    double from[PLAYED_RUN_COUNT] = {};
+    double to[PLAYED_RUN_COUNT] = {};
+};
+
+static inline void beginPlayedRun(PlayedRuns& runs, double position) {
+    if (runs.count == PLAYED_RUN_COUNT) {
+        for (unsigned r = 1; r < PLAYED_RUN_COUNT; r++) {
+            runs.from[r - 1] = runs.from[r];
+            runs.to[r - 1] = runs.to[r];
+        }
+        runs.count--;
+    }
+    runs.from[runs.count] = position;
+    runs.to[runs.count] = position;
+    runs.count++;
+}
+
+// Continue the last run from `position` in the direction of `advance`, or start a new one when
+// the playhead has moved since (a seek) or turned around.
+static inline void resumePlayedRun(PlayedRuns& runs, double position, double advance) {
+    if (runs.count > 0) {
+        const double from = runs.from[runs.count - 1], to = runs.to[runs.count - 1];
+        if (to == position && (to == from || (to > from) == (advance > 0.0)))
+            return;
+    }
+    beginPlayedRun(runs, position);
+}
+
+// --- Block audio generation ---
+// Fills `out` with `nframes` mono samples, advancing the playhead exactly like calling
+// handleLoop after every sample. Runs between boundaries are filled by the resampler's run
+// kernel (position = start + i * advance), and handleLoop only runs at the split points, where
+// the sample is taken nearest-neighbor. A boomerang reflection takes effect on the very next sample.
+// Runs are further split where they leave the source's window (without changing the sample
+// positions). Returns the number of runs that hit non-resident data, which are played as silence
+// while the playhead keeps moving.
+// With a layout other than u8 mono, `outs` holds one buffer per channel and runs go through the
+// frame kernels; Nearest takes the frame under the playhead and every other mode interpolates
+// linearly between frames. With `played`, the positions sampled are added to its runs.
+template <typename Source>
+static inline unsigned renderPlaybackFramesFrom(PlaybackState& state, Source& source, size_t size,
+    const AudioLayout& layout, double baseAdvance, float volume, float* const* outs, size_t nframes,
+    ResampleMode mode = RESAMPLE_NEAREST, PlayedRuns* played = nullptr) {
+    const double fileSize = static_cast<double>(size);
+    const float scale = volume / 128.0f;
+    const bool bytes = isByteLayout(layout);
+    float* const out = outs[0];
+    unsigned misses = 0;
+    if (state.loopEnabled && state.loopStart == state.loopEnd) {
+        // Degenerate loop: the playhead is pinned to loopStart.
+        state.position = state.loopStart;
+        if (played)
+            resumePlayedRun(*played, state.position, 0.0);
+        size_t index = boundaryIndex(state.position, fileSize, size);
+        bool resident = bytes ? sourceSample(source, index, scale, out[0])
+            : sourceFrame(source, index, layout, volume, outs, 0);
+        if (!resident)
+            misses++;
+        for (unsigned c = 0; c < layout.channels; c++)
+            for (size_t i = 1; i < nframes; i++)
+                outs[c][i] = outs[c][0];
+        return misses;
+    }
+    if (played)
+        resumePlayedRun(*played, state.position, baseAdvance * state.multiplier);
+    size_t i = 0;
+    while (i < nframes) {
+        const double advance = baseAdvance * state.multiplier;
+        size_t run = samplesUntilBoundary(state, fileSize, advance, nframes - i);
+        if (run > 0) {
+            const double start = state.position;
+            size_t done = 0;
+            while (done < run) {
+                SampleWindow window;
+                size_t index = static_cast<size_t>(start + static_cast<double>(done + 1) * advance);
+                if (!source.acquire(index, window)) {
+                    // Not resident: play silence up to the boundary rather than stall.
+                    for (unsigned c = 0; c < layout.channels; c++)
+                        std::memset(outs[c] + i + done, 0, (run - done) * sizeof(float));
+                    misses++;
+                    break;
+                }
+                size_t count = samplesInWindow(window, start, advance, done, run - done);
+                float* dst = out + i + done;
+                if (!bytes) {
+                    if (mode == RESAMPLE_NEAREST)
+                        decodeFrameRunAs<false>(layout.format, window.bytes, window.base, window.length, start, advance,
+                            done, layout.channels, volume, outs, i + done, count);
+                    else
+                        decodeFrameRunAs<true>(layout.format, window.bytes, window.base, window.length, start, advance,
+                            done, layout.channels, volume, outs, i + done, count);
+                }
+                else {
+                    switch (mode) {
+                    case RESAMPLE_LINEAR:
+                        resampleRunLinear(window.bytes, window.base, window.length, start, advance, done, scale, dst, count);
+                        break;
+                    case RESAMPLE_CUBIC:
+                        resampleRunCubic(window.bytes, window.base, window.length, start, advance, done, scale, dst, count);
+                        break;
+                    case RESAMPLE_DECIMATE:
+                        resampleRunDecimate(window.bytes, window.base, window.length, start, advance, done, scale, dst, count);
+                        break;
+                    default:
+                        resampleRunNearest(window.bytes, window.base, window.length, start, advance, done, scale, dst, count);
+                        break;
+                    }
+                }
+                source.release(window);
+                done += count;
+            }
+            state.position = start + static_cast<double>(run) * advance;
+            if (played)
+                played->to[played->count - 1] = state.position;
+            i += run;
+        }
+        else {
+            // Boundary sample: full loop handling.
+            state.position += advance;
+            const double unhandled = state.position;
+            handleLoop(state, fileSize, advance);
+            if (played) {
+                if (state.position == unhandled)
+                    played->to[played->count - 1] = state.position;
+                else
+                    beginPlayedRun(*played, state.position);
+            }
+            size_t index = boundaryIndex(state.position, fileSize, size);
+            bool resident = bytes ? sourceSample(source, index, scale, out[i])
+                : sourceFrame(source, index, layout, volume, outs, i);
+            if (!resident)
+                misses++;
+            i++;
+        }
+    }
+    return misses;
+}
+
+// The byte waterfall: u8 mono into a single buffer.
+template <typename Source>
+static inline unsigned renderPlaybackBlockFrom(PlaybackState& state, Source& source, size_t size, double baseAdvance,
+    float volume, float* out, size_t nframes, ResampleMode mode = RESAMPLE_NEAREST) {
+    float* outs[1] = { out };
+    return renderPlaybackFramesFrom(state, source, size, AudioLayout(), baseAdvance, volume, outs, nframes, mode);
+}
+
+static inline void renderPlaybackBlock(PlaybackState& state, const ByteView& data, double baseAdvance,
+    float volume, float* out, size_t nframes, ResampleMode mode = RESAMPLE_NEAREST) {
+    ByteViewSource source;
+    source.data = data;
+    renderPlaybackBlockFrom(state, source, data.size(), baseAdvance, volume, out, nframes, mode);
+}
+
+static inline void renderPlaybackFrames(PlaybackState& state, const ByteView& data, const AudioLayout& layout,
+    double baseAdvance, float volume, float* const* outs, size_t nframes, ResampleMode mode = RESAMPLE_NEAREST,
+    PlayedRuns* played = nullptr) {
+    ByteViewSource source;
+    source.data = data;
+    renderPlaybackFramesFrom(state, source, data.size(), layout, baseAdvance, volume, outs, nframes, mode, played);
+}
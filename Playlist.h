@@ -0,0 +1,280 @@
+#pragma once
+// Playlist of input files with background preloading and a pointer handoff to the audio thread.
+// Entries come from the command line, from directories (their regular files, sorted by name) and
+// from files dropped on the window. A MediaSource bundles everything that belongs to one open
+// file: the mapping, its prefetch ring, its saved session and the indexes it points to. The entry after the current
+// one is opened on a loader thread while the current one plays, so a switch only swaps pointers;
+// the JACK thread picks the new source up through CMD_SWAP_MEDIA at the start of a period. The
+// old source is retired once the playhead snapshot shows the audio thread has moved on, and torn
+// down on the loader thread, so neither the callback nor the render loop waits for joins or munmap.
+// A live stream (StreamSource.h) is a MediaSource too: its view is the stream's history buffer.
+#include "ControlChannel.h"
+#include "MappedFile.h"
+#include "OverviewIndex.h"
+#include "PrefetchRing.h"
+#include "Session.h"
+#include "StreamSource.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const size_t MEDIA_WARM_BYTES = 4 << 20;   // leading bytes faulted in by the loader
+static const int MEDIA_FIRST_CHUNK_WAIT_MS = 100;
+
+struct MediaSource {
+    std::string path;
+    MappedFile file;
+    PrefetchRing ring;         // running only while JACK is (started by the loader or initJackAudio)
+    OverviewIndex overview;    // from <file>.bwfov when a valid one exists
+    bool overviewLoaded = false;
+    SessionState session;      // from <file>.bwfsession when it was saved from this file
+    bool sessionLoaded = false;
+    FrameAnalysis analysis;    // saved analysis at the session's geometry
+    bool analysisLoaded = false;
+    std::vector<SearchMatch> searchMatches;    // saved search for the session's patterns
+    bool searchLoaded = false;
+    std::unique_ptr<StreamSource> stream;  // set for a live stream; file.view then points at its history
+};
+
+// Map the file, load its session and indexes and warm the first pages the renderers will touch.
+// The prefetch ring is started too when a sample rate is given (0: no audio running), with its
+// buffers locked in memory if `lockMemory` is set.
+static inline bool openMediaSource(MediaSource& source, const std::string& path, unsigned sampleRate,
+    bool lockMemory = false) {
+    if (!openMappedFile(source.file, path))
+        return false;
+    source.path = path;
+    source.sessionLoaded = loadSession(source.session, path, source.file.view);
+    if (source.sessionLoaded) {
+        loadSessionIndexes(source.session, path, source.file.view, source.analysis, source.analysisLoaded,
+            source.searchMatches, source.searchLoaded);
+    }
+    source.overviewLoaded = loadOverviewIndex(source.overview,
+        sessionIndexPath(path, source.session.overviewIndex, overviewIndexPath(path)), source.file.view);
+    if (!source.overviewLoaded)
+        source.overview = OverviewIndex();
+    const size_t warm = std::min(source.file.view.size(), MEDIA_WARM_BYTES);
+    volatile unsigned char sink = 0;
+    for (size_t offset = 0; offset < warm; offset += 4096)
+        sink ^= source.file.view[offset];
+    (void)sink;
+    // Wait (on the loader thread) for the first chunk, so the swap does not start with an underrun.
+    if (sampleRate && startPrefetchRing(source.ring, path, source.file.view.size(), sampleRate, lockMemory)) {
+        for (int tries = 0; tries < MEDIA_FIRST_CHUNK_WAIT_MS && source.ring.chunkSlots[0].load() < 0; tries++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return true;
+}
+
+// Connect to a stream and show its history. There is nothing to map, prefetch or index; the
+// audio thread reads the history directly, so `lockMemory` pins it.
+static inline bool openStreamMediaSource(MediaSource& source, const std::string& spec, size_t historyBytes,
+    bool lockMemory = false) {
+    std::unique_ptr<StreamSource> stream(new StreamSource());
+    if (!startStreamSource(*stream, spec, historyBytes))
+        return false;
+    if (lockMemory && !::lockMemory(stream->history.data(), stream->history.size()))
+        std::cerr << "Warning: Could not lock the stream history in memory (memlock limit?)." << std::endl;
+    source.path = spec;
+    source.file.view.bytes = stream->history.data();
+    source.file.view.length = stream->history.size();
+    source.stream = std::move(stream);
+    return true;
+}
+
+static inline void closeMediaSource(MediaSource& source) {
+    stopPrefetchRing(source.ring);
+    if (source.stream) {
+        stopStreamSource(*source.stream);
+        source.file.view = ByteView();     // the history is not a mapping
+        source.stream.reset();
+    }
+    closeMappedFile(source.file);
+    source.overview = OverviewIndex();
+    source.overviewLoaded = false;
+    source.session = SessionState();
+    source.sessionLoaded = false;
+    source.analysis = FrameAnalysis();
+    source.analysisLoaded = false;
+    source.searchMatches.clear();
+    source.searchLoaded = false;
+}
+
+// --- Playlist ---
+struct Playlist {
+    std::vector<std::string> paths;
+    size_t current = 0;
+};
+
+// Append a file, or every regular file in a directory (sorted, skipping the player's own index
+// files). Returns the number of entries added.
+static inline size_t addPlaylistPath(Playlist& playlist, const std::string& path) {
+    std::error_code error;
+    if (!std::filesystem::is_directory(path, error)) {
+        playlist.paths.push_back(path);
+        return 1;
+    }
+    std::vector<std::string> files;
+    for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator(path, error)) {
+        if (!entry.is_regular_file(error) || isPlayerIndexFile(entry.path()))
+            continue;
+        files.push_back(entry.path().string());
+    }
+    if (error)
+        std::cerr << "Error: Could not list directory: " << path << std::endl;
+    std::sort(files.begin(), files.end());
+    playlist.paths.insert(playlist.paths.end(), files.begin(), files.end());
+    return files.size();
+}
+
+// Entry `step` places away from the current one, wrapping around.
+static inline size_t playlistNeighbor(const Playlist& playlist, int step) {
+    const long long count = static_cast<long long>(playlist.paths.size());
+    if (count == 0)
+        return 0;
+    long long index = (static_cast<long long>(playlist.current) + step) % count;
+    return static_cast<size_t>(index < 0 ? index + count : index);
+}
+
+static inline std::string playlistEntryName(const Playlist& playlist, size_t index) {
+    if (index >= playlist.paths.size())
+        return "";
+    return std::filesystem::path(playlist.paths[index]).filename().string();
+}
+
+// --- Loader thread ---
+// Holds at most one opened source (the one asked for last); anything else it opened or was handed
+// back is closed on the same thread.
+struct MediaLoader {
+    std::thread worker;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::string wantedPath;                                // guarded by mutex
+    std::string readyPath;
+    std::unique_ptr<MediaSource> ready;
+    std::string failedPath;                                // last path that could not be opened
+    std::vector<std::unique_ptr<MediaSource>> retired;
+    std::atomic<unsigned> sampleRate{ 0 };                 // prefetch rate for new sources (0: no audio)
+    std::atomic<bool> lockMemory{ false };                 // pin the prefetch buffers of new sources
+};
+
+static inline void destroyMediaSources(std::vector<std::unique_ptr<MediaSource>>& sources) {
+    for (std::unique_ptr<MediaSource>& source : sources)
+        closeMediaSource(*source);
+    sources.clear();
+}
+
+static inline void mediaLoaderMain(MediaLoader* loaderPointer) {
+    MediaLoader& loader = *loaderPointer;
+    std::unique_lock<std::mutex> lock(loader.mutex);
+    for (;;) {
+        loader.wake.wait(lock, [&loader] {
+            return loader.stopping || !loader.retired.empty() ||
+                (!loader.wantedPath.empty() && loader.wantedPath != loader.readyPath && loader.wantedPath != loader.failedPath);
+        });
+        if (loader.stopping)
+            break;
+        if (!loader.retired.empty()) {
+            std::vector<std::unique_ptr<MediaSource>> dispose;
+            dispose.swap(loader.retired);
+            lock.unlock();
+            destroyMediaSources(dispose);
+            lock.lock();
+            continue;
+        }
+        std::string path = loader.wantedPath;
+        unsigned sampleRate = loader.sampleRate.load();
+        bool lockMemory = loader.lockMemory.load();
+        lock.unlock();
+        std::unique_ptr<MediaSource> source(new MediaSource());
+        bool opened = openMediaSource(*source, path, sampleRate, lockMemory);
+        lock.lock();
+        if (!opened) {
+            loader.failedPath = path;
+            continue;
+        }
+        if (loader.ready)
+            loader.retired.push_back(std::move(loader.ready));
+        if (loader.wantedPath == path) {
+            loader.ready = std::move(source);
+            loader.readyPath = path;
+        }
+        else {
+            loader.readyPath.clear();
+            loader.retired.push_back(std::move(source));
+        }
+    }
+    std::vector<std::unique_ptr<MediaSource>> dispose;
+    dispose.swap(loader.retired);
+    if (loader.ready)
+        dispose.push_back(std::move(loader.ready));
+    loader.readyPath.clear();
+    lock.unlock();
+    destroyMediaSources(dispose);
+}
+
+static inline void startMediaLoader(MediaLoader& loader) {
+    loader.stopping = false;
+    loader.worker = std::thread(mediaLoaderMain, &loader);
+}
+
+static inline void stopMediaLoader(MediaLoader& loader) {
+    if (!loader.worker.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(loader.mutex);
+        loader.stopping = true;
+    }
+    loader.wake.notify_one();
+    loader.worker.join();
+}
+
+// Open `path` in the background (replacing any earlier request).
+static inline void preloadMedia(MediaLoader& loader, const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(loader.mutex);
+        loader.wantedPath = path;
+        if (loader.failedPath == path)
+            loader.failedPath.clear();
+    }
+    loader.wake.notify_one();
+}
+
+// The opened source for `path` if the loader has it, otherwise null (and a request for it).
+// `failed` is set when opening it did not work.
+static inline std::unique_ptr<MediaSource> takePreloadedMedia(MediaLoader& loader, const std::string& path, bool& failed) {
+    std::unique_ptr<MediaSource> source;
+    {
+        std::lock_guard<std::mutex> lock(loader.mutex);
+        failed = loader.failedPath == path;
+        if (loader.readyPath == path && loader.ready) {
+            source = std::move(loader.ready);
+            loader.readyPath.clear();
+            loader.wantedPath.clear();
+        }
+        else if (!failed) {
+            loader.wantedPath = path;
+        }
+    }
+    if (!source && !failed)
+        loader.wake.notify_one();
+    return source;
+}
+
+// Hand a source the audio thread no longer uses to the loader for teardown.
+static inline void retireMediaSource(MediaLoader& loader, std::unique_ptr<MediaSource> source) {
+    if (!source)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(loader.mutex);
+        loader.retired.push_back(std::move(source));
+    }
+    loader.wake.notify_one();
+}
@@ -0,0 +1,404 @@
+#pragma once
+// Streaming prefetch for the audio thread.
+// The file is split into fixed-size chunks. A background I/O thread copies the chunks around the
+// playhead into a ring of owned buffers: the current chunk, a read-ahead window that follows the
+// direction and speed of playback, and the whole loop region while looping (so boomerangs and
+// loop jumps never touch the disk). The JACK callback reads only through PrefetchSource, which
+// hands out resident chunks without blocking; a chunk that is not in yet plays silence and bumps
+// the underrun counter.
+//
+// Residency protocol: chunkSlots[c] names the slot holding chunk c. The reader pins a slot
+// (readers++) and re-checks that it still holds c; the I/O thread unpublishes a slot before
+// eviction and waits for readers to drain before overwriting it. The reader side is wait-free.
+//
+// Reads use overlapped ReadFile on Windows. On POSIX they are pread calls from the I/O thread,
+// with posix_fadvise(WILLNEED) queued ahead of them so the kernel's own read-ahead overlaps them.
+// The I/O thread runs at raised priority where the system allows it (ThreadPriority.h), and the
+// ring's buffers can be locked in memory (MemoryLock.h) so the callback's reads never fault.
+#include "ControlChannel.h"
+#include "MappedFile.h"
+#include "MemoryLock.h"
+#include "ThreadPriority.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+static const size_t PREFETCH_CHUNK_BYTES = 256 * 1024;
+static const int PREFETCH_SLOTS = 128;                  // 32 MB of resident chunks
+static const size_t PREFETCH_GUARD_BYTES = 64;          // neighbor reads: cubic kernel, widest frame pair
+static const double PREFETCH_LOOKAHEAD_SECONDS = 0.5;
+static const int PREFETCH_MAX_PENDING = 4;              // overlapped reads in flight
+
+// What the audio thread last played, for the I/O thread's plan. Published once per period.
+struct PrefetchHint {
+    double position;
+    double sampleAdvance;      // bytes per sample, signed
+    double loopStart;
+    double loopEnd;
+    bool loopEnabled;
+};
+
+struct PrefetchSlot {
+    std::unique_ptr<unsigned char[]> buffer;
+    size_t base = 0;           // file offset of buffer[0] (chunk start minus guard)
+    size_t length = 0;
+    size_t coreFirst = 0;      // chunk bytes [coreFirst, coreEnd)
+    size_t coreEnd = 0;
+    std::atomic<long long> chunk{ -1 };
+    std::atomic<int> readers{ 0 };
+    unsigned lastWanted = 0;   // I/O thread only: plan generation that last wanted this slot
+};
+
+struct PrefetchRing {
+    size_t fileSize = 0;
+    size_t chunkCount = 0;
+    unsigned sampleRate = 48000;
+    std::unique_ptr<std::atomic<int>[]> chunkSlots;   // chunk -> slot, -1 if not resident
+    std::unique_ptr<PrefetchSlot[]> slots;
+    int slotCount = 0;
+    SeqLock<PrefetchHint> hint;
+    std::atomic<long long> urgentPosition{ -1 };      // UI seek target, served first
+    std::atomic<unsigned long long> underruns{ 0 };   // periods that hit a non-resident chunk
+    std::atomic<unsigned long long> chunksRead{ 0 };
+    std::atomic<bool> running{ false };
+    bool locked = false;                              // buffers and tables pinned (startPrefetchRing)
+    std::thread worker;
+    std::mutex wakeMutex;
+    std::condition_variable wake;
+#ifdef _WIN32
+    HANDLE fileHandle = INVALID_HANDLE_VALUE;
+#else
+    int fd = -1;
+#endif
+};
+
+// --- Reader side (JACK thread) ---
+struct PrefetchSource {
+    PrefetchRing* ring;
+    bool acquire(size_t index, SampleWindow& window) {
+        size_t chunk = index / PREFETCH_CHUNK_BYTES;
+        if (chunk >= ring->chunkCount)
+            return false;
+        int slotIndex = ring->chunkSlots[chunk].load(std::memory_order_acquire);
+        if (slotIndex < 0)
+            return false;
+        PrefetchSlot& slot = ring->slots[slotIndex];
+        slot.readers.fetch_add(1, std::memory_order_seq_cst);
+        if (slot.chunk.load(std::memory_order_seq_cst) != static_cast<long long>(chunk)) {
+            slot.readers.fetch_sub(1, std::memory_order_release);
+            return false;
+        }
+        window.bytes = slot.buffer.get();
+        window.base = slot.base;
+        window.length = slot.length;
+        window.coreFirst = static_cast<double>(slot.coreFirst);
+        window.coreLast = std::nextafter(static_cast<double>(slot.coreEnd), 0.0);
+        window.slot = slotIndex;
+        return true;
+    }
+    void release(SampleWindow& window) {
+        ring->slots[window.slot].readers.fetch_sub(1, std::memory_order_release);
+    }
+};
+
+static inline void publishPrefetchHint(PrefetchRing& ring, const PlaybackState& playback, double sampleAdvance) {
+    PrefetchHint hint;
+    hint.position = playback.position;
+    hint.sampleAdvance = sampleAdvance;
+    hint.loopStart = playback.loopStart;
+    hint.loopEnd = playback.loopEnd;
+    hint.loopEnabled = playback.loopEnabled;
+    ring.hint.store(hint);
+}
+
+// UI thread: ask for the chunk at a seek target before the audio thread gets there.
+static inline void requestPrefetch(PrefetchRing& ring, double position) {
+    if (!ring.running || ring.fileSize == 0)
+        return;
+    ring.urgentPosition.store(static_cast<long long>(wrapPosition(position, static_cast<double>(ring.fileSize))));
+    ring.wake.notify_one();
+}
+
+// --- I/O thread ---
+static inline size_t prefetchChunkAt(const PrefetchRing& ring, double position) {
+    size_t index = boundaryIndex(position, static_cast<double>(ring.fileSize), ring.fileSize);
+    return index / PREFETCH_CHUNK_BYTES;
+}
+
+// Chunks wanted right now, most important first (duplicates are harmless).
+static inline void planPrefetch(const PrefetchRing& ring, const PrefetchHint& hint, long long urgent,
+    std::vector<size_t>& plan) {
+    plan.clear();
+    const size_t budget = static_cast<size_t>(ring.slotCount);
+    if (ring.chunkCount <= budget) {
+        // Everything fits: keep the whole file resident, nearest chunks first.
+        size_t current = prefetchChunkAt(ring, hint.position);
+        for (size_t i = 0; i < ring.chunkCount; i++)
+            plan.push_back((current + i) % ring.chunkCount);
+        return;
+    }
+    if (urgent >= 0)
+        plan.push_back(static_cast<size_t>(urgent) / PREFETCH_CHUNK_BYTES);
+    size_t current = prefetchChunkAt(ring, hint.position);
+    plan.push_back(current);
+    // Read-ahead in the direction of travel, sized by speed; one chunk behind for reversals.
+    bool forward = hint.sampleAdvance >= 0.0;
+    double bytesAhead = std::fabs(hint.sampleAdvance) * ring.sampleRate * PREFETCH_LOOKAHEAD_SECONDS;
+    size_t ahead = static_cast<size_t>(bytesAhead / PREFETCH_CHUNK_BYTES) + 2;
+    if (ahead > budget / 2)
+        ahead = budget / 2;
+    for (size_t i = 1; i <= ahead; i++)
+        plan.push_back(forward ? (current + i) % ring.chunkCount : (current + ring.chunkCount - i % ring.chunkCount) % ring.chunkCount);
+    plan.push_back(forward ? (current + ring.chunkCount - 1) % ring.chunkCount : (current + 1) % ring.chunkCount);
+    // Pin the loop region, or its two ends if it is bigger than the remaining budget.
+    if (hint.loopEnabled && hint.loopStart != hint.loopEnd) {
+        size_t first = prefetchChunkAt(ring, hint.loopStart);
+        size_t last = prefetchChunkAt(ring, hint.loopEnd);
+        size_t span = (last >= first) ? last - first + 1 : ring.chunkCount - first + last + 1;
+        if (span + plan.size() <= budget) {
+            for (size_t i = 0; i < span; i++)
+                plan.push_back((first + i) % ring.chunkCount);
+        }
+        else {
+            plan.push_back(first);
+            plan.push_back(last);
+        }
+    }
+}
+
+// Take a slot out of circulation; returns once no reader holds it.
+static inline void unpublishSlot(PrefetchRing& ring, int slotIndex) {
+    PrefetchSlot& slot = ring.slots[slotIndex];
+    long long chunk = slot.chunk.load();
+    if (chunk >= 0)
+        ring.chunkSlots[chunk].store(-1);
+    slot.chunk.store(-1, std::memory_order_seq_cst);
+    while (slot.readers.load(std::memory_order_seq_cst) > 0)
+        std::this_thread::yield();
+}
+
+// File range a chunk's slot covers (chunk plus guard bytes, clamped to the file).
+static inline void chunkExtent(const PrefetchRing& ring, size_t chunk, PrefetchSlot& slot) {
+    slot.coreFirst = chunk * PREFETCH_CHUNK_BYTES;
+    slot.coreEnd = slot.coreFirst + PREFETCH_CHUNK_BYTES;
+    if (slot.coreEnd > ring.fileSize)
+        slot.coreEnd = ring.fileSize;
+    slot.base = (slot.coreFirst >= PREFETCH_GUARD_BYTES) ? slot.coreFirst - PREFETCH_GUARD_BYTES : 0;
+    size_t end = slot.coreEnd + PREFETCH_GUARD_BYTES;
+    if (end > ring.fileSize)
+        end = ring.fileSize;
+    slot.length = end - slot.base;
+}
+
+static inline void publishSlot(PrefetchRing& ring, int slotIndex, size_t chunk) {
+    ring.slots[slotIndex].chunk.store(static_cast<long long>(chunk), std::memory_order_seq_cst);
+    ring.chunkSlots[chunk].store(slotIndex, std::memory_order_release);
+    ring.chunksRead.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Read the given (slot, chunk) pairs, overlapped where the platform allows it.
+static inline void readChunks(PrefetchRing& ring, const std::vector<std::pair<int, size_t>>& reads) {
+#ifdef _WIN32
+    OVERLAPPED overlapped[PREFETCH_MAX_PENDING];
+    HANDLE events[PREFETCH_MAX_PENDING];
+    for (int i = 0; i < PREFETCH_MAX_PENDING; i++)
+        events[i] = CreateEventA(NULL, TRUE, FALSE, NULL);
+    for (size_t first = 0; first < reads.size(); first += PREFETCH_MAX_PENDING) {
+        size_t count = reads.size() - first;
+        if (count > PREFETCH_MAX_PENDING)
+            count = PREFETCH_MAX_PENDING;
+        bool issued[PREFETCH_MAX_PENDING] = { false };
+        for (size_t i = 0; i < count; i++) {
+            PrefetchSlot& slot = ring.slots[reads[first + i].first];
+            ZeroMemory(&overlapped[i], sizeof(OVERLAPPED));
+            overlapped[i].Offset = static_cast<DWORD>(slot.base & 0xFFFFFFFFu);
+            overlapped[i].OffsetHigh = static_cast<DWORD>(static_cast<unsigned long long>(slot.base) >> 32);
+            overlapped[i].hEvent = events[i];
+            ResetEvent(events[i]);
+            BOOL ok = ReadFile(ring.fileHandle, slot.buffer.get(), static_cast<DWORD>(slot.length), NULL, &overlapped[i]);
+            issued[i] = ok || GetLastError() == ERROR_IO_PENDING;
+        }
+        for (size_t i = 0; i < count; i++) {
+            DWORD bytes = 0;
+            int slotIndex = reads[first + i].first;
+            if (issued[i] && GetOverlappedResult(ring.fileHandle, &overlapped[i], &bytes, TRUE) &&
+                bytes == ring.slots[slotIndex].length)
+                publishSlot(ring, slotIndex, reads[first + i].second);
+        }
+    }
+    for (int i = 0; i < PREFETCH_MAX_PENDING; i++)
+        CloseHandle(events[i]);
+#else
+#ifdef POSIX_FADV_WILLNEED
+    for (size_t i = 0; i < reads.size(); i++) {
+        const PrefetchSlot& slot = ring.slots[reads[i].first];
+        posix_fadvise(ring.fd, static_cast<off_t>(slot.base), static_cast<off_t>(slot.length), POSIX_FADV_WILLNEED);
+    }
+#endif
+    for (size_t i = 0; i < reads.size(); i++) {
+        PrefetchSlot& slot = ring.slots[reads[i].first];
+        size_t done = 0;
+        while (done < slot.length) {
+            ssize_t got = pread(ring.fd, slot.buffer.get() + done, slot.length - done, static_cast<off_t>(slot.base + done));
+            if (got <= 0)
+                break;
+            done += static_cast<size_t>(got);
+        }
+        if (done == slot.length)
+            publishSlot(ring, reads[i].first, reads[i].second);
+    }
+#endif
+}
+
+static inline void prefetchThreadMain(PrefetchRing* ringPointer) {
+    PrefetchRing& ring = *ringPointer;
+    raiseThreadPriority();
+    std::vector<size_t> plan;
+    std::vector<std::pair<int, size_t>> reads;
+    unsigned generation = 0;
+    while (ring.running) {
+        long long urgent = ring.urgentPosition.exchange(-1);
+        planPrefetch(ring, ring.hint.load(), urgent, plan);
+        generation++;
+        // Mark the slots that are still wanted; collect the chunks that are missing.
+        reads.clear();
+        std::vector<size_t> missing;
+        for (size_t chunk : plan) {
+            int slotIndex = ring.chunkSlots[chunk].load(std::memory_order_acquire);
+            if (slotIndex >= 0)
+                ring.slots[slotIndex].lastWanted = generation;
+            else if (std::find(missing.begin(), missing.end(), chunk) == missing.end())
+                missing.push_back(chunk);
+        }
+        // Each missing chunk replaces the slot wanted longest ago (never one wanted this round).
+        for (size_t chunk : missing) {
+            int victim = -1;
+            for (int s = 0; s < ring.slotCount; s++) {
+                PrefetchSlot& slot = ring.slots[s];
+                if (slot.lastWanted == generation)
+                    continue;
+                if (victim < 0 || slot.lastWanted < ring.slots[victim].lastWanted)
+                    victim = s;
+            }
+            if (victim < 0)
+                break;
+            unpublishSlot(ring, victim);
+            PrefetchSlot& slot = ring.slots[victim];
+            slot.lastWanted = generation;
+            chunkExtent(ring, chunk, slot);
+            reads.push_back(std::make_pair(victim, chunk));
+            if (reads.size() >= static_cast<size_t>(PREFETCH_MAX_PENDING) * 4)
+                break;
+        }
+        if (!reads.empty()) {
+            readChunks(ring, reads);
+            continue;   // re-plan immediately: the playhead may have moved while reading
+        }
+        std::unique_lock<std::mutex> lock(ring.wakeMutex);
+        ring.wake.wait_for(lock, std::chrono::milliseconds(2));
+    }
+}
+
+// Everything the audio thread reads through PrefetchSource.
+static inline bool lockPrefetchRing(PrefetchRing& ring, bool lock) {
+    const size_t slotBytes = PREFETCH_CHUNK_BYTES + 2 * PREFETCH_GUARD_BYTES;
+    bool locked = true;
+    for (int i = 0; i < ring.slotCount; i++)
+        locked = (lock ? lockMemory(ring.slots[i].buffer.get(), slotBytes) : (unlockMemory(ring.slots[i].buffer.get(), slotBytes), true)) && locked;
+    const void* tables[2] = { ring.slots.get(), ring.chunkSlots.get() };
+    const size_t tableBytes[2] = { ring.slotCount * sizeof(PrefetchSlot), ring.chunkCount * sizeof(std::atomic<int>) };
+    for (int t = 0; t < 2; t++)
+        locked = (lock ? lockMemory(tables[t], tableBytes[t]) : (unlockMemory(tables[t], tableBytes[t]), true)) && locked;
+    return locked;
+}
+
+// --- Lifetime ---
+// Opens its own handle (overlapped on Windows) next to the mapping; the mapping stays in use by
+// the renderers, which may fault. With `lockBuffers` the slots are pinned in memory; if the
+// system refuses, the ring runs unlocked.
+static inline bool startPrefetchRing(PrefetchRing& ring, const std::string& filename, size_t fileSize, unsigned sampleRate,
+    bool lockBuffers = false) {
+    if (fileSize == 0)
+        return false;
+#ifdef _WIN32
+    ring.fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_OVERLAPPED, NULL);
+    if (ring.fileHandle == INVALID_HANDLE_VALUE) {
+        std::cerr << "Error: Could not open file for prefetch: " << filename << std::endl;
+        return false;
+    }
+#else
+    ring.fd = ::open(filename.c_str(), O_RDONLY);
+    if (ring.fd < 0) {
+        std::cerr << "Error: Could not open file for prefetch: " << filename << std::endl;
+        return false;
+    }
+#endif
+    ring.fileSize = fileSize;
+    ring.sampleRate = sampleRate;
+    ring.chunkCount = (fileSize + PREFETCH_CHUNK_BYTES - 1) / PREFETCH_CHUNK_BYTES;
+    ring.slotCount = (ring.chunkCount < static_cast<size_t>(PREFETCH_SLOTS)) ? static_cast<int>(ring.chunkCount) : PREFETCH_SLOTS;
+    ring.chunkSlots.reset(new std::atomic<int>[ring.chunkCount]);
+    for (size_t i = 0; i < ring.chunkCount; i++)
+        ring.chunkSlots[i].store(-1, std::memory_order_relaxed);
+    ring.slots.reset(new PrefetchSlot[ring.slotCount]);
+    for (int i = 0; i < ring.slotCount; i++)
+        ring.slots[i].buffer.reset(new unsigned char[PREFETCH_CHUNK_BYTES + 2 * PREFETCH_GUARD_BYTES]);
+    ring.locked = lockBuffers && lockPrefetchRing(ring, true);
+    if (lockBuffers && !ring.locked)
+        std::cerr << "Warning: Could not lock prefetch buffers in memory (memlock limit?)." << std::endl;
+    PrefetchHint hint = {};
+    ring.hint.store(hint);
+    ring.running = true;
+    ring.worker = std::thread(prefetchThreadMain, &ring);
+    return true;
+}
+
+static inline void stopPrefetchRing(PrefetchRing& ring) {
+    if (ring.running) {
+        ring.running = false;
+        ring.wake.notify_one();
+        ring.worker.join();
+    }
+#ifdef _WIN32
+    if (ring.fileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle(ring.fileHandle);
+    ring.fileHandle = INVALID_HANDLE_VALUE;
+#else
+    if (ring.fd >= 0)
+        ::close(ring.fd);
+    ring.fd = -1;
+#endif
+    if (ring.locked)
+        lockPrefetchRing(ring, false);
+    ring.locked = false;
+    ring.slots.reset();
+    ring.chunkSlots.reset();
+    ring.slotCount = 0;
+    ring.chunkCount = 0;
+    ring.fileSize = 0;
+}
+
+// Render one period through the ring; a period with any miss counts as one underrun.
+static inline void renderPrefetchedFrames(PrefetchRing& ring, PlaybackState& state, const AudioLayout& layout,
+    double baseAdvance, float volume, float* const* outs, size_t nframes, ResampleMode mode,
+    PlayedRuns* played = nullptr) {
+    PrefetchSource source;
+    source.ring = &ring;
+    unsigned misses = renderPlaybackFramesFrom(state, source, ring.fileSize, layout, baseAdvance, volume, outs,
+        nframes, mode, played);
+    if (misses)
+        ring.underruns.fetch_add(1, std::memory_order_relaxed);
+}
@@ -0,0 +1,125 @@
+#pragma once
+// Oscilloscope trace: the byte runs the audio played (PlayedRuns) reduced to one (min, max) pair
+// per panel column, in playing order. The columns share the played bytes evenly, and each also
+// takes the first byte of the next one so the trace is continuous. Every byte counts: a column
+// covering whole overview blocks takes their min and max from the index pyramid and scans only
+// the partial blocks at its ends, so the cost follows the panel width rather than the playback
+// speed; without an index the bytes are scanned 16 at a time.
+#include "OverviewIndex.h"
+#include "Playback.h"
+#include "Simd.h"
+#include <algorithm>
+#include <vector>
+
+// Folds bytes [first, end) into low and high.
+static inline void scanByteRange(const unsigned char* data, size_t first, size_t end, unsigned char& low,
+    unsigned char& high) {
+    size_t i = first;
+#if defined(BWF_SSE2) || defined(BWF_NEON)
+    if (end - first >= 16) {
+        unsigned char lows[16], highs[16];
+#if defined(BWF_SSE2)
+        __m128i vlow = _mm_set1_epi8(static_cast<char>(0xFF)), vhigh = _mm_setzero_si128();
+        for (; i + 16 <= end; i += 16) {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+            vlow = _mm_min_epu8(vlow, v);
+            vhigh = _mm_max_epu8(vhigh, v);
+        }
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(lows), vlow);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(highs), vhigh);
+#else
+        uint8x16_t vlow = vdupq_n_u8(0xFF), vhigh = vdupq_n_u8(0);
+        for (; i + 16 <= end; i += 16) {
+            uint8x16_t v = vld1q_u8(data + i);
+            vlow = vminq_u8(vlow, v);
+            vhigh = vmaxq_u8(vhigh, v);
+        }
+        vst1q_u8(lows, vlow);
+        vst1q_u8(highs, vhigh);
+#endif
+        for (int k = 0; k < 16; k++) {
+            low = std::min(low, lows[k]);
+            high = std::max(high, highs[k]);
+        }
+    }
+#endif
+    for (; i < end; i++) {
+        low = std::min(low, data[i]);
+        high = std::max(high, data[i]);
+    }
+}
+
+// Folds level-0 blocks [first, end) into low and high, taking each aligned run of blocks from
+// the highest level that holds it as one block.
+static inline void mergeOverviewBlocks(const OverviewIndex& index, size_t first, size_t end, unsigned char& low,
+    unsigned char& high) {
+    while (first < end) {
+        size_t level = 0;
+        while (level + 1 < index.levels.size() && (first & ((size_t(2) << level) - 1)) == 0 &&
+            first + (size_t(2) << level) <= end && (first >> (level + 1)) < index.levels[level + 1].blocks.size())
+            level++;
+        const OverviewBlock& block = index.levels[level].blocks[first >> level];
+        low = std::min(low, block.minimum);
+        high = std::max(high, block.maximum);
+        first += size_t(1) << level;
+    }
+}
+
+// Folds bytes [first, end) into low and high, through `index` when it is not null.
+static inline void reduceByteRange(const unsigned char* data, size_t first, size_t end, const OverviewIndex* index,
+    unsigned char& low, unsigned char& high) {
+    if (index) {
+        const size_t blockSize = index->levels[0].blockSize;
+        const size_t firstBlock = (first + blockSize - 1) / blockSize;
+        const size_t endBlock = end / blockSize;
+        if (endBlock > firstBlock) {
+            scanByteRange(data, first, firstBlock * blockSize, low, high);
+            mergeOverviewBlocks(*index, firstBlock, endBlock, low, high);
+            scanByteRange(data, endBlock * blockSize, end, low, high);
+            return;
+        }
+    }
+    scanByteRange(data, first, end, low, high);
+}
+
+// Fills `out` with `columns` (low, high) byte pairs for the runs, read from `data` (the file the
+// runs played) and `index` when it is built for that file. Returns false if nothing was played.
+static inline bool reduceScopeColumns(const PlayedRuns& runs, const unsigned char* data, size_t size,
+    const OverviewIndex* index, size_t columns, std::vector<unsigned char>& out) {
+    if (runs.count == 0 || size == 0 || columns == 0)
+        return false;
+    if (index && (index->empty() || index->fileSize != size))
+        index = nullptr;
+    // Each run as bytes [first, first + length) of the file, backward if played from the end.
+    size_t runFirst[PLAYED_RUN_COUNT], runLength[PLAYED_RUN_COUNT];
+    bool backward[PLAYED_RUN_COUNT];
+    size_t total = 0;
+    const double last = static_cast<double>(size - 1);
+    for (unsigned r = 0; r < runs.count; r++) {
+        size_t from = static_cast<size_t>(std::min(std::max(runs.from[r], 0.0), last));
+        size_t to = static_cast<size_t>(std::min(std::max(runs.to[r], 0.0), last));
+        backward[r] = to < from;
+        runFirst[r] = std::min(from, to);
+        runLength[r] = (backward[r] ? from - to : to - from) + 1;
+        total += runLength[r];
+    }
+    out.resize(columns * 2);
+    for (size_t c = 0; c < columns; c++) {
+        // Column c covers played bytes [begin, end), counted in playing order.
+        const size_t begin = c * total / columns;
+        const size_t end = std::min(std::max((c + 1) * total / columns, begin + 1) + 1, total);
+        unsigned char low = 0xFF, high = 0;
+        size_t offset = 0;
+        for (unsigned r = 0; r < runs.count; r++) {
+            const size_t a = std::max(begin, offset), b = std::min(end, offset + runLength[r]);
+            if (a < b) {
+                const size_t first = backward[r] ? runFirst[r] + (offset + runLength[r] - b) : runFirst[r] + (a - offset);
+                reduceByteRange(data, first, first + (b - a), index, low, high);
+            }
+            offset += runLength[r];
+        }
+        out[2 * c] = low;
+        out[2 * c + 1] = high;
+    }
+    return true;
+}
@@ -0,0 +1,351 @@
+#pragma once
+// Per-file session state, saved next to the file as <file>.bwfsession when the player switches
+// away from it or exits, and restored on the next open: playhead position, loop and boomerang
+// settings, geometry, palette and search patterns, plus the names of the index files built for
+// it. A session only applies to the file it was saved from: size, modification time and the
+// sampled-block fingerprint of OverviewIndex.h must all match.
+//
+// Besides the overview index (<file>.bwfov), the per-frame analysis (<file>.bwfan) and the last
+// complete search (<file>.bwfsr) are kept on disk, so reopening a large image recomputes nothing.
+// Both are a fixed header and one flat record array: the file is mapped, its header checked
+// against the file, frame size or pattern set it was built for, and the records copied out.
+// The session itself is a short text file of "key value" lines.
+#include "FrameAnalysis.h"
+#include "FrameGeometry.h"
+#include "MappedFile.h"
+#include "OverviewIndex.h"
+#include "Palette.h"
+#include "PatternSearch.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+const char SESSION_MAGIC[] = "bwfsession 1";
+const char ANALYSIS_INDEX_MAGIC[8] = { 'B', 'W', 'F', 'A', 'N', '0', '0', '1' };
+const char SEARCH_INDEX_MAGIC[8] = { 'B', 'W', 'F', 'S', 'R', '0', '0', '1' };
+const size_t SESSION_MAX_CACHED_MATCHES = 1 << 20;   // larger results are searched again
+
+static inline std::string sessionPath(const std::string& filename) {
+    return filename + ".bwfsession";
+}
+
+static inline std::string analysisIndexPath(const std::string& filename) {
+    return filename + ".bwfan";
+}
+
+static inline std::string searchIndexPath(const std::string& filename) {
+    return filename + ".bwfsr";
+}
+
+// The player's own files, which a directory in the playlist should not list.
+static inline bool isPlayerIndexFile(const std::filesystem::path& path) {
+    const std::filesystem::path extension = path.extension();
+    return extension == ".bwfov" || extension == ".bwfsession" || extension == ".bwfan" || extension == ".bwfsr";
+}
+
+// Modification time in the file clock's ticks (0 if unknown); only ever compared for equality.
+static inline long long fileModifiedTime(const std::string& filename) {
+    std::error_code error;
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(filename, error);
+    return error ? 0 : static_cast<long long>(time.time_since_epoch().count());
+}
+
+// Patterns in a form addSearchPattern reads back byte for byte.
+static inline std::string searchPatternText(const std::vector<unsigned char>& bytes) {
+    static const char digits[] = "0123456789abcdef";
+    std::string text = "hex:";
+    for (unsigned char value : bytes) {
+        text += digits[value >> 4];
+        text += digits[value & 15];
+    }
+    return text;
+}
+
+// FNV-1a over the patterns in order, so a cached search is only used for the same set.
+static inline unsigned long long patternSetHash(const PatternSet& set) {
+    unsigned long long hash = 1469598103934665603ULL;
+    for (const std::vector<unsigned char>& pattern : set.patterns) {
+        hash ^= pattern.size();
+        hash *= 1099511628211ULL;
+        for (unsigned char value : pattern) {
+            hash ^= value;
+            hash *= 1099511628211ULL;
+        }
+    }
+    return hash;
+}
+
+// --- Session file ---
+struct SessionState {
+    unsigned long long fileSize = 0;
+    long long modified = 0;
+    unsigned long long fingerprint = 0;
+    double position = 0.0;
+    bool loopEnabled = false;
+    double loopStart = 0.0;
+    double loopEnd = 0.0;
+    bool boomerangMode = false;
+    FrameGeometry geometry;
+    PaletteId palette = PALETTE_RAINBOW;
+    std::vector<std::string> patterns;        // as addSearchPattern takes them
+    // Index files, by name in the session's directory (empty: none saved).
+    std::string overviewIndex;
+    std::string analysisIndex;
+    std::string searchIndex;
+};
+
+// File name of the index at `indexPath` for the session to point to, or "" if it does not exist.
+static inline std::string sessionIndexName(const std::string& indexPath) {
+    std::error_code error;
+    if (!std::filesystem::exists(indexPath, error))
+        return "";
+    return std::filesystem::path(indexPath).filename().string();
+}
+
+// Path of an index the session names (next to the session), or `fallback` if it names none.
+static inline std::string sessionIndexPath(const std::string& filename, const std::string& name,
+    const std::string& fallback) {
+    if (name.empty())
+        return fallback;
+    return (std::filesystem::path(filename).parent_path() / name).string();
+}
+
+// Written to a temporary name and renamed, like the overview index.
+static inline bool saveSession(const SessionState& session, const std::string& filename) {
+    const std::string path = sessionPath(filename);
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary.c_str(), std::ios::trunc);
+        if (!out) {
+            std::cerr << "Warning: Could not write session: " << path << std::endl;
+            return false;
+        }
+        out.precision(17);
+        out << SESSION_MAGIC << "\n"
+            << "size " << session.fileSize << "\n"
+            << "modified " << session.modified << "\n"
+            << "fingerprint " << session.fingerprint << "\n"
+            << "position " << session.position << "\n"
+            << "loop " << (session.loopEnabled ? 1 : 0) << " " << session.loopStart << " " << session.loopEnd << "\n"
+            << "boomerang " << (session.boomerangMode ? 1 : 0) << "\n"
+            << "geometry " << session.geometry.width << " " << session.geometry.height << " "
+            << static_cast<int>(session.geometry.pixelFormat) << " " << session.geometry.scale << "\n"
+            << "palette " << static_cast<int>(session.palette) << "\n";
+        for (const std::string& pattern : session.patterns)
+            out << "pattern " << pattern << "\n";
+        if (!session.overviewIndex.empty())
+            out << "overview " << session.overviewIndex << "\n";
+        if (!session.analysisIndex.empty())
+            out << "analysis " << session.analysisIndex << "\n";
+        if (!session.searchIndex.empty())
+            out << "search " << session.searchIndex << "\n";
+        if (!out) {
+            std::cerr << "Warning: Could not write session: " << path << std::endl;
+            out.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    std::remove(path.c_str());
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Loads only a session saved from this exact file. Unknown keys are skipped, so older players
+// read newer sessions.
+static inline bool loadSession(SessionState& session, const std::string& filename, const ByteView& view) {
+    std::ifstream in(sessionPath(filename).c_str());
+    std::string line;
+    if (!in || !std::getline(in, line) || line != SESSION_MAGIC)
+        return false;
+    SessionState loaded;
+    bool identified = false;
+    while (std::getline(in, line)) {
+        std::istringstream fields(line);
+        std::string key;
+        fields >> key;
+        if (key == "size") {
+            fields >> loaded.fileSize;
+        }
+        else if (key == "modified") {
+            fields >> loaded.modified;
+        }
+        else if (key == "fingerprint") {
+            identified = static_cast<bool>(fields >> loaded.fingerprint);
+        }
+        else if (key == "position") {
+            fields >> loaded.position;
+        }
+        else if (key == "loop") {
+            int enabled = 0;
+            fields >> enabled >> loaded.loopStart >> loaded.loopEnd;
+            loaded.loopEnabled = enabled != 0;
+        }
+        else if (key == "boomerang") {
+            int enabled = 0;
+            fields >> enabled;
+            loaded.boomerangMode = enabled != 0;
+        }
+        else if (key == "geometry") {
+            int width = 0, height = 0, format = 0, scale = 0;
+            if (!(fields >> width >> height >> format >> scale) || width <= 0 || height <= 0 || scale <= 0 ||
+                format < 0 || format >= PIXEL_FORMAT_COUNT)
+                return false;
+            char size[32];
+            std::snprintf(size, sizeof(size), "%dx%d", width, height);
+            loaded.geometry.pixelFormat = static_cast<PixelFormat>(format);
+            parseFrameGeometry(size, loaded.geometry);
+            loaded.geometry.scale = scale;
+        }
+        else if (key == "palette") {
+            int palette = 0;
+            fields >> palette;
+            if (palette >= 0 && palette < PALETTE_COUNT)
+                loaded.palette = static_cast<PaletteId>(palette);
+        }
+        else if (key == "pattern") {
+            std::string pattern;
+            if (fields >> pattern)
+                loaded.patterns.push_back(pattern);
+        }
+        else if (key == "overview" || key == "analysis" || key == "search") {
+            std::string name;
+            std::getline(fields >> std::ws, name);
+            (key == "overview" ? loaded.overviewIndex : key == "analysis" ? loaded.analysisIndex : loaded.searchIndex) = name;
+        }
+    }
+    if (!identified || loaded.fileSize != view.size() || loaded.modified != fileModifiedTime(filename) ||
+        loaded.fingerprint != overviewFingerprint(view))
+        return false;
+    session = loaded;
+    return true;
+}
+
+// --- Index files ---
+struct SessionIndexHeader {
+    char magic[8];
+    uint64_t fileSize;
+    uint64_t fingerprint;
+    uint64_t key;             // frame bytes (analysis) or patternSetHash (search)
+    uint64_t count;
+    uint32_t recordBytes;     // sizeof the record, guards against layout changes
+    uint32_t reserved;
+};
+
+static inline bool saveSessionIndex(const std::string& path, const char* magic, const ByteView& view, uint64_t key,
+    const void* records, size_t count, size_t recordBytes) {
+    const std::string temporary = path + ".tmp";
+    {
+        std::ofstream out(temporary.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out) {
+            std::cerr << "Warning: Could not write index: " << path << std::endl;
+            return false;
+        }
+        SessionIndexHeader header;
+        std::memcpy(header.magic, magic, sizeof(header.magic));
+        header.fileSize = view.size();
+        header.fingerprint = overviewFingerprint(view);
+        header.key = key;
+        header.count = count;
+        header.recordBytes = static_cast<uint32_t>(recordBytes);
+        header.reserved = 0;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(static_cast<const char*>(records), static_cast<std::streamsize>(count * recordBytes));
+        if (!out) {
+            std::cerr << "Warning: Could not write index: " << path << std::endl;
+            out.close();
+            std::remove(temporary.c_str());
+            return false;
+        }
+    }
+    std::remove(path.c_str());
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) {
+        std::remove(temporary.c_str());
+        return false;
+    }
+    return true;
+}
+
+// Loads only an index built from this exact file for `key`.
+template <typename Record>
+static inline bool loadSessionIndex(const std::string& path, const char* magic, const ByteView& view, uint64_t key,
+    std::vector<Record>& records) {
+    MappedFile file;
+    if (!std::filesystem::exists(path) || !openMappedFile(file, path))
+        return false;
+    const ByteView& bytes = file.view;
+    SessionIndexHeader header;
+    bool valid = bytes.size() >= sizeof(header);
+    if (valid) {
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        valid = std::memcmp(header.magic, magic, sizeof(header.magic)) == 0 && header.recordBytes == sizeof(Record) &&
+            header.fileSize == view.size() && header.key == key &&
+            header.count <= bytes.size() / sizeof(Record) &&
+            bytes.size() == sizeof(header) + header.count * sizeof(Record) &&
+            header.fingerprint == overviewFingerprint(view);
+    }
+    if (valid) {
+        records.resize(static_cast<size_t>(header.count));
+        if (!records.empty())
+            std::memcpy(records.data(), bytes.data() + sizeof(header), records.size() * sizeof(Record));
+    }
+    closeMappedFile(file);
+    return valid;
+}
+
+static inline bool saveAnalysisIndex(const FrameAnalysis& analysis, const std::string& path, const ByteView& view) {
+    return saveSessionIndex(path, ANALYSIS_INDEX_MAGIC, view, analysis.frameBytes, analysis.frames.data(),
+        analysis.frames.size(), sizeof(FrameStats));
+}
+
+// Only an analysis of every whole frame at this frame size is accepted.
+static inline bool loadAnalysisIndex(FrameAnalysis& analysis, const std::string& path, const ByteView& view,
+    size_t frameBytes) {
+    FrameAnalysis loaded;
+    loaded.frameBytes = frameBytes;
+    if (frameBytes == 0 || !loadSessionIndex(path, ANALYSIS_INDEX_MAGIC, view, frameBytes, loaded.frames) ||
+        loaded.frames.size() != view.size() / frameBytes)
+        return false;
+    analysis = std::move(loaded);
+    return true;
+}
+
+static inline bool saveSearchIndex(const std::vector<SearchMatch>& matches, const PatternSet& set,
+    const std::string& path, const ByteView& view) {
+    if (matches.size() > SESSION_MAX_CACHED_MATCHES)
+        return false;
+    return saveSessionIndex(path, SEARCH_INDEX_MAGIC, view, patternSetHash(set), matches.data(), matches.size(),
+        sizeof(SearchMatch));
+}
+
+static inline bool loadSearchIndex(std::vector<SearchMatch>& matches, const PatternSet& set, const std::string& path,
+    const ByteView& view) {
+    return !set.empty() && loadSessionIndex(path, SEARCH_INDEX_MAGIC, view, patternSetHash(set), matches);
+}
+
+static inline PatternSet sessionPatternSet(const std::vector<std::string>& patterns) {
+    PatternSet set;
+    for (const std::string& pattern : patterns)
+        addSearchPattern(set, pattern);
+    return set;
+}
+
+// The indexes a loaded session points to, for its own geometry and patterns. Run where the file
+// is opened (the loader thread), so the UI only moves them into place.
+static inline void loadSessionIndexes(const SessionState& session, const std::string& filename, const ByteView& view,
+    FrameAnalysis& analysis, bool& analysisLoaded, std::vector<SearchMatch>& matches, bool& searchLoaded) {
+    analysisLoaded = loadAnalysisIndex(analysis,
+        sessionIndexPath(filename, session.analysisIndex, analysisIndexPath(filename)), view,
+        frameByteCount(session.geometry));
+    searchLoaded = loadSearchIndex(matches, sessionPatternSet(session.patterns),
+        sessionIndexPath(filename, session.searchIndex, searchIndexPath(filename)), view);
+}
@@ -0,0 +1,11 @@
+#pragma once
+// The vector instruction set of the hand-written kernels. SSE2 is part of every x86-64 target
+// (MSVC does not define __SSE2__ there, hence _M_X64) and NEON of every AArch64 one; other
+// targets take the scalar loop that sits next to each vector path.
+#if defined(__SSE2__) || defined(_M_X64)
+#define BWF_SSE2 1
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(_M_ARM64)
+#define BWF_NEON 1
+#include <arm_neon.h>
+#endif
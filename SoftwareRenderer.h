@@ -0,0 +1,167 @@
+#pragma once
+// CPU renderer for machines without a usable GL 3.x driver (remote desktops, old VMs).
+// Frames are colorized through the PaletteLUT into RGBA, upscaled with the nearest-neighbour
+// kernels from Colorize.h, and kept in a cache of scaled tiles keyed by frame index; a redraw is
+// one glDrawPixels per visible cell. Loops and boomerangs revisit the same frames, so once the
+// region has been shown it costs no colorize or scale work at all. The cache holds tiles for one
+// geometry, scale, pixel format, palette and source at a time and empties itself when any of them
+// changes; eviction is least recently shown first, as in TileArrayRenderer.
+#include "Colorize.h"
+#include "FrameRenderer.h"
+#include <unordered_map>
+#include <vector>
+
+static const size_t SOFTWARE_CACHE_BYTES = 128u << 20;   // scaled RGBA tiles kept around
+
+struct SoftwareTile {
+    size_t frame = NO_FRAME;
+    unsigned stamp = 0;                         // redraw that last showed the tile
+    std::vector<unsigned char> pixels;          // RGBA, (frameWidth * scale) x (frameHeight * scale)
+};
+
+struct SoftwareRenderer {
+    // What the cached tiles were made for.
+    const unsigned char* data = nullptr;
+    uint32_t generation = 0;
+    size_t frameBytes = 0;
+    const PaletteLUT* palette = nullptr;
+    int frameWidth = 0;
+    int frameHeight = 0;
+    int scale = 0;
+    PixelFormat pixelFormat = PIXEL_INDEXED8;
+    std::vector<SoftwareTile> tiles;
+    std::unordered_map<size_t, int> frameTile;  // frame index -> tile
+    std::vector<int> slotTiles;                 // per redraw: slot -> tile
+    std::vector<unsigned char> colorized;       // one unscaled RGBA frame
+    unsigned stamp = 0;
+    size_t budgetBytes = SOFTWARE_CACHE_BYTES;
+    // Counters for the last redraw.
+    int lastHits = 0;
+    int lastMisses = 0;
+};
+
+static inline void resetSoftwareCache(SoftwareRenderer& renderer) {
+    renderer.tiles.clear();
+    renderer.frameTile.clear();
+}
+
+// Forget the tiles of frames that overlap bytes [first, end), which a live stream has rewritten.
+// They are the first taken the next time a tile is needed.
+static inline void forgetSoftwareBytes(SoftwareRenderer& renderer, size_t first, size_t end) {
+    const size_t frameBytes = renderer.frameBytes;
+    if (frameBytes == 0)
+        return;
+    for (size_t t = 0; t < renderer.tiles.size(); t++) {
+        SoftwareTile& tile = renderer.tiles[t];
+        if (tile.frame == NO_FRAME || tile.frame * frameBytes >= end || (tile.frame + 1) * frameBytes <= first)
+            continue;
+        renderer.frameTile.erase(tile.frame);
+        tile.frame = NO_FRAME;
+        tile.stamp = 0;
+    }
+}
+
+static inline void destroySoftwareRenderer(SoftwareRenderer& renderer) {
+    renderer = SoftwareRenderer();
+}
+
+// Colorize one frame of any pixel format into unscaled RGBA.
+static inline void colorizeFrameRGBA(PixelFormat format, const unsigned char* frame, int width, int height,
+    const PaletteLUT& palette, unsigned char* dst) {
+    if (format == PIXEL_INDEXED8) {
+        colorizeRGBA32(frame, static_cast<size_t>(width) * height, palette, dst);
+        return;
+    }
+    for (int y = 0; y < height; y++) {
+        for (int x = 0; x < width; x++, dst += 4)
+            unpackPixel(format, frame, width, height, x, y, palette, dst);
+    }
+}
+
+// Draw the grid from cached tiles, colorizing and scaling only frames that are not cached. Tiles
+// shown in this redraw are never evicted by it, so the cache may briefly exceed its budget when
+// one grid alone is larger. `generation` identifies the source as in renderTilesArray. Always succeeds.
+static inline bool renderTilesSoftware(SoftwareRenderer& renderer, const TileLayout& layout,
+    const unsigned char* data, uint32_t generation, size_t startFrame, size_t totalFrames, const PaletteLUT& palette) {
+    size_t cells = static_cast<size_t>(layout.columns) * static_cast<size_t>(layout.rows);
+    int slots = static_cast<int>(cells < totalFrames ? cells : totalFrames);
+    if (slots <= 0)
+        return false;
+    if (renderer.data != data || renderer.generation != generation || renderer.frameBytes != layout.frameBytes ||
+        renderer.palette != &palette || renderer.frameWidth != layout.frameWidth ||
+        renderer.frameHeight != layout.frameHeight || renderer.scale != layout.scale ||
+        renderer.pixelFormat != layout.pixelFormat) {
+        resetSoftwareCache(renderer);
+        renderer.data = data;
+        renderer.generation = generation;
+        renderer.frameBytes = layout.frameBytes;
+        renderer.palette = &palette;
+        renderer.frameWidth = layout.frameWidth;
+        renderer.frameHeight = layout.frameHeight;
+        renderer.scale = layout.scale;
+        renderer.pixelFormat = layout.pixelFormat;
+    }
+    const int scaledWidth = layout.frameWidth * layout.scale;
+    const int scaledHeight = layout.frameHeight * layout.scale;
+    const size_t tileBytes = static_cast<size_t>(scaledWidth) * scaledHeight * 4;
+    size_t capacity = renderer.budgetBytes / tileBytes;
+    if (capacity > totalFrames)
+        capacity = totalFrames;
+    if (capacity < static_cast<size_t>(slots))
+        capacity = static_cast<size_t>(slots);
+    const unsigned stamp = ++renderer.stamp;
+
+    renderer.slotTiles.assign(slots, -1);
+    renderer.lastHits = 0;
+    renderer.lastMisses = 0;
+    for (int slot = 0; slot < slots; slot++) {
+        size_t frameIndex = (startFrame + slot) % totalFrames;
+        std::unordered_map<size_t, int>::const_iterator found = renderer.frameTile.find(frameIndex);
+        if (found != renderer.frameTile.end()) {
+            renderer.slotTiles[slot] = found->second;
+            renderer.tiles[found->second].stamp = stamp;
+            renderer.lastHits++;
+            continue;
+        }
+        // Miss: take a free tile while under capacity, otherwise the least recently shown one.
+        int tile = -1;
+        if (renderer.tiles.size() < capacity) {
+            tile = static_cast<int>(renderer.tiles.size());
+            renderer.tiles.push_back(SoftwareTile());
+            renderer.tiles[tile].pixels.resize(tileBytes);
+        }
+        else {
+            for (int t = 0; t < static_cast<int>(renderer.tiles.size()); t++) {
+                const SoftwareTile& candidate = renderer.tiles[t];
+                if (candidate.stamp != stamp && (tile < 0 || candidate.stamp < renderer.tiles[tile].stamp))
+                    tile = t;
+            }
+            renderer.frameTile.erase(renderer.tiles[tile].frame);
+        }
+        SoftwareTile& target = renderer.tiles[tile];
+        target.frame = frameIndex;
+        target.stamp = stamp;
+        renderer.colorized.resize(static_cast<size_t>(layout.frameWidth) * layout.frameHeight * 4);
+        colorizeFrameRGBA(layout.pixelFormat, data + frameIndex * layout.frameBytes, layout.frameWidth,
+            layout.frameHeight, palette, renderer.colorized.data());
+        scaleNearest(renderer.colorized.data(), layout.frameWidth, layout.frameHeight, 4, layout.scale,
+            target.pixels.data());
+        renderer.frameTile[frameIndex] = tile;
+        renderer.slotTiles[slot] = tile;
+        renderer.lastMisses++;
+    }
+
+    // Rows are stored top-down; a negative zoom draws them downward from each cell's corner.
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    glPixelZoom(1.0f, -1.0f);
+    for (int r = 0; r < layout.rows; r++) {
+        for (int c = 0; c < layout.columns; c++) {
+            int slot = static_cast<int>(static_cast<size_t>(r * layout.columns + c) % static_cast<size_t>(slots));
+            glRasterPos2i(c * scaledWidth, r * scaledHeight);
+            glDrawPixels(scaledWidth, scaledHeight, GL_RGBA, GL_UNSIGNED_BYTE,
+                renderer.tiles[renderer.slotTiles[slot]].pixels.data());
+        }
+    }
+    glPixelZoom(1.0f, 1.0f);
+    return true;
+}
@@ -0,0 +1,259 @@
+#pragma once
+// Spectrogram of what the audio thread plays.
+// The JACK callback copies the first output channel into a lock-free single-producer ring (one or
+// two memcpys per period, nothing else). An analysis thread cuts the stream into Hann-windowed
+// blocks with 50% overlap, runs a radix-2 FFT on each and turns the magnitudes into a row of
+// 0..255 levels (dB above SPECTROGRAM_FLOOR_DB). The UI streams new rows into a scrolling texture
+// (SpectrogramRenderer in FrameRenderer.h). Periodic structure in the bytes (tables, fixed-size
+// records, padding) shows up as tonal lines.
+//
+// The FFT keeps real and imaginary parts in separate arrays and stores each stage's twiddles
+// contiguously, so every butterfly loop walks unit-stride arrays and stages of four or more
+// butterflies run four at a time with SSE2 or NEON (Simd.h); bench spectrogram/levels times a block.
+#include "Simd.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+const int SPECTROGRAM_FFT_SIZE = 1024;
+const int SPECTROGRAM_BINS = SPECTROGRAM_FFT_SIZE / 2;
+const int SPECTROGRAM_HOP = SPECTROGRAM_FFT_SIZE / 2;       // 50% overlap
+const int SPECTROGRAM_HISTORY = 512;                         // rows kept for display
+const size_t SPECTROGRAM_RING_SAMPLES = 1 << 16;             // power of two
+const float SPECTROGRAM_FLOOR_DB = -96.0f;
+
+// --- Sample ring (audio thread -> analysis thread) ---
+struct SampleRing {
+    float samples[SPECTROGRAM_RING_SAMPLES];
+    alignas(64) std::atomic<size_t> head{ 0 };              // written by the audio thread
+    alignas(64) std::atomic<size_t> tail{ 0 };              // written by the analysis thread
+    std::atomic<unsigned long long> dropped{ 0 };            // samples lost to a lagging reader
+};
+
+// Audio thread. A block that does not fit is dropped whole rather than waited for.
+static inline void pushSamples(SampleRing& ring, const float* src, size_t count) {
+    size_t head = ring.head.load(std::memory_order_relaxed);
+    if (SPECTROGRAM_RING_SAMPLES - (head - ring.tail.load(std::memory_order_acquire)) < count) {
+        ring.dropped.fetch_add(count, std::memory_order_relaxed);
+        return;
+    }
+    size_t offset = head & (SPECTROGRAM_RING_SAMPLES - 1);
+    size_t first = std::min(count, SPECTROGRAM_RING_SAMPLES - offset);
+    std::memcpy(ring.samples + offset, src, first * sizeof(float));
+    std::memcpy(ring.samples, src + first, (count - first) * sizeof(float));
+    ring.head.store(head + count, std::memory_order_release);
+}
+
+// Analysis thread. Appends up to `count` samples to `dst`; returns how many.
+static inline size_t popSamples(SampleRing& ring, std::vector<float>& dst, size_t count) {
+    size_t tail = ring.tail.load(std::memory_order_relaxed);
+    size_t available = ring.head.load(std::memory_order_acquire) - tail;
+    count = std::min(count, available);
+    size_t offset = tail & (SPECTROGRAM_RING_SAMPLES - 1);
+    size_t first = std::min(count, SPECTROGRAM_RING_SAMPLES - offset);
+    dst.insert(dst.end(), ring.samples + offset, ring.samples + offset + first);
+    dst.insert(dst.end(), ring.samples, ring.samples + (count - first));
+    ring.tail.store(tail + count, std::memory_order_release);
+    return count;
+}
+
+// Analysis thread. Forget whatever was queued before the spectrogram was (re)started.
+static inline void discardSamples(SampleRing& ring) {
+    ring.tail.store(ring.head.load(std::memory_order_acquire), std::memory_order_release);
+}
+
+// --- FFT ---
+struct FftPlan {
+    int size = 0;
+    std::vector<int> bitReverse;
+    std::vector<float> twiddleRe;       // stage with half-size h uses entries [h, 2h)
+    std::vector<float> twiddleIm;
+    std::vector<float> window;          // Hann
+};
+
+static inline void initFftPlan(FftPlan& plan, int size) {
+    plan.size = size;
+    int bits = 0;
+    while ((1 << bits) < size)
+        bits++;
+    plan.bitReverse.resize(size);
+    for (int i = 0; i < size; i++) {
+        int reversed = 0;
+        for (int b = 0; b < bits; b++)
+            reversed |= ((i >> b) & 1) << (bits - 1 - b);
+        plan.bitReverse[i] = reversed;
+    }
+    plan.twiddleRe.assign(size, 0.0f);
+    plan.twiddleIm.assign(size, 0.0f);
+    const double pi = 3.14159265358979323846;
+    for (int half = 1; half < size; half *= 2) {
+        for (int j = 0; j < half; j++) {
+            double angle = -pi * j / half;
+            plan.twiddleRe[half + j] = static_cast<float>(std::cos(angle));
+            plan.twiddleIm[half + j] = static_cast<float>(std::sin(angle));
+        }
+    }
+    plan.window.resize(size);
+    for (int i = 0; i < size; i++)
+        plan.window[i] = static_cast<float>(0.5 - 0.5 * std::cos(2.0 * pi * i / size));
+}
+
+// In-place forward transform; `re` and `im` hold plan.size values in natural order.
+static inline void fftInPlace(const FftPlan& plan, float* re, float* im) {
+    const int size = plan.size;
+    for (int i = 0; i < size; i++) {
+        int j = plan.bitReverse[i];
+        if (j > i) {
+            std::swap(re[i], re[j]);
+            std::swap(im[i], im[j]);
+        }
+    }
+    for (int half = 1; half < size; half *= 2) {
+        const float* wr = plan.twiddleRe.data() + half;
+        const float* wi = plan.twiddleIm.data() + half;
+        for (int start = 0; start < size; start += 2 * half) {
+            float* ar = re + start;
+            float* ai = im + start;
+            float* br = ar + half;
+            float* bi = ai + half;
+            int j = 0;
+#if defined(BWF_SSE2)
+            for (; j + 4 <= half; j += 4) {
+                __m128 xr = _mm_loadu_ps(br + j), xi = _mm_loadu_ps(bi + j);
+                __m128 cr = _mm_loadu_ps(wr + j), ci = _mm_loadu_ps(wi + j);
+                __m128 tr = _mm_sub_ps(_mm_mul_ps(xr, cr), _mm_mul_ps(xi, ci));
+                __m128 ti = _mm_add_ps(_mm_mul_ps(xr, ci), _mm_mul_ps(xi, cr));
+                __m128 yr = _mm_loadu_ps(ar + j), yi = _mm_loadu_ps(ai + j);
+                _mm_storeu_ps(br + j, _mm_sub_ps(yr, tr));
+                _mm_storeu_ps(bi + j, _mm_sub_ps(yi, ti));
+                _mm_storeu_ps(ar + j, _mm_add_ps(yr, tr));
+                _mm_storeu_ps(ai + j, _mm_add_ps(yi, ti));
+            }
+#elif defined(BWF_NEON)
+            for (; j + 4 <= half; j += 4) {
+                float32x4_t xr = vld1q_f32(br + j), xi = vld1q_f32(bi + j);
+                float32x4_t cr = vld1q_f32(wr + j), ci = vld1q_f32(wi + j);
+                float32x4_t tr = vsubq_f32(vmulq_f32(xr, cr), vmulq_f32(xi, ci));
+                float32x4_t ti = vaddq_f32(vmulq_f32(xr, ci), vmulq_f32(xi, cr));
+                float32x4_t yr = vld1q_f32(ar + j), yi = vld1q_f32(ai + j);
+                vst1q_f32(br + j, vsubq_f32(yr, tr));
+                vst1q_f32(bi + j, vsubq_f32(yi, ti));
+                vst1q_f32(ar + j, vaddq_f32(yr, tr));
+                vst1q_f32(ai + j, vaddq_f32(yi, ti));
+            }
+#endif
+            for (; j < half; j++) {
+                float tr = br[j] * wr[j] - bi[j] * wi[j];
+                float ti = br[j] * wi[j] + bi[j] * wr[j];
+                br[j] = ar[j] - tr;
+                bi[j] = ai[j] - ti;
+                ar[j] += tr;
+                ai[j] += ti;
+            }
+        }
+    }
+}
+
+// Window one block of plan.size samples, transform it and write plan.size / 2 levels. A full-scale
+// sine reads 255 in its bin; SPECTROGRAM_FLOOR_DB and below read 0.
+static inline void spectrumLevels(const FftPlan& plan, const float* samples, std::vector<float>& re,
+    std::vector<float>& im, unsigned char* levels) {
+    const int size = plan.size;
+    re.resize(size);
+    im.assign(size, 0.0f);
+    for (int i = 0; i < size; i++)
+        re[i] = samples[i] * plan.window[i];
+    fftInPlace(plan, re.data(), im.data());
+    // The Hann window halves the amplitude, and a real sine splits into two bins.
+    const float normalize = 4.0f / static_cast<float>(size);
+    for (int bin = 0; bin < size / 2; bin++) {
+        float magnitude = std::sqrt(re[bin] * re[bin] + im[bin] * im[bin]) * normalize;
+        float db = 20.0f * std::log10(magnitude + 1.0e-9f);
+        float level = (db - SPECTROGRAM_FLOOR_DB) * (255.0f / -SPECTROGRAM_FLOOR_DB);
+        levels[bin] = static_cast<unsigned char>(std::min(255.0f, std::max(0.0f, level)) + 0.5f);
+    }
+}
+
+// --- Analysis thread ---
+struct SpectrogramAnalyzer {
+    std::thread worker;
+    std::atomic<bool> stopping{ false };
+    std::atomic<bool> enabled{ false };            // the audio thread feeds the ring only while set
+    SampleRing ring;
+    std::mutex mutex;
+    std::vector<unsigned char> rows;               // SPECTROGRAM_HISTORY x SPECTROGRAM_BINS, guarded by mutex
+    unsigned long long rowsWritten = 0;            // guarded by mutex
+};
+
+// Audio thread: the only spectrogram work in the callback.
+static inline void pushSpectrogramSamples(SpectrogramAnalyzer& analyzer, const float* samples, size_t count) {
+    if (analyzer.enabled.load(std::memory_order_relaxed))
+        pushSamples(analyzer.ring, samples, count);
+}
+
+static inline void spectrogramMain(SpectrogramAnalyzer* analyzerPointer) {
+    SpectrogramAnalyzer& analyzer = *analyzerPointer;
+    FftPlan plan;
+    initFftPlan(plan, SPECTROGRAM_FFT_SIZE);
+    std::vector<float> pending, re, im;
+    std::vector<unsigned char> levels(SPECTROGRAM_BINS);
+    discardSamples(analyzer.ring);
+    while (!analyzer.stopping.load(std::memory_order_relaxed)) {
+        if (popSamples(analyzer.ring, pending, SPECTROGRAM_RING_SAMPLES) == 0) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            continue;
+        }
+        size_t offset = 0;
+        for (; offset + SPECTROGRAM_FFT_SIZE <= pending.size(); offset += SPECTROGRAM_HOP) {
+            spectrumLevels(plan, pending.data() + offset, re, im, levels.data());
+            std::lock_guard<std::mutex> lock(analyzer.mutex);
+            std::memcpy(analyzer.rows.data() + (analyzer.rowsWritten % SPECTROGRAM_HISTORY) * SPECTROGRAM_BINS,
+                levels.data(), SPECTROGRAM_BINS);
+            analyzer.rowsWritten++;
+        }
+        pending.erase(pending.begin(), pending.begin() + offset);
+    }
+}
+
+static inline void startSpectrogram(SpectrogramAnalyzer& analyzer) {
+    if (analyzer.worker.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(analyzer.mutex);
+        analyzer.rows.assign(static_cast<size_t>(SPECTROGRAM_HISTORY) * SPECTROGRAM_BINS, 0);
+    }
+    analyzer.stopping = false;
+    analyzer.worker = std::thread(spectrogramMain, &analyzer);
+    analyzer.enabled = true;
+}
+
+static inline void stopSpectrogram(SpectrogramAnalyzer& analyzer) {
+    analyzer.enabled = false;
+    if (!analyzer.worker.joinable())
+        return;
+    analyzer.stopping = true;
+    analyzer.worker.join();
+}
+
+// UI thread: copy the rows from index `first` on into `out` (SPECTROGRAM_BINS bytes each) and
+// return how many. If `first` has fallen out of the history it is moved up to the oldest kept row.
+static inline size_t takeSpectrogramRows(SpectrogramAnalyzer& analyzer, unsigned long long& first,
+    std::vector<unsigned char>& out) {
+    std::lock_guard<std::mutex> lock(analyzer.mutex);
+    if (analyzer.rowsWritten > SPECTROGRAM_HISTORY && first < analyzer.rowsWritten - SPECTROGRAM_HISTORY)
+        first = analyzer.rowsWritten - SPECTROGRAM_HISTORY;
+    if (first > analyzer.rowsWritten)
+        first = analyzer.rowsWritten;
+    size_t count = static_cast<size_t>(analyzer.rowsWritten - first);
+    out.resize(count * SPECTROGRAM_BINS);
+    for (size_t i = 0; i < count; i++) {
+        std::memcpy(out.data() + i * SPECTROGRAM_BINS,
+            analyzer.rows.data() + ((first + i) % SPECTROGRAM_HISTORY) * SPECTROGRAM_BINS, SPECTROGRAM_BINS);
+    }
+    return count;
+}
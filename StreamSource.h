@@ -0,0 +1,460 @@
+#pragma once
+// Live byte streams (stdin, named pipe, TCP, serial port) as a playback source.
+// A reader thread reads straight into a fixed-size circular history buffer, with no staging copy;
+// `received` counts every byte so far, so the live edge is at received % capacity. To the rest of
+// the player the history is a ByteView of `capacity` bytes, so wrapping and looping work unchanged
+// while old bytes are overwritten as new ones arrive. The renderers that keep frames or rows
+// resident by offset do not: before each redraw the UI drops whatever streamChangesBetween says
+// was written since the last one. Readers can see a region near the edge while it is being
+// written; that only shows as a torn row or sample, and a resident one is redrawn once complete.
+//
+// Specs: "-" or "stdin", "pipe:PATH" (a FIFO; on Windows the name under \\.\pipe\),
+// "tcp:HOST:PORT", "serial:PORT[@BAUD]" (COM3 or /dev/ttyUSB0, 115200 baud by default).
+// On Windows, include <winsock2.h> before <windows.h>.
+#include <atomic>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#ifdef _WIN32
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#include <windows.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <termios.h>
+#include <unistd.h>
+#endif
+
+static const size_t STREAM_DEFAULT_HISTORY_BYTES = 64u << 20;
+static const size_t STREAM_READ_BYTES = 64 << 10;      // largest single read, so the edge moves often
+static const int STREAM_POLL_MS = 100;                 // how long a read may block before stop is checked
+
+enum StreamKind {
+    STREAM_STDIN,
+    STREAM_PIPE,
+    STREAM_TCP,
+    STREAM_SERIAL
+};
+
+struct StreamSource {
+    std::string spec;
+    StreamKind kind = STREAM_STDIN;
+    std::vector<unsigned char> history;                 // allocated once; never resized while reading
+    std::atomic<unsigned long long> received{ 0 };       // total bytes read (the live edge)
+    std::atomic<bool> stopping{ false };
+    std::atomic<bool> ended{ false };                    // end of stream or read error; history stays
+    std::atomic<bool> finished{ false };                 // reader thread has returned
+    std::thread reader;
+#ifdef _WIN32
+    HANDLE handle = INVALID_HANDLE_VALUE;
+    SOCKET socket = INVALID_SOCKET;
+#else
+    int fd = -1;
+#endif
+};
+
+static inline bool isStreamSpec(const std::string& spec) {
+    return spec == "-" || spec == "stdin" || spec.compare(0, 5, "pipe:") == 0 || spec.compare(0, 4, "tcp:") == 0 ||
+        spec.compare(0, 7, "serial:") == 0;
+}
+
+static inline size_t streamCapacity(const StreamSource& stream) {
+    return stream.history.size();
+}
+
+// Offset of the next byte to arrive within the history.
+static inline size_t streamEdge(const StreamSource& stream) {
+    return static_cast<size_t>(stream.received.load(std::memory_order_acquire) % stream.history.size());
+}
+
+// Byte ranges of the history written while `received` went from `seen` to `received`, split
+// where the history wraps. A whole history or more comes back as [0, capacity).
+struct StreamChanges {
+    int count = 0;
+    size_t first[2] = { 0, 0 };
+    size_t end[2] = { 0, 0 };
+};
+
+static inline StreamChanges streamChangesBetween(unsigned long long seen, unsigned long long received, size_t capacity) {
+    StreamChanges changes;
+    if (received <= seen || capacity == 0)
+        return changes;
+    if (received - seen >= capacity) {
+        changes.count = 1;
+        changes.end[0] = capacity;
+        return changes;
+    }
+    size_t first = static_cast<size_t>(seen % capacity);
+    size_t end = static_cast<size_t>(received % capacity);
+    changes.first[0] = first;
+    changes.end[0] = first < end ? end : capacity;
+    changes.count = 1;
+    if (first >= end && end > 0) {
+        changes.end[1] = end;
+        changes.count = 2;
+    }
+    return changes;
+}
+
+// True if any byte of [first, end) is in one of the ranges.
+static inline bool streamChangesTouch(const StreamChanges& changes, size_t first, size_t end) {
+    for (int i = 0; i < changes.count; i++) {
+        if (first < changes.end[i] && changes.first[i] < end)
+            return true;
+    }
+    return false;
+}
+
+// --- Platform connection ---
+#ifdef _WIN32
+static inline bool initWinsock(void) {
+    static bool started = false;
+    WSADATA data;
+    if (!started)
+        started = WSAStartup(MAKEWORD(2, 2), &data) == 0;
+    return started;
+}
+#endif
+
+static inline bool openTcpStream(StreamSource& stream, const std::string& address) {
+    size_t colon = address.rfind(':');
+    if (colon == std::string::npos || colon == 0 || colon + 1 == address.size()) {
+        std::cerr << "Error: TCP stream needs HOST:PORT: " << address << std::endl;
+        return false;
+    }
+    std::string host = address.substr(0, colon), port = address.substr(colon + 1);
+#ifdef _WIN32
+    if (!initWinsock()) {
+        std::cerr << "Error: Winsock unavailable." << std::endl;
+        return false;
+    }
+#endif
+    addrinfo hints;
+    std::memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    addrinfo* results = nullptr;
+    if (getaddrinfo(host.c_str(), port.c_str(), &hints, &results) != 0) {
+        std::cerr << "Error: Could not resolve " << host << std::endl;
+        return false;
+    }
+    bool connected = false;
+    for (addrinfo* entry = results; entry && !connected; entry = entry->ai_next) {
+#ifdef _WIN32
+        SOCKET s = ::socket(entry->ai_family, entry->ai_socktype, entry->ai_protocol);
+        if (s == INVALID_SOCKET)
+            continue;
+        if (::connect(s, entry->ai_addr, static_cast<int>(entry->ai_addrlen)) == 0) {
+            DWORD timeout = STREAM_POLL_MS;
+            setsockopt(s, SOL_SOCKET, SO_RCVTIMEO, reinterpret_cast<const char*>(&timeout), sizeof(timeout));
+            stream.socket = s;
+            connected = true;
+        }
+        else {
+            closesocket(s);
+        }
+#else
+        int s = ::socket(entry->ai_family, entry->ai_socktype, entry->ai_protocol);
+        if (s < 0)
+            continue;
+        if (::connect(s, entry->ai_addr, entry->ai_addrlen) == 0) {
+            stream.fd = s;
+            connected = true;
+        }
+        else {
+            ::close(s);
+        }
+#endif
+    }
+    freeaddrinfo(results);
+    if (!connected)
+        std::cerr << "Error: Could not connect to " << address << std::endl;
+    return connected;
+}
+
+#ifndef _WIN32
+static inline bool serialBaudConstant(int baud, speed_t& speed) {
+    switch (baud) {
+    case 9600: speed = B9600; return true;
+    case 19200: speed = B19200; return true;
+    case 38400: speed = B38400; return true;
+    case 57600: speed = B57600; return true;
+    case 115200: speed = B115200; return true;
+    case 230400: speed = B230400; return true;
+#ifdef B460800
+    case 460800: speed = B460800; return true;
+#endif
+#ifdef B921600
+    case 921600: speed = B921600; return true;
+#endif
+    default: return false;
+    }
+}
+#endif
+
+static inline bool openSerialStream(StreamSource& stream, const std::string& target) {
+    std::string port = target;
+    int baud = 115200;
+    size_t at = target.rfind('@');
+    if (at != std::string::npos) {
+        port = target.substr(0, at);
+        baud = std::atoi(target.c_str() + at + 1);
+    }
+#ifdef _WIN32
+    std::string device = (port.compare(0, 4, "\\\\.\\") == 0) ? port : "\\\\.\\" + port;
+    stream.handle = CreateFileA(device.c_str(), GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+    if (stream.handle == INVALID_HANDLE_VALUE) {
+        std::cerr << "Error: Could not open serial port: " << port << std::endl;
+        return false;
+    }
+    DCB dcb;
+    std::memset(&dcb, 0, sizeof(dcb));
+    dcb.DCBlength = sizeof(dcb);
+    COMMTIMEOUTS timeouts;
+    std::memset(&timeouts, 0, sizeof(timeouts));
+    // Return as soon as anything arrives, or after STREAM_POLL_MS with nothing.
+    timeouts.ReadIntervalTimeout = MAXDWORD;
+    timeouts.ReadTotalTimeoutMultiplier = MAXDWORD;
+    timeouts.ReadTotalTimeoutConstant = STREAM_POLL_MS;
+    bool configured = GetCommState(stream.handle, &dcb) != 0;
+    if (configured) {
+        dcb.BaudRate = static_cast<DWORD>(baud);
+        dcb.ByteSize = 8;
+        dcb.Parity = NOPARITY;
+        dcb.StopBits = ONESTOPBIT;
+        configured = SetCommState(stream.handle, &dcb) && SetCommTimeouts(stream.handle, &timeouts);
+    }
+#else
+    speed_t speed;
+    if (!serialBaudConstant(baud, speed)) {
+        std::cerr << "Error: Unsupported baud rate: " << baud << std::endl;
+        return false;
+    }
+    stream.fd = ::open(port.c_str(), O_RDONLY | O_NOCTTY);
+    if (stream.fd < 0) {
+        std::cerr << "Error: Could not open serial port: " << port << std::endl;
+        return false;
+    }
+    termios options;
+    bool configured = tcgetattr(stream.fd, &options) == 0;
+    if (configured) {
+        cfmakeraw(&options);
+        cfsetispeed(&options, speed);
+        cfsetospeed(&options, speed);
+        options.c_cflag |= CLOCAL | CREAD;
+        configured = tcsetattr(stream.fd, TCSANOW, &options) == 0;
+    }
+#endif
+    if (!configured)
+        std::cerr << "Error: Could not configure serial port: " << port << std::endl;
+    return configured;
+}
+
+static inline bool openStreamConnection(StreamSource& stream) {
+    const std::string& spec = stream.spec;
+    if (spec == "-" || spec == "stdin") {
+        stream.kind = STREAM_STDIN;
+#ifdef _WIN32
+        stream.handle = GetStdHandle(STD_INPUT_HANDLE);
+        return stream.handle != INVALID_HANDLE_VALUE && stream.handle != NULL;
+#else
+        stream.fd = STDIN_FILENO;
+        return true;
+#endif
+    }
+    if (spec.compare(0, 5, "pipe:") == 0) {
+        stream.kind = STREAM_PIPE;
+        std::string path = spec.substr(5);
+#ifdef _WIN32
+        if (path.compare(0, 4, "\\\\.\\") != 0)
+            path = "\\\\.\\pipe\\" + path;
+        stream.handle = CreateFileA(path.c_str(), GENERIC_READ, 0, NULL, OPEN_EXISTING, 0, NULL);
+        bool opened = stream.handle != INVALID_HANDLE_VALUE;
+#else
+        // Blocks until a writer opens the FIFO.
+        stream.fd = ::open(path.c_str(), O_RDONLY);
+        bool opened = stream.fd >= 0;
+#endif
+        if (!opened)
+            std::cerr << "Error: Could not open pipe: " << path << std::endl;
+        return opened;
+    }
+    if (spec.compare(0, 4, "tcp:") == 0) {
+        stream.kind = STREAM_TCP;
+        return openTcpStream(stream, spec.substr(4));
+    }
+    if (spec.compare(0, 7, "serial:") == 0) {
+        stream.kind = STREAM_SERIAL;
+        return openSerialStream(stream, spec.substr(7));
+    }
+    std::cerr << "Error: Unknown stream: " << spec << " (use -, pipe:PATH, tcp:HOST:PORT or serial:PORT[@BAUD])" << std::endl;
+    return false;
+}
+
+static inline void closeStreamConnection(StreamSource& stream) {
+#ifdef _WIN32
+    if (stream.socket != INVALID_SOCKET)
+        closesocket(stream.socket);
+    if (stream.handle != INVALID_HANDLE_VALUE && stream.kind != STREAM_STDIN)
+        CloseHandle(stream.handle);
+    stream.socket = INVALID_SOCKET;
+    stream.handle = INVALID_HANDLE_VALUE;
+#else
+    if (stream.fd >= 0 && stream.kind != STREAM_STDIN)
+        ::close(stream.fd);
+    stream.fd = -1;
+#endif
+}
+
+// Read up to `count` bytes into `dst`. Returns the byte count, 0 if nothing arrived within
+// STREAM_POLL_MS, or -1 at the end of the stream or on an error.
+static inline long long readStreamBytes(StreamSource& stream, unsigned char* dst, size_t count) {
+#ifdef _WIN32
+    if (stream.kind == STREAM_TCP) {
+        int got = recv(stream.socket, reinterpret_cast<char*>(dst), static_cast<int>(count), 0);
+        if (got == SOCKET_ERROR)
+            return WSAGetLastError() == WSAETIMEDOUT ? 0 : -1;
+        return got > 0 ? got : -1;
+    }
+    DWORD got = 0;
+    if (!ReadFile(stream.handle, dst, static_cast<DWORD>(count), &got, NULL))
+        return GetLastError() == ERROR_OPERATION_ABORTED ? 0 : -1;
+    // Serial reads time out with zero bytes; for pipes and stdin zero bytes is the end.
+    if (got == 0)
+        return stream.kind == STREAM_SERIAL ? 0 : -1;
+    return static_cast<long long>(got);
+#else
+    pollfd entry;
+    entry.fd = stream.fd;
+    entry.events = POLLIN;
+    entry.revents = 0;
+    int ready = poll(&entry, 1, STREAM_POLL_MS);
+    if (ready == 0)
+        return 0;
+    if (ready < 0)
+        return -1;
+    ssize_t got = ::read(stream.fd, dst, count);
+    return got > 0 ? static_cast<long long>(got) : -1;
+#endif
+}
+
+// --- Reader thread ---
+static inline void streamReaderMain(StreamSource* streamPointer) {
+    StreamSource& stream = *streamPointer;
+    const size_t capacity = stream.history.size();
+    while (!stream.stopping.load(std::memory_order_relaxed)) {
+        unsigned long long received = stream.received.load(std::memory_order_relaxed);
+        size_t offset = static_cast<size_t>(received % capacity);
+        size_t room = capacity - offset;
+        long long got = readStreamBytes(stream, stream.history.data() + offset,
+            room < STREAM_READ_BYTES ? room : STREAM_READ_BYTES);
+        if (got < 0) {
+            stream.ended = true;
+            break;
+        }
+        stream.received.store(received + static_cast<unsigned long long>(got), std::memory_order_release);
+    }
+    stream.finished = true;
+}
+
+// Connect and start reading into a zeroed history of `historyBytes`.
+static inline bool startStreamSource(StreamSource& stream, const std::string& spec, size_t historyBytes) {
+    stream.spec = spec;
+    if (historyBytes == 0 || !openStreamConnection(stream)) {
+        closeStreamConnection(stream);
+        return false;
+    }
+    stream.history.assign(historyBytes, 0);
+    stream.received = 0;
+    stream.stopping = false;
+    stream.ended = false;
+    stream.finished = false;
+    stream.reader = std::thread(streamReaderMain, &stream);
+    return true;
+}
+
+static inline void stopStreamSource(StreamSource& stream) {
+    if (stream.reader.joinable()) {
+        stream.stopping = true;
+#ifdef _WIN32
+        // Pipe and console reads have no timeout; cancel until the reader notices.
+        while (!stream.finished.load()) {
+            CancelSynchronousIo(stream.reader.native_handle());
+            Sleep(10);
+        }
+#endif
+        stream.reader.join();
+    }
+    closeStreamConnection(stream);
+}
+
+// --- Following the live edge ---
+// The UI keeps the playhead `latencySeconds` of arriving data behind the edge. With audio running
+// it steers the speed (arrival rate plus a correction that closes the gap in about
+// STREAM_CATCHUP_SECONDS) so playback stays continuous; a gap that is too large, or a playhead that
+// has run past the edge, is fixed with a jump instead.
+static const double STREAM_RATE_SMOOTHING_SECONDS = 1.0;
+static const double STREAM_CATCHUP_SECONDS = 1.0;
+static const double STREAM_JUMP_SECONDS = 2.0;
+static const double STREAM_MAX_MULTIPLIER = 64.0;
+
+struct StreamFollower {
+    double latencySeconds = 0.5;
+    double rate = 0.0;                  // arriving bytes per second, smoothed
+    unsigned long long lastReceived = 0;
+    double lastTime = -1.0;
+};
+
+static inline void measureStreamRate(StreamFollower& follower, const StreamSource& stream, double now) {
+    unsigned long long received = stream.received.load(std::memory_order_acquire);
+    if (follower.lastTime < 0.0) {
+        follower.lastTime = now;
+        follower.lastReceived = received;
+        return;
+    }
+    double elapsed = now - follower.lastTime;
+    if (elapsed < 0.05)
+        return;
+    double instant = static_cast<double>(received - follower.lastReceived) / elapsed;
+    double blend = elapsed < STREAM_RATE_SMOOTHING_SECONDS ? elapsed / STREAM_RATE_SMOOTHING_SECONDS : 1.0;
+    follower.rate += (instant - follower.rate) * blend;
+    follower.lastTime = now;
+    follower.lastReceived = received;
+}
+
+// Bytes the playhead should trail the edge by: the latency target at the measured rate, but at
+// least `minimumBytes` (one frame) so there is always something complete to show.
+static inline double streamTargetLag(const StreamFollower& follower, double minimumBytes) {
+    double lag = follower.latencySeconds * follower.rate;
+    return lag > minimumBytes ? lag : minimumBytes;
+}
+
+// Bytes between `position` and the live edge, in [0, capacity).
+static inline double streamLag(const StreamSource& stream, double position) {
+    double capacity = static_cast<double>(stream.history.size());
+    double lag = std::fmod(static_cast<double>(streamEdge(stream)) - position, capacity);
+    return lag < 0.0 ? lag + capacity : lag;
+}
+
+static inline bool streamNeedsJump(const StreamFollower& follower, const StreamSource& stream, double lag,
+    double target, double nominalRate) {
+    double fastest = follower.rate > nominalRate ? follower.rate : nominalRate;
+    return lag > static_cast<double>(stream.history.size()) / 2.0 || lag > target + STREAM_JUMP_SECONDS * fastest;
+}
+
+// Speed (as a multiplier of `nominalRate`, the bytes per second played at 1x) that matches the
+// arrival rate and pulls the lag towards `target`.
+static inline double streamFollowMultiplier(const StreamFollower& follower, double lag, double target, double nominalRate) {
+    double speed = (follower.rate + (lag - target) / STREAM_CATCHUP_SECONDS) / nominalRate;
+    if (speed < 0.0)
+        return 0.0;
+    return speed > STREAM_MAX_MULTIPLIER ? STREAM_MAX_MULTIPLIER : speed;
+}
@@ -0,0 +1,156 @@
+#pragma once
+// Fixed-size work-stealing worker pool. submit() returns a future so callers can bound the number
+// of jobs in flight and consume results in order.
+// Each worker owns a deque: outside submissions are dealt round-robin across them, a task submitted
+// from a worker goes onto that worker's own deque, owners pop the newest task and idle workers
+// steal the oldest from the others. parallelFor splits a range into tasks and waits for them; it
+// must not be called from inside a pool task.
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class ThreadPool {
+public:
+    explicit ThreadPool(unsigned threadCount) {
+        if (threadCount == 0)
+            threadCount = 1;
+        queues_.reset(new WorkQueue[threadCount]);
+        queueCount_ = threadCount;
+        for (unsigned i = 0; i < threadCount; i++)
+            workers_.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            stopping_ = true;
+        }
+        wake_.notify_all();
+        for (std::thread& worker : workers_)
+            worker.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned size() const { return static_cast<unsigned>(workers_.size()); }
+
+    template <typename Function>
+    std::future<void> submit(Function&& function) {
+        std::shared_ptr<std::packaged_task<void()>> task =
+            std::make_shared<std::packaged_task<void()>>(std::forward<Function>(function));
+        std::future<void> result = task->get_future();
+        push([task] { (*task)(); });
+        return result;
+    }
+
+    // Runs function(begin, end) over [0, count) in chunks of at most `grain` items.
+    template <typename Function>
+    void parallelFor(size_t count, size_t grain, Function function) {
+        if (grain == 0)
+            grain = 1;
+        std::vector<std::future<void>> pending;
+        pending.reserve((count + grain - 1) / grain);
+        for (size_t begin = 0; begin < count; begin += grain) {
+            size_t end = (begin + grain < count) ? begin + grain : count;
+            pending.push_back(submit([&function, begin, end] { function(begin, end); }));
+        }
+        for (std::future<void>& done : pending)
+            done.get();
+    }
+
+    // Default worker count: one per hardware thread.
+    static unsigned defaultThreadCount() {
+        unsigned count = std::thread::hardware_concurrency();
+        return count ? count : 4;
+    }
+
+private:
+    struct WorkQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    // The pool and worker index of the calling thread (null outside pool workers).
+    static const ThreadPool*& currentPool() {
+        static thread_local const ThreadPool* pool = nullptr;
+        return pool;
+    }
+    static unsigned& currentWorker() {
+        static thread_local unsigned worker = 0;
+        return worker;
+    }
+
+    void push(std::function<void()> task) {
+        unsigned index = (currentPool() == this) ? currentWorker()
+            : nextQueue_.fetch_add(1, std::memory_order_relaxed) % queueCount_;
+        {
+            std::lock_guard<std::mutex> lock(queues_[index].mutex);
+            queues_[index].tasks.push_back(std::move(task));
+        }
+        {
+            // Counted under the wake mutex so a worker about to sleep cannot miss it.
+            std::lock_guard<std::mutex> lock(wakeMutex_);
+            pending_++;
+        }
+        wake_.notify_one();
+    }
+
+    bool tryPop(unsigned self, std::function<void()>& task) {
+        {
+            WorkQueue& own = queues_[self];
+            std::lock_guard<std::mutex> lock(own.mutex);
+            if (!own.tasks.empty()) {
+                task = std::move(own.tasks.back());
+                own.tasks.pop_back();
+                return true;
+            }
+        }
+        for (unsigned k = 1; k < queueCount_; k++) {
+            WorkQueue& victim = queues_[(self + k) % queueCount_];
+            std::lock_guard<std::mutex> lock(victim.mutex);
+            if (!victim.tasks.empty()) {
+                task = std::move(victim.tasks.front());
+                victim.tasks.pop_front();
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void workerLoop(unsigned self) {
+        currentPool() = this;
+        currentWorker() = self;
+        for (;;) {
+            std::function<void()> task;
+            if (tryPop(self, task)) {
+                {
+                    std::lock_guard<std::mutex> lock(wakeMutex_);
+                    pending_--;
+                }
+                task();
+                continue;
+            }
+            std::unique_lock<std::mutex> lock(wakeMutex_);
+            wake_.wait(lock, [this] { return stopping_ || pending_ > 0; });
+            if (stopping_ && pending_ == 0)
+                return;
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::unique_ptr<WorkQueue[]> queues_;
+    unsigned queueCount_ = 0;
+    std::atomic<unsigned> nextQueue_{ 0 };
+    std::mutex wakeMutex_;
+    std::condition_variable wake_;
+    size_t pending_ = 0;   // queued tasks not yet taken, guarded by wakeMutex_
+    bool stopping_ = false;
+};
@@ -0,0 +1,24 @@
+#pragma once
+// Scheduling boost for threads the audio thread depends on (the prefetch I/O thread), so a busy
+// render loop or background scan does not delay them. On Windows this is a thread priority; on
+// POSIX a low SCHED_FIFO priority, which needs rtprio rights (the JACK group on most audio
+// setups). Without them the thread quietly keeps its normal priority.
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+const int THREAD_FIFO_PRIORITY = 10;   // well below JACK's own RT threads (70 and up by default)
+
+// Applies to the calling thread. Returns false if the system refused.
+static inline bool raiseThreadPriority(void) {
+#ifdef _WIN32
+    return SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_ABOVE_NORMAL) != 0;
+#else
+    sched_param param = {};
+    param.sched_priority = THREAD_FIFO_PRIORITY;
+    return pthread_setschedparam(pthread_self(), SCHED_FIFO, &param) == 0;
+#endif
+}
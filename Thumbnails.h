@@ -0,0 +1,301 @@
+#pragma once
+// Thumbnails for the filmstrip along the bottom of the window (T) and the hover preview.
+// The strip is centered on the playhead: the THUMBNAIL_FINE_SLOTS slots each side of it are one
+// frame apart, and further out the offsets grow with a power curve to the first and last frame, so
+// the middle shows where playback is going and the edges reach across the whole file. The slots
+// in between are rounded to a coarser grid the further out they are, so they keep the same frames
+// (and stay cached) while the playhead moves.
+// A thumbnail is THUMBNAIL_SIZE texels on its long side and shows the frame's byte values through
+// the palette, as Indexed8 does, whatever the pixel format. Slots near the playhead are box
+// filtered from the mapping: at most THUMBNAIL_ROW_SAMPLES source rows per thumbnail row are added
+// into 16-bit column sums, 16 columns per instruction (SSE2 or NEON), then summed across each box
+// (bench thumbnail/box-*). Outer slots of frames that span several overview blocks per thumbnail
+// row are banded from the overview index's block means instead, without touching the file. Both
+// run on a ThreadPool behind a request queue the UI refills every redraw, most important first;
+// the render thread only uploads finished ones.
+#include "MappedFile.h"
+#include "OverviewIndex.h"
+#include "Simd.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+const int THUMBNAIL_SIZE = 64;               // texels on the long side
+const int THUMBNAIL_ROW_SAMPLES = 8;         // source rows read per thumbnail row at most
+const int THUMBNAIL_FINE_SLOTS = 3;          // slots each side of the playhead never banded or rounded
+const double THUMBNAIL_STRIP_CURVE = 2.5;    // offset growth toward the strip edges
+const size_t THUMBNAIL_BATCH = 32;           // requests taken per pool pass
+const size_t NO_THUMBNAIL = static_cast<size_t>(-1);
+
+// A request or atlas entry: frame << 1, plus 1 for a thumbnail banded from the overview.
+static inline uint64_t thumbnailKey(size_t frame, bool coarse) {
+    return static_cast<uint64_t>(frame) << 1 | (coarse ? 1u : 0u);
+}
+
+static inline size_t thumbnailKeyFrame(uint64_t key) {
+    return static_cast<size_t>(key >> 1);
+}
+
+// How a frame is cut into thumbnail texels: `rows` rows of `frameWidth` bytes.
+struct ThumbnailShape {
+    int frameWidth = 0;
+    size_t rows = 0;
+    size_t frameBytes = 0;
+    int width = 0;
+    int height = 0;
+};
+
+static inline ThumbnailShape chooseThumbnailShape(int frameWidth, size_t frameBytes) {
+    ThumbnailShape shape;
+    shape.frameWidth = frameWidth;
+    shape.frameBytes = frameBytes;
+    shape.rows = frameWidth > 0 ? frameBytes / static_cast<size_t>(frameWidth) : 0;
+    if (shape.rows == 0)
+        return shape;
+    if (static_cast<size_t>(frameWidth) >= shape.rows) {
+        shape.width = std::min(frameWidth, THUMBNAIL_SIZE);
+        shape.height = static_cast<int>(std::max<size_t>(1, shape.rows * shape.width / frameWidth));
+    }
+    else {
+        shape.height = static_cast<int>(std::min<size_t>(shape.rows, THUMBNAIL_SIZE));
+        shape.width = static_cast<int>(std::max<size_t>(1, frameWidth * static_cast<size_t>(shape.height) / shape.rows));
+    }
+    return shape;
+}
+
+// --- Strip layout ---
+// The frame of each of `count` slots (count odd; the middle one is `playFrame`), or NO_THUMBNAIL for
+// a slot past the start or end of the file.
+static inline void thumbnailStripFrames(size_t playFrame, size_t totalFrames, int count, std::vector<size_t>& frames) {
+    frames.assign(static_cast<size_t>(std::max(count, 1)), NO_THUMBNAIL);
+    if (totalFrames == 0 || count < 1)
+        return;
+    const int middle = count / 2;
+    playFrame = std::min(playFrame, totalFrames - 1);
+    frames[middle] = playFrame;
+    for (int side = -1; side <= 1; side += 2) {
+        const size_t span = side < 0 ? playFrame : totalFrames - 1 - playFrame;
+        for (int k = 1; k <= middle; k++) {
+            size_t offset = static_cast<size_t>(k);
+            if (k > THUMBNAIL_FINE_SLOTS && span > static_cast<size_t>(THUMBNAIL_FINE_SLOTS)) {
+                double t = static_cast<double>(k - THUMBNAIL_FINE_SLOTS) / (middle - THUMBNAIL_FINE_SLOTS);
+                offset = std::max(offset, THUMBNAIL_FINE_SLOTS + static_cast<size_t>(std::llround(
+                    static_cast<double>(span - THUMBNAIL_FINE_SLOTS) * std::pow(t, THUMBNAIL_STRIP_CURVE))));
+            }
+            if (offset > span)
+                continue;
+            size_t frame = side < 0 ? playFrame - offset : playFrame + offset;
+            if (k > THUMBNAIL_FINE_SLOTS && k < middle) {
+                size_t grid = 1;
+                while (grid * 16 <= offset)
+                    grid *= 2;
+                frame -= frame % grid;
+            }
+            frames[middle + side * k] = frame;
+        }
+    }
+}
+
+// --- Building ---
+// sums[x] += row[x] for the `width` bytes of one source row, 16 columns per instruction. Rows are
+// added whole, in memory order, so the reads stream through the frame.
+static inline void addThumbnailRow(const unsigned char* row, int width, uint16_t* sums) {
+    int x = 0;
+#if defined(BWF_SSE2)
+    const __m128i zero = _mm_setzero_si128();
+    for (; x + 16 <= width; x += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x));
+        __m128i* out = reinterpret_cast<__m128i*>(sums + x);
+        _mm_storeu_si128(out, _mm_add_epi16(_mm_loadu_si128(out), _mm_unpacklo_epi8(v, zero)));
+        _mm_storeu_si128(out + 1, _mm_add_epi16(_mm_loadu_si128(out + 1), _mm_unpackhi_epi8(v, zero)));
+    }
+#elif defined(BWF_NEON)
+    for (; x + 16 <= width; x += 16) {
+        uint8x16_t v = vld1q_u8(row + x);
+        vst1q_u16(sums + x, vaddw_u8(vld1q_u16(sums + x), vget_low_u8(v)));
+        vst1q_u16(sums + x + 8, vaddw_u8(vld1q_u16(sums + x + 8), vget_high_u8(v)));
+    }
+#endif
+    for (; x < width; x++)
+        sums[x] = static_cast<uint16_t>(sums[x] + row[x]);
+}
+
+// Mean of each `shape.width` x `shape.height` box of the frame at `frame` into `pixels`. Fewer than
+// 2 * THUMBNAIL_ROW_SAMPLES rows are sampled per box, so a column sum fits in 16 bits and a box
+// (under a million bytes wide) in 32.
+static inline void boxFilterThumbnail(const unsigned char* frame, const ThumbnailShape& shape, unsigned char* pixels) {
+    std::vector<uint16_t> sums(static_cast<size_t>(shape.frameWidth));
+    for (int ty = 0; ty < shape.height; ty++) {
+        size_t first = static_cast<size_t>(ty) * shape.rows / shape.height;
+        size_t last = std::max(first + 1, static_cast<size_t>(ty + 1) * shape.rows / shape.height);
+        size_t step = std::max<size_t>(1, (last - first) / THUMBNAIL_ROW_SAMPLES);
+        std::fill(sums.begin(), sums.end(), static_cast<uint16_t>(0));
+        uint32_t sampled = 0;
+        for (size_t row = first; row < last; row += step, sampled++)
+            addThumbnailRow(frame + row * static_cast<size_t>(shape.frameWidth), shape.frameWidth, sums.data());
+        for (int tx = 0; tx < shape.width; tx++) {
+            int left = tx * shape.frameWidth / shape.width;
+            int right = std::max(left + 1, (tx + 1) * shape.frameWidth / shape.width);
+            uint32_t total = 0;
+            for (int x = left; x < right; x++)
+                total += sums[x];
+            uint32_t count = static_cast<uint32_t>(right - left) * sampled;
+            pixels[ty * shape.width + tx] = static_cast<unsigned char>((total + count / 2) / count);
+        }
+    }
+}
+
+// Level-0 block means of an overview index, for banded thumbnails.
+static inline std::vector<unsigned char> overviewBlockMeans(const OverviewIndex& index) {
+    std::vector<unsigned char> means;
+    if (index.empty())
+        return means;
+    means.reserve(index.levels[0].blocks.size());
+    for (const OverviewBlock& block : index.levels[0].blocks)
+        means.push_back(block.mean);
+    return means;
+}
+
+// Banding is only worth it when each thumbnail row spans whole overview blocks.
+static inline bool thumbnailsUseOverview(const ThumbnailShape& shape, size_t blockSize) {
+    return blockSize > 0 && shape.height > 0 && shape.frameBytes / static_cast<size_t>(shape.height) >= blockSize;
+}
+
+// One thumbnail row per band of the frame at byte `offset`, each the mean of the blocks it covers.
+static inline void bandThumbnail(const std::vector<unsigned char>& means, size_t blockSize, size_t offset,
+    const ThumbnailShape& shape, unsigned char* pixels) {
+    for (int ty = 0; ty < shape.height; ty++) {
+        size_t first = (offset + static_cast<size_t>(ty) * shape.frameBytes / shape.height) / blockSize;
+        size_t last = (offset + static_cast<size_t>(ty + 1) * shape.frameBytes / shape.height + blockSize - 1) / blockSize;
+        first = std::min(first, means.size() - 1);
+        last = std::min(std::max(last, first + 1), means.size());
+        unsigned total = 0;
+        for (size_t block = first; block < last; block++)
+            total += means[block];
+        unsigned count = static_cast<unsigned>(last - first);
+        std::fill(pixels + ty * shape.width, pixels + (ty + 1) * shape.width,
+            static_cast<unsigned char>((total + count / 2) / count));
+    }
+}
+
+// --- Background builder ---
+// What thumbnails are made of. The view must stay mapped until the builder is stopped.
+struct ThumbnailSource {
+    ByteView view;
+    ThumbnailShape shape;
+    std::shared_ptr<const std::vector<unsigned char>> blockMeans;   // null: no overview yet
+    size_t blockSize = 0;
+};
+
+struct Thumbnail {
+    uint64_t key = 0;
+    std::vector<unsigned char> pixels;      // shape.width x shape.height
+};
+
+struct ThumbnailBuilder {
+    std::thread worker;
+    ThumbnailSource source;                 // fixed while the worker runs
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;                  // guarded by mutex
+    std::vector<uint64_t> queue;            // guarded by mutex; most important first
+    std::vector<uint64_t> building;         // guarded by mutex; the batch in the pool
+    std::vector<Thumbnail> done;            // guarded by mutex
+};
+
+static inline void makeThumbnail(const ThumbnailSource& source, uint64_t key, Thumbnail& out) {
+    const ThumbnailShape& shape = source.shape;
+    size_t offset = thumbnailKeyFrame(key) * shape.frameBytes;
+    out.key = key;
+    out.pixels.resize(static_cast<size_t>(shape.width) * shape.height);
+    if ((key & 1) && source.blockMeans && !source.blockMeans->empty())
+        bandThumbnail(*source.blockMeans, source.blockSize, offset, shape, out.pixels.data());
+    else
+        boxFilterThumbnail(source.view.data() + offset, shape, out.pixels.data());
+}
+
+static inline void thumbnailWorkerMain(ThumbnailBuilder* builderPointer) {
+    ThumbnailBuilder& builder = *builderPointer;
+    ThreadPool pool(ThreadPool::defaultThreadCount());
+    std::vector<uint64_t> batch;
+    std::vector<Thumbnail> made;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(builder.mutex);
+            builder.building.clear();
+            builder.wake.wait(lock, [&]() { return builder.stopping || !builder.queue.empty(); });
+            if (builder.stopping)
+                return;
+            size_t take = std::min(builder.queue.size(), THUMBNAIL_BATCH);
+            batch.assign(builder.queue.begin(), builder.queue.begin() + static_cast<long>(take));
+            builder.queue.erase(builder.queue.begin(), builder.queue.begin() + static_cast<long>(take));
+            builder.building = batch;
+        }
+        made.assign(batch.size(), Thumbnail());
+        pool.parallelFor(batch.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+                makeThumbnail(builder.source, batch[i], made[i]);
+        });
+        std::lock_guard<std::mutex> lock(builder.mutex);
+        for (Thumbnail& thumbnail : made)
+            builder.done.push_back(std::move(thumbnail));
+    }
+}
+
+static inline void stopThumbnails(ThumbnailBuilder& builder) {
+    if (builder.worker.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(builder.mutex);
+            builder.stopping = true;
+        }
+        builder.wake.notify_all();
+        builder.worker.join();
+    }
+    builder.stopping = false;
+    builder.queue.clear();
+    builder.building.clear();
+    builder.done.clear();
+    builder.source = ThumbnailSource();
+}
+
+static inline void startThumbnails(ThumbnailBuilder& builder, const ThumbnailSource& source) {
+    stopThumbnails(builder);
+    builder.source = source;
+    if (source.view.empty() || source.shape.width <= 0 || source.view.size() < source.shape.frameBytes)
+        return;
+    builder.worker = std::thread(thumbnailWorkerMain, &builder);
+}
+
+static inline bool thumbnailsRunning(const ThumbnailBuilder& builder) {
+    return builder.worker.joinable();
+}
+
+// Replace the queue with `keys` (most important first), skipping those already in the pool.
+static inline void requestThumbnails(ThumbnailBuilder& builder, const std::vector<uint64_t>& keys) {
+    if (!builder.worker.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(builder.mutex);
+        builder.queue.clear();
+        for (uint64_t key : keys) {
+            if (std::find(builder.building.begin(), builder.building.end(), key) == builder.building.end())
+                builder.queue.push_back(key);
+        }
+        if (builder.queue.empty())
+            return;
+    }
+    builder.wake.notify_one();
+}
+
+// Move the thumbnails finished since the last call into `out`.
+static inline void pollThumbnails(ThumbnailBuilder& builder, std::vector<Thumbnail>& out) {
+    out.clear();
+    std::lock_guard<std::mutex> lock(builder.mutex);
+    out.swap(builder.done);
+}
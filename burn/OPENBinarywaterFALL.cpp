@@ -7,6 +7,7 @@
 #include <string>
 #include <cmath>
 #include <jack/jack.h>
+#include "../Palette.h"
 
 // Configuration constants
 #define FRAME_WIDTH 455
@@ -310,25 +311,12 @@ void renderFrame(GLFWwindow* window) {
     float pixelWidth = (float)windowWidth / FRAME_WIDTH;
     float pixelHeight = (float)windowHeight / FRAME_HEIGHT;
     size_t frameOffset = frameIndex * bytesPerFrame;
+    const PaletteLUT& palette = getPalette(PALETTE_RAINBOW);
     glClear(GL_COLOR_BUFFER_BIT);
     glBegin(GL_QUADS);
     for (int y = 0; y < FRAME_HEIGHT; y++) {
         for (int x = 0; x < FRAME_WIDTH; x++) {
-            unsigned char value = fileData[frameOffset + y * FRAME_WIDTH + x];
-            const struct { float r, g, b; } rainbow[18] = {
-                {1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 1.0f},
-                {1.0f, 0.0f, 1.0f}, {0.0f, 1.0f, 1.0f}, {1.0f, 1.0f, 0.0f},
-                {1.0f, 0.75f, 0.8f}, {0.5f, 1.0f, 0.0f}, {0.0f, 0.75f, 1.0f},
-                {0.76f, 0.7f, 0.0f}, {0.9f, 0.3f, 0.0f}, {0.58f, 0.0f, 0.83f},
-                {0.29f, 0.0f, 0.51f}, {0.0f, 0.42f, 0.5f}, {0.0f, 1.0f, 0.5f},
-                {0.42f, 0.56f, 0.14f}, {1.0f, 0.65f, 0.0f}, {0.4f, 0.0f, 1.0f}
-            };
-            int colorIndex = (value / 14) % 18;
-            float intensity = ((value % 14) + 1) / 14.0f;
-            float r = rainbow[colorIndex].r * intensity;
-            float g = rainbow[colorIndex].g * intensity;
-            float b = rainbow[colorIndex].b * intensity;
-            glColor3f(r, g, b);
+            glColor4ubv(palette.rgba[fileData[frameOffset + y * FRAME_WIDTH + x]]);
             float x1 = x * pixelWidth, y1 = y * pixelHeight;
             float x2 = (x + 1) * pixelWidth, y2 = (y + 1) * pixelHeight;
             glVertex2f(x1, y1); glVertex2f(x2, y1);
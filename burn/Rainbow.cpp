@@ -7,6 +7,7 @@
 #include <string>
 #include <chrono>
 #include <thread>
+#include "../Palette.h"
 
 // Configuration constants
 #define FRAME_WIDTH 128
@@ -121,52 +122,15 @@ void renderFrame(GLFWwindow* window) {
     // Clear the screen
     glClear(GL_COLOR_BUFFER_BIT);
 
+    // 18-color rainbow lookup table (shared with the other players)
+    const PaletteLUT& palette = getPalette(PALETTE_RAINBOW);
+
     // Draw the frame pixel by pixel
     glBegin(GL_QUADS);
     for (int y = 0; y < FRAME_HEIGHT; y++) {
         for (int x = 0; x < FRAME_WIDTH; x++) {
-            // Get pixel value from file data
-            unsigned char value = fileData[frameOffset + y * FRAME_WIDTH + x];
-
             // Map raw byte value to one of 18 colors with 14 intensity levels
-            // Define the 18 rainbow colors
-            const struct {
-                float r, g, b;
-            } rainbow[18] = {
-                {1.0f, 0.0f, 0.0f},     // Red
-                {0.0f, 1.0f, 0.0f},     // Lime
-                {0.0f, 0.0f, 1.0f},     // Blue
-                {1.0f, 0.0f, 1.0f},     // Magenta
-                {0.0f, 1.0f, 1.0f},     // Cyan
-                {1.0f, 1.0f, 0.0f},     // Yellow
-                {1.0f, 0.75f, 0.8f},    // Pink
-                {0.5f, 1.0f, 0.0f},     // Chartreuse
-                {0.0f, 0.75f, 1.0f},    // Cerulean
-                {0.76f, 0.7f, 0.0f},    // Mustard
-                {0.9f, 0.3f, 0.0f},     // Infrared (approximation)
-                {0.58f, 0.0f, 0.83f},   // Violet
-                {0.29f, 0.0f, 0.51f},   // Indigo
-                {0.0f, 0.42f, 0.5f},    // Thalo
-                {0.0f, 1.0f, 0.5f},     // Mint
-                {0.42f, 0.56f, 0.14f},  // Camo
-                {1.0f, 0.65f, 0.0f},    // Orange
-                {0.4f, 0.0f, 1.0f}      // Ultraviolet (approximation)
-            };
-
-            // Calculate color index and intensity
-            // Split the 256 possible values into 18 colors x 14 intensities
-            // (Note: 18*14=252, so the last 4 values will wrap)
-
-            int colorIndex = (value / 14) % 18;  // Color cycles every 14 values
-            float intensity = (value % 14 + 1) / 14.0f;  // Intensity from 1/14 to 14/14
-
-            // Get base color and apply intensity
-            float r = rainbow[colorIndex].r * intensity;
-            float g = rainbow[colorIndex].g * intensity;
-            float b = rainbow[colorIndex].b * intensity;
-
-            // Set the color for this pixel
-            glColor3f(r, g, b);
+            glColor4ubv(palette.rgba[fileData[frameOffset + y * FRAME_WIDTH + x]]);
 
             // Calculate pixel coordinates in the window
             float x1 = x * pixelWidth;
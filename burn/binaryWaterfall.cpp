@@ -7,6 +7,7 @@
 #include <string>
 #include <chrono>
 #include <thread>
+#include "../Palette.h"
 
 // Configuration constants
 #define FRAME_WIDTH 64
@@ -111,39 +112,15 @@ void renderFrame(GLFWwindow* window) {
     // Clear the screen
     glClear(GL_COLOR_BUFFER_BIT);
 
+    // Heatmap lookup table (shared with the other players)
+    const PaletteLUT& palette = getPalette(PALETTE_HEATMAP);
+
     // Draw the frame pixel by pixel
     glBegin(GL_QUADS);
     for (int y = 0; y < FRAME_HEIGHT; y++) {
         for (int x = 0; x < FRAME_WIDTH; x++) {
-            // Get pixel value from file data
-            unsigned char value = fileData[frameOffset + y * FRAME_WIDTH + x];
-
-            // Map raw byte value to a color
-            // Using a heatmap-like colorization (black->red->yellow->white)
-            float r = 0.0f, g = 0.0f, b = 0.0f;
-
-            if (value < 64) {
-                // Black to Red (0-63)
-                r = value / 63.0f;
-            }
-            else if (value < 128) {
-                // Red to Yellow (64-127)
-                r = 1.0f;
-                g = (value - 64) / 63.0f;
-            }
-            else if (value < 192) {
-                // Yellow to White (128-191)
-                r = 1.0f;
-                g = 1.0f;
-                b = (value - 128) / 63.0f;
-            }
-            else {
-                // Full white (192-255)
-                r = g = b = 1.0f;
-            }
-
-            // Set the color for this pixel
-            glColor3f(r, g, b);
+            // Map raw byte value to a color (heatmap: black->red->yellow->white)
+            glColor4ubv(palette.rgba[fileData[frameOffset + y * FRAME_WIDTH + x]]);
 
             // Calculate pixel coordinates in the window
             float x1 = x * pixelWidth;